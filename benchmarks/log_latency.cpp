@@ -0,0 +1,121 @@
+// Producer-side latency of log_info() with the flight recorder and in binary,
+// synchronous text, synchronous JSON-lines and async mode.
+//
+// Usage: hydra-log-latency [threads] [records_per_thread]
+//
+// Every thread times each call individually; the report lists percentiles
+// over all calls. Records go to temporary files so the terminal is not part
+// of the measurement; the recorder and binary runs have no text sink at all.
+
+#include "hydra/log.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+std::vector<int64_t> run(int threads, int records) {
+  std::vector<std::vector<int64_t>> per_thread(threads);
+  std::vector<std::thread> workers;
+  for (int t = 0; t < threads; ++t) {
+    workers.emplace_back([&, t] {
+      auto& samples = per_thread[t];
+      samples.reserve(records);
+      for (int i = 0; i < records; ++i) {
+        auto start = Clock::now();
+        log_info("step %d of worker %d: loss=%f", i, t, 0.5 / (i + 1));
+        auto end = Clock::now();
+        samples.push_back(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(end - start)
+                .count());
+      }
+    });
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  std::vector<int64_t> all;
+  for (auto& samples : per_thread) {
+    all.insert(all.end(), samples.begin(), samples.end());
+  }
+  std::sort(all.begin(), all.end());
+  return all;
+}
+
+void report(const char* mode, const std::vector<int64_t>& samples) {
+  auto at = [&](double q) {
+    return samples[static_cast<size_t>(q * (samples.size() - 1))];
+  };
+  std::printf("%-6s p50=%6lld ns  p99=%8lld ns  p99.9=%8lld ns  max=%9lld ns\n",
+              mode, static_cast<long long>(at(0.50)),
+              static_cast<long long>(at(0.99)),
+              static_cast<long long>(at(0.999)),
+              static_cast<long long>(samples.back()));
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  int threads = argc > 1 ? std::atoi(argv[1]) : 4;
+  int records = argc > 2 ? std::atoi(argv[2]) : 100000;
+  if (threads <= 0 || records <= 0) {
+    std::fprintf(stderr, "usage: %s [threads] [records_per_thread]\n",
+                 argv[0]);
+    return 1;
+  }
+
+  log_set_quiet(true);
+  std::printf("%d threads x %d records\n", threads, records);
+
+  if (log_start_recorder(nullptr, 256, LOG_TRACE, nullptr) != 0) {
+    std::perror("recorder");
+    return 1;
+  }
+  report("flight", run(threads, records));
+  log_stop_recorder();
+
+  const char* blog = "hydra-log-latency.blog";
+  if (log_start_binary(blog, LOG_TRACE) != 0) {
+    std::perror(blog);
+    return 1;
+  }
+  report("binary", run(threads, records));
+  log_stop_binary();
+  std::remove(blog);
+
+  FILE* sink = std::tmpfile();
+  if (sink == nullptr) {
+    std::perror("tmpfile");
+    return 1;
+  }
+  log_add_fp(sink, LOG_TRACE);
+  report("sync", run(threads, records));
+  log_remove_fp(sink);
+
+  FILE* json = std::tmpfile();
+  if (json == nullptr) {
+    std::perror("tmpfile");
+    return 1;
+  }
+  const char* fields[] = {"job", "hydra-log-latency", "run_dir", "."};
+  log_add_json_fp(json, LOG_TRACE, fields, 2);
+  report("json", run(threads, records));
+  log_remove_fp(json);
+  std::fclose(json);
+
+  log_add_fp(sink, LOG_TRACE);
+
+  log_start_async(8192, LOG_OVERFLOW_BLOCK);
+  report("async", run(threads, records));
+  log_stop_async();
+
+  std::fclose(sink);
+  return 0;
+}
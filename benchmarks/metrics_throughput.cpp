@@ -0,0 +1,75 @@
+// Producer-side cost of hydra_metrics_write() and hydra_metrics_log(), with
+// log_info() writing the same records to a file for comparison.
+//
+// Usage: hydra-metrics-throughput [records]
+//
+// Records go to a temporary run directory in the binary format; the time
+// includes handing batches to the writer thread but not the final flush.
+
+#include "hydra/log.h"
+#include "hydra/metrics.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+template <typename Fn> double per_record_ns(long records, Fn&& fn) {
+  auto start = Clock::now();
+  for (long i = 0; i < records; ++i) {
+    fn(i);
+  }
+  auto end = Clock::now();
+  return std::chrono::duration<double, std::nano>(end - start).count() /
+         static_cast<double>(records);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  long records = argc > 1 ? std::atol(argv[1]) : 10000000;
+  if (records <= 0) {
+    std::fprintf(stderr, "usage: %s [records]\n", argv[0]);
+    return 1;
+  }
+  auto run_dir =
+      std::filesystem::temp_directory_path() / "hydra-metrics-throughput";
+  std::printf("%ld records\n", records);
+
+  hydra_metrics_t* metrics = hydra_metrics_open(
+      run_dir.string().c_str(), HYDRA_METRICS_BINARY, 0, nullptr);
+  if (metrics == nullptr) {
+    std::fprintf(stderr, "hydra_metrics_open: %s\n", hydra_last_error());
+    return 1;
+  }
+  int32_t loss = hydra_metrics_intern(metrics, "train/loss");
+  std::printf("write  %6.1f ns/record\n", per_record_ns(records, [&](long i) {
+                hydra_metrics_write(metrics, i, loss, 1.0 / (i + 1));
+              }));
+  std::printf("log    %6.1f ns/record\n", per_record_ns(records, [&](long i) {
+                hydra_metrics_log(metrics, i, "train/loss", 1.0 / (i + 1));
+              }));
+  hydra_metrics_close(metrics, nullptr);
+
+  FILE* sink = std::tmpfile();
+  if (sink == nullptr) {
+    std::perror("tmpfile");
+    return 1;
+  }
+  log_set_quiet(true);
+  log_add_fp(sink, LOG_TRACE);
+  long log_records = records / 10 > 0 ? records / 10 : 1;
+  std::printf("log_info %6.1f ns/record\n",
+              per_record_ns(log_records, [&](long i) {
+                log_info("step=%ld train/loss=%f", i, 1.0 / (i + 1));
+              }));
+  log_remove_fp(sink);
+  std::fclose(sink);
+
+  std::filesystem::remove_all(run_dir);
+  return 0;
+}
@@ -0,0 +1,80 @@
+# hydra_generate_config_types(<target> <config.yaml>
+#                             [NAME <Type>] [NAMESPACE <ns>]
+#                             [OVERRIDES <override>...])
+#
+# Composes <config.yaml> with hydra-codegen at build time and adds the
+# generated <type>.h (C structs and <type>_load) and <type>.hpp (C++ structs
+# and load_<type>) to <target>'s include path. NAME defaults to AppConfig,
+# whose headers are app_config.h and app_config.hpp. The headers are
+# regenerated whenever a YAML file next to or below the config changes.
+function(hydra_generate_config_types target config)
+  cmake_parse_arguments(ARG "" "NAME;NAMESPACE" "OVERRIDES" ${ARGN})
+  if(NOT ARG_NAME)
+    set(ARG_NAME AppConfig)
+  endif()
+
+  get_filename_component(config_path "${config}" ABSOLUTE)
+  get_filename_component(config_dir "${config_path}" DIRECTORY)
+  string(REGEX REPLACE "([a-z0-9])([A-Z])" "\\1_\\2" stem "${ARG_NAME}")
+  string(TOLOWER "${stem}" stem)
+
+  set(output_dir "${CMAKE_CURRENT_BINARY_DIR}/hydra_generated/${target}")
+  set(outputs "${output_dir}/${stem}.h" "${output_dir}/${stem}.hpp")
+  set(namespace_args)
+  if(ARG_NAMESPACE)
+    set(namespace_args --namespace "${ARG_NAMESPACE}")
+  endif()
+  file(GLOB_RECURSE config_inputs CONFIGURE_DEPENDS "${config_dir}/*.yaml"
+       "${config_dir}/*.yml")
+
+  add_custom_command(
+    OUTPUT ${outputs}
+    COMMAND
+      hydra-codegen --config "${config_path}" --name "${ARG_NAME}"
+      ${namespace_args} --output-dir "${output_dir}" ${ARG_OVERRIDES}
+    DEPENDS hydra-codegen ${config_inputs}
+    WORKING_DIRECTORY "${CMAKE_CURRENT_BINARY_DIR}"
+    COMMENT "Generating ${ARG_NAME} types from ${config}"
+    VERBATIM)
+
+  target_sources(${target} PRIVATE ${outputs})
+  target_include_directories(${target} PRIVATE "${output_dir}")
+endfunction()
+
+# hydra_embed_config(<target> <config.yaml> [NAME <Type>]
+#                    [OVERRIDES <override>...])
+#
+# Composes <config.yaml> at build time and compiles it into <target> as
+# <type>_embedded / <type>_embedded_size (declared in <type>_embedded.h), to
+# be passed to hydra_initialize_embedded or
+# hydra::utils::initialize_embedded. Interpolations such as ${now:...} and
+# hydra.job.name are still resolved at startup; nothing else reads a file.
+function(hydra_embed_config target config)
+  cmake_parse_arguments(ARG "" "NAME" "OVERRIDES" ${ARGN})
+  if(NOT ARG_NAME)
+    set(ARG_NAME AppConfig)
+  endif()
+
+  get_filename_component(config_path "${config}" ABSOLUTE)
+  get_filename_component(config_dir "${config_path}" DIRECTORY)
+  string(REGEX REPLACE "([a-z0-9])([A-Z])" "\\1_\\2" stem "${ARG_NAME}")
+  string(TOLOWER "${stem}" stem)
+
+  set(output_dir "${CMAKE_CURRENT_BINARY_DIR}/hydra_generated/${target}")
+  set(outputs "${output_dir}/${stem}_embedded.h"
+              "${output_dir}/${stem}_embedded.c")
+  file(GLOB_RECURSE config_inputs CONFIGURE_DEPENDS "${config_dir}/*.yaml"
+       "${config_dir}/*.yml")
+
+  add_custom_command(
+    OUTPUT ${outputs}
+    COMMAND hydra-codegen --embed --config "${config_path}" --name
+            "${ARG_NAME}" --output-dir "${output_dir}" ${ARG_OVERRIDES}
+    DEPENDS hydra-codegen ${config_inputs}
+    WORKING_DIRECTORY "${CMAKE_CURRENT_BINARY_DIR}"
+    COMMENT "Embedding ${config} into ${target}"
+    VERBATIM)
+
+  target_sources(${target} PRIVATE ${outputs})
+  target_include_directories(${target} PRIVATE "${output_dir}")
+endfunction()
@@ -1,3 +1,4 @@
+#include "hydra/config_bind.hpp"
 #include "hydra/config_node.hpp"
 #include "hydra/config_utils.hpp"
 #include "hydra/logging.hpp"
@@ -15,52 +16,49 @@ struct DatabaseConfig {
   int64_t port;
   std::string user;
 };
+HYDRA_BIND(DatabaseConfig, host, port, user)
 
 struct ModelConfig {
   std::string name;
   int64_t depth;
   std::string activation;
 };
+HYDRA_BIND(ModelConfig, name, depth, activation)
 
 struct TrainerConfig {
   int64_t batch_size;
   int64_t max_epochs;
 };
+HYDRA_BIND(TrainerConfig, batch_size, max_epochs)
 
 struct ExperimentConfig {
   std::string name;
-  std::string run_dir;
 };
+HYDRA_BIND(ExperimentConfig, name)
+
+struct RunConfig {
+  std::string dir;
+};
+HYDRA_BIND(RunConfig, dir)
+
+struct HydraConfig {
+  RunConfig run;
+};
+HYDRA_BIND(HydraConfig, run)
 
 struct AppConfig {
   DatabaseConfig database;
   ModelConfig model;
   TrainerConfig trainer;
   ExperimentConfig experiment;
+  HydraConfig hydra;
 };
+HYDRA_BIND(AppConfig, database, model, trainer, experiment, hydra)
 
+/* One pass over each mapping; every missing or mistyped field is reported
+ * in a single hydra::utils::BindError. */
 AppConfig bind_config(const hydra::ConfigNode& root) {
-  AppConfig cfg;
-  cfg.database.host = hydra::utils::expect_string(root, {"database", "host"});
-  cfg.database.port = hydra::utils::expect_int(root, {"database", "port"});
-  cfg.database.user = hydra::utils::expect_string(root, {"database", "user"});
-
-  cfg.model.name  = hydra::utils::expect_string(root, {"model", "name"});
-  cfg.model.depth = hydra::utils::expect_int(root, {"model", "depth"});
-  cfg.model.activation =
-      hydra::utils::expect_string(root, {"model", "activation"});
-
-  cfg.trainer.batch_size =
-      hydra::utils::expect_int(root, {"trainer", "batch_size"});
-  cfg.trainer.max_epochs =
-      hydra::utils::expect_int(root, {"trainer", "max_epochs"});
-
-  cfg.experiment.name =
-      hydra::utils::expect_string(root, {"experiment", "name"});
-  cfg.experiment.run_dir =
-      hydra::utils::expect_string(root, {"hydra", "run", "dir"});
-
-  return cfg;
+  return hydra::utils::bind<AppConfig>(root);
 }
 
 static void ensure_experiment_name(hydra::ConfigNode& config) {
@@ -81,7 +79,7 @@ static void print_config_summary(const AppConfig& app) {
   log_debug("Database endpoint  : %s (port=%" PRId64 ", user=%s)",
             app.database.host.c_str(), app.database.port,
             app.database.user.c_str());
-  log_debug("hydra.run.dir      : %s", app.experiment.run_dir.c_str());
+  log_debug("hydra.run.dir      : %s", app.hydra.run.dir.c_str());
 }
 
 static void simulate_training_job(const AppConfig& app) {
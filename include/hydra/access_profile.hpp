@@ -0,0 +1,85 @@
+#pragma once
+
+#include "hydra/config_node.hpp"
+
+#include <atomic>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Usage-profile-guided loading.
+//
+// With tracking on, every path looked up through find_path or the C getters
+// is recorded; record_access_profile writes them to
+// <run_dir>/.hydra/access_profile when the process exits (set
+// hydra.access_profile.record=true to have initialize() do it). Later runs
+// started through hydra_initialize with hydra.access_profile.load=<that
+// file> keep only the recorded subtrees (and `hydra`), so interpolation and
+// copying scale with what the program reads, and load the full tree the
+// first time a lookup misses. A composition whose interpolations reach
+// outside the profile is redone in full. The C++ initialize() functions
+// return complete trees and ignore the profile; ComposeContext projects only
+// when use_access_profile is set. find_path records the path it
+// is given, so profiled programs should look nodes up from the root.
+
+namespace hydra {
+
+namespace detail {
+
+extern std::atomic<bool> access_tracking;
+void record_access(const std::vector<std::string>& path);
+
+} // namespace detail
+
+void set_access_tracking(bool enabled);
+
+inline bool access_tracking_enabled() {
+  return detail::access_tracking.load(std::memory_order_relaxed);
+}
+
+// Records `path` (components from the root) when tracking is on.
+inline void track_access(const std::vector<std::string>& path) {
+  if (access_tracking_enabled()) {
+    detail::record_access(path);
+  }
+}
+
+// Paths recorded so far, sorted.
+std::vector<std::vector<std::string>> tracked_paths();
+void clear_tracked_paths();
+
+// Writes tracked_paths() to <run_dir>/.hydra/access_profile, one path
+// expression per line, and returns the file.
+std::filesystem::path
+write_access_profile(const std::filesystem::path& run_dir);
+// Turns tracking on and writes the profile to `run_dir` at exit.
+void record_access_profile(const std::filesystem::path& run_dir);
+// record_access_profile(hydra.run.dir) if hydra.access_profile.record is true.
+void configure_access_tracking(const ConfigNode& config);
+
+class AccessProfile {
+public:
+  explicit AccessProfile(std::vector<std::vector<std::string>> paths);
+
+  // Reads a file written by write_access_profile; throws on I/O errors.
+  static AccessProfile load_file(const std::filesystem::path& path);
+
+  // Sorted; no path lies below another.
+  const std::vector<std::vector<std::string>>& paths() const {
+    return paths_;
+  }
+
+  // Copy of `config` holding the subtrees at the profiled paths, their
+  // ancestors and `hydra`. Sequences are kept whole.
+  ConfigNode project(const ConfigNode& config) const;
+
+private:
+  std::vector<std::vector<std::string>> paths_;
+};
+
+// Adds every entry of `source` that `destination` lacks, recursing into
+// mappings present in both. Existing nodes are left untouched, so pointers
+// into `destination` stay valid.
+void fill_missing(ConfigNode& destination, const ConfigNode& source);
+
+} // namespace hydra
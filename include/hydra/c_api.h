@@ -9,17 +9,122 @@ extern "C" {
 
 typedef struct hydra_config hydra_config_t;
 typedef struct hydra_config_iter hydra_config_iter_t;
+typedef struct hydra_arena hydra_arena_t;
 
 typedef enum hydra_status {
-  HYDRA_STATUS_OK    = 0,
-  HYDRA_STATUS_ERROR = 1
+  HYDRA_STATUS_OK               = 0,
+  HYDRA_STATUS_ERROR            = 1,
+  HYDRA_STATUS_NOT_FOUND        = 2,
+  HYDRA_STATUS_TYPE_MISMATCH    = 3,
+  HYDRA_STATUS_PARSE_ERROR      = 4,
+  HYDRA_STATUS_INVALID_ARGUMENT = 5,
+  HYDRA_STATUS_OUT_OF_MEMORY    = 6,
+  HYDRA_STATUS_IO_ERROR         = 7,
+  HYDRA_STATUS_FROZEN           = 8
 } hydra_status_t;
 
+typedef enum hydra_value_type {
+  HYDRA_VALUE_MISSING  = 0,
+  HYDRA_VALUE_NULL     = 1,
+  HYDRA_VALUE_BOOL     = 2,
+  HYDRA_VALUE_INT      = 3,
+  HYDRA_VALUE_DOUBLE   = 4,
+  HYDRA_VALUE_STRING   = 5,
+  HYDRA_VALUE_SEQUENCE = 6,
+  HYDRA_VALUE_MAPPING  = 7
+} hydra_value_type_t;
+
+/*
+ * A value read in bulk. Strings are borrowed from the config (valid until it
+ * is modified or destroyed) and are NUL-terminated; containers report only
+ * their element count.
+ */
+typedef struct hydra_value {
+  hydra_value_type_t type;
+  union {
+    int boolean;
+    int64_t integer;
+    double real;
+    struct {
+      const char* data;
+      size_t length;
+    } string;
+    size_t size;
+  } as;
+} hydra_value_t;
+
+/*
+ * Every leaf of a config as parallel arrays: paths[i] addresses values[i].
+ * Empty sequences and mappings count as leaves. Released with
+ * hydra_config_flat_free.
+ */
+typedef struct hydra_config_flat {
+  const char** paths;
+  hydra_value_t* values;
+  size_t count;
+} hydra_config_flat_t;
+
+/*
+ * Hooks for every block the C API hands to the caller (strings, string
+ * lists, captured overrides, flattened exports) and for arena blocks.
+ * Configuration trees themselves stay on the C++ heap.
+ */
+typedef struct hydra_allocator {
+  void* (*allocate)(size_t size, void* user_data);
+  void (*deallocate)(void* ptr, void* user_data);
+  void* user_data;
+} hydra_allocator_t;
+
 typedef struct hydra_cli_overrides {
   char** items;
   size_t count;
 } hydra_cli_overrides_t;
 
+/**
+ * Message of the most recent failed call on the calling thread.
+ *
+ * The returned buffer is owned by the library and stays valid until the next
+ * failing call on the same thread. Successful calls leave it untouched.
+ * Every failing call records its message here, so passing NULL as
+ * error_message avoids the heap copy without losing the diagnostic.
+ */
+const char* hydra_last_error(void);
+
+/** Status of the most recent failed call on the calling thread. */
+hydra_status_t hydra_last_status(void);
+
+/** Static, human-readable name of a status code. */
+const char* hydra_status_string(hydra_status_t status);
+
+/**
+ * Route caller-visible allocations through `allocator` (NULL restores
+ * malloc/free).
+ *
+ * Install it once at startup, before any other call and before other threads
+ * use the library: memory must be released by the allocator that produced it.
+ */
+void hydra_set_allocator(const hydra_allocator_t* allocator);
+
+/**
+ * Create a bump allocator for the *_arena variants below.
+ *
+ * Everything allocated from an arena is released at once by
+ * hydra_arena_reset or hydra_arena_destroy and must not be passed to
+ * hydra_string_free / hydra_string_list_free. An arena is not thread-safe.
+ *
+ * @param block_size Bytes per block (0 selects a default of 4 KiB)
+ * @return Arena, or NULL when out of memory
+ */
+hydra_arena_t* hydra_arena_create(size_t block_size);
+
+/** Release everything allocated from `arena`, keeping one block for reuse. */
+void hydra_arena_reset(hydra_arena_t* arena);
+
+void hydra_arena_destroy(hydra_arena_t* arena);
+
+/** Bytes handed out since creation or the last reset. */
+size_t hydra_arena_bytes_used(const hydra_arena_t* arena);
+
 hydra_config_t* hydra_config_create(void);
 void hydra_config_destroy(hydra_config_t* config);
 
@@ -37,11 +142,52 @@ hydra_status_t hydra_config_apply_override(hydra_config_t* config,
                                            const char* expression,
                                            char** error_message);
 
+/**
+ * Resolve all interpolations once and mark the config immutable.
+ *
+ * Afterwards every getter, iterator and emitter only reads the config, so a
+ * frozen config may be shared by any number of threads without locking.
+ * Calls that would modify it (merge, override, clear, CLI parsing) fail.
+ * Freezing an already frozen config is a no-op.
+ *
+ * @param config Configuration object
+ * @param error_message Output parameter for error message
+ * @return HYDRA_STATUS_OK on success
+ */
+hydra_status_t hydra_config_freeze(hydra_config_t* config,
+                                   char** error_message);
+
+int hydra_config_is_frozen(const hydra_config_t* config);
+
 hydra_status_t hydra_config_subnode(hydra_config_t* config,
                                     const char* path_expression,
                                     hydra_config_t** out_subconfig,
                                     char** error_message);
 
+/**
+ * Borrow the subtree at `path_expression` without copying it.
+ *
+ * The returned handle accepts every read-only call (getters, iterators,
+ * emitters, further views) with paths relative to the subtree, and reads
+ * interpolations through the config it was taken from. Mutating calls on a
+ * view fail with HYDRA_STATUS_INVALID_ARGUMENT.
+ *
+ * A view must be released with hydra_config_destroy before its parent is
+ * destroyed, and is invalidated by any merge, override or clear of the
+ * parent. Views of a frozen config are safe to read from any thread.
+ *
+ * @param config Configuration object or another view
+ * @param path_expression Dot-separated path ("" for the root)
+ * @param out_view Output parameter for the view handle
+ * @param error_message Output parameter for error message
+ * @return HYDRA_STATUS_OK on success, HYDRA_STATUS_NOT_FOUND if the path is
+ * missing
+ */
+hydra_status_t hydra_config_view(const hydra_config_t* config,
+                                 const char* path_expression,
+                                 hydra_config_t** out_view,
+                                 char** error_message);
+
 hydra_status_t hydra_config_sequence_iter(const hydra_config_t* config,
                                           const char* path_expression,
                                           hydra_config_iter_t** out_iter,
@@ -55,6 +201,12 @@ hydra_status_t hydra_config_map_iter(const hydra_config_t* config,
 int hydra_config_iter_next(hydra_config_iter_t* iter, char** child_path,
                            char** key, size_t* index, char** error_message);
 
+/* As hydra_config_iter_next, with child_path and key allocated from arena. */
+int hydra_config_iter_next_arena(hydra_config_iter_t* iter,
+                                 hydra_arena_t* arena, char** child_path,
+                                 char** key, size_t* index,
+                                 char** error_message);
+
 void hydra_config_iter_destroy(hydra_config_iter_t* iter);
 
 int hydra_config_has(const hydra_config_t* config, const char* path_expression);
@@ -75,6 +227,71 @@ hydra_status_t hydra_config_get_string(const hydra_config_t* config,
                                        const char* path_expression,
                                        char** out_value, char** error_message);
 
+/* As hydra_config_get_string, with the copy allocated from arena. */
+hydra_status_t hydra_config_get_string_arena(const hydra_config_t* config,
+                                             const char* path_expression,
+                                             hydra_arena_t* arena,
+                                             char** out_value,
+                                             char** error_message);
+
+/*
+ * Lookup-or-default getters. A missing key or a value of the wrong type
+ * yields default_value; nothing is allocated and hydra_last_error() is not
+ * touched. The string variant returns a pointer borrowed from the config,
+ * valid until the config is modified or destroyed.
+ */
+int hydra_config_get_bool_or_default(const hydra_config_t* config,
+                                     const char* path_expression,
+                                     int default_value);
+
+int64_t hydra_config_get_int_or_default(const hydra_config_t* config,
+                                        const char* path_expression,
+                                        int64_t default_value);
+
+double hydra_config_get_double_or_default(const hydra_config_t* config,
+                                          const char* path_expression,
+                                          double default_value);
+
+const char* hydra_config_get_string_or_default(const hydra_config_t* config,
+                                               const char* path_expression,
+                                               const char* default_value);
+
+/**
+ * Look up `count` paths in one call.
+ *
+ * Interpolations are resolved once and lookups sharing a prefix walk it only
+ * once. A path that does not exist yields HYDRA_VALUE_MISSING rather than an
+ * error.
+ *
+ * @param config Configuration object or view
+ * @param paths Array of `count` path expressions
+ * @param count Number of paths
+ * @param out_values Array of `count` values, filled in order
+ * @param error_message Output parameter for error message
+ * @return HYDRA_STATUS_OK, or HYDRA_STATUS_INVALID_ARGUMENT if any path could
+ * not be parsed (its value is HYDRA_VALUE_MISSING, the others are filled)
+ */
+hydra_status_t hydra_config_get_many(const hydra_config_t* config,
+                                     const char* const* paths, size_t count,
+                                     hydra_value_t* out_values,
+                                     char** error_message);
+
+/**
+ * Export every leaf of the config in a single allocation.
+ *
+ * Paths are escaped so they can be passed back to any getter.
+ *
+ * @param config Configuration object or view
+ * @param out_flat Output parameter, release with hydra_config_flat_free
+ * @param error_message Output parameter for error message
+ * @return HYDRA_STATUS_OK on success
+ */
+hydra_status_t hydra_config_flatten(const hydra_config_t* config,
+                                    hydra_config_flat_t* out_flat,
+                                    char** error_message);
+
+void hydra_config_flat_free(hydra_config_flat_t* flat);
+
 hydra_status_t hydra_config_clone_string(const hydra_config_t* config,
                                          const char* path_expression,
                                          char** out_value,
@@ -86,6 +303,12 @@ hydra_status_t hydra_config_clone_string_list(const hydra_config_t* config,
                                               size_t* out_count,
                                               char** error_message);
 
+/* As hydra_config_clone_string_list, with array and items from arena. */
+hydra_status_t hydra_config_clone_string_list_arena(
+    const hydra_config_t* config, const char* path_expression,
+    hydra_arena_t* arena, char*** out_items, size_t* out_count,
+    char** error_message);
+
 void hydra_string_list_free(char** items, size_t count);
 
 hydra_status_t hydra_config_ensure_directory(const hydra_config_t* config,
@@ -95,6 +318,10 @@ hydra_status_t hydra_config_ensure_directory(const hydra_config_t* config,
 char* hydra_config_to_yaml_string(const hydra_config_t* config,
                                   char** error_message);
 
+char* hydra_config_to_yaml_string_arena(const hydra_config_t* config,
+                                        hydra_arena_t* arena,
+                                        char** error_message);
+
 void hydra_string_free(char* str);
 
 void hydra_cli_overrides_free(hydra_cli_overrides_t* overrides);
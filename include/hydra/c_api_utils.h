@@ -2,6 +2,7 @@
 
 #include "hydra/c_api.h"
 
+#include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 
@@ -35,6 +36,68 @@ hydra_config_t* hydra_initialize(int argc, char** argv,
                                  const char* default_config,
                                  char** error_message);
 
+/**
+ * Like hydra_initialize, but starts from a config embedded at build time by
+ * hydra_embed_config (cmake/HydraCodegen.cmake) instead of reading a default
+ * file: startup parses no YAML and reads no file unless `--config` is given.
+ *
+ * @param blob Embedded config, e.g. app_config_embedded
+ * @param size Size of `blob` in bytes, e.g. app_config_embedded_size
+ * @return Config object on success, NULL on failure
+ */
+hydra_config_t* hydra_initialize_embedded(int argc, char** argv,
+                                          const void* blob, size_t size,
+                                          char** error_message);
+
+/**
+ * Usage profiles (see hydra/access_profile.hpp): while tracking is on, every
+ * path read through the getters is recorded; hydra_access_profile_write
+ * saves them to <run_dir>/.hydra/access_profile for runs started with
+ * hydra.access_profile.load=<file>. hydra.access_profile.record=true does
+ * both for hydra_initialize, writing at exit.
+ */
+void hydra_access_tracking(int enabled);
+hydra_status_t hydra_access_profile_write(const char* run_dir,
+                                          char** error_message);
+
+/**
+ * Pending hydra_initialize_async. Every handle must be passed to
+ * hydra_init_wait exactly once.
+ */
+typedef struct hydra_init hydra_init_t;
+
+/**
+ * Called on the loading thread when it finishes, with HYDRA_STATUS_OK or the
+ * status hydra_init_wait will report. hydra_init_ready already returns 1.
+ * The callback must not call hydra_init_wait itself: on the loading thread
+ * it returns NULL with HYDRA_STATUS_INVALID_ARGUMENT and keeps the handle,
+ * which another thread must still wait on.
+ */
+typedef void (*hydra_init_callback_t)(hydra_status_t status, void* user_data);
+
+/**
+ * Runs hydra_initialize on a background thread so that the caller can open
+ * sockets, load models, etc. while configs are read and resolved. `argv` and
+ * `default_config` are copied before this returns.
+ *
+ * @param callback Optional completion callback
+ * @return Handle on success, NULL if the thread could not be started
+ */
+hydra_init_t* hydra_initialize_async(int argc, char** argv,
+                                     const char* default_config,
+                                     hydra_init_callback_t callback,
+                                     void* user_data, char** error_message);
+
+/* 1 once the loading thread has finished, 0 while it is still running. */
+int hydra_init_ready(const hydra_init_t* init);
+
+/**
+ * Blocks until the loading thread has finished (callback included), releases
+ * `init`, and returns what hydra_initialize would have. If the thread cannot
+ * be joined, `init` is left untouched and may be waited on again.
+ */
+hydra_config_t* hydra_init_wait(hydra_init_t* init, char** error_message);
+
 #ifdef __cplusplus
 }
 #endif
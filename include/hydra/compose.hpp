@@ -0,0 +1,101 @@
+#pragma once
+
+#include "hydra/access_profile.hpp"
+#include "hydra/config_node.hpp"
+#include "hydra/interpolation.hpp"
+#include "hydra/yaml_loader.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace hydra {
+
+// The inputs of one composition: files merged in order, then override
+// expressions ("key=value", "+new.key=value") applied on top.
+struct OverrideSet {
+  std::vector<std::filesystem::path> config_files;
+  std::vector<std::string> overrides;
+};
+
+// Everything a composition reads besides its OverrideSet and the files
+// themselves. compose() touches no process-global state: ${oc.env:...}
+// looks in `environment`, ${now:...} calls `clock`, and files are read
+// through `cache`, so one context can be shared by any number of threads
+// composing at once (`clock` must then be safe to call concurrently).
+//
+//   hydra::ComposeContext context = hydra::ComposeContext::from_process();
+//   context.default_config        = "configs/main.yaml";
+//   hydra::ConfigNode config = context.compose({{}, {"trainer.lr=0.1"}});
+struct ComposeContext {
+  std::map<std::string, std::string> environment;
+  std::function<std::chrono::system_clock::time_point()> clock = [] {
+    return std::chrono::system_clock::now();
+  };
+  // Parsed files shared by every composition using this context; null reads
+  // every file each time.
+  std::shared_ptr<YamlFileCache> cache = std::make_shared<YamlFileCache>();
+  // Tree the files are merged onto (an empty mapping when null), e.g. a
+  // config embedded with hydra_embed_config.
+  std::shared_ptr<const ConfigNode> base;
+  // Read when an OverrideSet names no files.
+  std::filesystem::path default_config;
+  // hydra.job.name when the config leaves it unset.
+  std::string job_name = "app";
+  // Subtrees compose() keeps (see hydra/access_profile.hpp); when null, the
+  // file named by hydra.access_profile.load is used, if it exists.
+  std::shared_ptr<const AccessProfile> profile;
+  // Projection is opt-in: a projected tree lacks whatever the profile left
+  // out, so only callers that can compose in full on a miss (as
+  // hydra_initialize does) should set this. false composes in full
+  // regardless of `profile` and the config.
+  bool use_access_profile = false;
+
+  // A context whose environment is a copy of the process environment taken
+  // now; later setenv calls do not affect it.
+  static ComposeContext from_process();
+
+  // Files, then overrides; interpolations and hydra.job.name are left
+  // unresolved.
+  ConfigNode compose_unresolved(const OverrideSet& set) const;
+  // compose_unresolved, then hydra.job.name, interpolation and validation
+  // against the schema named by hydra.schema (throws hydra::SchemaError).
+  // With use_access_profile and a profile, only the profiled subtrees are
+  // resolved and returned, and *projected is set; configs whose
+  // interpolations reach outside the profile, or that name a schema, are
+  // composed in full.
+  ConfigNode compose(const OverrideSet& set, bool* projected = nullptr) const;
+
+  ResolveOptions resolve_options() const;
+};
+
+// context.compose(set) on a new thread, so that startup can overlap reading
+// and resolving configs with other initialization. get() on the future
+// blocks until the whole tree is resolved (an interpolation may reference any
+// subtree) and rethrows what compose() threw.
+std::future<ConfigNode> compose_async(ComposeContext context, OverrideSet set);
+
+struct ComposeResult {
+  ConfigNode config;
+  // what() of the exception that stopped the composition; empty on success.
+  std::string error;
+
+  bool ok() const { return error.empty(); }
+};
+
+// context.compose(set) for every set, spread over `threads` threads (the
+// calling one included; 0 selects std::thread::hardware_concurrency()).
+// Results are in the order of `sets`; a failing set does not affect the
+// others.
+std::vector<ComposeResult> compose_many(const ComposeContext& context,
+                                        std::span<const OverrideSet> sets,
+                                        size_t threads = 0);
+
+} // namespace hydra
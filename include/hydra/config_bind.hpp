@@ -0,0 +1,346 @@
+#pragma once
+
+#include "hydra/access_profile.hpp"
+#include "hydra/config_node.hpp"
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Declarative binding of configuration mappings to structs.
+//
+//   enum class Activation { relu, gelu };
+//   HYDRA_BIND_ENUM(Activation, relu, gelu)
+//
+//   struct ModelConfig {
+//     std::string name;
+//     int64_t depth;
+//     Activation activation;
+//     std::optional<double> dropout;
+//     std::vector<int64_t> widths;
+//   };
+//   HYDRA_BIND(ModelConfig, name, depth, activation, dropout, widths)
+//
+//   ModelConfig model = hydra::utils::bind<ModelConfig>(root, {"model"});
+//
+// HYDRA_BIND expands to a constexpr table of (key, member pointer) pairs, so
+// binding a struct walks its mapping once and dispatches each key to its
+// member; nested structs recurse one level at a time. Fields may be strings,
+// bool, integers, floating point, bound enums and structs, ConfigNode, and
+// std::vector / std::optional of those. A missing std::optional field stays
+// empty; every other field is required. Keys without a field are ignored.
+// All mismatches are collected and thrown together as one BindError.
+//
+// Use both macros at namespace scope, in the namespace of the bound type.
+
+#define HYDRA_BIND_PARENS ()
+#define HYDRA_BIND_EXPAND(...)                                                 \
+  HYDRA_BIND_EXPAND4(HYDRA_BIND_EXPAND4(                                       \
+      HYDRA_BIND_EXPAND4(HYDRA_BIND_EXPAND4(__VA_ARGS__))))
+#define HYDRA_BIND_EXPAND4(...)                                                \
+  HYDRA_BIND_EXPAND3(HYDRA_BIND_EXPAND3(                                       \
+      HYDRA_BIND_EXPAND3(HYDRA_BIND_EXPAND3(__VA_ARGS__))))
+#define HYDRA_BIND_EXPAND3(...)                                                \
+  HYDRA_BIND_EXPAND2(HYDRA_BIND_EXPAND2(                                       \
+      HYDRA_BIND_EXPAND2(HYDRA_BIND_EXPAND2(__VA_ARGS__))))
+#define HYDRA_BIND_EXPAND2(...)                                                \
+  HYDRA_BIND_EXPAND1(HYDRA_BIND_EXPAND1(                                       \
+      HYDRA_BIND_EXPAND1(HYDRA_BIND_EXPAND1(__VA_ARGS__))))
+#define HYDRA_BIND_EXPAND1(...) __VA_ARGS__
+// Applies `macro(type, name)` to every name (up to 256).
+#define HYDRA_BIND_FOR_EACH(macro, type, ...)                                  \
+  __VA_OPT__(HYDRA_BIND_EXPAND(HYDRA_BIND_FOR_EACH_STEP(macro, type,           \
+                                                        __VA_ARGS__)))
+#define HYDRA_BIND_FOR_EACH_STEP(macro, type, name, ...)                       \
+  macro(type, name)                                                            \
+      __VA_OPT__(HYDRA_BIND_FOR_EACH_AGAIN HYDRA_BIND_PARENS(macro, type,      \
+                                                             __VA_ARGS__))
+#define HYDRA_BIND_FOR_EACH_AGAIN() HYDRA_BIND_FOR_EACH_STEP
+
+#define HYDRA_BIND_FIELD(type, name)                                           \
+  , ::hydra::utils::bind_field(#name, &type::name)
+#define HYDRA_BIND_ENUM_VALUE(type, name)                                      \
+  ::hydra::utils::EnumName<type>{#name, type::name},
+
+#define HYDRA_BIND(type, ...)                                                  \
+  [[maybe_unused]] constexpr auto hydra_bind_fields(const type*) {             \
+    return ::hydra::utils::bind_fields(                                        \
+        0 HYDRA_BIND_FOR_EACH(HYDRA_BIND_FIELD, type, __VA_ARGS__));           \
+  }
+
+#define HYDRA_BIND_ENUM(type, ...)                                             \
+  [[maybe_unused]] constexpr auto hydra_bind_enum_names(const type*) {         \
+    return std::array{                                                         \
+        HYDRA_BIND_FOR_EACH(HYDRA_BIND_ENUM_VALUE, type, __VA_ARGS__)};        \
+  }
+
+namespace hydra::utils {
+
+template <typename Struct, typename Member> struct BindField {
+  const char* key;
+  Member Struct::*member;
+};
+
+template <typename Struct, typename Member>
+constexpr BindField<Struct, Member> bind_field(const char* key,
+                                               Member Struct::*member) {
+  return {key, member};
+}
+
+// The leading int absorbs the comma HYDRA_BIND_FIELD puts before each entry.
+template <typename... Fields>
+constexpr std::tuple<Fields...> bind_fields(int, Fields... fields) {
+  return {fields...};
+}
+
+template <typename Enum> struct EnumName {
+  const char* name;
+  Enum value;
+};
+
+// Every problem found while binding, one "path: message" entry each.
+class BindError : public std::runtime_error {
+public:
+  explicit BindError(std::vector<std::string> errors)
+      : std::runtime_error(format(errors)), errors_(std::move(errors)) {}
+
+  const std::vector<std::string>& errors() const { return errors_; }
+
+private:
+  static std::string format(const std::vector<std::string>& errors) {
+    std::string message = "Invalid configuration:";
+    for (const std::string& error : errors) {
+      message += "\n  " + error;
+    }
+    return message;
+  }
+
+  std::vector<std::string> errors_;
+};
+
+namespace detail {
+
+template <typename T>
+concept BoundStruct = requires(const T* type) { hydra_bind_fields(type); };
+
+template <typename T>
+concept BoundEnum =
+    std::is_enum_v<T> && requires(const T* type) { hydra_bind_enum_names(type); };
+
+template <typename T> struct is_vector : std::false_type {};
+template <typename T> struct is_vector<std::vector<T>> : std::true_type {};
+template <typename T> struct is_optional : std::false_type {};
+template <typename T> struct is_optional<std::optional<T>> : std::true_type {};
+
+struct BindContext {
+  std::vector<std::string> errors;
+
+  void error(const std::string& path, const std::string& message) {
+    errors.push_back((path.empty() ? std::string("<root>") : path) + ": " +
+                     message);
+  }
+
+  void mismatch(const std::string& path, const char* expected,
+                const ConfigNode& node) {
+    error(path, std::string("expected ") + expected + ", got " +
+                    node.type_name());
+  }
+};
+
+inline std::string child_path(const std::string& parent,
+                              std::string_view key) {
+  std::string path = parent;
+  if (!path.empty()) {
+    path += '.';
+  }
+  path += key;
+  return path;
+}
+
+inline std::vector<std::string>
+to_components(std::initializer_list<const char*> parts) {
+  return std::vector<std::string>(parts.begin(), parts.end());
+}
+
+template <typename T>
+void bind_value(const ConfigNode& node, T& out, const std::string& path,
+                BindContext& context);
+
+template <typename T>
+void bind_struct(const ConfigNode& node, T& out, const std::string& path,
+                 BindContext& context) {
+  if (!node.is_mapping()) {
+    context.mismatch(path, "mapping", node);
+    return;
+  }
+  constexpr auto fields = hydra_bind_fields(static_cast<const T*>(nullptr));
+  constexpr size_t count = std::tuple_size_v<decltype(fields)>;
+  std::array<bool, count> seen{};
+
+  for (const auto& [key, value] : node.as_mapping()) {
+    std::apply(
+        [&](const auto&... field) {
+          size_t index = 0;
+          // Stops at the first field whose key matches.
+          (void)((key == field.key
+                      ? (seen[index] = true,
+                         bind_value(value, out.*field.member,
+                                    child_path(path, key), context),
+                         true)
+                      : (++index, false)) ||
+                 ...);
+        },
+        fields);
+  }
+
+  std::apply(
+      [&](const auto&... field) {
+        size_t index = 0;
+        auto check   = [&](const auto& entry) {
+          using Member =
+              std::remove_reference_t<decltype(out.*entry.member)>;
+          if (!seen[index++]) {
+            if constexpr (is_optional<Member>::value) {
+              (out.*entry.member).reset();
+            } else {
+              context.error(child_path(path, entry.key), "missing");
+            }
+          }
+        };
+        (check(field), ...);
+      },
+      fields);
+}
+
+template <typename T>
+void bind_value(const ConfigNode& node, T& out, const std::string& path,
+                BindContext& context) {
+  if constexpr (std::is_same_v<T, ConfigNode>) {
+    out = node;
+  } else if constexpr (std::is_same_v<T, std::string>) {
+    if (node.is_string()) {
+      out = node.as_string();
+    } else {
+      context.mismatch(path, "string", node);
+    }
+  } else if constexpr (std::is_same_v<T, bool>) {
+    if (node.is_bool()) {
+      out = node.as_bool();
+    } else {
+      context.mismatch(path, "boolean", node);
+    }
+  } else if constexpr (std::is_integral_v<T>) {
+    if (!node.is_int()) {
+      context.mismatch(path, "integer", node);
+    } else if (!std::in_range<T>(node.as_int())) {
+      context.error(path, "integer " + std::to_string(node.as_int()) +
+                              " is out of range");
+    } else {
+      out = static_cast<T>(node.as_int());
+    }
+  } else if constexpr (std::is_floating_point_v<T>) {
+    if (node.is_double()) {
+      out = static_cast<T>(node.as_double());
+    } else if (node.is_int()) {
+      out = static_cast<T>(node.as_int());
+    } else {
+      context.mismatch(path, "numeric value", node);
+    }
+  } else if constexpr (BoundEnum<T>) {
+    constexpr auto names = hydra_bind_enum_names(static_cast<const T*>(nullptr));
+    if (!node.is_string()) {
+      context.mismatch(path, "enum name", node);
+      return;
+    }
+    for (const auto& entry : names) {
+      if (node.as_string() == entry.name) {
+        out = entry.value;
+        return;
+      }
+    }
+    std::string allowed;
+    for (const auto& entry : names) {
+      allowed += allowed.empty() ? "" : ", ";
+      allowed += entry.name;
+    }
+    context.error(path, "'" + node.as_string() + "' is not one of " + allowed);
+  } else if constexpr (is_optional<T>::value) {
+    if (node.is_null()) {
+      out.reset();
+    } else {
+      bind_value(node, out.emplace(), path, context);
+    }
+  } else if constexpr (is_vector<T>::value) {
+    if (!node.is_sequence()) {
+      context.mismatch(path, "sequence", node);
+      return;
+    }
+    const ConfigNode::seq_t& items = node.as_sequence();
+    out.clear();
+    out.resize(items.size());
+    for (size_t i = 0; i < items.size(); ++i) {
+      bind_value(items[i], out[i], child_path(path, std::to_string(i)),
+                 context);
+    }
+  } else if constexpr (BoundStruct<T>) {
+    bind_struct(node, out, path, context);
+  } else {
+    static_assert(BoundStruct<T>,
+                  "type is not bindable; declare it with HYDRA_BIND or "
+                  "HYDRA_BIND_ENUM");
+  }
+}
+
+} // namespace detail
+
+// Binds `node` into `out` and returns the problems found (empty on success).
+// Fields that failed keep their previous value.
+template <typename T>
+std::vector<std::string> bind_into(const ConfigNode& node, T& out,
+                                   const std::string& path = "") {
+  detail::BindContext context;
+  detail::bind_value(node, out, path, context);
+  return std::move(context.errors);
+}
+
+// Binds the node at `path_parts` under `root` (root itself when empty) and
+// throws BindError listing every problem.
+template <typename T>
+T bind(const ConfigNode& root,
+       std::initializer_list<const char*> path_parts = {}) {
+  if (access_tracking_enabled()) {
+    hydra::detail::record_access(detail::to_components(path_parts));
+  }
+  const ConfigNode* node = &root;
+  std::string path;
+  for (const char* part : path_parts) {
+    path = detail::child_path(path, part);
+    if (node->is_mapping()) {
+      node = find_child(*node, part);
+    } else {
+      node = nullptr;
+    }
+    if (node == nullptr) {
+      throw BindError({path + ": missing"});
+    }
+  }
+  T out{};
+  std::vector<std::string> errors = bind_into(*node, out, path);
+  if (!errors.empty()) {
+    throw BindError(std::move(errors));
+  }
+  return out;
+}
+
+} // namespace hydra::utils
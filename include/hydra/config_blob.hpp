@@ -0,0 +1,26 @@
+#pragma once
+
+#include "hydra/config_node.hpp"
+
+#include <cstddef>
+#include <string>
+
+namespace hydra {
+
+// Compact binary form of a configuration tree, used to embed composed
+// configs into executables (see hydra_embed_config in
+// cmake/HydraCodegen.cmake):
+//
+//   "HYDRACFG" u32 version, then the root node in pre-order:
+//   u8 type, followed by  bool: u8 | int: i64 | double: f64 |
+//   string: u32 length, bytes | sequence: u32 count, nodes |
+//   mapping: u32 count, (u32 length, key bytes, node) in key order
+//
+// Integers are in native byte order. Loading a blob needs no YAML parsing.
+std::string serialize_config(const ConfigNode& root);
+
+// Rebuilds the tree serialized into `data`; throws std::runtime_error when
+// the blob is truncated or was written by another format version.
+ConfigNode deserialize_config(const void* data, size_t size);
+
+} // namespace hydra
@@ -11,8 +11,10 @@ namespace hydra {
 
 class ConfigNode {
 public:
-  using map_t = std::map<std::string, ConfigNode>;
-  using seq_t = std::vector<ConfigNode>;
+  using map_t     = std::map<std::string, ConfigNode>;
+  using seq_t     = std::vector<ConfigNode>;
+  using variant_t = std::variant<std::nullptr_t, bool, int64_t, double,
+                                 std::string, seq_t, map_t>;
 
   ConfigNode();
   ConfigNode(std::nullptr_t);
@@ -48,9 +50,11 @@ public:
 
   std::string type_name() const;
 
+  // The value itself; hydra/visit.hpp dispatches on it.
+  const variant_t& variant() const { return value_; }
+  variant_t& variant() { return value_; }
+
 private:
-  using variant_t = std::variant<std::nullptr_t, bool, int64_t, double,
-                                 std::string, seq_t, map_t>;
   variant_t value_;
 };
 
@@ -67,6 +71,11 @@ ConfigNode merged(const ConfigNode& base, const ConfigNode& override_node);
 
 ConfigNode deep_copy(const ConfigNode& node);
 
+// One step of find_path: the mapping entry or sequence element named by
+// `component`, or nullptr.
+const ConfigNode* find_child(const ConfigNode& parent,
+                             const std::string& component);
+
 ConfigNode* find_path(ConfigNode& root, const std::vector<std::string>& path);
 const ConfigNode* find_path(const ConfigNode& root,
                             const std::vector<std::string>& path);
@@ -1,10 +1,13 @@
 #pragma once
 
+#include "hydra/compose.hpp"
 #include "hydra/config_node.hpp"
 #include "hydra/yaml_emitter.hpp"
 #include "hydra/yaml_loader.hpp"
 
+#include <cstddef>
 #include <filesystem>
+#include <future>
 #include <initializer_list>
 #include <ostream>
 #include <stdexcept>
@@ -114,10 +117,38 @@ std::filesystem::path
 write_hydra_outputs(const ConfigNode& root,
                     const std::vector<std::string>& overrides);
 
+// The --config/-c files and the override expressions in argv[1..argc).
+OverrideSet parse_command_line(int argc, char** argv);
+
+// The context initialize() composes with: a snapshot of the process
+// environment, the program name from argv[0] as job name, and a clock fixed
+// at this call; files are read afresh each time.
+ComposeContext process_context(int argc, char** argv);
+
 // Initialize Hydra configuration from command-line arguments
-// Performs: config loading, override application, job.name derivation, and
-// interpolation
+// Performs: config loading, override application, job.name derivation,
+// interpolation, and validation against the schema file named by
+// hydra.schema (see hydra/schema.hpp), which throws hydra::SchemaError.
+// Also starts recording an access profile when hydra.access_profile.record
+// is set (see hydra/access_profile.hpp)
 ConfigNode initialize(int argc, char** argv,
                       const std::string& default_config = "configs/main.yaml");
 
+// initialize() on a background thread; `argv` is read before this returns.
+std::future<ConfigNode>
+initialize_async(int argc, char** argv,
+                 const std::string& default_config = "configs/main.yaml");
+
+// Loads and merges `config_files`, then applies `overrides`, leaving
+// interpolations and hydra.job.name unresolved (what hydra_embed_config
+// stores).
+ConfigNode compose(const std::vector<std::filesystem::path>& config_files,
+                   const std::vector<std::string>& overrides = {});
+
+// initialize() starting from a config serialized by hydra_embed_config
+// (see hydra/config_blob.hpp) instead of a file: only --config files given
+// on the command line are read, merged on top of the embedded one.
+ConfigNode initialize_embedded(int argc, char** argv, const void* blob,
+                               size_t size);
+
 } // namespace hydra::utils
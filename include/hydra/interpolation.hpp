@@ -2,8 +2,24 @@
 
 #include "hydra/config_node.hpp"
 
+#include <chrono>
+#include <functional>
+#include <optional>
+#include <string>
+
 namespace hydra {
 
+// Where ${oc.env:NAME} and ${now:FORMAT} take their values from. Empty
+// members fall back to std::getenv and std::chrono::system_clock, so a
+// default-constructed ResolveOptions reads process-global state; set both to
+// make resolution a function of its inputs only.
+struct ResolveOptions {
+  // nullopt (or an empty string) selects the placeholder's fallback.
+  std::function<std::optional<std::string>(const std::string& name)> getenv;
+  std::function<std::chrono::system_clock::time_point()> now;
+};
+
 void resolve_interpolations(ConfigNode& root);
+void resolve_interpolations(ConfigNode& root, const ResolveOptions& options);
 
-}
+} // namespace hydra
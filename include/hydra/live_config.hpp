@@ -0,0 +1,101 @@
+#pragma once
+
+#include "hydra/config_node.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace hydra {
+
+// A configuration that can change while other threads read it.
+//
+//   hydra::LiveConfig live(hydra::utils::compose({"configs/main.yaml"}));
+//   auto id = live.subscribe("trainer", [](const auto& snapshot) { ... });
+//   ...
+//   hydra::LiveConfig::Snapshot config = live.snapshot();  // any thread
+//   live.update({"trainer.batch_size=64", "+trainer.warmup=5"});
+//
+// Every version is an immutable, fully resolved ConfigNode published RCU
+// style: writers swap an atomic pointer to the current shared_ptr, and
+// snapshot() copies it inside a read-side section that is a fixed number of
+// atomic operations, so readers never wait for writers or each other. The
+// snapshot stays valid for as long as the caller holds it. Writers are
+// serialized; update() applies its overrides to the unresolved source tree,
+// so interpolations that depend on a changed value follow it (${now:...} is
+// evaluated again too), resolves a copy, publishes it, waits for readers
+// still copying the previous pointer, and then notifies the subscribers
+// whose subtree hash changed.
+class LiveConfig {
+public:
+  using Snapshot     = std::shared_ptr<const ConfigNode>;
+  using Callback     = std::function<void(const Snapshot&)>;
+  using Subscription = uint64_t;
+
+  // `source` may still contain interpolations; it is resolved for the first
+  // snapshot.
+  explicit LiveConfig(ConfigNode source);
+  ~LiveConfig();
+
+  LiveConfig(const LiveConfig&)            = delete;
+  LiveConfig& operator=(const LiveConfig&) = delete;
+
+  Snapshot snapshot() const;
+  // Number of snapshots published before the current one.
+  uint64_t version() const { return version_.load(std::memory_order_acquire); }
+
+  // Applies the override expressions ("key=value", "+new.key=value") as one
+  // batch and publishes the result. Throws without publishing anything when
+  // an expression does not parse or apply.
+  Snapshot update(const std::vector<std::string>& overrides);
+  // Applies `mutate` to a copy of the unresolved source tree and publishes
+  // the result; nothing is published if it throws.
+  Snapshot update(const std::function<void(ConfigNode&)>& mutate);
+
+  // Calls `callback` with the new snapshot after every update that changes
+  // the subtree at the dotted `prefix` ("" for the whole config), including
+  // the subtree appearing or disappearing. Callbacks run on the updating
+  // thread, in order, and must not call update(), subscribe() or
+  // unsubscribe().
+  Subscription subscribe(const std::string& prefix, Callback callback);
+  void unsubscribe(Subscription subscription);
+
+private:
+  struct Subscriber {
+    Subscription id;
+    std::vector<std::string> path;
+    uint64_t hash;
+    Callback callback;
+  };
+
+  Snapshot publish(ConfigNode source);
+  // Returns once no reader can still be copying a pointer unpublished
+  // before the call.
+  void synchronize();
+
+  struct alignas(64) ReaderCount {
+    std::atomic<int64_t> value{0};
+  };
+
+  std::atomic<const Snapshot*> current_{nullptr};
+  std::atomic<uint64_t> version_{0};
+  // Readers register under the parity of epoch_ they observed.
+  std::atomic<uint64_t> epoch_{0};
+  mutable ReaderCount readers_[2];
+
+  // Guards everything below; held by writers and (un)subscribers only.
+  std::mutex mutex_;
+  ConfigNode source_;
+  std::vector<Subscriber> subscribers_;
+  Subscription next_subscription_ = 1;
+};
+
+// Structural 64-bit hash of `node`: equal trees hash equally, and a change
+// anywhere in the tree changes it with overwhelming probability.
+uint64_t hash_config(const ConfigNode& node);
+
+} // namespace hydra
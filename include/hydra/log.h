@@ -15,6 +15,67 @@
 
 #define LOG_VERSION "0.1.0"
 
+/* Longest message (after formatting) an async record can carry; longer ones
+ * are truncated. */
+#ifndef LOG_ASYNC_MESSAGE_SIZE
+#define LOG_ASYNC_MESSAGE_SIZE 480
+#endif
+
+/* Key/value field attached to a record by log_kv. */
+enum { LOG_FIELD_STRING, LOG_FIELD_INT, LOG_FIELD_DOUBLE, LOG_FIELD_BOOL };
+
+typedef struct {
+  const char* key;
+  int type;
+  union {
+    const char* s;
+    long long i;
+    double d;
+    bool b;
+  } value;
+} log_Field;
+
+static inline log_Field log_field_str(const char* key, const char* value) {
+  log_Field field;
+  field.key     = key;
+  field.type    = LOG_FIELD_STRING;
+  field.value.s = value;
+  return field;
+}
+
+static inline log_Field log_field_int(const char* key, long long value) {
+  log_Field field;
+  field.key     = key;
+  field.type    = LOG_FIELD_INT;
+  field.value.i = value;
+  return field;
+}
+
+static inline log_Field log_field_double(const char* key, double value) {
+  log_Field field;
+  field.key     = key;
+  field.type    = LOG_FIELD_DOUBLE;
+  field.value.d = value;
+  return field;
+}
+
+static inline log_Field log_field_bool(const char* key, bool value) {
+  log_Field field;
+  field.key     = key;
+  field.type    = LOG_FIELD_BOOL;
+  field.value.b = value;
+  return field;
+}
+
+/* Per-call-site state of the rate-limited macros; zero-initialized static. */
+typedef struct {
+  unsigned long long calls;
+  unsigned long long suppressed; /* since the last emitted record */
+  long long next_ns;             /* log_every_sec / log_first_n summaries */
+} log_RateState;
+
+enum { LOG_RATE_EVERY_N, LOG_RATE_FIRST_N, LOG_RATE_EVERY_SEC, LOG_RATE_SAMPLE };
+
 typedef struct {
   va_list ap;
   const char* fmt;
@@ -23,6 +84,9 @@ typedef struct {
   void* udata;
   int line;
   int level;
+  const char* logger; /* NULL for plain log_* calls */
+  const log_Field* fields;
+  size_t field_count;
 } log_Event;
 
 typedef void (*log_LogFn)(log_Event* ev);
@@ -30,25 +94,205 @@ typedef void (*log_LockFn)(bool lock, void* udata);
 
 enum { LOG_TRACE, LOG_DEBUG, LOG_INFO, LOG_WARN, LOG_ERROR, LOG_FATAL };
 
-#define log_trace(...) log_log(LOG_TRACE, __FILE__, __LINE__, __VA_ARGS__)
-#define log_debug(...) log_log(LOG_DEBUG, __FILE__, __LINE__, __VA_ARGS__)
-#define log_info(...) log_log(LOG_INFO, __FILE__, __LINE__, __VA_ARGS__)
-#define log_warn(...) log_log(LOG_WARN, __FILE__, __LINE__, __VA_ARGS__)
-#define log_error(...) log_log(LOG_ERROR, __FILE__, __LINE__, __VA_ARGS__)
-#define log_fatal(...) log_log(LOG_FATAL, __FILE__, __LINE__, __VA_ARGS__)
+/* When a built-in sink hands buffered records to the kernel. */
+enum { LOG_FLUSH_RECORD, LOG_FLUSH_INTERVAL, LOG_FLUSH_LEVEL };
+
+/* Time-based rotation of a file sink. */
+enum { LOG_ROTATE_NEVER, LOG_ROTATE_MIDNIGHT };
+
+/* What an async producer does when the queue is full. */
+enum { LOG_OVERFLOW_BLOCK, LOG_OVERFLOW_DROP };
+
+/*
+ * Calls below HYDRA_LOG_MIN_LEVEL (0 = TRACE ... 5 = FATAL) compile to
+ * nothing; their arguments are type-checked but never evaluated. Calls above
+ * it first compare against log_enabled_level, so a level no sink accepts
+ * costs one relaxed load and no argument evaluation.
+ */
+#ifndef HYDRA_LOG_MIN_LEVEL
+#define HYDRA_LOG_MIN_LEVEL 0
+#endif
+
+#define log_enabled(level)                                                     \
+  ((level) >= __atomic_load_n(&log_enabled_level, __ATOMIC_RELAXED))
+#define LOG_CALL(level, ...)                                                   \
+  (log_enabled(level) ? log_log(level, __FILE__, __LINE__, __VA_ARGS__)       \
+                      : (void)0)
+#define LOG_ELIDED(level, ...)                                                 \
+  (0 ? log_log(level, __FILE__, __LINE__, __VA_ARGS__) : (void)0)
+
+#if HYDRA_LOG_MIN_LEVEL <= 0
+#define log_trace(...) LOG_CALL(LOG_TRACE, __VA_ARGS__)
+#else
+#define log_trace(...) LOG_ELIDED(LOG_TRACE, __VA_ARGS__)
+#endif
+#if HYDRA_LOG_MIN_LEVEL <= 1
+#define log_debug(...) LOG_CALL(LOG_DEBUG, __VA_ARGS__)
+#else
+#define log_debug(...) LOG_ELIDED(LOG_DEBUG, __VA_ARGS__)
+#endif
+#if HYDRA_LOG_MIN_LEVEL <= 2
+#define log_info(...) LOG_CALL(LOG_INFO, __VA_ARGS__)
+#else
+#define log_info(...) LOG_ELIDED(LOG_INFO, __VA_ARGS__)
+#endif
+#if HYDRA_LOG_MIN_LEVEL <= 3
+#define log_warn(...) LOG_CALL(LOG_WARN, __VA_ARGS__)
+#else
+#define log_warn(...) LOG_ELIDED(LOG_WARN, __VA_ARGS__)
+#endif
+#if HYDRA_LOG_MIN_LEVEL <= 4
+#define log_error(...) LOG_CALL(LOG_ERROR, __VA_ARGS__)
+#else
+#define log_error(...) LOG_ELIDED(LOG_ERROR, __VA_ARGS__)
+#endif
+#define log_fatal(...) LOG_CALL(LOG_FATAL, __VA_ARGS__)
+
+/*
+ * Rate-limited logging, with state kept per call site:
+ *   log_every_n(level, n, ...)        the 1st, (n+1)th, (2n+1)th ... call
+ *   log_first_n(level, n, ...)        the first n calls
+ *   log_every_sec(level, seconds, ...) at most one record per interval
+ *   log_sample(level, probability, ...) each call with the given probability
+ * An emitted record carries a `suppressed` field counting the calls skipped
+ * since the previous one. Past its limit, log_first_n emits a summary of the
+ * suppressed calls at most once a minute.
+ */
+#define LOG_RATED(level, kind, arg, ...)                                       \
+  do {                                                                         \
+    static log_RateState log_rate_state_;                                      \
+    unsigned long long log_rate_suppressed_;                                   \
+    if ((level) >= HYDRA_LOG_MIN_LEVEL && log_enabled(level) &&                \
+        log_rate_admit(&log_rate_state_, kind, arg, level, __FILE__,           \
+                       __LINE__, &log_rate_suppressed_)) {                     \
+      log_log_rated(level, __FILE__, __LINE__, log_rate_suppressed_,           \
+                    __VA_ARGS__);                                              \
+    }                                                                          \
+  } while (0)
+
+#define log_every_n(level, n, ...)                                             \
+  LOG_RATED(level, LOG_RATE_EVERY_N, n, __VA_ARGS__)
+#define log_first_n(level, n, ...)                                             \
+  LOG_RATED(level, LOG_RATE_FIRST_N, n, __VA_ARGS__)
+#define log_every_sec(level, seconds, ...)                                     \
+  LOG_RATED(level, LOG_RATE_EVERY_SEC, seconds, __VA_ARGS__)
+#define log_sample(level, probability, ...)                                    \
+  LOG_RATED(level, LOG_RATE_SAMPLE, probability, __VA_ARGS__)
+
+/* log_kv(LOG_INFO, fields, count, "epoch done") attaches `count` log_Field
+ * values to the record: JSON sinks add them as members, text sinks append
+ * ` key=value`. */
+#define log_kv(level, fields, count, ...)                                      \
+  (log_enabled(level) ? log_log_kv(level, __FILE__, __LINE__, fields, count,   \
+                                   __VA_ARGS__)                                \
+                      : (void)0)
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/* Lowest level any sink, the binary handler or the recorder accepts. Maintained by log.c;
+ * read it through log_enabled(). */
+extern int log_enabled_level;
+
 const char* log_level_string(int level);
 void log_set_lock(log_LockFn fn, void* udata);
 void log_set_level(int level);
 void log_set_quiet(bool enable);
 int log_add_callback(log_LogFn fn, void* udata, int level);
 int log_add_fp(FILE* fp, int level);
+/* Sink writing one JSON object per record to `fp`: ts, level, file, line,
+ * logger (named loggers only), msg, then `count` fixed key/value string
+ * pairs from `fields` (key0, value0, key1, ...) and the log_kv fields.
+ * Remove it with log_remove_fp. */
+int log_add_json_fp(FILE* fp, int level, const char* const* fields,
+                    size_t count);
+/* Unregister a callback or a sink added with log_add_fp, writing out what the
+ * sink still buffers. The caller keeps ownership of `fp`. Adding and
+ * removing is safe while other threads log; it waits for records being
+ * delivered to finish. Do not call these from inside a callback. */
+int log_remove_callback(log_LogFn fn, void* udata);
+int log_remove_fp(FILE* fp);
+
+/*
+ * Rotate the file sink writing to `fp`, which was opened at `path`, once it
+ * holds `max_bytes` (0: no limit) and/or at local midnight
+ * (LOG_ROTATE_MIDNIGHT). The live file becomes `path`.1, older segments move
+ * up to `path`.`backup_count` (0 keeps none), and with `compress` the new
+ * segment is gzipped. A background thread does the work; producers never
+ * wait for it. Passing 0 and LOG_ROTATE_NEVER turns rotation off.
+ */
+int log_set_rotation(FILE* fp, const char* path, long long max_bytes,
+                     int backup_count, int when, bool compress);
+
+/*
+ * Flush policy of the sinks writing to `fp` (stderr selects the console):
+ * LOG_FLUSH_RECORD writes every record immediately (the default),
+ * LOG_FLUSH_INTERVAL buffers and writes at least every `arg` ms, and
+ * LOG_FLUSH_LEVEL buffers until a record at level `arg` or above arrives.
+ * Buffered records are also written by log_flush and at exit.
+ * Returns -1 if no sink writes to `fp` or the policy is invalid.
+ */
+int log_set_flush(FILE* fp, int policy, int arg);
 
 void log_log(int level, const char* file, int line, const char* fmt, ...);
+void log_log_kv(int level, const char* file, int line, const log_Field* fields,
+                size_t count, const char* fmt, ...);
+/* Back ends of the rate-limited macros: log_rate_admit decides whether this
+ * call is emitted and reports the calls suppressed since the last one. */
+bool log_rate_admit(log_RateState* state, int kind, double arg, int level,
+                    const char* file, int line,
+                    unsigned long long* suppressed);
+void log_log_rated(int level, const char* file, int line,
+                   unsigned long long suppressed, const char* fmt, ...);
+/* Record from a named logger (see hydra_logger_get). The caller has already
+ * checked the logger's level; the console prints it regardless of
+ * log_set_level and tags it with `[logger]`. */
+void log_log_named(const char* logger, int level, const char* file, int line,
+                   const char* fmt, ...);
+
+/*
+ * Async mode. log_log only copies the formatted message into a lock-free
+ * queue of `queue_size` records (rounded up to a power of two); a background
+ * thread writes them in batches. FATAL records and log_flush wait until
+ * everything queued so far is written, and the queue is drained at exit.
+ * Returns 0 on success, -1 if already running or on allocation failure.
+ * Sinks must be registered before starting.
+ */
+int log_start_async(size_t queue_size, int overflow);
+void log_stop_async(void);
+/* Waits for queued async records and writes out buffered sinks. */
+void log_flush(void);
+unsigned long long log_dropped_count(void);
+
+/*
+ * Binary handler. Records at `level` or above are additionally stored
+ * unformatted in `path`: call site, timestamp and raw argument values, kept
+ * in a per-thread buffer and written in blocks. Strings are truncated to
+ * 1024 bytes. log_decode_binary renders such a file as text in time order
+ * and returns the number of records, or -1 if it cannot be read.
+ * log_start_binary returns -1 if `path` cannot be created.
+ */
+int log_start_binary(const char* path, int level);
+void log_stop_binary(void);
+long log_decode_binary(const char* path, FILE* out);
+
+/*
+ * Flight recorder. The last `records_per_thread` records at `level` or above
+ * of every thread (up to 64 threads) are kept formatted in memory, truncated
+ * to 240 bytes. With a `path` the rings are a shared mapping of that file,
+ * which survives a crash; with NULL they are anonymous memory. On SIGSEGV,
+ * SIGBUS, SIGFPE, SIGILL and SIGABRT the rings are written as text, headed
+ * by `label` (e.g. a config hash), to `path`.dump or stderr before the
+ * signal is passed on. log_dump_recorder writes the same text to `fd`, and
+ * log_decode_recorder renders a recorder file like log_decode_binary.
+ * log_start_recorder returns -1 if the rings cannot be created.
+ */
+int log_start_recorder(const char* path, size_t records_per_thread, int level,
+                       const char* label);
+void log_stop_recorder(void);
+int log_dump_recorder(int fd);
+long log_decode_recorder(const char* path, FILE* out);
 
 #ifdef __cplusplus
 }
@@ -7,6 +7,78 @@
 extern "C" {
 #endif
 
+/**
+ * Named logger handle. `level` is the effective level resolved from
+ * hydra.job_logging.loggers: the entry for the name itself or, failing that,
+ * its nearest dotted ancestor ("trainer" for "trainer.data"), then
+ * hydra.job_logging.root.level. It is refreshed by every init_logging call;
+ * read it through hydra_logger_enabled().
+ */
+typedef struct hydra_logger {
+  const char* name;
+  int level;
+} hydra_logger_t;
+
+/**
+ * Get the logger called `name`, creating it on first use. Handles live until
+ * exit and the same name always returns the same handle, so callers can
+ * cache it in a static.
+ *
+ * @param name Dotted logger name, e.g. "trainer.data"
+ * @return Logger handle, or NULL if name is NULL or allocation fails
+ */
+hydra_logger_t* hydra_logger_get(const char* name);
+
+#define hydra_logger_enabled(logger, lvl)                                      \
+  ((lvl) >= __atomic_load_n(&(logger)->level, __ATOMIC_RELAXED))
+#define HYDRA_LOGGER_CALL(logger, lvl, ...)                                    \
+  (hydra_logger_enabled(logger, lvl)                                           \
+       ? log_log_named((logger)->name, lvl, __FILE__, __LINE__, __VA_ARGS__)   \
+       : (void)0)
+#define HYDRA_LOGGER_ELIDED(logger, lvl, ...)                                  \
+  (0 ? log_log_named((logger)->name, lvl, __FILE__, __LINE__, __VA_ARGS__)     \
+     : (void)0)
+
+/* Logger counterparts of log_trace ... log_fatal, honoring
+ * HYDRA_LOG_MIN_LEVEL the same way. */
+#if HYDRA_LOG_MIN_LEVEL <= 0
+#define hydra_log_trace(logger, ...)                                           \
+  HYDRA_LOGGER_CALL(logger, LOG_TRACE, __VA_ARGS__)
+#else
+#define hydra_log_trace(logger, ...)                                           \
+  HYDRA_LOGGER_ELIDED(logger, LOG_TRACE, __VA_ARGS__)
+#endif
+#if HYDRA_LOG_MIN_LEVEL <= 1
+#define hydra_log_debug(logger, ...)                                           \
+  HYDRA_LOGGER_CALL(logger, LOG_DEBUG, __VA_ARGS__)
+#else
+#define hydra_log_debug(logger, ...)                                           \
+  HYDRA_LOGGER_ELIDED(logger, LOG_DEBUG, __VA_ARGS__)
+#endif
+#if HYDRA_LOG_MIN_LEVEL <= 2
+#define hydra_log_info(logger, ...)                                            \
+  HYDRA_LOGGER_CALL(logger, LOG_INFO, __VA_ARGS__)
+#else
+#define hydra_log_info(logger, ...)                                            \
+  HYDRA_LOGGER_ELIDED(logger, LOG_INFO, __VA_ARGS__)
+#endif
+#if HYDRA_LOG_MIN_LEVEL <= 3
+#define hydra_log_warn(logger, ...)                                            \
+  HYDRA_LOGGER_CALL(logger, LOG_WARN, __VA_ARGS__)
+#else
+#define hydra_log_warn(logger, ...)                                            \
+  HYDRA_LOGGER_ELIDED(logger, LOG_WARN, __VA_ARGS__)
+#endif
+#if HYDRA_LOG_MIN_LEVEL <= 4
+#define hydra_log_error(logger, ...)                                           \
+  HYDRA_LOGGER_CALL(logger, LOG_ERROR, __VA_ARGS__)
+#else
+#define hydra_log_error(logger, ...)                                           \
+  HYDRA_LOGGER_ELIDED(logger, LOG_ERROR, __VA_ARGS__)
+#endif
+#define hydra_log_fatal(logger, ...)                                           \
+  HYDRA_LOGGER_CALL(logger, LOG_FATAL, __VA_ARGS__)
+
 /**
  * Initialize Hydra logging system from configuration.
  *
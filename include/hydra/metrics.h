@@ -0,0 +1,67 @@
+#pragma once
+
+#include "hydra/c_api.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Scalar metrics writer. Records (step, metric, value) are appended to a
+ * bounded in-memory batch; a background thread writes full batches, and
+ * whatever is pending at least once a second, to the run directory:
+ *
+ *   metrics.bin  "HYDRAMET" u32 version, then one block per batch:
+ *                u32 count, i64 step[count], u32 metric[count],
+ *                f64 value[count] (native byte order)
+ *   metrics.csv  "step,name,value" header, one line per record
+ *
+ * Metric names are interned to dense ids (0, 1, ...) in first-use order and
+ * listed, id order, under `names` in <run_dir>/.hydra/metrics.yaml next to
+ * the saved config. When a batch is full the writing thread waits for the
+ * background thread, so no record is dropped. All functions may be called
+ * from several threads at once.
+ */
+typedef struct hydra_metrics hydra_metrics_t;
+
+typedef enum hydra_metrics_format {
+  HYDRA_METRICS_BINARY = 0,
+  HYDRA_METRICS_CSV    = 1
+} hydra_metrics_format_t;
+
+/*
+ * Creates <run_dir>/metrics.{bin,csv} (and <run_dir>/.hydra) and starts the
+ * background writer. `batch_records` of 0 selects 65536.
+ */
+hydra_metrics_t* hydra_metrics_open(const char* run_dir,
+                                    hydra_metrics_format_t format,
+                                    size_t batch_records,
+                                    char** error_message);
+/* As hydra_metrics_open with hydra.run.dir, hydra.metrics.format ("binary"
+ * or "csv") and hydra.metrics.batch_records from `config`. */
+hydra_metrics_t* hydra_metrics_open_config(const hydra_config_t* config,
+                                           char** error_message);
+
+/* Id of `name`, registering it on first use; -1 on invalid arguments. */
+int32_t hydra_metrics_intern(hydra_metrics_t* metrics, const char* name);
+/* Appends a record for an id returned by hydra_metrics_intern. */
+hydra_status_t hydra_metrics_write(hydra_metrics_t* metrics, int64_t step,
+                                   int32_t metric, double value);
+/* hydra_metrics_intern followed by hydra_metrics_write. */
+hydra_status_t hydra_metrics_log(hydra_metrics_t* metrics, int64_t step,
+                                 const char* name, double value);
+
+/* Waits until every record appended so far is written. */
+hydra_status_t hydra_metrics_flush(hydra_metrics_t* metrics,
+                                   char** error_message);
+/* Flushes, stops the writer and releases `metrics`; reports the first write
+ * error, if any. */
+hydra_status_t hydra_metrics_close(hydra_metrics_t* metrics,
+                                   char** error_message);
+
+#ifdef __cplusplus
+}
+#endif
@@ -14,6 +14,8 @@ struct Override {
 };
 
 std::vector<std::string> parse_override_path(const std::string& expression);
+// Inverse of parse_override_path: joins with '.', escaping '.' and '\\'.
+std::string format_override_path(const std::vector<std::string>& path);
 Override parse_override(const std::string& expression);
 
 } // namespace hydra
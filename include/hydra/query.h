@@ -0,0 +1,52 @@
+#pragma once
+
+#include "hydra/c_api.h"
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Compiled path query; see hydra/query.hpp for the expression syntax. A
+ * query is compiled once and may then run over any number of configs, from
+ * several threads at once.
+ */
+typedef struct hydra_query hydra_query_t;
+
+/*
+ * Called with each match: its canonical path ("" for the root) and value, as
+ * hydra_config_get_many describes them. Both are valid only during the call.
+ * Return non-zero to continue, 0 to stop.
+ */
+typedef int (*hydra_query_visitor_t)(const char* path,
+                                     const hydra_value_t* value,
+                                     void* user_data);
+
+/* HYDRA_STATUS_PARSE_ERROR (returning NULL) when `expression` does not parse. */
+hydra_query_t* hydra_query_compile(const char* expression,
+                                   char** error_message);
+
+/*
+ * Visits the matches in `config` (as resolved by hydra_initialize) in
+ * document order, in a single traversal. `visit` may be NULL to only count;
+ * `match_count`, if not NULL, receives the number of matches visited.
+ */
+hydra_status_t hydra_query_run(const hydra_query_t* query,
+                               const hydra_config_t* config,
+                               hydra_query_visitor_t visit, void* user_data,
+                               size_t* match_count, char** error_message);
+
+/* Compiles `expression` and runs it once. */
+hydra_status_t hydra_config_select(const hydra_config_t* config,
+                                   const char* expression,
+                                   hydra_query_visitor_t visit,
+                                   void* user_data, size_t* match_count,
+                                   char** error_message);
+
+void hydra_query_destroy(hydra_query_t* query);
+
+#ifdef __cplusplus
+}
+#endif
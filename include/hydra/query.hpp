@@ -0,0 +1,76 @@
+#pragma once
+
+#include "hydra/config_node.hpp"
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace hydra {
+
+// Path queries over a config tree.
+//
+//   model.layers.*.units          units of every layer
+//   datasets[*].path              path of every dataset
+//   **.lr                         every `lr`, at any depth
+//   model.layers[1:-1]            all layers but the first and the last
+//   model.layers[::2].name        every other layer
+//   trainer.stages[?epochs>10]    stages whose `epochs` is above 10
+//   **[?type=='conv'].kernel      kernel of every mapping with type conv
+//
+// Segments are separated by '.' (write '\.' for a literal dot) and are one
+// of:
+//
+//   name        the child with that key; on a sequence, a decimal index
+//   *           every child of a mapping (key order) or sequence
+//   **          the node itself and all of its descendants
+//   [N]         sequence element N; negative N counts from the end
+//   [a:b:s]     Python-style slice of a sequence; every part is optional
+//   [*]         same as *
+//   ['key']     the child with that key, which may contain '.' or ']'
+//   [?p]        every child for which the predicate holds: `p` is a
+//               relative path, true when the child has it, or `p OP value`
+//               with OP one of == != < <= > >= and value a number,
+//               true/false/null or a quoted string. Numbers compare with
+//               numbers, strings with strings.
+//
+// Any number of bracket segments may follow a name without a '.'. An empty
+// expression selects the root. Compiling parses the expression once into a
+// list of steps; evaluation walks the tree depth first, carrying only the
+// current path, and hands each match to the caller as it is found, in
+// document order. A Query is cheap to copy and may run from several threads
+// at once.
+class Query {
+public:
+  // Called with each match and its path from the root (sequence indices in
+  // decimal); return false to stop.
+  using Visitor = std::function<bool(const std::vector<std::string>& path,
+                                     const ConfigNode& node)>;
+
+  // Throws std::runtime_error naming the offending position when
+  // `expression` does not parse.
+  static Query compile(std::string_view expression);
+
+  const std::string& expression() const;
+
+  // Visits the matches below `root`; returns false if `visit` stopped early.
+  bool for_each(const ConfigNode& root, const Visitor& visit) const;
+  // The matches, in document order.
+  std::vector<const ConfigNode*> select(const ConfigNode& root) const;
+
+  struct Step;
+
+private:
+  struct Compiled;
+  explicit Query(std::shared_ptr<const Compiled> compiled);
+
+  std::shared_ptr<const Compiled> compiled_;
+};
+
+// Query::compile(expression).select(root).
+std::vector<const ConfigNode*> select(const ConfigNode& root,
+                                      std::string_view expression);
+
+} // namespace hydra
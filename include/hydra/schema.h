@@ -0,0 +1,34 @@
+#pragma once
+
+#include "hydra/c_api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Compiled config schema; see hydra/schema.hpp for the schema format. A
+ * schema is compiled once and may then validate any number of configs, from
+ * several threads at once.
+ */
+typedef struct hydra_schema hydra_schema_t;
+
+hydra_schema_t* hydra_schema_compile_file(const char* path,
+                                          char** error_message);
+hydra_schema_t* hydra_schema_compile_string(const char* yaml,
+                                            char** error_message);
+
+/*
+ * Checks `config` (as resolved by hydra_initialize) in a single pass.
+ * Returns HYDRA_STATUS_OK when it conforms, otherwise HYDRA_STATUS_ERROR with
+ * every violation in `error_message`, one "path: message" per line.
+ */
+hydra_status_t hydra_schema_validate(const hydra_schema_t* schema,
+                                     const hydra_config_t* config,
+                                     char** error_message);
+
+void hydra_schema_destroy(hydra_schema_t* schema);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "hydra/config_node.hpp"
+
+#include <filesystem>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace hydra {
+
+// Declarative validation of resolved configs.
+//
+//   trainer:
+//     batch_size: {type: int, min: 1, max: 4096}
+//     optimizer: {type: string, enum: [adam, sgd]}
+//     learning_rate: {type: double, min: 0.0}
+//     tags: {type: sequence, items: {type: string}, required: false}
+//   model:
+//     name: {type: string, pattern: "[a-z0-9_]+"}
+//
+// A mapping whose `type` is a string is a rule; any other mapping describes
+// a nested mapping whose keys are rules in turn (`{type: mapping, fields:
+// {...}}` spelled out). Rule keys:
+//
+//   type      any, null, bool, int, double (accepts ints), string,
+//             sequence or mapping
+//   required  false lets the key be absent (default true)
+//   nullable  true also accepts null (default false)
+//   min, max  inclusive bounds for numbers
+//   enum      the allowed scalar values
+//   pattern   ECMAScript regex the whole string must match
+//   items     rule for every sequence element
+//   fields    rules for the keys of a mapping
+//
+// Keys without a rule are accepted. Compiling checks the schema itself, sorts
+// the fields and builds the regexes once; validate() then walks the config in
+// a single pass, visiting each mapping's keys alongside the sorted rules, and
+// reports every violation. A Schema is cheap to copy and may validate from
+// several threads at once.
+class SchemaError : public std::runtime_error {
+public:
+  explicit SchemaError(std::vector<std::string> errors);
+
+  // One "path: message" entry per violation.
+  const std::vector<std::string>& errors() const { return errors_; }
+
+private:
+  std::vector<std::string> errors_;
+};
+
+class Schema {
+public:
+  // Throws std::runtime_error naming the offending rule when `spec` is not a
+  // valid schema.
+  static Schema compile(const ConfigNode& spec);
+  static Schema load_file(const std::filesystem::path& path);
+
+  // Every violation in `config`, empty when it conforms.
+  std::vector<std::string> validate(const ConfigNode& config) const;
+  // Throws SchemaError listing every violation.
+  void check(const ConfigNode& config) const;
+
+  struct Rule;
+
+private:
+  explicit Schema(std::shared_ptr<const Rule> root);
+
+  std::shared_ptr<const Rule> root_;
+};
+
+} // namespace hydra
@@ -1,9 +1,13 @@
 #pragma once
 
+#include <chrono>
 #include <string>
 
 namespace hydra {
 
+// strftime(`format`) of `time` in local time.
+std::string format_time(const std::string& format,
+                        std::chrono::system_clock::time_point time);
 std::string format_now(const std::string& format);
 
-}
+} // namespace hydra
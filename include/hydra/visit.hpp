@@ -0,0 +1,137 @@
+#pragma once
+
+#include "hydra/config_node.hpp"
+
+#include <cstddef>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+// Single-dispatch access to ConfigNode.
+//
+// visit() calls the overload of `visitor` that takes the node's value, one of
+//
+//   std::nullptr_t, bool, int64_t, double, std::string,
+//   ConfigNode::seq_t, ConfigNode::map_t
+//
+// (const references for a const node), chosen by one jump on the variant
+// index rather than a chain of is_*() tests:
+//
+//   std::string text = hydra::visit(node, hydra::overloaded{
+//       [](const ConfigNode::map_t& map) { return ...; },
+//       [](const ConfigNode::seq_t& seq) { return ...; },
+//       [](const auto& scalar) { return ...; }});
+//
+// Every overload must return the same type. A `const auto&` overload
+// catches whatever the others do not.
+//
+// walk() visits a tree depth first, mapping entries in key order, calling
+// `pre` before a node's children and `post` after them. Both get the path
+// from the root as a WalkPath, a view of one buffer the walk grows and
+// shrinks as it moves, so visiting a node allocates nothing; copy what must
+// outlive the call. `pre` may return a WalkAction to skip a subtree or stop.
+
+namespace hydra {
+
+template <typename... Fs> struct overloaded : Fs... {
+  using Fs::operator()...;
+};
+template <typename... Fs> overloaded(Fs...) -> overloaded<Fs...>;
+
+template <typename Visitor>
+decltype(auto) visit(const ConfigNode& node, Visitor&& visitor) {
+  return std::visit(std::forward<Visitor>(visitor), node.variant());
+}
+
+template <typename Visitor>
+decltype(auto) visit(ConfigNode& node, Visitor&& visitor) {
+  return std::visit(std::forward<Visitor>(visitor), node.variant());
+}
+
+// One step below a node: the entry `*key` of a mapping, or element `index`
+// of a sequence (key == nullptr).
+struct PathSegment {
+  const std::string* key = nullptr;
+  size_t index           = 0;
+};
+
+using WalkPath = std::span<const PathSegment>;
+
+// The components find_path takes, sequence indices in decimal.
+std::vector<std::string> path_components(WalkPath path);
+
+enum class WalkAction {
+  Continue,     // visit the children
+  SkipChildren, // go on with the next sibling (post still runs)
+  Stop,         // end the walk
+};
+
+namespace detail {
+
+template <typename Node, typename Pre, typename Post>
+bool walk_node(Node& node, std::vector<PathSegment>& path, Pre& pre,
+               Post& post) {
+  WalkAction action = WalkAction::Continue;
+  if constexpr (std::is_void_v<std::invoke_result_t<Pre&, WalkPath, Node&>>) {
+    pre(WalkPath(path), node);
+  } else {
+    action = pre(WalkPath(path), node);
+  }
+  if (action == WalkAction::Stop) {
+    return false;
+  }
+  if (action == WalkAction::Continue) {
+    bool finished = visit(node, [&](auto& value) {
+      using T = std::remove_cvref_t<decltype(value)>;
+      if constexpr (std::is_same_v<T, ConfigNode::map_t>) {
+        for (auto& [key, child] : value) {
+          path.push_back({&key, 0});
+          bool keep_going = walk_node(child, path, pre, post);
+          path.pop_back();
+          if (!keep_going) {
+            return false;
+          }
+        }
+      } else if constexpr (std::is_same_v<T, ConfigNode::seq_t>) {
+        for (size_t i = 0; i < value.size(); ++i) {
+          path.push_back({nullptr, i});
+          bool keep_going = walk_node(value[i], path, pre, post);
+          path.pop_back();
+          if (!keep_going) {
+            return false;
+          }
+        }
+      }
+      return true;
+    });
+    if (!finished) {
+      return false;
+    }
+  }
+  post(WalkPath(path), node);
+  return true;
+}
+
+} // namespace detail
+
+// Walks `root` (a ConfigNode or const ConfigNode); returns false if `pre`
+// stopped it.
+template <typename Node, typename Pre, typename Post>
+  requires std::is_same_v<std::remove_const_t<Node>, ConfigNode>
+bool walk(Node& root, Pre&& pre, Post&& post) {
+  std::vector<PathSegment> path;
+  path.reserve(16);
+  return detail::walk_node(root, path, pre, post);
+}
+
+template <typename Node, typename Pre>
+  requires std::is_same_v<std::remove_const_t<Node>, ConfigNode>
+bool walk(Node& root, Pre&& pre) {
+  auto post = [](WalkPath, Node&) {};
+  return walk(root, pre, post);
+}
+
+} // namespace hydra
@@ -3,11 +3,32 @@
 #include "hydra/config_node.hpp"
 
 #include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <string>
 
 namespace hydra {
 
+// Files loaded by load_yaml_file (defaults lists applied), keyed by
+// normalized path, for composing many configs from the same tree. Files are
+// assumed not to change while cached. Safe to share between threads.
+class YamlFileCache {
+public:
+  std::shared_ptr<const ConfigNode>
+  find(const std::filesystem::path& normalized) const;
+  void insert(const std::filesystem::path& normalized, ConfigNode node);
+  void clear();
+
+private:
+  mutable std::mutex mutex_;
+  std::map<std::filesystem::path, std::shared_ptr<const ConfigNode>> entries_;
+};
+
 ConfigNode load_yaml_file(const std::filesystem::path& path);
+// As above, reading `path` and every file it includes through `cache`.
+ConfigNode load_yaml_file(const std::filesystem::path& path,
+                          YamlFileCache& cache);
 ConfigNode load_yaml_string(const std::string& content,
                             const std::string& name = "<string>");
 
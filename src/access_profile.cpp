@@ -0,0 +1,291 @@
+#include "hydra/access_profile.hpp"
+
+#include "c_api_internal.hpp"
+#include "hydra/c_api_utils.h"
+#include "hydra/overrides.hpp"
+#include "hydra/visit.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <utility>
+#include <variant>
+
+namespace hydra {
+
+namespace detail {
+
+std::atomic<bool> access_tracking{false};
+
+} // namespace detail
+
+namespace {
+
+namespace fs = std::filesystem;
+
+struct Tracker {
+  std::mutex mutex;
+  std::set<std::vector<std::string>> paths;
+  // Written by the exit handler record_access_profile installs.
+  fs::path run_dir;
+};
+
+// Leaked so that it outlives the exit handler.
+Tracker& tracker() {
+  static auto* instance = new Tracker();
+  return *instance;
+}
+
+void write_at_exit() {
+  fs::path run_dir;
+  {
+    std::lock_guard<std::mutex> lock(tracker().mutex);
+    run_dir = tracker().run_dir;
+  }
+  try {
+    write_access_profile(run_dir);
+  } catch (...) {
+    // Nothing can report the failure this late.
+  }
+}
+
+// Profiled paths as a tree; `whole` marks a path whose subtree is kept.
+struct Selection {
+  bool whole = false;
+  std::map<std::string, Selection> children;
+};
+
+ConfigNode project_node(const ConfigNode& node, const Selection& selection) {
+  if (selection.whole || !node.is_mapping()) {
+    return node;
+  }
+  ConfigNode result           = make_mapping();
+  ConfigNode::map_t& out      = result.as_mapping();
+  const ConfigNode::map_t& in = node.as_mapping();
+  for (const auto& [key, child] : selection.children) {
+    auto it = in.find(key);
+    if (it != in.end()) {
+      out.emplace(key, project_node(it->second, child));
+    }
+  }
+  return result;
+}
+
+bool selected(const Selection& root, const std::vector<std::string>& path) {
+  const Selection* selection = &root;
+  for (const std::string& component : path) {
+    if (selection->whole) {
+      return true;
+    }
+    auto it = selection->children.find(component);
+    if (it == selection->children.end()) {
+      return false;
+    }
+    selection = &it->second;
+  }
+  return selection->whole;
+}
+
+// Targets of the ${path} references in the strings below `node`; ${now:...}
+// and ${oc.env:...} refer to nothing in the tree.
+void collect_references(const ConfigNode& node,
+                        std::vector<std::vector<std::string>>& out) {
+  walk(node, [&](WalkPath, const ConfigNode& child) {
+    const auto* value = std::get_if<std::string>(&child.variant());
+    if (value == nullptr) {
+      return;
+    }
+    for (size_t start = value->find("${"); start != std::string::npos;
+         start        = value->find("${", start + 2)) {
+      size_t end = value->find('}', start + 2);
+      if (end == std::string::npos) {
+        return;
+      }
+      std::string expression = value->substr(start + 2, end - (start + 2));
+      if (expression.rfind("now:", 0) == 0 ||
+          expression.rfind("oc.env:", 0) == 0) {
+        continue;
+      }
+      try {
+        out.push_back(parse_override_path(expression));
+      } catch (const std::exception&) {
+        // Resolution reports it.
+      }
+    }
+  });
+}
+
+} // namespace
+
+namespace detail {
+
+void record_access(const std::vector<std::string>& path) {
+  for (const std::string& component : path) {
+    if (component.empty()) {
+      return; // not expressible as a path expression
+    }
+  }
+  std::lock_guard<std::mutex> lock(tracker().mutex);
+  tracker().paths.insert(path);
+}
+
+} // namespace detail
+
+void set_access_tracking(bool enabled) {
+  detail::access_tracking.store(enabled, std::memory_order_relaxed);
+}
+
+std::vector<std::vector<std::string>> tracked_paths() {
+  std::lock_guard<std::mutex> lock(tracker().mutex);
+  return {tracker().paths.begin(), tracker().paths.end()};
+}
+
+void clear_tracked_paths() {
+  std::lock_guard<std::mutex> lock(tracker().mutex);
+  tracker().paths.clear();
+}
+
+fs::path write_access_profile(const fs::path& run_dir) {
+  fs::path hydra_dir = run_dir / ".hydra";
+  fs::create_directories(hydra_dir);
+  fs::path file = hydra_dir / "access_profile";
+  AccessProfile profile(tracked_paths());
+  std::ofstream out(file, std::ios::trunc);
+  for (const auto& path : profile.paths()) {
+    out << format_override_path(path) << '\n';
+  }
+  if (!out.good()) {
+    throw std::runtime_error("Failed to write access profile: " +
+                             file.string());
+  }
+  return file;
+}
+
+void record_access_profile(const fs::path& run_dir) {
+  static std::once_flag registered;
+  {
+    std::lock_guard<std::mutex> lock(tracker().mutex);
+    tracker().run_dir = run_dir;
+  }
+  set_access_tracking(true);
+  std::call_once(registered, [] { std::atexit(write_at_exit); });
+}
+
+void configure_access_tracking(const ConfigNode& config) {
+  const ConfigNode* record =
+      find_path(config, {"hydra", "access_profile", "record"});
+  const ConfigNode* run_dir = find_path(config, {"hydra", "run", "dir"});
+  if (record != nullptr && record->is_bool() && record->as_bool() &&
+      run_dir != nullptr && run_dir->is_string()) {
+    record_access_profile(run_dir->as_string());
+  }
+}
+
+AccessProfile::AccessProfile(std::vector<std::vector<std::string>> paths)
+    : paths_(std::move(paths)) {
+  std::sort(paths_.begin(), paths_.end());
+  // Sorted, a path directly follows the nearest path it lies below.
+  std::vector<std::vector<std::string>> kept;
+  for (auto& path : paths_) {
+    if (!kept.empty() && kept.back().size() <= path.size() &&
+        std::equal(kept.back().begin(), kept.back().end(), path.begin())) {
+      continue;
+    }
+    kept.push_back(std::move(path));
+  }
+  paths_ = std::move(kept);
+}
+
+AccessProfile AccessProfile::load_file(const fs::path& path) {
+  std::ifstream in(path);
+  if (!in) {
+    throw std::runtime_error("Failed to open access profile: " +
+                             path.string());
+  }
+  std::vector<std::vector<std::string>> paths;
+  std::string line;
+  while (std::getline(in, line)) {
+    if (line.empty()) {
+      paths.emplace_back(); // the root
+    } else {
+      paths.push_back(parse_override_path(line));
+    }
+  }
+  return AccessProfile(std::move(paths));
+}
+
+ConfigNode AccessProfile::project(const ConfigNode& config) const {
+  Selection root;
+  std::vector<std::vector<std::string>> wanted = paths_;
+  wanted.push_back({"hydra"});
+  size_t added = 0;
+  while (true) {
+    for (size_t i = added; i < wanted.size(); ++i) {
+      Selection* selection = &root;
+      for (const std::string& component : wanted[i]) {
+        if (selection->whole) {
+          break;
+        }
+        selection = &selection->children[component];
+      }
+      selection->whole = true;
+    }
+    added = wanted.size();
+
+    // Keep what the kept interpolations refer to, until nothing new is.
+    ConfigNode result = project_node(config, root);
+    std::vector<std::vector<std::string>> references;
+    collect_references(result, references);
+    for (auto& reference : references) {
+      if (!selected(root, reference)) {
+        wanted.push_back(std::move(reference));
+      }
+    }
+    if (wanted.size() == added) {
+      return result;
+    }
+  }
+}
+
+void fill_missing(ConfigNode& destination, const ConfigNode& source) {
+  if (!destination.is_mapping() || !source.is_mapping()) {
+    return;
+  }
+  ConfigNode::map_t& out = destination.as_mapping();
+  for (const auto& [key, value] : source.as_mapping()) {
+    auto it = out.find(key);
+    if (it == out.end()) {
+      out.emplace(key, value);
+    } else {
+      fill_missing(it->second, value);
+    }
+  }
+}
+
+} // namespace hydra
+
+extern "C" {
+
+void hydra_access_tracking(int enabled) {
+  hydra::set_access_tracking(enabled != 0);
+}
+
+hydra_status_t hydra_access_profile_write(const char* run_dir,
+                                          char** error_message) {
+  if (run_dir == nullptr) {
+    return hydra::capi::fail(error_message, HYDRA_STATUS_INVALID_ARGUMENT,
+                             "Run directory is null");
+  }
+  try {
+    hydra::write_access_profile(run_dir);
+    return HYDRA_STATUS_OK;
+  } catch (const std::exception& ex) {
+    return hydra::capi::fail(error_message, HYDRA_STATUS_IO_ERROR, ex.what());
+  }
+}
+
+} // extern "C"
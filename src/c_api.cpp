@@ -1,12 +1,16 @@
 #include "hydra/c_api.h"
 
+#include "c_api_internal.hpp"
+#include "hydra/access_profile.hpp"
 #include "hydra/config_node.hpp"
 #include "hydra/config_utils.hpp"
 #include "hydra/interpolation.hpp"
 #include "hydra/overrides.hpp"
+#include "hydra/visit.hpp"
 #include "hydra/yaml_emitter.hpp"
 #include "hydra/yaml_loader.hpp"
 
+#include <algorithm>
 #include <cstdlib>
 #include <cstring>
 #include <filesystem>
@@ -17,10 +21,6 @@
 #include <utility>
 #include <vector>
 
-struct hydra_config {
-  hydra::ConfigNode node;
-};
-
 struct hydra_config_iter {
   enum class Kind { Sequence, Mapping } kind;
   std::string base_path;
@@ -33,70 +33,179 @@ struct hydra_config_iter {
 
 namespace {
 
-char* dup_string(const std::string& value) {
-  char* buffer = static_cast<char*>(std::malloc(value.size() + 1));
-  if (buffer == nullptr) {
-    return nullptr;
-  }
-  std::memcpy(buffer, value.data(), value.size());
-  buffer[value.size()] = '\0';
-  return buffer;
-}
+// Per-thread copy of the most recent failure. Fixed-size so that recording an
+// error never allocates; messages longer than the buffer are truncated.
+constexpr size_t kLastErrorCapacity = 512;
+
+thread_local char last_error_message[kLastErrorCapacity] = "";
+thread_local hydra_status_t last_error_status            = HYDRA_STATUS_OK;
+
+} // namespace
 
-void assign_error(char** error_out, const std::string& message) {
+hydra_status_t hydra::capi::fail(char** error_out, hydra_status_t status,
+                                 std::string_view message) {
+  size_t length = std::min(message.size(), kLastErrorCapacity - 1);
+  std::memcpy(last_error_message, message.data(), length);
+  last_error_message[length] = '\0';
+  last_error_status          = status;
   if (error_out != nullptr) {
     *error_out = dup_string(message);
   }
+  return status;
 }
 
-void ensure_resolved(hydra_config_t* config) {
-  if (config != nullptr) {
-    resolve_interpolations(config->node);
+bool hydra::capi::materialize(const hydra_config_t* config) {
+  hydra_config_t* owner = owner_of(config);
+  if (!owner->materialize || is_frozen(owner)) {
+    return false;
+  }
+  std::function<hydra::ConfigNode()> compose_full =
+      std::move(owner->materialize);
+  owner->materialize = nullptr;
+  try {
+    hydra::fill_missing(owner->node, compose_full());
+    owner->resolved = false;
+  } catch (const std::exception&) {
+    return false; // the lookup reports the miss
   }
+  return true;
 }
 
-std::vector<std::string> parse_path(const char* expression) {
-  if (expression == nullptr) {
-    throw std::runtime_error("Path expression is null");
+void hydra::capi::ensure_resolved(const hydra_config_t* config) {
+  if (config == nullptr || is_frozen(config)) {
+    return;
+  }
+  // Views resolve through their owner: a subtree may interpolate keys that
+  // live outside it.
+  hydra_config_t* owner = owner_of(config);
+  if (owner->resolved) {
+    return;
   }
-  return hydra::parse_override_path(expression);
+  hydra::resolve_interpolations(owner->node);
+  owner->resolved = true;
 }
 
-const hydra::ConfigNode* locate(const hydra_config_t* config,
-                                const char* path_expression) {
-  if (config == nullptr) {
-    throw std::runtime_error("Config is null");
+hydra_value_t hydra::capi::describe(const hydra::ConfigNode& node) {
+  hydra_value_t value{};
+  hydra::overloaded fill{
+      [&](std::nullptr_t) { value.type = HYDRA_VALUE_NULL; },
+      [&](bool flag) {
+        value.type       = HYDRA_VALUE_BOOL;
+        value.as.boolean = flag ? 1 : 0;
+      },
+      [&](int64_t integer) {
+        value.type       = HYDRA_VALUE_INT;
+        value.as.integer = integer;
+      },
+      [&](double real) {
+        value.type    = HYDRA_VALUE_DOUBLE;
+        value.as.real = real;
+      },
+      [&](const std::string& text) {
+        value.type             = HYDRA_VALUE_STRING;
+        value.as.string.data   = text.c_str();
+        value.as.string.length = text.size();
+      },
+      [&](const hydra::ConfigNode::seq_t& sequence) {
+        value.type    = HYDRA_VALUE_SEQUENCE;
+        value.as.size = sequence.size();
+      },
+      [&](const hydra::ConfigNode::map_t& mapping) {
+        value.type    = HYDRA_VALUE_MAPPING;
+        value.as.size = mapping.size();
+      },
+  };
+  hydra::visit(node, fill);
+  return value;
+}
+
+namespace {
+
+using hydra::capi::dup_string;
+using hydra::capi::ensure_resolved;
+using hydra::capi::fail;
+
+// Records `path` below the config's root, as seen from the owner's root.
+void track(const hydra_config_t* config, const std::vector<std::string>& path) {
+  if (!hydra::access_tracking_enabled()) {
+    return;
+  }
+  if (!hydra::capi::is_view(config)) {
+    hydra::detail::record_access(path);
+    return;
   }
-  std::vector<std::string> path = parse_path(path_expression);
-  return hydra::find_path(config->node, path);
+  std::vector<std::string> full = config->view_path;
+  full.insert(full.end(), path.begin(), path.end());
+  hydra::detail::record_access(full);
 }
 
-std::string escape_path_segment(const std::string& value) {
-  std::string escaped;
-  escaped.reserve(value.size());
-  for (char ch : value) {
-    if (ch == '.' || ch == '\\') {
-      escaped.push_back('\\');
+// The node at `path` below the config's root. A miss in a config composed
+// with an access profile loads the rest of the config and looks again.
+const hydra::ConfigNode* find_in(const hydra_config_t* config,
+                                 const std::vector<std::string>& path) {
+  track(config, path);
+  auto walk = [&] {
+    const hydra::ConfigNode* node = &hydra::capi::root_of(config);
+    for (const auto& component : path) {
+      node = hydra::find_child(*node, component);
+      if (node == nullptr) {
+        break;
+      }
     }
-    escaped.push_back(ch);
+    return node;
+  };
+  const hydra::ConfigNode* node = walk();
+  if (node == nullptr && hydra::capi::materialize(config)) {
+    node = walk();
   }
-  return escaped;
+  return node;
 }
 
-std::string build_path_expression(const std::vector<std::string>& components) {
-  if (components.empty()) {
-    return "";
+// Mutators refuse frozen configs and views; the returned status is what they
+// should hand back, HYDRA_STATUS_OK meaning the write may proceed.
+hydra_status_t reject_if_immutable(const hydra_config_t* config,
+                                   char** error_out) {
+  if (hydra::capi::is_view(config)) {
+    return fail(error_out, HYDRA_STATUS_INVALID_ARGUMENT,
+                "Config views are read-only");
   }
-  std::string rendered;
-  bool first = true;
-  for (const auto& component : components) {
-    if (!first) {
-      rendered.push_back('.');
-    }
-    rendered += escape_path_segment(component);
-    first = false;
+  if (hydra::capi::is_frozen(config)) {
+    return fail(error_out, HYDRA_STATUS_FROZEN, "Config is frozen");
+  }
+  return HYDRA_STATUS_OK;
+}
+
+// Walks a path expression and reports the outcome in *status only, without
+// setting hydra_last_error(), so probing for an optional key costs only the
+// parse and the lookup. The path is still tracked for access profiles and a
+// miss completes a profiled config (see find_in). An empty expression
+// addresses the root.
+const hydra::ConfigNode* find_node(const hydra_config_t* config,
+                                   const char* path_expression,
+                                   hydra_status_t* status) {
+  if (path_expression == nullptr) {
+    *status = HYDRA_STATUS_INVALID_ARGUMENT;
+    return nullptr;
+  }
+  if (path_expression[0] == '\0') {
+    track(config, {});
+    *status = HYDRA_STATUS_OK;
+    return &hydra::capi::root_of(config);
+  }
+  std::vector<std::string> path;
+  try {
+    path = hydra::parse_override_path(path_expression);
+  } catch (const std::runtime_error&) {
+    *status = HYDRA_STATUS_INVALID_ARGUMENT;
+    return nullptr;
   }
-  return rendered;
+  const hydra::ConfigNode* node = find_in(config, path);
+  *status = node != nullptr ? HYDRA_STATUS_OK : HYDRA_STATUS_NOT_FOUND;
+  return node;
+}
+
+std::string escape_path_segment(const std::string& value) {
+  return hydra::format_override_path({value});
 }
 
 std::string append_segment(const std::string& base,
@@ -116,23 +225,96 @@ std::string append_segment(const std::string& base,
   return combined;
 }
 
-const hydra::ConfigNode*
-locate_with_rendered(const hydra_config_t* config, const char* path_expression,
-                     std::string& rendered_expression) {
-  if (config == nullptr) {
-    throw std::runtime_error("Config is null");
+// Like find_node, but records a NOT_FOUND / INVALID_ARGUMENT failure and can
+// render the canonical form of the path for iterators.
+hydra_status_t lookup(const hydra_config_t* config, const char* path_expression,
+                      const hydra::ConfigNode** out_node, char** error_out,
+                      std::string* rendered_expression = nullptr) {
+  *out_node = nullptr;
+  if (path_expression == nullptr) {
+    return fail(error_out, HYDRA_STATUS_INVALID_ARGUMENT,
+                "Path expression is null");
+  }
+  if (path_expression[0] == '\0') {
+    if (rendered_expression != nullptr) {
+      rendered_expression->clear();
+    }
+    track(config, {});
+    *out_node = &hydra::capi::root_of(config);
+    return HYDRA_STATUS_OK;
+  }
+  std::vector<std::string> path;
+  try {
+    path = hydra::parse_override_path(path_expression);
+  } catch (const std::runtime_error& ex) {
+    return fail(error_out, HYDRA_STATUS_INVALID_ARGUMENT, ex.what());
+  }
+  if (rendered_expression != nullptr) {
+    *rendered_expression = hydra::format_override_path(path);
+  }
+  *out_node = find_in(config, path);
+  if (*out_node == nullptr) {
+    return fail(error_out, HYDRA_STATUS_NOT_FOUND,
+                "Requested node does not exist");
   }
-  if (path_expression == nullptr || path_expression[0] == '\0') {
-    rendered_expression.clear();
-    return &config->node;
+  return HYDRA_STATUS_OK;
+}
+
+void collect_leaves(const hydra::ConfigNode& node, const std::string& path,
+                    std::vector<std::string>& paths,
+                    std::vector<hydra_value_t>& values) {
+  if (node.is_mapping() && !node.as_mapping().empty()) {
+    for (const auto& [key, child] : node.as_mapping()) {
+      collect_leaves(child, append_segment(path, key), paths, values);
+    }
+    return;
+  }
+  if (node.is_sequence() && !node.as_sequence().empty()) {
+    const auto& sequence = node.as_sequence();
+    for (size_t i = 0; i < sequence.size(); ++i) {
+      collect_leaves(sequence[i], append_segment(path, std::to_string(i)),
+                     paths, values);
+    }
+    return;
   }
-  std::vector<std::string> path = parse_path(path_expression);
-  rendered_expression           = build_path_expression(path);
-  return hydra::find_path(config->node, path);
+  paths.push_back(path);
+  values.push_back(hydra::capi::describe(node));
 }
 
 } // namespace
 
+const char* hydra_last_error(void) {
+  return last_error_message;
+}
+
+hydra_status_t hydra_last_status(void) {
+  return last_error_status;
+}
+
+const char* hydra_status_string(hydra_status_t status) {
+  switch (status) {
+  case HYDRA_STATUS_OK:
+    return "ok";
+  case HYDRA_STATUS_ERROR:
+    return "error";
+  case HYDRA_STATUS_NOT_FOUND:
+    return "not found";
+  case HYDRA_STATUS_TYPE_MISMATCH:
+    return "type mismatch";
+  case HYDRA_STATUS_PARSE_ERROR:
+    return "parse error";
+  case HYDRA_STATUS_INVALID_ARGUMENT:
+    return "invalid argument";
+  case HYDRA_STATUS_OUT_OF_MEMORY:
+    return "out of memory";
+  case HYDRA_STATUS_IO_ERROR:
+    return "I/O error";
+  case HYDRA_STATUS_FROZEN:
+    return "config is frozen";
+  }
+  return "unknown status";
+}
+
 hydra_config_t* hydra_config_create(void) {
   try {
     hydra_config* cfg = new hydra_config();
@@ -149,25 +331,39 @@ void hydra_config_destroy(hydra_config_t* config) {
 
 hydra_status_t hydra_config_clear(hydra_config_t* config) {
   if (config == nullptr) {
-    return HYDRA_STATUS_ERROR;
+    return fail(nullptr, HYDRA_STATUS_INVALID_ARGUMENT, "Config is null");
+  }
+  if (hydra_status_t status = reject_if_immutable(config, nullptr);
+      status != HYDRA_STATUS_OK) {
+    return status;
   }
-  config->node = hydra::make_mapping();
+  config->node     = hydra::make_mapping();
+  config->resolved = false;
   return HYDRA_STATUS_OK;
 }
 
 hydra_status_t hydra_config_merge_file(hydra_config_t* config, const char* path,
                                        char** error_message) {
   if (config == nullptr || path == nullptr) {
-    assign_error(error_message, "Config or path is null");
-    return HYDRA_STATUS_ERROR;
+    return fail(error_message, HYDRA_STATUS_INVALID_ARGUMENT,
+                "Config or path is null");
+  }
+  if (hydra_status_t status = reject_if_immutable(config, error_message);
+      status != HYDRA_STATUS_OK) {
+    return status;
+  }
+  std::error_code ec;
+  if (!std::filesystem::exists(path, ec)) {
+    return fail(error_message, HYDRA_STATUS_IO_ERROR,
+                std::string("Failed to open YAML file '") + path + "'");
   }
   try {
     hydra::ConfigNode loaded = hydra::load_yaml_file(path);
     hydra::merge(config->node, loaded);
+    config->resolved = false;
     return HYDRA_STATUS_OK;
   } catch (const std::exception& ex) {
-    assign_error(error_message, ex.what());
-    return HYDRA_STATUS_ERROR;
+    return fail(error_message, HYDRA_STATUS_PARSE_ERROR, ex.what());
   }
 }
 
@@ -176,8 +372,12 @@ hydra_status_t hydra_config_merge_string(hydra_config_t* config,
                                          const char* name,
                                          char** error_message) {
   if (config == nullptr || yaml_content == nullptr) {
-    assign_error(error_message, "Config or YAML content is null");
-    return HYDRA_STATUS_ERROR;
+    return fail(error_message, HYDRA_STATUS_INVALID_ARGUMENT,
+                "Config or YAML content is null");
+  }
+  if (hydra_status_t status = reject_if_immutable(config, error_message);
+      status != HYDRA_STATUS_OK) {
+    return status;
   }
   try {
     std::string source_name =
@@ -185,10 +385,10 @@ hydra_status_t hydra_config_merge_string(hydra_config_t* config,
     hydra::ConfigNode loaded =
         hydra::load_yaml_string(yaml_content, source_name);
     hydra::merge(config->node, loaded);
+    config->resolved = false;
     return HYDRA_STATUS_OK;
   } catch (const std::exception& ex) {
-    assign_error(error_message, ex.what());
-    return HYDRA_STATUS_ERROR;
+    return fail(error_message, HYDRA_STATUS_PARSE_ERROR, ex.what());
   }
 }
 
@@ -196,20 +396,65 @@ hydra_status_t hydra_config_apply_override(hydra_config_t* config,
                                            const char* expression,
                                            char** error_message) {
   if (config == nullptr || expression == nullptr) {
-    assign_error(error_message, "Config or override expression is null");
-    return HYDRA_STATUS_ERROR;
+    return fail(error_message, HYDRA_STATUS_INVALID_ARGUMENT,
+                "Config or override expression is null");
+  }
+  if (hydra_status_t status = reject_if_immutable(config, error_message);
+      status != HYDRA_STATUS_OK) {
+    return status;
   }
+  hydra::Override ov;
   try {
-    hydra::Override ov = hydra::parse_override(expression);
+    ov = hydra::parse_override(expression);
+  } catch (const std::exception& ex) {
+    return fail(error_message, HYDRA_STATUS_PARSE_ERROR, ex.what());
+  }
+  try {
+    if (config->materialize && !ov.require_new &&
+        hydra::find_path(config->node, ov.path) == nullptr) {
+      hydra::capi::materialize(config);
+    }
+    config->resolved = false;
     hydra::assign_path(config->node, ov.path, std::move(ov.value),
                        ov.require_new);
     return HYDRA_STATUS_OK;
   } catch (const std::exception& ex) {
-    assign_error(error_message, ex.what());
-    return HYDRA_STATUS_ERROR;
+    bool missing =
+        !ov.require_new && hydra::find_path(config->node, ov.path) == nullptr;
+    return fail(error_message,
+                missing ? HYDRA_STATUS_NOT_FOUND : HYDRA_STATUS_ERROR,
+                ex.what());
+  }
+}
+
+hydra_status_t hydra_config_freeze(hydra_config_t* config,
+                                   char** error_message) {
+  if (config == nullptr) {
+    return fail(error_message, HYDRA_STATUS_INVALID_ARGUMENT,
+                "Config is null");
+  }
+  if (hydra::capi::is_view(config)) {
+    return fail(error_message, HYDRA_STATUS_INVALID_ARGUMENT,
+                "Freeze the config a view was taken from, not the view");
+  }
+  if (hydra::capi::is_frozen(config)) {
+    return HYDRA_STATUS_OK;
+  }
+  try {
+    hydra::capi::materialize(config);
+    hydra::resolve_interpolations(config->node);
+    config->resolved = true;
+    config->frozen.store(true, std::memory_order_release);
+    return HYDRA_STATUS_OK;
+  } catch (const std::exception& ex) {
+    return fail(error_message, HYDRA_STATUS_ERROR, ex.what());
   }
 }
 
+int hydra_config_is_frozen(const hydra_config_t* config) {
+  return hydra::capi::is_frozen(config) ? 1 : 0;
+}
+
 hydra_status_t hydra_config_subnode(hydra_config_t* config,
                                     const char* path_expression,
                                     hydra_config_t** out_subconfig,
@@ -218,33 +463,71 @@ hydra_status_t hydra_config_subnode(hydra_config_t* config,
     *out_subconfig = nullptr;
   }
   if (config == nullptr || out_subconfig == nullptr) {
-    assign_error(error_message, "Config or output pointer is null");
-    return HYDRA_STATUS_ERROR;
+    return fail(error_message, HYDRA_STATUS_INVALID_ARGUMENT,
+                "Config or output pointer is null");
   }
   try {
     ensure_resolved(config);
     const hydra::ConfigNode* source = nullptr;
-    if (path_expression == nullptr || path_expression[0] == '\0') {
-      source = &config->node;
-    } else {
-      source = locate(config, path_expression);
-    }
-    if (source == nullptr) {
-      assign_error(error_message, "Requested node does not exist");
-      return HYDRA_STATUS_ERROR;
+    hydra_status_t status =
+        lookup(config, path_expression != nullptr ? path_expression : "",
+               &source, error_message);
+    if (status != HYDRA_STATUS_OK) {
+      return status;
     }
 
     hydra_config_t* child = hydra_config_create();
     if (child == nullptr) {
-      assign_error(error_message, "Failed to allocate config");
-      return HYDRA_STATUS_ERROR;
+      return fail(error_message, HYDRA_STATUS_OUT_OF_MEMORY,
+                  "Failed to allocate config");
     }
     child->node    = hydra::deep_copy(*source);
     *out_subconfig = child;
     return HYDRA_STATUS_OK;
   } catch (const std::exception& ex) {
-    assign_error(error_message, ex.what());
-    return HYDRA_STATUS_ERROR;
+    return fail(error_message, HYDRA_STATUS_ERROR, ex.what());
+  }
+}
+
+hydra_status_t hydra_config_view(const hydra_config_t* config,
+                                 const char* path_expression,
+                                 hydra_config_t** out_view,
+                                 char** error_message) {
+  if (out_view != nullptr) {
+    *out_view = nullptr;
+  }
+  if (config == nullptr || out_view == nullptr) {
+    return fail(error_message, HYDRA_STATUS_INVALID_ARGUMENT,
+                "Config or output pointer is null");
+  }
+  // No resolution here: it only rewrites string leaves, never the shape of
+  // the tree, so the subtree found now is the one readers will resolve later.
+  try {
+    std::vector<std::string> path;
+    if (path_expression != nullptr && path_expression[0] != '\0') {
+      try {
+        path = hydra::parse_override_path(path_expression);
+      } catch (const std::runtime_error& ex) {
+        return fail(error_message, HYDRA_STATUS_INVALID_ARGUMENT, ex.what());
+      }
+    }
+    const hydra::ConfigNode* root = find_in(config, path);
+    if (root == nullptr) {
+      return fail(error_message, HYDRA_STATUS_NOT_FOUND,
+                  "Requested node does not exist");
+    }
+    auto view       = std::make_unique<hydra_config>();
+    view->owner     = hydra::capi::owner_of(config);
+    view->root      = root;
+    view->view_path = config->view_path;
+    view->view_path.insert(view->view_path.end(), path.begin(), path.end());
+    *out_view = view.release();
+    return HYDRA_STATUS_OK;
+  } catch (const std::bad_alloc&) {
+    return fail(error_message, HYDRA_STATUS_OUT_OF_MEMORY,
+                "Failed to allocate config view");
+  } catch (const std::exception& ex) {
+    return fail(error_message, HYDRA_STATUS_ERROR, ex.what());
   }
 }
 
@@ -254,9 +537,9 @@ int hydra_config_has(const hydra_config_t* config,
     return 0;
   }
   try {
-    hydra_config_t* mutable_config = const_cast<hydra_config_t*>(config);
-    ensure_resolved(mutable_config);
-    return locate(config, path_expression) != nullptr;
+    ensure_resolved(config);
+    hydra_status_t status = HYDRA_STATUS_OK;
+    return find_node(config, path_expression, &status) != nullptr;
   } catch (...) {
     return 0;
   }
@@ -270,22 +553,22 @@ hydra_status_t hydra_config_sequence_iter(const hydra_config_t* config,
     *out_iter = nullptr;
   }
   if (config == nullptr || out_iter == nullptr) {
-    assign_error(error_message, "Config or iterator output is null");
-    return HYDRA_STATUS_ERROR;
+    return fail(error_message, HYDRA_STATUS_INVALID_ARGUMENT,
+                "Config or iterator output is null");
   }
   try {
-    hydra_config_t* mutable_config = const_cast<hydra_config_t*>(config);
-    ensure_resolved(mutable_config);
+    ensure_resolved(config);
     std::string rendered_path;
-    const hydra::ConfigNode* node =
-        locate_with_rendered(config, path_expression, rendered_path);
-    if (node == nullptr) {
-      assign_error(error_message, "Requested node does not exist");
-      return HYDRA_STATUS_ERROR;
+    const hydra::ConfigNode* node = nullptr;
+    hydra_status_t status =
+        lookup(config, path_expression != nullptr ? path_expression : "",
+               &node, error_message, &rendered_path);
+    if (status != HYDRA_STATUS_OK) {
+      return status;
     }
     if (!node->is_sequence()) {
-      assign_error(error_message, "Requested node is not a sequence");
-      return HYDRA_STATUS_ERROR;
+      return fail(error_message, HYDRA_STATUS_TYPE_MISMATCH,
+                  "Requested node is not a sequence");
     }
     hydra_config_iter* iter = new hydra_config_iter();
     iter->kind              = hydra_config_iter::Kind::Sequence;
@@ -295,8 +578,7 @@ hydra_status_t hydra_config_sequence_iter(const hydra_config_t* config,
     *out_iter               = iter;
     return HYDRA_STATUS_OK;
   } catch (const std::exception& ex) {
-    assign_error(error_message, ex.what());
-    return HYDRA_STATUS_ERROR;
+    return fail(error_message, HYDRA_STATUS_ERROR, ex.what());
   }
 }
 
@@ -308,22 +590,22 @@ hydra_status_t hydra_config_map_iter(const hydra_config_t* config,
     *out_iter = nullptr;
   }
   if (config == nullptr || out_iter == nullptr) {
-    assign_error(error_message, "Config or iterator output is null");
-    return HYDRA_STATUS_ERROR;
+    return fail(error_message, HYDRA_STATUS_INVALID_ARGUMENT,
+                "Config or iterator output is null");
   }
   try {
-    hydra_config_t* mutable_config = const_cast<hydra_config_t*>(config);
-    ensure_resolved(mutable_config);
+    ensure_resolved(config);
     std::string rendered_path;
-    const hydra::ConfigNode* node =
-        locate_with_rendered(config, path_expression, rendered_path);
-    if (node == nullptr) {
-      assign_error(error_message, "Requested node does not exist");
-      return HYDRA_STATUS_ERROR;
+    const hydra::ConfigNode* node = nullptr;
+    hydra_status_t status =
+        lookup(config, path_expression != nullptr ? path_expression : "",
+               &node, error_message, &rendered_path);
+    if (status != HYDRA_STATUS_OK) {
+      return status;
     }
     if (!node->is_mapping()) {
-      assign_error(error_message, "Requested node is not a mapping");
-      return HYDRA_STATUS_ERROR;
+      return fail(error_message, HYDRA_STATUS_TYPE_MISMATCH,
+                  "Requested node is not a mapping");
     }
     hydra_config_iter* iter = new hydra_config_iter();
     iter->kind              = hydra_config_iter::Kind::Mapping;
@@ -335,13 +617,20 @@ hydra_status_t hydra_config_map_iter(const hydra_config_t* config,
     *out_iter               = iter;
     return HYDRA_STATUS_OK;
   } catch (const std::exception& ex) {
-    assign_error(error_message, ex.what());
-    return HYDRA_STATUS_ERROR;
+    return fail(error_message, HYDRA_STATUS_ERROR, ex.what());
   }
 }
 
 int hydra_config_iter_next(hydra_config_iter_t* iter, char** child_path,
                            char** key, size_t* index, char** error_message) {
+  return hydra_config_iter_next_arena(iter, nullptr, child_path, key, index,
+                                      error_message);
+}
+
+int hydra_config_iter_next_arena(hydra_config_iter_t* iter,
+                                 hydra_arena_t* arena, char** child_path,
+                                 char** key, size_t* index,
+                                 char** error_message) {
   if (child_path != nullptr) {
     *child_path = nullptr;
   }
@@ -355,7 +644,7 @@ int hydra_config_iter_next(hydra_config_iter_t* iter, char** child_path,
     *error_message = nullptr;
   }
   if (iter == nullptr) {
-    assign_error(error_message, "Iterator is null");
+    fail(error_message, HYDRA_STATUS_INVALID_ARGUMENT, "Iterator is null");
     return -1;
   }
 
@@ -363,9 +652,9 @@ int hydra_config_iter_next(hydra_config_iter_t* iter, char** child_path,
     if (target == nullptr) {
       return true;
     }
-    char* copy = dup_string(value);
+    char* copy = dup_string(value, arena);
     if (copy == nullptr) {
-      assign_error(error_message, "Out of memory");
+      fail(error_message, HYDRA_STATUS_OUT_OF_MEMORY, "Out of memory");
       return false;
     }
     *target = copy;
@@ -402,7 +691,7 @@ int hydra_config_iter_next(hydra_config_iter_t* iter, char** child_path,
     return -1;
   }
   if (!assign_string(key, entry_key)) {
-    if (child_path != nullptr) {
+    if (child_path != nullptr && arena == nullptr) {
       hydra_string_free(*child_path);
       *child_path = nullptr;
     }
@@ -420,13 +709,17 @@ hydra_status_t hydra_config_apply_cli(hydra_config_t* config, int argc,
                                       hydra_cli_overrides_t* captured_overrides,
                                       char** error_message) {
   if (config == nullptr) {
-    assign_error(error_message, "Config is null");
-    return HYDRA_STATUS_ERROR;
+    return fail(error_message, HYDRA_STATUS_INVALID_ARGUMENT,
+                "Config is null");
   }
 
   if (error_message != nullptr) {
     *error_message = nullptr;
   }
+  if (hydra_status_t status = reject_if_immutable(config, error_message);
+      status != HYDRA_STATUS_OK) {
+    return status;
+  }
   if (captured_overrides != nullptr) {
     captured_overrides->items = nullptr;
     captured_overrides->count = 0;
@@ -444,8 +737,8 @@ hydra_status_t hydra_config_apply_cli(hydra_config_t* config, int argc,
     } else if (std::strcmp(arg, "--config") == 0 ||
                std::strcmp(arg, "-c") == 0) {
       if (i + 1 >= argc) {
-        assign_error(error_message, "--config requires an argument");
-        return HYDRA_STATUS_ERROR;
+        return fail(error_message, HYDRA_STATUS_INVALID_ARGUMENT,
+                    "--config requires an argument");
       }
       config_paths.emplace_back(argv[++i]);
     } else {
@@ -474,29 +767,30 @@ hydra_status_t hydra_config_apply_cli(hydra_config_t* config, int argc,
   }
 
   if (captured_overrides != nullptr && !overrides.empty()) {
-    captured_overrides->items =
-        static_cast<char**>(std::malloc(sizeof(char*) * overrides.size()));
+    captured_overrides->items = static_cast<char**>(
+        hydra::capi::allocate(sizeof(char*) * overrides.size()));
     if (captured_overrides->items == nullptr) {
-      assign_error(error_message, "Out of memory while capturing overrides");
-      return HYDRA_STATUS_ERROR;
+      return fail(error_message, HYDRA_STATUS_OUT_OF_MEMORY,
+                  "Out of memory while capturing overrides");
     }
     captured_overrides->count = overrides.size();
     for (size_t i = 0; i < overrides.size(); ++i) {
       captured_overrides->items[i] = dup_string(overrides[i]);
       if (captured_overrides->items[i] == nullptr) {
-        assign_error(error_message, "Out of memory while capturing overrides");
         for (size_t j = 0; j < i; ++j) {
           hydra_string_free(captured_overrides->items[j]);
         }
-        std::free(captured_overrides->items);
+        hydra::capi::release(captured_overrides->items);
         captured_overrides->items = nullptr;
         captured_overrides->count = 0;
-        return HYDRA_STATUS_ERROR;
+        return fail(error_message, HYDRA_STATUS_OUT_OF_MEMORY,
+                    "Out of memory while capturing overrides");
       }
     }
   }
 
   // Set job name from program name if not already set
+  config->resolved = false;
   try {
     const hydra::ConfigNode* job_name_node =
         hydra::find_path(config->node, {"hydra", "job", "name"});
@@ -512,18 +806,17 @@ hydra_status_t hydra_config_apply_cli(hydra_config_t* config, int argc,
                          hydra::make_string(job_name), false);
     }
   } catch (const std::exception& ex) {
-    assign_error(error_message,
-                 std::string("Failed to set job name: ") + ex.what());
-    return HYDRA_STATUS_ERROR;
+    return fail(error_message, HYDRA_STATUS_ERROR,
+                std::string("Failed to set job name: ") + ex.what());
   }
 
   // Resolve interpolations after loading all configs and overrides
   try {
     hydra::resolve_interpolations(config->node);
+    config->resolved = true;
   } catch (const std::exception& ex) {
-    assign_error(error_message,
-                 std::string("Failed to resolve interpolations: ") + ex.what());
-    return HYDRA_STATUS_ERROR;
+    return fail(error_message, HYDRA_STATUS_ERROR,
+                std::string("Failed to resolve interpolations: ") + ex.what());
   }
 
   return HYDRA_STATUS_OK;
@@ -533,22 +826,25 @@ hydra_status_t hydra_config_get_bool(const hydra_config_t* config,
                                      const char* path_expression,
                                      int* out_value, char** error_message) {
   if (config == nullptr || out_value == nullptr) {
-    assign_error(error_message, "Config or output pointer is null");
-    return HYDRA_STATUS_ERROR;
+    return fail(error_message, HYDRA_STATUS_INVALID_ARGUMENT,
+                "Config or output pointer is null");
   }
   try {
-    hydra_config_t* mutable_config = const_cast<hydra_config_t*>(config);
-    ensure_resolved(mutable_config);
-    const hydra::ConfigNode* node = locate(config, path_expression);
-    if (node == nullptr || !node->is_bool()) {
-      assign_error(error_message, "Requested node is not a bool");
-      return HYDRA_STATUS_ERROR;
+    ensure_resolved(config);
+    const hydra::ConfigNode* node = nullptr;
+    hydra_status_t status =
+        lookup(config, path_expression, &node, error_message);
+    if (status != HYDRA_STATUS_OK) {
+      return status;
+    }
+    if (!node->is_bool()) {
+      return fail(error_message, HYDRA_STATUS_TYPE_MISMATCH,
+                  "Requested node is not a bool");
     }
     *out_value = node->as_bool() ? 1 : 0;
     return HYDRA_STATUS_OK;
   } catch (const std::exception& ex) {
-    assign_error(error_message, ex.what());
-    return HYDRA_STATUS_ERROR;
+    return fail(error_message, HYDRA_STATUS_ERROR, ex.what());
   }
 }
 
@@ -556,26 +852,25 @@ hydra_status_t hydra_config_get_int(const hydra_config_t* config,
                                     const char* path_expression,
                                     int64_t* out_value, char** error_message) {
   if (config == nullptr || out_value == nullptr) {
-    assign_error(error_message, "Config or output pointer is null");
-    return HYDRA_STATUS_ERROR;
+    return fail(error_message, HYDRA_STATUS_INVALID_ARGUMENT,
+                "Config or output pointer is null");
   }
   try {
-    hydra_config_t* mutable_config = const_cast<hydra_config_t*>(config);
-    ensure_resolved(mutable_config);
-    const hydra::ConfigNode* node = locate(config, path_expression);
-    if (node == nullptr) {
-      assign_error(error_message, "Requested node does not exist");
-      return HYDRA_STATUS_ERROR;
-    }
-    if (node->is_int()) {
-      *out_value = node->as_int();
-      return HYDRA_STATUS_OK;
+    ensure_resolved(config);
+    const hydra::ConfigNode* node = nullptr;
+    hydra_status_t status =
+        lookup(config, path_expression, &node, error_message);
+    if (status != HYDRA_STATUS_OK) {
+      return status;
     }
-    assign_error(error_message, "Requested node is not an integer");
-    return HYDRA_STATUS_ERROR;
+    if (!node->is_int()) {
+      return fail(error_message, HYDRA_STATUS_TYPE_MISMATCH,
+                  "Requested node is not an integer");
+    }
+    *out_value = node->as_int();
+    return HYDRA_STATUS_OK;
   } catch (const std::exception& ex) {
-    assign_error(error_message, ex.what());
-    return HYDRA_STATUS_ERROR;
+    return fail(error_message, HYDRA_STATUS_ERROR, ex.what());
   }
 }
 
@@ -584,60 +879,277 @@ hydra_status_t hydra_config_get_double(const hydra_config_t* config,
                                        double* out_value,
                                        char** error_message) {
   if (config == nullptr || out_value == nullptr) {
-    assign_error(error_message, "Config or output pointer is null");
-    return HYDRA_STATUS_ERROR;
+    return fail(error_message, HYDRA_STATUS_INVALID_ARGUMENT,
+                "Config or output pointer is null");
   }
   try {
-    hydra_config_t* mutable_config = const_cast<hydra_config_t*>(config);
-    ensure_resolved(mutable_config);
-    const hydra::ConfigNode* node = locate(config, path_expression);
-    if (node == nullptr) {
-      assign_error(error_message, "Requested node does not exist");
-      return HYDRA_STATUS_ERROR;
-    }
-    if (node->is_double() || node->is_int()) {
-      *out_value = node->as_double();
-      return HYDRA_STATUS_OK;
+    ensure_resolved(config);
+    const hydra::ConfigNode* node = nullptr;
+    hydra_status_t status =
+        lookup(config, path_expression, &node, error_message);
+    if (status != HYDRA_STATUS_OK) {
+      return status;
+    }
+    if (!node->is_double() && !node->is_int()) {
+      return fail(error_message, HYDRA_STATUS_TYPE_MISMATCH,
+                  "Requested node is not numeric");
     }
-    assign_error(error_message, "Requested node is not numeric");
-    return HYDRA_STATUS_ERROR;
+    *out_value = node->as_double();
+    return HYDRA_STATUS_OK;
   } catch (const std::exception& ex) {
-    assign_error(error_message, ex.what());
-    return HYDRA_STATUS_ERROR;
+    return fail(error_message, HYDRA_STATUS_ERROR, ex.what());
   }
 }
 
 hydra_status_t hydra_config_get_string(const hydra_config_t* config,
                                        const char* path_expression,
                                        char** out_value, char** error_message) {
+  return hydra_config_get_string_arena(config, path_expression, nullptr,
+                                       out_value, error_message);
+}
+
+hydra_status_t hydra_config_get_string_arena(const hydra_config_t* config,
+                                             const char* path_expression,
+                                             hydra_arena_t* arena,
+                                             char** out_value,
+                                             char** error_message) {
   if (config == nullptr || out_value == nullptr) {
-    assign_error(error_message, "Config or output pointer is null");
-    return HYDRA_STATUS_ERROR;
+    return fail(error_message, HYDRA_STATUS_INVALID_ARGUMENT,
+                "Config or output pointer is null");
   }
   try {
-    hydra_config_t* mutable_config = const_cast<hydra_config_t*>(config);
-    ensure_resolved(mutable_config);
-    const hydra::ConfigNode* node = locate(config, path_expression);
-    if (node == nullptr) {
-      assign_error(error_message, "Requested node does not exist");
-      return HYDRA_STATUS_ERROR;
+    ensure_resolved(config);
+    const hydra::ConfigNode* node = nullptr;
+    hydra_status_t status =
+        lookup(config, path_expression, &node, error_message);
+    if (status != HYDRA_STATUS_OK) {
+      return status;
     }
     if (!node->is_string()) {
-      assign_error(error_message, "Requested node is not a string");
-      return HYDRA_STATUS_ERROR;
+      return fail(error_message, HYDRA_STATUS_TYPE_MISMATCH,
+                  "Requested node is not a string");
     }
-    *out_value = dup_string(node->as_string());
+    *out_value = dup_string(node->as_string(), arena);
     if (*out_value == nullptr) {
-      assign_error(error_message, "Out of memory");
-      return HYDRA_STATUS_ERROR;
+      return fail(error_message, HYDRA_STATUS_OUT_OF_MEMORY, "Out of memory");
+    }
+    return HYDRA_STATUS_OK;
+  } catch (const std::exception& ex) {
+    return fail(error_message, HYDRA_STATUS_ERROR, ex.what());
+  }
+}
+
+int hydra_config_get_bool_or_default(const hydra_config_t* config,
+                                     const char* path_expression,
+                                     int default_value) {
+  if (config == nullptr) {
+    return default_value;
+  }
+  try {
+    ensure_resolved(config);
+    hydra_status_t status         = HYDRA_STATUS_OK;
+    const hydra::ConfigNode* node = find_node(config, path_expression, &status);
+    if (node == nullptr || !node->is_bool()) {
+      return default_value;
+    }
+    return node->as_bool() ? 1 : 0;
+  } catch (...) {
+    return default_value;
+  }
+}
+
+int64_t hydra_config_get_int_or_default(const hydra_config_t* config,
+                                        const char* path_expression,
+                                        int64_t default_value) {
+  if (config == nullptr) {
+    return default_value;
+  }
+  try {
+    ensure_resolved(config);
+    hydra_status_t status         = HYDRA_STATUS_OK;
+    const hydra::ConfigNode* node = find_node(config, path_expression, &status);
+    if (node == nullptr || !node->is_int()) {
+      return default_value;
+    }
+    return node->as_int();
+  } catch (...) {
+    return default_value;
+  }
+}
+
+double hydra_config_get_double_or_default(const hydra_config_t* config,
+                                          const char* path_expression,
+                                          double default_value) {
+  if (config == nullptr) {
+    return default_value;
+  }
+  try {
+    ensure_resolved(config);
+    hydra_status_t status         = HYDRA_STATUS_OK;
+    const hydra::ConfigNode* node = find_node(config, path_expression, &status);
+    if (node == nullptr || (!node->is_double() && !node->is_int())) {
+      return default_value;
+    }
+    return node->as_double();
+  } catch (...) {
+    return default_value;
+  }
+}
+
+const char* hydra_config_get_string_or_default(const hydra_config_t* config,
+                                               const char* path_expression,
+                                               const char* default_value) {
+  if (config == nullptr) {
+    return default_value;
+  }
+  try {
+    ensure_resolved(config);
+    hydra_status_t status         = HYDRA_STATUS_OK;
+    const hydra::ConfigNode* node = find_node(config, path_expression, &status);
+    if (node == nullptr || !node->is_string()) {
+      return default_value;
+    }
+    return node->as_string().c_str();
+  } catch (...) {
+    return default_value;
+  }
+}
+
+hydra_status_t hydra_config_get_many(const hydra_config_t* config,
+                                     const char* const* paths, size_t count,
+                                     hydra_value_t* out_values,
+                                     char** error_message) {
+  if (config == nullptr ||
+      (count > 0 && (paths == nullptr || out_values == nullptr))) {
+    return fail(error_message, HYDRA_STATUS_INVALID_ARGUMENT,
+                "Config, paths or output array is null");
+  }
+  try {
+    ensure_resolved(config);
+    hydra_status_t result = HYDRA_STATUS_OK;
+    std::vector<std::vector<std::string>> parsed(count);
+    std::vector<size_t> order;
+    order.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+      out_values[i]      = hydra_value_t{};
+      out_values[i].type = HYDRA_VALUE_MISSING;
+      if (paths[i] == nullptr) {
+        result = fail(error_message, HYDRA_STATUS_INVALID_ARGUMENT,
+                      "Path expression is null");
+        continue;
+      }
+      if (paths[i][0] != '\0') {
+        try {
+          parsed[i] = hydra::parse_override_path(paths[i]);
+        } catch (const std::runtime_error& ex) {
+          result = fail(error_message, HYDRA_STATUS_INVALID_ARGUMENT,
+                        ex.what());
+          continue;
+        }
+      }
+      track(config, parsed[i]);
+      order.push_back(i);
+    }
+
+    // Sorted, paths sharing a prefix are adjacent; `walked[k]` is the node
+    // reached after k components of the previous path, so each lookup only
+    // walks the components it does not share with its predecessor.
+    std::sort(order.begin(), order.end(),
+              [&](size_t a, size_t b) { return parsed[a] < parsed[b]; });
+    std::vector<const hydra::ConfigNode*> walked{
+        &hydra::capi::root_of(config)};
+    const std::vector<std::string>* previous = nullptr;
+    bool missed                              = false;
+    for (size_t index : order) {
+      const auto& path = parsed[index];
+      size_t shared    = 0;
+      if (previous != nullptr) {
+        size_t limit = std::min(path.size(), walked.size() - 1);
+        while (shared < limit && path[shared] == (*previous)[shared]) {
+          ++shared;
+        }
+      }
+      walked.resize(shared + 1);
+      const hydra::ConfigNode* node = walked.back();
+      for (size_t k = shared; k < path.size() && node != nullptr; ++k) {
+        node = hydra::find_child(*node, path[k]);
+        if (node != nullptr) {
+          walked.push_back(node);
+        }
+      }
+      previous = &path;
+      if (node != nullptr) {
+        out_values[index] = hydra::capi::describe(*node);
+      } else {
+        missed = true;
+      }
+    }
+    if (missed && hydra::capi::materialize(config)) {
+      return hydra_config_get_many(config, paths, count, out_values,
+                                   error_message);
+    }
+    return result;
+  } catch (const std::exception& ex) {
+    return fail(error_message, HYDRA_STATUS_ERROR, ex.what());
+  }
+}
+
+hydra_status_t hydra_config_flatten(const hydra_config_t* config,
+                                    hydra_config_flat_t* out_flat,
+                                    char** error_message) {
+  if (out_flat != nullptr) {
+    *out_flat = hydra_config_flat_t{};
+  }
+  if (config == nullptr || out_flat == nullptr) {
+    return fail(error_message, HYDRA_STATUS_INVALID_ARGUMENT,
+                "Config or output pointer is null");
+  }
+  try {
+    ensure_resolved(config);
+    std::vector<std::string> paths;
+    std::vector<hydra_value_t> values;
+    collect_leaves(hydra::capi::root_of(config), "", paths, values);
+
+    // Values, path pointers and path characters share one block so that the
+    // whole export is a single allocation (and a single free).
+    size_t text_bytes = 0;
+    for (const auto& path : paths) {
+      text_bytes += path.size() + 1;
     }
+    size_t values_bytes = sizeof(hydra_value_t) * values.size();
+    size_t paths_bytes  = sizeof(const char*) * paths.size();
+    char* block         = static_cast<char*>(
+        hydra::capi::allocate(values_bytes + paths_bytes + text_bytes));
+    if (block == nullptr) {
+      return fail(error_message, HYDRA_STATUS_OUT_OF_MEMORY,
+                  "Out of memory while flattening config");
+    }
+    auto* out_values = reinterpret_cast<hydra_value_t*>(block);
+    auto* out_paths  = reinterpret_cast<const char**>(block + values_bytes);
+    char* text       = block + values_bytes + paths_bytes;
+    for (size_t i = 0; i < paths.size(); ++i) {
+      out_values[i] = values[i];
+      std::memcpy(text, paths[i].c_str(), paths[i].size() + 1);
+      out_paths[i] = text;
+      text += paths[i].size() + 1;
+    }
+    out_flat->values = out_values;
+    out_flat->paths  = out_paths;
+    out_flat->count  = paths.size();
     return HYDRA_STATUS_OK;
   } catch (const std::exception& ex) {
-    assign_error(error_message, ex.what());
-    return HYDRA_STATUS_ERROR;
+    return fail(error_message, HYDRA_STATUS_ERROR, ex.what());
   }
 }
 
+void hydra_config_flat_free(hydra_config_flat_t* flat) {
+  if (flat == nullptr) {
+    return;
+  }
+  hydra::capi::release(flat->values);
+  *flat = hydra_config_flat_t{};
+}
+
 hydra_status_t hydra_config_clone_string(const hydra_config_t* config,
                                          const char* path_expression,
                                          char** out_value,
@@ -651,6 +1163,15 @@ hydra_status_t hydra_config_clone_string_list(const hydra_config_t* config,
                                               char*** out_items,
                                               size_t* out_count,
                                               char** error_message) {
+  return hydra_config_clone_string_list_arena(config, path_expression, nullptr,
+                                              out_items, out_count,
+                                              error_message);
+}
+
+hydra_status_t hydra_config_clone_string_list_arena(
+    const hydra_config_t* config, const char* path_expression,
+    hydra_arena_t* arena, char*** out_items, size_t* out_count,
+    char** error_message) {
   if (out_items != nullptr) {
     *out_items = nullptr;
   }
@@ -658,48 +1179,50 @@ hydra_status_t hydra_config_clone_string_list(const hydra_config_t* config,
     *out_count = 0;
   }
   if (config == nullptr || out_items == nullptr || out_count == nullptr) {
-    assign_error(error_message, "Config or output pointer is null");
-    return HYDRA_STATUS_ERROR;
+    return fail(error_message, HYDRA_STATUS_INVALID_ARGUMENT,
+                "Config or output pointer is null");
   }
   try {
-    hydra_config_t* mutable_config = const_cast<hydra_config_t*>(config);
-    ensure_resolved(mutable_config);
+    ensure_resolved(config);
     const hydra::ConfigNode* node = nullptr;
-    if (path_expression == nullptr || path_expression[0] == '\0') {
-      node = &config->node;
-    } else {
-      node = locate(config, path_expression);
-    }
-    if (node == nullptr) {
-      assign_error(error_message, "Requested node does not exist");
-      return HYDRA_STATUS_ERROR;
+    hydra_status_t status =
+        lookup(config, path_expression != nullptr ? path_expression : "",
+               &node, error_message);
+    if (status != HYDRA_STATUS_OK) {
+      return status;
     }
     if (!node->is_sequence()) {
-      assign_error(error_message, "Requested node is not a sequence");
-      return HYDRA_STATUS_ERROR;
+      return fail(error_message, HYDRA_STATUS_TYPE_MISMATCH,
+                  "Requested node is not a sequence");
     }
     const auto& sequence = node->as_sequence();
     if (sequence.empty()) {
       return HYDRA_STATUS_OK;
     }
-    char** buffer =
-        static_cast<char**>(std::calloc(sequence.size(), sizeof(char*)));
+    // Arena memory is reclaimed with the arena, so only heap copies are
+    // unwound on failure.
+    auto discard = [arena](char** items, size_t count) {
+      if (arena == nullptr) {
+        hydra_string_list_free(items, count);
+      }
+    };
+    char** buffer = static_cast<char**>(
+        hydra::capi::allocate(sequence.size() * sizeof(char*), arena));
     if (buffer == nullptr) {
-      assign_error(error_message, "Out of memory");
-      return HYDRA_STATUS_ERROR;
+      return fail(error_message, HYDRA_STATUS_OUT_OF_MEMORY, "Out of memory");
     }
     size_t count = 0;
     for (const auto& element : sequence) {
       if (!element.is_string()) {
-        assign_error(error_message, "Sequence element is not a string");
-        hydra_string_list_free(buffer, count);
-        return HYDRA_STATUS_ERROR;
+        discard(buffer, count);
+        return fail(error_message, HYDRA_STATUS_TYPE_MISMATCH,
+                    "Sequence element is not a string");
       }
-      buffer[count] = dup_string(element.as_string());
+      buffer[count] = dup_string(element.as_string(), arena);
       if (buffer[count] == nullptr) {
-        assign_error(error_message, "Out of memory");
-        hydra_string_list_free(buffer, count);
-        return HYDRA_STATUS_ERROR;
+        discard(buffer, count);
+        return fail(error_message, HYDRA_STATUS_OUT_OF_MEMORY,
+                    "Out of memory");
       }
       ++count;
     }
@@ -707,8 +1230,7 @@ hydra_status_t hydra_config_clone_string_list(const hydra_config_t* config,
     *out_count = count;
     return HYDRA_STATUS_OK;
   } catch (const std::exception& ex) {
-    assign_error(error_message, ex.what());
-    return HYDRA_STATUS_ERROR;
+    return fail(error_message, HYDRA_STATUS_ERROR, ex.what());
   }
 }
 
@@ -719,15 +1241,15 @@ void hydra_string_list_free(char** items, size_t count) {
   for (size_t i = 0; i < count; ++i) {
     hydra_string_free(items[i]);
   }
-  std::free(items);
+  hydra::capi::release(items);
 }
 
 hydra_status_t hydra_config_ensure_directory(const hydra_config_t* config,
                                              const char* path_expression,
                                              char** error_message) {
   if (config == nullptr || path_expression == nullptr) {
-    assign_error(error_message, "Config or path is null");
-    return HYDRA_STATUS_ERROR;
+    return fail(error_message, HYDRA_STATUS_INVALID_ARGUMENT,
+                "Config or path is null");
   }
   char* path_value      = nullptr;
   hydra_status_t status = hydra_config_get_string(config, path_expression,
@@ -738,36 +1260,41 @@ hydra_status_t hydra_config_ensure_directory(const hydra_config_t* config,
   std::string directory_path(path_value ? path_value : "");
   hydra_string_free(path_value);
   if (directory_path.empty()) {
-    assign_error(error_message, "Directory path is empty");
-    return HYDRA_STATUS_ERROR;
+    return fail(error_message, HYDRA_STATUS_INVALID_ARGUMENT,
+                "Directory path is empty");
   }
   try {
     std::filesystem::path dir(directory_path);
     std::filesystem::create_directories(dir);
     return HYDRA_STATUS_OK;
   } catch (const std::exception& ex) {
-    assign_error(error_message, ex.what());
-    return HYDRA_STATUS_ERROR;
+    return fail(error_message, HYDRA_STATUS_IO_ERROR, ex.what());
   }
 }
 
 char* hydra_config_to_yaml_string(const hydra_config_t* config,
                                   char** error_message) {
+  return hydra_config_to_yaml_string_arena(config, nullptr, error_message);
+}
+
+char* hydra_config_to_yaml_string_arena(const hydra_config_t* config,
+                                        hydra_arena_t* arena,
+                                        char** error_message) {
   if (config == nullptr) {
-    assign_error(error_message, "Config is null");
+    fail(error_message, HYDRA_STATUS_INVALID_ARGUMENT, "Config is null");
     return nullptr;
   }
   try {
-    hydra_config_t* mutable_config = const_cast<hydra_config_t*>(config);
-    ensure_resolved(mutable_config);
-    std::string rendered = hydra::to_yaml_string(config->node);
-    return dup_string(rendered);
+    ensure_resolved(config);
+    std::string rendered =
+        hydra::to_yaml_string(hydra::capi::root_of(config));
+    char* copy = dup_string(rendered, arena);
+    if (copy == nullptr) {
+      fail(error_message, HYDRA_STATUS_OUT_OF_MEMORY, "Out of memory");
+    }
+    return copy;
   } catch (const std::exception& ex) {
-    assign_error(error_message, ex.what());
+    fail(error_message, HYDRA_STATUS_ERROR, ex.what());
     return nullptr;
   }
 }
-
-void hydra_string_free(char* str) {
-  std::free(str);
-}
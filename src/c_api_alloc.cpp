@@ -0,0 +1,144 @@
+#include "hydra/c_api.h"
+
+#include "c_api_internal.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+namespace {
+
+void* default_allocate(size_t size, void* /*user_data*/) {
+  return std::malloc(size);
+}
+
+void default_deallocate(void* ptr, void* /*user_data*/) {
+  std::free(ptr);
+}
+
+hydra_allocator_t current_allocator = {default_allocate, default_deallocate,
+                                       nullptr};
+
+constexpr size_t kArenaAlignment        = alignof(std::max_align_t);
+constexpr size_t kDefaultArenaBlockSize = 4096;
+
+size_t align_up(size_t size) {
+  return (size + kArenaAlignment - 1) & ~(kArenaAlignment - 1);
+}
+
+} // namespace
+
+// Blocks are chained newest first; allocation bumps `used` in the head block
+// and starts a new one when it does not fit.
+struct hydra_arena {
+  struct alignas(std::max_align_t) Block {
+    Block* next;
+    size_t capacity;
+    size_t used;
+
+    char* data() { return reinterpret_cast<char*>(this + 1); }
+  };
+
+  Block* head       = nullptr;
+  size_t block_size = kDefaultArenaBlockSize;
+  size_t bytes_used = 0;
+};
+
+void* hydra::capi::allocate(size_t size, hydra_arena_t* arena) {
+  if (arena == nullptr) {
+    return current_allocator.allocate(size, current_allocator.user_data);
+  }
+  size = align_up(std::max<size_t>(size, 1));
+  hydra_arena::Block* block = arena->head;
+  if (block == nullptr || block->capacity - block->used < size) {
+    size_t capacity = std::max(arena->block_size, size);
+    void* storage   = current_allocator.allocate(
+        sizeof(hydra_arena::Block) + capacity, current_allocator.user_data);
+    if (storage == nullptr) {
+      return nullptr;
+    }
+    block           = static_cast<hydra_arena::Block*>(storage);
+    block->next     = arena->head;
+    block->capacity = capacity;
+    block->used     = 0;
+    arena->head     = block;
+  }
+  void* result = block->data() + block->used;
+  block->used += size;
+  arena->bytes_used += size;
+  return result;
+}
+
+void hydra::capi::release(void* ptr) {
+  if (ptr != nullptr) {
+    current_allocator.deallocate(ptr, current_allocator.user_data);
+  }
+}
+
+char* hydra::capi::dup_string(std::string_view value, hydra_arena_t* arena) {
+  char* buffer = static_cast<char*>(allocate(value.size() + 1, arena));
+  if (buffer == nullptr) {
+    return nullptr;
+  }
+  std::memcpy(buffer, value.data(), value.size());
+  buffer[value.size()] = '\0';
+  return buffer;
+}
+
+void hydra_set_allocator(const hydra_allocator_t* allocator) {
+  if (allocator == nullptr || allocator->allocate == nullptr ||
+      allocator->deallocate == nullptr) {
+    current_allocator = {default_allocate, default_deallocate, nullptr};
+    return;
+  }
+  current_allocator = *allocator;
+}
+
+hydra_arena_t* hydra_arena_create(size_t block_size) {
+  void* storage = hydra::capi::allocate(sizeof(hydra_arena));
+  if (storage == nullptr) {
+    return nullptr;
+  }
+  auto* arena = new (storage) hydra_arena();
+  if (block_size > 0) {
+    arena->block_size = block_size;
+  }
+  return arena;
+}
+
+void hydra_arena_reset(hydra_arena_t* arena) {
+  if (arena == nullptr || arena->head == nullptr) {
+    return;
+  }
+  // Keep the newest block so that a startup phase repeated after a reset
+  // does not go back to the allocator.
+  hydra_arena::Block* block = arena->head->next;
+  while (block != nullptr) {
+    hydra_arena::Block* next = block->next;
+    hydra::capi::release(block);
+    block = next;
+  }
+  arena->head->next = nullptr;
+  arena->head->used = 0;
+  arena->bytes_used = 0;
+}
+
+void hydra_arena_destroy(hydra_arena_t* arena) {
+  if (arena == nullptr) {
+    return;
+  }
+  hydra_arena_reset(arena);
+  hydra::capi::release(arena->head);
+  arena->~hydra_arena();
+  hydra::capi::release(arena);
+}
+
+size_t hydra_arena_bytes_used(const hydra_arena_t* arena) {
+  return arena != nullptr ? arena->bytes_used : 0;
+}
+
+void hydra_string_free(char* str) {
+  hydra::capi::release(str);
+}
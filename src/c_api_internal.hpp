@@ -0,0 +1,85 @@
+#pragma once
+
+// Private definitions shared by the translation units implementing the C API.
+// Not installed; include only from src/.
+
+#include "hydra/c_api.h"
+#include "hydra/config_node.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct hydra_config {
+  hydra::ConfigNode node;
+  // Set once by hydra_config_freeze. A frozen config is fully resolved and
+  // never written again, so readers may share it across threads.
+  std::atomic<bool> frozen{false};
+  // Whether `node` has been resolved since it last changed; mutators clear
+  // it so that reads resolve again, and only then.
+  bool resolved = false;
+  // Views created by hydra_config_view own no storage: `node` stays null and
+  // reads go to `root`, a subtree of `owner->node`.
+  hydra_config* owner           = nullptr;
+  const hydra::ConfigNode* root = nullptr;
+  // Views: where `root` sits below the owner's root, so that the access
+  // tracker records paths from the top.
+  std::vector<std::string> view_path;
+  // Configs composed with an access profile (hydra/access_profile.hpp):
+  // composes the full config, which the first lookup that misses merges in.
+  std::function<hydra::ConfigNode()> materialize;
+};
+
+namespace hydra::capi {
+
+// Memory handed to C callers. Without an arena it comes from the allocator
+// installed by hydra_set_allocator and is returned with release(); arena
+// memory is only reclaimed by hydra_arena_reset / hydra_arena_destroy.
+void* allocate(size_t size, hydra_arena_t* arena = nullptr);
+void release(void* ptr);
+
+// NUL-terminated copy of `value`, see allocate().
+char* dup_string(std::string_view value, hydra_arena_t* arena = nullptr);
+
+// Records `message` as this thread's hydra_last_error(), copies it into
+// *error_out when the caller asked for one, and returns `status`.
+hydra_status_t fail(char** error_out, hydra_status_t status,
+                    std::string_view message);
+
+inline bool is_view(const hydra_config_t* config) {
+  return config->owner != nullptr;
+}
+
+// The config that owns the storage `config` reads from (itself unless it is a
+// view).
+inline hydra_config_t* owner_of(const hydra_config_t* config) {
+  return const_cast<hydra_config_t*>(is_view(config) ? config->owner : config);
+}
+
+// The node every read through `config` is relative to.
+inline const hydra::ConfigNode& root_of(const hydra_config_t* config) {
+  return is_view(config) ? *config->root : config->node;
+}
+
+inline bool is_frozen(const hydra_config_t* config) {
+  return config != nullptr &&
+         owner_of(config)->frozen.load(std::memory_order_acquire);
+}
+
+// Resolves interpolations through the owner before a read, once per write.
+// Resolution rewrites string nodes in place, so it is skipped once a config
+// is frozen; that is what makes concurrent reads of a frozen config safe.
+void ensure_resolved(const hydra_config_t* config);
+
+// Type and scalar payload of `node`; strings point into the node.
+hydra_value_t describe(const hydra::ConfigNode& node);
+
+// Merges the rest of a config composed with an access profile into its
+// owner, once; true if anything may have been added. Frozen configs are
+// complete already (hydra_config_freeze materializes first).
+bool materialize(const hydra_config_t* config);
+
+} // namespace hydra::capi
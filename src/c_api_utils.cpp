@@ -1,89 +1,136 @@
 #include "hydra/c_api_utils.h"
 
+#include "c_api_internal.hpp"
+#include "hydra/access_profile.hpp"
+#include "hydra/config_blob.hpp"
 #include "hydra/config_utils.hpp"
 #include "hydra/logging.h"
 
+#include <atomic>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
 #include <exception>
 #include <filesystem>
+#include <memory>
+#include <new>
 #include <string>
+#include <thread>
 #include <vector>
 
-struct hydra_config {
-  hydra::ConfigNode node;
-};
-
 namespace {
 
-char* duplicate_string(const char* text) {
-  if (text == nullptr) {
-    return nullptr;
-  }
-  size_t len = std::strlen(text);
-  char* copy = static_cast<char*>(std::malloc(len + 1));
-  if (copy == nullptr) {
-    return nullptr;
-  }
-  std::memcpy(copy, text, len + 1);
-  return copy;
-}
-
-void set_error(char** error_out, const std::string& message) {
-  if (error_out != nullptr) {
-    *error_out = duplicate_string(message.c_str());
-  }
-}
+using hydra::capi::dup_string;
+using hydra::capi::fail;
 
-[[noreturn]] void handle_expect_failure(const char* path, const char* expected,
-                                        char* err) {
+[[noreturn]] void handle_expect_failure(const char* path,
+                                        const char* expected) {
   std::fprintf(stderr, "[hydra] expected %s at '%s': %s\n", expected, path,
-               err ? err : "(unknown error)");
-  hydra_string_free(err);
+               hydra_last_error());
   std::exit(EXIT_FAILURE);
 }
 
+// What hydra::utils::initialize does, but with the access profile: a
+// projected config keeps its inputs so that a miss can complete it.
+std::unique_ptr<hydra_config> compose_config(hydra::ComposeContext context,
+                                             hydra::OverrideSet set) {
+  context.use_access_profile = true;
+  bool projected             = false;
+  hydra::ConfigNode config   = context.compose(set, &projected);
+  hydra::configure_access_tracking(config);
+
+  auto result  = std::make_unique<hydra_config>();
+  result->node = std::move(config);
+  if (projected) {
+    context.use_access_profile = false;
+    result->materialize = [context = std::move(context),
+                           set     = std::move(set)] {
+      return context.compose(set);
+    };
+  }
+  return result;
+}
+
 } // namespace
 
+struct hydra_init {
+  std::vector<std::string> args;
+  std::string default_config;
+  hydra_init_callback_t callback = nullptr;
+  void* user_data                = nullptr;
+
+  // Written by `thread` before `done` is set; read after joining it.
+  std::unique_ptr<hydra_config> config;
+  hydra_status_t status = HYDRA_STATUS_OK;
+  std::string error;
+
+  std::atomic<bool> done{false};
+  std::thread thread;
+
+  void run() {
+    try {
+      std::vector<char*> argv;
+      for (std::string& arg : args) {
+        argv.push_back(arg.data());
+      }
+      argv.push_back(nullptr);
+      int argc = static_cast<int>(args.size());
+      hydra::ComposeContext context =
+          hydra::utils::process_context(argc, argv.data());
+      context.default_config = default_config;
+      hydra::OverrideSet set =
+          hydra::utils::parse_command_line(argc, argv.data());
+      config = compose_config(std::move(context), std::move(set));
+    } catch (const std::bad_alloc&) {
+      status = HYDRA_STATUS_OUT_OF_MEMORY;
+      error  = "Failed to allocate config object";
+    } catch (const std::exception& ex) {
+      status = HYDRA_STATUS_ERROR;
+      error  = ex.what();
+    }
+    done.store(true, std::memory_order_release);
+    if (callback != nullptr) {
+      callback(status, user_data);
+    }
+  }
+};
+
 extern "C" {
 
 int64_t hydra_config_expect_int(hydra_config_t* config, const char* path) {
-  char* err             = nullptr;
   int64_t value         = 0;
-  hydra_status_t status = hydra_config_get_int(config, path, &value, &err);
+  hydra_status_t status = hydra_config_get_int(config, path, &value, nullptr);
   if (status != HYDRA_STATUS_OK) {
-    handle_expect_failure(path, "an integer", err);
+    handle_expect_failure(path, "an integer");
   }
   return value;
 }
 
 double hydra_config_expect_double(hydra_config_t* config, const char* path) {
-  char* err             = nullptr;
   double value          = 0.0;
-  hydra_status_t status = hydra_config_get_double(config, path, &value, &err);
+  hydra_status_t status =
+      hydra_config_get_double(config, path, &value, nullptr);
   if (status != HYDRA_STATUS_OK) {
-    handle_expect_failure(path, "a double", err);
+    handle_expect_failure(path, "a double");
   }
   return value;
 }
 
 char* hydra_config_expect_string(hydra_config_t* config, const char* path) {
-  char* err             = nullptr;
   char* value           = nullptr;
-  hydra_status_t status = hydra_config_get_string(config, path, &value, &err);
+  hydra_status_t status =
+      hydra_config_get_string(config, path, &value, nullptr);
   if (status != HYDRA_STATUS_OK) {
-    handle_expect_failure(path, "a string", err);
+    handle_expect_failure(path, "a string");
   }
   return value;
 }
 
 int hydra_config_expect_bool(hydra_config_t* config, const char* path) {
-  char* err             = nullptr;
   int value             = 0;
-  hydra_status_t status = hydra_config_get_bool(config, path, &value, &err);
+  hydra_status_t status = hydra_config_get_bool(config, path, &value, nullptr);
   if (status != HYDRA_STATUS_OK) {
-    handle_expect_failure(path, "a boolean", err);
+    handle_expect_failure(path, "a boolean");
   }
   return value;
 }
@@ -91,27 +138,27 @@ int hydra_config_expect_bool(hydra_config_t* config, const char* path) {
 hydra_status_t hydra_config_write_yaml(hydra_config_t* config, const char* path,
                                        char** error_message) {
   if (config == nullptr || path == nullptr) {
-    set_error(error_message, "Config or path is null");
-    return HYDRA_STATUS_ERROR;
+    return fail(error_message, HYDRA_STATUS_INVALID_ARGUMENT,
+                "Config or path is null");
   }
   char* yaml = hydra_config_to_yaml_string(config, error_message);
   if (yaml == nullptr) {
-    return HYDRA_STATUS_ERROR;
+    return hydra_last_status();
   }
 
   FILE* out = std::fopen(path, "wb");
   if (!out) {
-    set_error(error_message, "Failed to open output file");
     hydra_string_free(yaml);
-    return HYDRA_STATUS_ERROR;
+    return fail(error_message, HYDRA_STATUS_IO_ERROR,
+                "Failed to open output file");
   }
   size_t len     = std::strlen(yaml);
   size_t written = std::fwrite(yaml, 1, len, out);
   std::fclose(out);
   hydra_string_free(yaml);
   if (written != len) {
-    set_error(error_message, "Failed to write full YAML output");
-    return HYDRA_STATUS_ERROR;
+    return fail(error_message, HYDRA_STATUS_IO_ERROR,
+                "Failed to write full YAML output");
   }
   return HYDRA_STATUS_OK;
 }
@@ -119,12 +166,12 @@ hydra_status_t hydra_config_write_yaml(hydra_config_t* config, const char* path,
 hydra_status_t hydra_config_stream_yaml(hydra_config_t* config, FILE* stream,
                                         char** error_message) {
   if (config == nullptr || stream == nullptr) {
-    set_error(error_message, "Config or stream is null");
-    return HYDRA_STATUS_ERROR;
+    return fail(error_message, HYDRA_STATUS_INVALID_ARGUMENT,
+                "Config or stream is null");
   }
   char* yaml = hydra_config_to_yaml_string(config, error_message);
   if (yaml == nullptr) {
-    return HYDRA_STATUS_ERROR;
+    return hydra_last_status();
   }
   std::fputs(yaml, stream);
   if (yaml[0] && yaml[std::strlen(yaml) - 1] != '\n') {
@@ -141,7 +188,7 @@ void hydra_cli_overrides_free(hydra_cli_overrides_t* overrides) {
   for (size_t i = 0; i < overrides->count; ++i) {
     hydra_string_free(overrides->items[i]);
   }
-  std::free(overrides->items);
+  hydra::capi::release(overrides->items);
   overrides->items = nullptr;
   overrides->count = 0;
 }
@@ -154,8 +201,8 @@ hydra_status_t hydra_write_outputs(hydra_config_t* config,
     *run_dir_out = nullptr;
   }
   if (config == nullptr) {
-    set_error(error_message, "Config is null");
-    return HYDRA_STATUS_ERROR;
+    return fail(error_message, HYDRA_STATUS_INVALID_ARGUMENT,
+                "Config is null");
   }
   try {
     std::vector<std::string> override_vec;
@@ -163,16 +210,18 @@ hydra_status_t hydra_write_outputs(hydra_config_t* config,
     for (size_t i = 0; i < override_count; ++i) {
       override_vec.emplace_back(overrides[i] ? overrides[i] : "");
     }
+    // The full config goes to .hydra, whatever the profile left out.
+    hydra::capi::materialize(config);
     std::filesystem::path run_dir =
-        hydra::utils::write_hydra_outputs(config->node, override_vec);
+        hydra::utils::write_hydra_outputs(hydra::capi::root_of(config),
+                                          override_vec);
     if (run_dir_out) {
-      *run_dir_out = duplicate_string(run_dir.string().c_str());
+      *run_dir_out = dup_string(run_dir.string());
     }
 
     return HYDRA_STATUS_OK;
   } catch (const std::exception& ex) {
-    set_error(error_message, ex.what());
-    return HYDRA_STATUS_ERROR;
+    return fail(error_message, HYDRA_STATUS_IO_ERROR, ex.what());
   }
 }
 
@@ -180,31 +229,111 @@ hydra_config_t* hydra_initialize(int argc, char** argv,
                                  const char* default_config,
                                  char** error_message) {
   if (default_config == nullptr) {
-    set_error(error_message, "default_config is null");
+    fail(error_message, HYDRA_STATUS_INVALID_ARGUMENT,
+         "default_config is null");
     return nullptr;
   }
 
   try {
-    // Use C++ utility function for initialization
-    hydra::ConfigNode config =
-        hydra::utils::initialize(argc, argv, default_config);
-
-    // Wrap in C API structure
-    hydra_config_t* result =
-        static_cast<hydra_config_t*>(std::malloc(sizeof(hydra_config_t)));
-    if (result == nullptr) {
-      set_error(error_message, "Failed to allocate config object");
-      return nullptr;
+    hydra::ComposeContext context = hydra::utils::process_context(argc, argv);
+    context.default_config        = default_config;
+    // Released by hydra_config_destroy
+    return compose_config(std::move(context),
+                          hydra::utils::parse_command_line(argc, argv))
+        .release();
+  } catch (const std::bad_alloc&) {
+    fail(error_message, HYDRA_STATUS_OUT_OF_MEMORY,
+         "Failed to allocate config object");
+    return nullptr;
+  } catch (const std::exception& ex) {
+    fail(error_message, HYDRA_STATUS_ERROR, ex.what());
+    return nullptr;
+  }
+}
+
+hydra_config_t* hydra_initialize_embedded(int argc, char** argv,
+                                          const void* blob, size_t size,
+                                          char** error_message) {
+  if (blob == nullptr) {
+    fail(error_message, HYDRA_STATUS_INVALID_ARGUMENT, "blob is null");
+    return nullptr;
+  }
+
+  try {
+    hydra::ComposeContext context = hydra::utils::process_context(argc, argv);
+    context.base                  = std::make_shared<const hydra::ConfigNode>(
+        hydra::deserialize_config(blob, size));
+    return compose_config(std::move(context),
+                          hydra::utils::parse_command_line(argc, argv))
+        .release();
+  } catch (const std::bad_alloc&) {
+    fail(error_message, HYDRA_STATUS_OUT_OF_MEMORY,
+         "Failed to allocate config object");
+    return nullptr;
+  } catch (const std::exception& ex) {
+    fail(error_message, HYDRA_STATUS_ERROR, ex.what());
+    return nullptr;
+  }
+}
+
+hydra_init_t* hydra_initialize_async(int argc, char** argv,
+                                     const char* default_config,
+                                     hydra_init_callback_t callback,
+                                     void* user_data, char** error_message) {
+  if (default_config == nullptr) {
+    fail(error_message, HYDRA_STATUS_INVALID_ARGUMENT,
+         "default_config is null");
+    return nullptr;
+  }
+
+  try {
+    auto init = std::make_unique<hydra_init>();
+    for (int i = 0; i < argc && argv != nullptr && argv[i] != nullptr; ++i) {
+      init->args.emplace_back(argv[i]);
     }
+    init->default_config = default_config;
+    init->callback       = callback;
+    init->user_data      = user_data;
+    init->thread         = std::thread(&hydra_init::run, init.get());
+    return init.release();
+  } catch (const std::exception& ex) {
+    fail(error_message, HYDRA_STATUS_ERROR,
+         std::string("Failed to start initialization: ") + ex.what());
+    return nullptr;
+  }
+}
 
-    // Move construct the ConfigNode into the C structure
-    new (&result->node) hydra::ConfigNode(std::move(config));
+int hydra_init_ready(const hydra_init_t* init) {
+  return init != nullptr && init->done.load(std::memory_order_acquire) ? 1
+                                                                       : 0;
+}
 
-    return result;
+hydra_config_t* hydra_init_wait(hydra_init_t* init, char** error_message) {
+  if (init == nullptr) {
+    fail(error_message, HYDRA_STATUS_INVALID_ARGUMENT, "init is null");
+    return nullptr;
+  }
+  // Joining the loader from itself would throw; the handle stays valid so
+  // that another thread can still wait on it.
+  if (init->thread.get_id() == std::this_thread::get_id()) {
+    fail(error_message, HYDRA_STATUS_INVALID_ARGUMENT,
+         "hydra_init_wait called on the loading thread");
+    return nullptr;
+  }
+  // A failed join leaves the thread joinable and still writing to `init`,
+  // so ownership is only taken once it has been reaped.
+  try {
+    init->thread.join();
   } catch (const std::exception& ex) {
-    set_error(error_message, ex.what());
+    fail(error_message, HYDRA_STATUS_ERROR, ex.what());
+    return nullptr;
+  }
+  std::unique_ptr<hydra_init> owned(init);
+  if (owned->status != HYDRA_STATUS_OK) {
+    fail(error_message, owned->status, owned->error);
     return nullptr;
   }
+  return owned->config.release();
 }
 
 } // extern "C"
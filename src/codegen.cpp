@@ -0,0 +1,854 @@
+// hydra-codegen: composes a reference config and emits C and C++ types that
+// mirror its shape, plus loaders that fill them in one pass per mapping.
+//
+//   hydra-codegen --config configs/main.yaml --name AppConfig
+//                 [--namespace ns] --output-dir <dir> [overrides...]
+//
+// writes <dir>/app_config.hpp (structs bound with hydra/config_bind.hpp and
+// load_app_config(const ConfigNode&)) and <dir>/app_config.h (C structs,
+// app_config_load(const hydra_config_t*, ...) and app_config_release).
+// Types follow the composed values: int64_t, double, bool, strings, nested
+// structs and vectors typed after their first element. Null values, empty
+// containers and mixed sequences stay ConfigNode in C++ and are left out of
+// the C structs.
+//
+// With --embed it instead writes <dir>/app_config_embedded.{h,c}: the
+// composed config, interpolations unresolved, serialized as a byte array for
+// hydra_initialize_embedded.
+
+#include "hydra/config_blob.hpp"
+#include "hydra/config_node.hpp"
+#include "hydra/config_utils.hpp"
+
+#include <cctype>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+using hydra::ConfigNode;
+using hydra::serialize_config;
+
+namespace {
+
+struct Type;
+
+struct Field {
+  std::string key;
+  std::string ident;
+  std::shared_ptr<Type> type;
+};
+
+struct Type {
+  enum Kind { Int, Double, Bool, String, Struct, Sequence, Any } kind = Any;
+  std::string cpp_name; // Struct: name relative to the enclosing struct
+  std::string cpp_path; // Struct: fully qualified below the namespace
+  std::string c_name;   // Struct: typedef name without the _t suffix
+  std::vector<Field> fields;
+  std::shared_ptr<Type> element; // Sequence
+};
+
+const std::set<std::string>& keywords() {
+  static const std::set<std::string> words = {
+      "alignas",  "alignof",   "and",       "asm",      "auto",
+      "bool",     "break",     "case",      "catch",    "char",
+      "class",    "concept",   "const",     "continue", "default",
+      "delete",   "do",        "double",    "else",     "enum",
+      "explicit", "export",    "extern",    "false",    "float",
+      "for",      "friend",    "goto",      "if",       "inline",
+      "int",      "long",      "mutable",   "namespace", "new",
+      "not",      "operator",  "or",        "private",  "protected",
+      "public",   "register",  "requires",  "restrict", "return",
+      "short",    "signed",    "sizeof",    "static",   "struct",
+      "switch",   "template",  "this",      "throw",    "true",
+      "try",      "typedef",   "typename",  "union",    "unsigned",
+      "using",    "virtual",   "void",      "volatile", "while",
+      "xor"};
+  return words;
+}
+
+std::string identifier(const std::string& key) {
+  std::string ident;
+  for (char c : key) {
+    ident += std::isalnum(static_cast<unsigned char>(c)) ? c : '_';
+  }
+  if (ident.empty() || std::isdigit(static_cast<unsigned char>(ident[0]))) {
+    ident.insert(ident.begin(), '_');
+  }
+  if (keywords().count(ident) != 0) {
+    ident += '_';
+  }
+  return ident;
+}
+
+std::string pascal_case(const std::string& ident) {
+  std::string name;
+  bool upper = true;
+  for (char c : ident) {
+    if (c == '_') {
+      upper = true;
+    } else {
+      name += upper ? static_cast<char>(std::toupper(c)) : c;
+      upper = false;
+    }
+  }
+  return name.empty() || std::isdigit(static_cast<unsigned char>(name[0]))
+             ? "T" + name
+             : name;
+}
+
+std::string snake_case(const std::string& name) {
+  std::string out;
+  for (size_t i = 0; i < name.size(); ++i) {
+    char c = name[i];
+    if (std::isupper(static_cast<unsigned char>(c))) {
+      if (i > 0 && (std::islower(static_cast<unsigned char>(name[i - 1])) ||
+                    std::isdigit(static_cast<unsigned char>(name[i - 1])))) {
+        out += '_';
+      }
+      out += static_cast<char>(std::tolower(c));
+    } else {
+      out += c;
+    }
+  }
+  return out;
+}
+
+// Keys the C path syntax can address without escaping.
+bool plain_key(const std::string& key) {
+  for (char c : key) {
+    if (!std::isalnum(static_cast<unsigned char>(c)) && c != '_' && c != '-') {
+      return false;
+    }
+  }
+  return !key.empty();
+}
+
+// `key` as the body of a C++ string literal. Octal escapes never absorb the
+// character that follows them, unlike \x.
+std::string quoted_key(const std::string& key) {
+  std::string out;
+  for (char c : key) {
+    unsigned char byte = static_cast<unsigned char>(c);
+    if (c == '"' || c == '\\') {
+      out += '\\';
+      out += c;
+    } else if (byte < 0x20 || byte == 0x7f) {
+      char escaped[5];
+      std::snprintf(escaped, sizeof(escaped), "\\%03o", byte);
+      out += escaped;
+    } else {
+      out += c;
+    }
+  }
+  return out;
+}
+
+std::shared_ptr<Type> infer(const ConfigNode& node, const std::string& cpp_name,
+                            const std::string& cpp_path,
+                            const std::string& c_name) {
+  auto type = std::make_shared<Type>();
+  if (node.is_int()) {
+    type->kind = Type::Int;
+  } else if (node.is_double()) {
+    type->kind = Type::Double;
+  } else if (node.is_bool()) {
+    type->kind = Type::Bool;
+  } else if (node.is_string()) {
+    type->kind = Type::String;
+  } else if (node.is_mapping() && !node.as_mapping().empty()) {
+    type->kind     = Type::Struct;
+    type->cpp_name = cpp_name;
+    type->cpp_path = cpp_path;
+    type->c_name   = c_name;
+    std::set<std::string> used;
+    for (const auto& [key, child] : node.as_mapping()) {
+      std::string ident = identifier(key);
+      while (!used.insert(ident).second) {
+        ident += '_';
+      }
+      std::string child_name = pascal_case(ident);
+      if (child_name == cpp_name) {
+        child_name += "Config";
+      }
+      type->fields.push_back(
+          {key, ident,
+           infer(child, child_name, cpp_path + "::" + child_name,
+                 c_name + "_" + snake_case(ident))});
+    }
+  } else if (node.is_sequence() && !node.as_sequence().empty()) {
+    const ConfigNode::seq_t& items = node.as_sequence();
+    std::string item_name          = cpp_name + "Item";
+    auto element = infer(items.front(), item_name,
+                         cpp_path.substr(0, cpp_path.rfind("::") + 2) +
+                             item_name,
+                         c_name + "_item");
+    for (const ConfigNode& item : items) {
+      bool same = (item.is_int() && element->kind == Type::Int) ||
+                  (item.is_double() && element->kind == Type::Double) ||
+                  (item.is_int() && element->kind == Type::Double) ||
+                  (item.is_bool() && element->kind == Type::Bool) ||
+                  (item.is_string() && element->kind == Type::String) ||
+                  (item.is_mapping() && element->kind == Type::Struct) ||
+                  (item.is_sequence() && element->kind == Type::Sequence);
+      if (item.is_double() && element->kind == Type::Int) {
+        element->kind = Type::Double;
+        same          = true;
+      }
+      if (!same) {
+        element       = std::make_shared<Type>();
+        element->kind = Type::Any;
+        break;
+      }
+    }
+    type->kind    = Type::Sequence;
+    type->element = element;
+  }
+  return type;
+}
+
+// ---- C++ ----
+
+std::string cpp_type(const Type& type) {
+  switch (type.kind) {
+  case Type::Int:
+    return "int64_t";
+  case Type::Double:
+    return "double";
+  case Type::Bool:
+    return "bool";
+  case Type::String:
+    return "std::string";
+  case Type::Struct:
+    return type.cpp_name;
+  case Type::Sequence:
+    return "std::vector<" + cpp_type(*type.element) + ">";
+  case Type::Any:
+    break;
+  }
+  return "hydra::ConfigNode";
+}
+
+void emit_cpp_struct(std::ostream& out, const Type& type,
+                     const std::string& indent) {
+  out << indent << "struct " << type.cpp_name << " {\n";
+  for (const Field& field : type.fields) {
+    const Type* nested = field.type.get();
+    while (nested->kind == Type::Sequence) {
+      nested = nested->element.get();
+    }
+    if (nested->kind == Type::Struct) {
+      emit_cpp_struct(out, *nested, indent + "  ");
+    }
+  }
+  for (const Field& field : type.fields) {
+    out << indent << "  " << cpp_type(*field.type) << " " << field.ident
+        << "{};\n";
+  }
+  out << indent << "};\n";
+}
+
+void collect_structs(const Type& type, std::vector<const Type*>& structs) {
+  if (type.kind == Type::Sequence) {
+    collect_structs(*type.element, structs);
+  } else if (type.kind == Type::Struct) {
+    for (const Field& field : type.fields) {
+      collect_structs(*field.type, structs);
+    }
+    structs.push_back(&type);
+  }
+}
+
+void emit_cpp(std::ostream& out, const Type& root, const std::string& source,
+              const std::string& name_space, const std::string& stem) {
+  out << "// Generated by hydra-codegen from " << source
+      << "; do not edit.\n"
+      << "#pragma once\n\n"
+      << "#include \"hydra/config_bind.hpp\"\n"
+      << "#include \"hydra/config_node.hpp\"\n\n"
+      << "#include <cstdint>\n#include <string>\n#include <vector>\n\n";
+  if (!name_space.empty()) {
+    out << "namespace " << name_space << " {\n\n";
+  }
+  emit_cpp_struct(out, root, "");
+  out << "\n";
+
+  std::vector<const Type*> structs;
+  collect_structs(root, structs);
+  for (const Type* type : structs) {
+    out << "[[maybe_unused]] constexpr auto hydra_bind_fields(const "
+        << type->cpp_path << "*) {\n"
+        << "  return hydra::utils::bind_fields(\n      0";
+    for (const Field& field : type->fields) {
+      out << ",\n      hydra::utils::bind_field(\""
+          << quoted_key(field.key) << "\", &"
+          << type->cpp_path << "::" << field.ident << ")";
+    }
+    out << ");\n}\n\n";
+  }
+
+  out << "// Fills every field in one pass per mapping; throws\n"
+      << "// hydra::utils::BindError listing each missing or mistyped key.\n"
+      << "inline " << root.cpp_name << " load_" << stem
+      << "(const hydra::ConfigNode& root) {\n"
+      << "  return hydra::utils::bind<" << root.cpp_name << ">(root);\n"
+      << "}\n";
+  if (!name_space.empty()) {
+    out << "\n} // namespace " << name_space << "\n";
+  }
+}
+
+// ---- C ----
+
+// C carries scalars, structs and flat sequences of either.
+bool c_supported(const Type& type) {
+  if (type.kind == Type::Sequence) {
+    return type.element->kind != Type::Sequence &&
+           c_supported(*type.element);
+  }
+  return type.kind != Type::Any;
+}
+
+std::string c_type(const Type& type) {
+  switch (type.kind) {
+  case Type::Int:
+    return "int64_t";
+  case Type::Double:
+    return "double";
+  case Type::Bool:
+    return "bool";
+  case Type::String:
+    return "const char*";
+  case Type::Struct:
+    return type.c_name + "_t";
+  default:
+    break;
+  }
+  throw std::logic_error("no C type");
+}
+
+const char* c_converter(const Type& type) {
+  switch (type.kind) {
+  case Type::Int:
+    return "hydra_codegen_int";
+  case Type::Double:
+    return "hydra_codegen_double";
+  case Type::Bool:
+    return "hydra_codegen_bool";
+  default:
+    return "hydra_codegen_string";
+  }
+}
+
+const char* kCHelpers = R"(#ifndef HYDRA_CODEGEN_HELPERS
+#define HYDRA_CODEGEN_HELPERS
+
+/* "prefix.key", or just key at the root; NULL when out of memory. */
+static inline char* hydra_codegen_path(const char* prefix, const char* key) {
+  size_t prefix_len = strlen(prefix);
+  size_t key_len    = strlen(key);
+  char* path        = (char*)malloc(prefix_len + key_len + 2);
+  if (path == NULL) {
+    return NULL;
+  }
+  if (prefix_len > 0) {
+    memcpy(path, prefix, prefix_len);
+    path[prefix_len++] = '.';
+  }
+  memcpy(path + prefix_len, key, key_len + 1);
+  return path;
+}
+
+static inline void hydra_codegen_free_paths(char** paths, size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    free(paths[i]);
+  }
+}
+
+/* Looks up the `count` children `keys` of `prefix` with one
+ * hydra_config_get_many call. */
+static inline hydra_status_t
+hydra_codegen_fetch(const hydra_config_t* config, const char* prefix,
+                    const char* const* keys, size_t count, char** paths,
+                    hydra_value_t* values, char** error_message) {
+  for (size_t i = 0; i < count; ++i) {
+    paths[i] = hydra_codegen_path(prefix, keys[i]);
+    if (paths[i] == NULL) {
+      hydra_codegen_free_paths(paths, i);
+      return HYDRA_STATUS_OUT_OF_MEMORY;
+    }
+  }
+  hydra_status_t status = hydra_config_get_many(
+      config, (const char* const*)paths, count, values, error_message);
+  if (status != HYDRA_STATUS_OK) {
+    hydra_codegen_free_paths(paths, count);
+  }
+  return status;
+}
+
+/* Each converter takes a value fetched from `path`; on a mismatch the typed
+ * getter for `path` reports the error. */
+static inline hydra_status_t
+hydra_codegen_int(const hydra_config_t* config, const char* path,
+                  const hydra_value_t* value, int64_t* out,
+                  char** error_message) {
+  if (value->type == HYDRA_VALUE_INT) {
+    *out = value->as.integer;
+    return HYDRA_STATUS_OK;
+  }
+  return hydra_config_get_int(config, path, out, error_message);
+}
+
+static inline hydra_status_t
+hydra_codegen_double(const hydra_config_t* config, const char* path,
+                     const hydra_value_t* value, double* out,
+                     char** error_message) {
+  if (value->type == HYDRA_VALUE_DOUBLE) {
+    *out = value->as.real;
+    return HYDRA_STATUS_OK;
+  }
+  if (value->type == HYDRA_VALUE_INT) {
+    *out = (double)value->as.integer;
+    return HYDRA_STATUS_OK;
+  }
+  return hydra_config_get_double(config, path, out, error_message);
+}
+
+static inline hydra_status_t
+hydra_codegen_bool(const hydra_config_t* config, const char* path,
+                   const hydra_value_t* value, bool* out,
+                   char** error_message) {
+  int flag = 0;
+  if (value->type == HYDRA_VALUE_BOOL) {
+    *out = value->as.boolean != 0;
+    return HYDRA_STATUS_OK;
+  }
+  hydra_status_t status =
+      hydra_config_get_bool(config, path, &flag, error_message);
+  *out = flag != 0;
+  return status;
+}
+
+static inline hydra_status_t
+hydra_codegen_string(const hydra_config_t* config, const char* path,
+                     const hydra_value_t* value, const char** out,
+                     char** error_message) {
+  char* copy = NULL;
+  if (value->type == HYDRA_VALUE_STRING) {
+    *out = value->as.string.data;
+    return HYDRA_STATUS_OK;
+  }
+  hydra_status_t status =
+      hydra_config_get_string(config, path, &copy, error_message);
+  hydra_string_free(copy);
+  return status == HYDRA_STATUS_OK ? HYDRA_STATUS_TYPE_MISMATCH : status;
+}
+
+/* Allocates `*items` for the sequence fetched from `path`. */
+static inline hydra_status_t
+hydra_codegen_sequence(const hydra_config_t* config, const char* path,
+                       const hydra_value_t* value, size_t element_size,
+                       void** items, size_t* count, char** error_message) {
+  if (value->type != HYDRA_VALUE_SEQUENCE) {
+    hydra_config_iter_t* iter = NULL;
+    hydra_status_t status =
+        hydra_config_sequence_iter(config, path, &iter, error_message);
+    hydra_config_iter_destroy(iter);
+    return status == HYDRA_STATUS_OK ? HYDRA_STATUS_TYPE_MISMATCH : status;
+  }
+  *count = value->as.size;
+  *items = calloc(*count > 0 ? *count : 1, element_size);
+  return *items != NULL ? HYDRA_STATUS_OK : HYDRA_STATUS_OUT_OF_MEMORY;
+}
+
+/* Fetches elements 0 .. count-1 of `path` in one call; release `paths` and
+ * `values` with hydra_codegen_free_elements. */
+static inline hydra_status_t
+hydra_codegen_fetch_elements(const hydra_config_t* config, const char* path,
+                             size_t count, char*** paths,
+                             hydra_value_t** values, char** error_message) {
+  *paths  = (char**)calloc(count > 0 ? count : 1, sizeof(char*));
+  *values = (hydra_value_t*)calloc(count > 0 ? count : 1,
+                                   sizeof(hydra_value_t));
+  if (*paths == NULL || *values == NULL) {
+    free(*paths);
+    free(*values);
+    *paths  = NULL;
+    *values = NULL;
+    return HYDRA_STATUS_OUT_OF_MEMORY;
+  }
+  for (size_t i = 0; i < count; ++i) {
+    char index[24];
+    snprintf(index, sizeof(index), "%zu", i);
+    (*paths)[i] = hydra_codegen_path(path, index);
+    if ((*paths)[i] == NULL) {
+      return HYDRA_STATUS_OUT_OF_MEMORY;
+    }
+  }
+  return hydra_config_get_many(config, (const char* const*)*paths, count,
+                               *values, error_message);
+}
+
+static inline void hydra_codegen_free_elements(char** paths,
+                                               hydra_value_t* values,
+                                               size_t count) {
+  if (paths != NULL) {
+    hydra_codegen_free_paths(paths, count);
+  }
+  free(paths);
+  free(values);
+}
+
+#endif /* HYDRA_CODEGEN_HELPERS */
+)";
+
+// Fields the C struct carries, with their index among the fetched keys.
+std::vector<const Field*> c_fields(const Type& type) {
+  std::vector<const Field*> fields;
+  for (const Field& field : type.fields) {
+    if (c_supported(*field.type) && plain_key(field.key)) {
+      fields.push_back(&field);
+    }
+  }
+  return fields;
+}
+
+void collect_c_structs(const Type& type, std::vector<const Type*>& structs) {
+  if (type.kind == Type::Sequence) {
+    collect_c_structs(*type.element, structs);
+  } else if (type.kind == Type::Struct) {
+    for (const Field* field : c_fields(type)) {
+      collect_c_structs(*field->type, structs);
+    }
+    structs.push_back(&type);
+  }
+}
+
+void emit_c_struct(std::ostream& out, const Type& type) {
+  out << "typedef struct " << type.c_name << " {\n";
+  for (const Field& field : type.fields) {
+    if (!c_supported(*field.type) || !plain_key(field.key)) {
+      out << "  /* " << field.key << ": not mirrored in C */\n";
+    } else if (field.type->kind == Type::Sequence) {
+      out << "  " << c_type(*field.type->element) << "* " << field.ident
+          << ";\n  size_t " << field.ident << "_count;\n";
+    } else {
+      out << "  " << c_type(*field.type) << " " << field.ident << ";\n";
+    }
+  }
+  out << "} " << type.c_name << "_t;\n\n";
+}
+
+void emit_c_release(std::ostream& out, const Type& type) {
+  out << "static inline void " << type.c_name << "_release(" << type.c_name
+      << "_t* value) {\n";
+  bool owns = false;
+  for (const Field* field : c_fields(type)) {
+    owns = owns || field->type->kind == Type::Sequence ||
+           field->type->kind == Type::Struct;
+    if (field->type->kind == Type::Sequence) {
+      const Type& element = *field->type->element;
+      if (element.kind == Type::Struct) {
+        out << "  for (size_t i = 0; value->" << field->ident
+            << " != NULL && i < value->" << field->ident << "_count; ++i) {\n"
+            << "    " << element.c_name << "_release(&value->" << field->ident
+            << "[i]);\n  }\n";
+      }
+      out << "  free(value->" << field->ident << ");\n"
+          << "  value->" << field->ident << " = NULL;\n"
+          << "  value->" << field->ident << "_count = 0;\n";
+    } else if (field->type->kind == Type::Struct) {
+      out << "  " << field->type->c_name << "_release(&value->"
+          << field->ident << ");\n";
+    }
+  }
+  out << (owns ? "" : "  (void)value;\n") << "}\n\n";
+}
+
+void emit_c_sequence(std::ostream& out, const Field& field, size_t index) {
+  const Type& element = *field.type->element;
+  std::string target  = "out->" + field.ident;
+  out << "  if (status == HYDRA_STATUS_OK) {\n"
+      << "    status = hydra_codegen_sequence(config, paths[" << index
+      << "], &values[" << index << "], sizeof(*" << target
+      << "), (void**)&" << target << ", &" << target << "_count, "
+      << "error_message);\n"
+      << "  }\n";
+  if (element.kind == Type::Struct) {
+    out << "  for (size_t i = 0; status == HYDRA_STATUS_OK && i < " << target
+        << "_count; ++i) {\n"
+        << "    char index[24];\n"
+        << "    snprintf(index, sizeof(index), \"%zu\", i);\n"
+        << "    char* element = hydra_codegen_path(paths[" << index
+        << "], index);\n"
+        << "    status = element == NULL ? HYDRA_STATUS_OUT_OF_MEMORY\n"
+        << "                             : " << element.c_name
+        << "_load_at(config, element, &" << target << "[i],\n"
+        << "                                   error_message);\n"
+        << "    free(element);\n"
+        << "  }\n";
+    return;
+  }
+  out << "  if (status == HYDRA_STATUS_OK) {\n"
+      << "    char** element_paths        = NULL;\n"
+      << "    hydra_value_t* element_values = NULL;\n"
+      << "    status = hydra_codegen_fetch_elements(config, paths[" << index
+      << "], " << target << "_count,\n"
+      << "                                          &element_paths, "
+         "&element_values,\n"
+      << "                                          error_message);\n"
+      << "    for (size_t i = 0; status == HYDRA_STATUS_OK && i < " << target
+      << "_count; ++i) {\n"
+      << "      status = " << c_converter(element)
+      << "(config, element_paths[i], &element_values[i],\n"
+      << "                 &" << target << "[i], error_message);\n"
+      << "    }\n"
+      << "    hydra_codegen_free_elements(element_paths, element_values, "
+      << target << "_count);\n"
+      << "  }\n";
+}
+
+void emit_c_loader(std::ostream& out, const Type& type) {
+  std::vector<const Field*> fields = c_fields(type);
+  out << "static inline hydra_status_t " << type.c_name
+      << "_load_at(const hydra_config_t* config, const char* prefix, "
+      << type.c_name << "_t* out, char** error_message) {\n";
+  if (fields.empty()) {
+    out << "  (void)config;\n  (void)prefix;\n  (void)out;\n"
+        << "  (void)error_message;\n  return HYDRA_STATUS_OK;\n}\n\n";
+    return;
+  }
+  out << "  static const char* const keys[] = {";
+  for (size_t i = 0; i < fields.size(); ++i) {
+    out << (i ? ", " : "") << "\"" << fields[i]->key << "\"";
+  }
+  out << "};\n"
+      << "  char* paths[" << fields.size() << "];\n"
+      << "  hydra_value_t values[" << fields.size() << "];\n"
+      << "  hydra_status_t status = hydra_codegen_fetch(config, prefix, keys, "
+      << fields.size() << ", paths, values, error_message);\n"
+      << "  if (status != HYDRA_STATUS_OK) {\n    return status;\n  }\n";
+  for (size_t i = 0; i < fields.size(); ++i) {
+    const Field& field = *fields[i];
+    if (field.type->kind == Type::Sequence) {
+      emit_c_sequence(out, field, i);
+    } else if (field.type->kind == Type::Struct) {
+      out << "  if (status == HYDRA_STATUS_OK) {\n"
+          << "    status = " << field.type->c_name << "_load_at(config, paths["
+          << i << "], &out->" << field.ident << ", error_message);\n"
+          << "  }\n";
+    } else {
+      out << "  if (status == HYDRA_STATUS_OK) {\n"
+          << "    status = " << c_converter(*field.type) << "(config, paths["
+          << i << "], &values[" << i << "], &out->" << field.ident
+          << ", error_message);\n"
+          << "  }\n";
+    }
+  }
+  out << "  hydra_codegen_free_paths(paths, " << fields.size() << ");\n"
+      << "  return status;\n}\n\n";
+}
+
+void emit_c(std::ostream& out, const Type& root, const std::string& source,
+            const std::string& stem) {
+  std::string guard = stem;
+  for (char& c : guard) {
+    c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+  }
+  out << "/* Generated by hydra-codegen from " << source
+      << "; do not edit.\n"
+      << " *\n"
+      << " * " << stem << "_load fills " << root.c_name
+      << "_t in one hydra_config_get_many call per\n"
+      << " * mapping. Strings point into the config and stay valid until it "
+         "is\n"
+      << " * modified or destroyed; sequences are allocated and freed by\n"
+      << " * " << stem << "_release. */\n"
+      << "#ifndef " << guard << "_H\n#define " << guard << "_H\n\n"
+      << "#include \"hydra/c_api.h\"\n\n"
+      << "#include <stdbool.h>\n#include <stdint.h>\n#include <stdio.h>\n"
+      << "#include <stdlib.h>\n#include <string.h>\n\n"
+      << "#ifdef __cplusplus\nextern \"C\" {\n#endif\n\n"
+      << kCHelpers << "\n";
+
+  std::vector<const Type*> structs;
+  collect_c_structs(root, structs);
+  for (const Type* type : structs) {
+    emit_c_struct(out, *type);
+  }
+  for (const Type* type : structs) {
+    emit_c_release(out, *type);
+  }
+  for (const Type* type : structs) {
+    out << "static inline hydra_status_t " << type->c_name
+        << "_load_at(const hydra_config_t* config, const char* prefix, "
+        << type->c_name << "_t* out, char** error_message);\n";
+  }
+  out << "\n";
+  for (const Type* type : structs) {
+    emit_c_loader(out, *type);
+  }
+  out << "static inline hydra_status_t " << stem
+      << "_load(const hydra_config_t* config, " << root.c_name
+      << "_t* out, char** error_message) {\n"
+      << "  memset(out, 0, sizeof(*out));\n"
+      << "  hydra_status_t status = " << root.c_name
+      << "_load_at(config, \"\", out, error_message);\n"
+      << "  if (status != HYDRA_STATUS_OK) {\n"
+      << "    " << root.c_name << "_release(out);\n  }\n"
+      << "  return status;\n}\n\n"
+      << "#ifdef __cplusplus\n}\n#endif\n\n#endif\n";
+}
+
+// ---- Embedded config ----
+
+void emit_embedded(std::ostream& header, std::ostream& source,
+                   const std::string& blob, const std::string& config_path,
+                   const std::string& symbol) {
+  std::string guard = symbol;
+  for (char& c : guard) {
+    c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+  }
+  header << "/* Generated by hydra-codegen from " << config_path
+         << "; do not edit.\n"
+         << " *\n"
+         << " * The composed config, for hydra_initialize_embedded(argc, argv, "
+         << symbol << ",\n"
+         << " * " << symbol << "_size, &error) or "
+         << "hydra::utils::initialize_embedded. */\n"
+         << "#ifndef " << guard << "_H\n#define " << guard << "_H\n\n"
+         << "#include <stddef.h>\n\n"
+         << "#ifdef __cplusplus\nextern \"C\" {\n#endif\n\n"
+         << "extern const unsigned char " << symbol << "[];\n"
+         << "extern const size_t " << symbol << "_size;\n\n"
+         << "#ifdef __cplusplus\n}\n#endif\n\n#endif\n";
+
+  source << "/* Generated by hydra-codegen from " << config_path
+         << "; do not edit. */\n"
+         << "#include \"" << symbol << ".h\"\n\n"
+         << "const unsigned char " << symbol << "[" << blob.size()
+         << "] = {";
+  static const char* const digits = "0123456789abcdef";
+  for (size_t i = 0; i < blob.size(); ++i) {
+    auto byte = static_cast<unsigned char>(blob[i]);
+    source << (i % 12 == 0 ? "\n   " : "") << " 0x" << digits[byte >> 4]
+           << digits[byte & 15] << ",";
+  }
+  source << "\n};\n\n"
+         << "const size_t " << symbol << "_size = sizeof(" << symbol
+         << ");\n";
+}
+
+void write_file(const fs::path& path, const std::string& content) {
+  // Leave an unchanged file alone so dependents are not rebuilt.
+  std::ifstream existing(path, std::ios::binary);
+  std::string previous((std::istreambuf_iterator<char>(existing)),
+                       std::istreambuf_iterator<char>());
+  if (existing && previous == content) {
+    return;
+  }
+  existing.close();
+  std::ofstream out(path, std::ios::binary);
+  out << content;
+  if (!out) {
+    throw std::runtime_error("Failed to write " + path.string());
+  }
+}
+
+void print_usage() {
+  std::cout << "Usage: hydra-codegen --config <file.yaml> --output-dir <dir> "
+               "[--name <Type>] [--namespace <ns>] [--embed] "
+               "[overrides...]\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) try {
+  std::string config_path;
+  std::string output_dir;
+  std::string name = "AppConfig";
+  std::string name_space;
+  bool embed = false;
+  std::vector<std::string> overrides;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    auto value      = [&]() -> std::string {
+      if (i + 1 >= argc) {
+        throw std::runtime_error("Missing argument for " + arg);
+      }
+      return argv[++i];
+    };
+    if (arg == "-h" || arg == "--help") {
+      print_usage();
+      return 0;
+    } else if (arg == "-c" || arg == "--config") {
+      config_path = value();
+    } else if (arg == "-o" || arg == "--output-dir") {
+      output_dir = value();
+    } else if (arg == "--name") {
+      name = value();
+    } else if (arg == "--namespace") {
+      name_space = value();
+    } else if (arg == "--embed") {
+      embed = true;
+    } else {
+      overrides.push_back(arg);
+    }
+  }
+  if (config_path.empty() || output_dir.empty() || identifier(name) != name) {
+    print_usage();
+    return 1;
+  }
+  std::string stem = snake_case(name);
+  fs::create_directories(output_dir);
+
+  if (embed) {
+    // Interpolations and the job name stay unresolved so they follow the
+    // program that loads the blob.
+    std::string blob = serialize_config(
+        hydra::utils::compose({fs::path(config_path)}, overrides));
+    std::ostringstream header;
+    std::ostringstream source;
+    emit_embedded(header, source, blob, config_path, stem + "_embedded");
+    write_file(fs::path(output_dir) / (stem + "_embedded.h"), header.str());
+    write_file(fs::path(output_dir) / (stem + "_embedded.c"), source.str());
+    return 0;
+  }
+
+  // Composition arguments as hydra::utils::initialize expects them.
+  std::vector<std::string> compose_args = {"hydra-codegen", "--config",
+                                           config_path};
+  compose_args.insert(compose_args.end(), overrides.begin(), overrides.end());
+  std::vector<char*> compose_argv;
+  for (std::string& arg : compose_args) {
+    compose_argv.push_back(arg.data());
+  }
+  ConfigNode config = hydra::utils::initialize(
+      static_cast<int>(compose_argv.size()), compose_argv.data(), "");
+
+  auto root = infer(config, name, name, stem);
+  if (root->kind != Type::Struct) {
+    throw std::runtime_error(config_path + " does not compose to a mapping");
+  }
+
+  std::ostringstream cpp;
+  emit_cpp(cpp, *root, config_path, name_space, stem);
+  std::ostringstream c;
+  emit_c(c, *root, config_path, stem);
+
+  write_file(fs::path(output_dir) / (stem + ".hpp"), cpp.str());
+  write_file(fs::path(output_dir) / (stem + ".h"), c.str());
+  return 0;
+} catch (const std::exception& ex) {
+  std::cerr << "hydra-codegen: " << ex.what() << "\n";
+  return 1;
+}
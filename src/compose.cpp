@@ -0,0 +1,198 @@
+#include "hydra/compose.hpp"
+
+#include "hydra/overrides.hpp"
+#include "hydra/schema.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#ifdef _WIN32
+#include <stdlib.h>
+#define HYDRA_ENVIRON _environ
+#else
+#include <unistd.h>
+extern char** environ;
+#define HYDRA_ENVIRON environ
+#endif
+
+namespace hydra {
+
+namespace {
+
+// Schemas named by hydra.schema, compiled once per path per process so that
+// composing many configs against the same file only pays for validation.
+const Schema& cached_schema(const std::string& path) {
+  static std::mutex mutex;
+  static std::map<std::string, Schema> schemas;
+  std::lock_guard<std::mutex> lock(mutex);
+  auto it = schemas.find(path);
+  if (it == schemas.end()) {
+    it = schemas.emplace(path, Schema::load_file(path)).first;
+  }
+  return it->second;
+}
+
+// Profiles named by hydra.access_profile.load, read once per path; null
+// when the file does not exist yet (the run that records it).
+std::shared_ptr<const AccessProfile>
+cached_profile(const std::string& path) {
+  static std::mutex mutex;
+  static std::map<std::string, std::shared_ptr<const AccessProfile>> profiles;
+  std::lock_guard<std::mutex> lock(mutex);
+  auto it = profiles.find(path);
+  if (it == profiles.end()) {
+    std::shared_ptr<const AccessProfile> profile;
+    std::error_code ec;
+    if (std::filesystem::exists(path, ec)) {
+      profile = std::make_shared<const AccessProfile>(
+          AccessProfile::load_file(path));
+    }
+    it = profiles.emplace(path, std::move(profile)).first;
+  }
+  return it->second;
+}
+
+} // namespace
+
+ComposeContext ComposeContext::from_process() {
+  ComposeContext context;
+  for (char** entry = HYDRA_ENVIRON; entry != nullptr && *entry != nullptr;
+       ++entry) {
+    std::string text = *entry;
+    size_t equals    = text.find('=');
+    if (equals != std::string::npos && equals > 0) {
+      context.environment.emplace(text.substr(0, equals),
+                                  text.substr(equals + 1));
+    }
+  }
+  return context;
+}
+
+ResolveOptions ComposeContext::resolve_options() const {
+  ResolveOptions options;
+  options.getenv =
+      [this](const std::string& name) -> std::optional<std::string> {
+    auto it = environment.find(name);
+    if (it == environment.end()) {
+      return std::nullopt;
+    }
+    return it->second;
+  };
+  options.now = clock;
+  return options;
+}
+
+ConfigNode ComposeContext::compose_unresolved(const OverrideSet& set) const {
+  ConfigNode config = base ? *base : make_mapping();
+
+  auto load = [&](const std::filesystem::path& path) {
+    ConfigNode loaded = cache ? load_yaml_file(path, *cache)
+                              : load_yaml_file(path);
+    merge(config, loaded);
+  };
+  if (set.config_files.empty() && !default_config.empty()) {
+    load(default_config);
+  }
+  for (const auto& path : set.config_files) {
+    load(path);
+  }
+
+  for (const auto& expr : set.overrides) {
+    Override ov = parse_override(expr);
+    assign_path(config, ov.path, std::move(ov.value), ov.require_new);
+  }
+  return config;
+}
+
+ConfigNode ComposeContext::compose(const OverrideSet& set,
+                                   bool* projected) const {
+  if (projected != nullptr) {
+    *projected = false;
+  }
+  ConfigNode config = compose_unresolved(set);
+
+  const ConfigNode* job_name_node = find_path(config, {"hydra", "job", "name"});
+  if (!job_name_node || job_name_node->is_null()) {
+    assign_path(config, {"hydra", "job", "name"}, make_string(job_name),
+                false);
+  }
+
+  const ConfigNode* schema_path = find_path(config, {"hydra", "schema"});
+  bool has_schema = schema_path != nullptr && schema_path->is_string();
+
+  std::shared_ptr<const AccessProfile> access_profile = profile;
+  const ConfigNode* profile_path =
+      find_path(config, {"hydra", "access_profile", "load"});
+  if (!access_profile && use_access_profile && profile_path != nullptr &&
+      profile_path->is_string()) {
+    access_profile = cached_profile(profile_path->as_string());
+  }
+  if (access_profile && use_access_profile && !has_schema) {
+    ConfigNode selected = access_profile->project(config);
+    try {
+      resolve_interpolations(selected, resolve_options());
+      if (projected != nullptr) {
+        *projected = true;
+      }
+      return selected;
+    } catch (const std::exception&) {
+      // A reference outside the profile; resolve everything instead.
+    }
+  }
+
+  resolve_interpolations(config, resolve_options());
+  if (has_schema) {
+    cached_schema(schema_path->as_string()).check(config);
+  }
+  return config;
+}
+
+std::future<ConfigNode> compose_async(ComposeContext context,
+                                      OverrideSet set) {
+  return std::async(std::launch::async,
+                    [context = std::move(context), set = std::move(set)] {
+                      return context.compose(set);
+                    });
+}
+
+std::vector<ComposeResult> compose_many(const ComposeContext& context,
+                                        std::span<const OverrideSet> sets,
+                                        size_t threads) {
+  std::vector<ComposeResult> results(sets.size());
+  std::atomic<size_t> next{0};
+
+  auto work = [&] {
+    for (size_t i = next.fetch_add(1, std::memory_order_relaxed);
+         i < sets.size(); i = next.fetch_add(1, std::memory_order_relaxed)) {
+      try {
+        results[i].config = context.compose(sets[i]);
+      } catch (const std::exception& ex) {
+        results[i].error = ex.what();
+      } catch (...) {
+        results[i].error = "unknown error";
+      }
+    }
+  };
+
+  if (threads == 0) {
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  threads = std::min(threads, std::max<size_t>(sets.size(), 1));
+
+  std::vector<std::thread> workers;
+  workers.reserve(threads - 1);
+  for (size_t i = 1; i < threads; ++i) {
+    workers.emplace_back(work);
+  }
+  work();
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+  return results;
+}
+
+} // namespace hydra
@@ -0,0 +1,170 @@
+#include "hydra/config_blob.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace hydra {
+
+namespace {
+
+constexpr char kMagic[8]     = {'H', 'Y', 'D', 'R', 'A', 'C', 'F', 'G'};
+constexpr uint32_t kVersion  = 1;
+constexpr unsigned kMaxDepth = 512;
+
+enum Tag : uint8_t {
+  kNull     = 0,
+  kBool     = 1,
+  kInt      = 2,
+  kDouble   = 3,
+  kString   = 4,
+  kSequence = 5,
+  kMapping  = 6
+};
+
+template <typename T> void put(std::string& out, T value) {
+  out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void put_string(std::string& out, const std::string& value) {
+  if (value.size() > UINT32_MAX) {
+    throw std::runtime_error("String too long to serialize");
+  }
+  put<uint32_t>(out, static_cast<uint32_t>(value.size()));
+  out += value;
+}
+
+void put_node(std::string& out, const ConfigNode& node) {
+  if (node.is_bool()) {
+    put<uint8_t>(out, kBool);
+    put<uint8_t>(out, node.as_bool() ? 1 : 0);
+  } else if (node.is_int()) {
+    put<uint8_t>(out, kInt);
+    put<int64_t>(out, node.as_int());
+  } else if (node.is_double()) {
+    put<uint8_t>(out, kDouble);
+    put<double>(out, node.as_double());
+  } else if (node.is_string()) {
+    put<uint8_t>(out, kString);
+    put_string(out, node.as_string());
+  } else if (node.is_sequence()) {
+    put<uint8_t>(out, kSequence);
+    put<uint32_t>(out, static_cast<uint32_t>(node.as_sequence().size()));
+    for (const ConfigNode& item : node.as_sequence()) {
+      put_node(out, item);
+    }
+  } else if (node.is_mapping()) {
+    put<uint8_t>(out, kMapping);
+    put<uint32_t>(out, static_cast<uint32_t>(node.as_mapping().size()));
+    for (const auto& [key, value] : node.as_mapping()) {
+      put_string(out, key);
+      put_node(out, value);
+    }
+  } else {
+    put<uint8_t>(out, kNull);
+  }
+}
+
+class Reader {
+public:
+  Reader(const void* data, size_t size)
+      : data_(static_cast<const char*>(data)), size_(size) {}
+
+  template <typename T> T get() {
+    T value;
+    std::memcpy(&value, take(sizeof(value)), sizeof(value));
+    return value;
+  }
+
+  std::string get_string() {
+    uint32_t length = get<uint32_t>();
+    return std::string(take(length), length);
+  }
+
+  ConfigNode get_node(unsigned depth) {
+    if (depth > kMaxDepth) {
+      throw std::runtime_error("Config blob is nested too deeply");
+    }
+    switch (get<uint8_t>()) {
+    case kNull:
+      return ConfigNode();
+    case kBool:
+      return ConfigNode(get<uint8_t>() != 0);
+    case kInt:
+      return ConfigNode(get<int64_t>());
+    case kDouble:
+      return ConfigNode(get<double>());
+    case kString:
+      return ConfigNode(get_string());
+    case kSequence: {
+      uint32_t count = get<uint32_t>();
+      ConfigNode::seq_t items;
+      // Every element takes at least its type byte.
+      items.reserve(count <= remaining() ? count : 0);
+      for (uint32_t i = 0; i < count; ++i) {
+        items.push_back(get_node(depth + 1));
+      }
+      return ConfigNode(std::move(items));
+    }
+    case kMapping: {
+      uint32_t count = get<uint32_t>();
+      ConfigNode::map_t mapping;
+      for (uint32_t i = 0; i < count; ++i) {
+        std::string key = get_string();
+        // Keys were written in order, so each one goes at the end.
+        mapping.emplace_hint(mapping.end(), std::move(key),
+                             get_node(depth + 1));
+      }
+      return ConfigNode(std::move(mapping));
+    }
+    default:
+      throw std::runtime_error("Config blob has an unknown node type");
+    }
+  }
+
+  size_t remaining() const { return size_ - offset_; }
+
+private:
+  const char* take(size_t count) {
+    if (count > remaining()) {
+      throw std::runtime_error("Config blob is truncated");
+    }
+    const char* at = data_ + offset_;
+    offset_ += count;
+    return at;
+  }
+
+  const char* data_;
+  size_t size_;
+  size_t offset_ = 0;
+};
+
+} // namespace
+
+std::string serialize_config(const ConfigNode& root) {
+  std::string out(kMagic, sizeof(kMagic));
+  put<uint32_t>(out, kVersion);
+  put_node(out, root);
+  return out;
+}
+
+ConfigNode deserialize_config(const void* data, size_t size) {
+  if (data == nullptr || size < sizeof(kMagic) + sizeof(uint32_t) ||
+      std::memcmp(data, kMagic, sizeof(kMagic)) != 0) {
+    throw std::runtime_error("Not a config blob");
+  }
+  Reader reader(static_cast<const char*>(data) + sizeof(kMagic),
+                size - sizeof(kMagic));
+  if (reader.get<uint32_t>() != kVersion) {
+    throw std::runtime_error("Unsupported config blob version");
+  }
+  ConfigNode root = reader.get_node(0);
+  if (reader.remaining() != 0) {
+    throw std::runtime_error("Config blob has trailing data");
+  }
+  return root;
+}
+
+} // namespace hydra
@@ -1,5 +1,8 @@
 #include "hydra/config_node.hpp"
 
+#include "hydra/access_profile.hpp"
+#include "hydra/visit.hpp"
+
 #include <cmath>
 #include <sstream>
 #include <stdexcept>
@@ -54,16 +57,13 @@ bool ConfigNode::is_mapping() const {
 }
 
 bool ConfigNode::empty() const {
-  if (is_null()) {
-    return true;
-  }
-  if (is_sequence()) {
-    return as_sequence().empty();
-  }
-  if (is_mapping()) {
-    return as_mapping().empty();
-  }
-  return false;
+  overloaded is_empty{
+      [](std::nullptr_t) { return true; },
+      [](const seq_t& sequence) { return sequence.empty(); },
+      [](const map_t& mapping) { return mapping.empty(); },
+      [](const auto&) { return false; },
+  };
+  return visit(*this, is_empty);
 }
 
 bool ConfigNode::as_bool() const {
@@ -126,21 +126,16 @@ ConfigNode::map_t& ConfigNode::as_mapping() {
 }
 
 std::string ConfigNode::type_name() const {
-  if (is_null())
-    return "null";
-  if (is_bool())
-    return "bool";
-  if (is_int())
-    return "int";
-  if (is_double())
-    return "double";
-  if (is_string())
-    return "string";
-  if (is_sequence())
-    return "sequence";
-  if (is_mapping())
-    return "mapping";
-  return "unknown";
+  overloaded name{
+      [](std::nullptr_t) { return "null"; },
+      [](bool) { return "bool"; },
+      [](int64_t) { return "int"; },
+      [](double) { return "double"; },
+      [](const std::string&) { return "string"; },
+      [](const seq_t&) { return "sequence"; },
+      [](const map_t&) { return "mapping"; },
+  };
+  return visit(*this, name);
 }
 
 ConfigNode make_null() {
@@ -168,22 +163,26 @@ ConfigNode make_mapping() {
 namespace {
 
 ConfigNode deep_copy_impl(const ConfigNode& node) {
-  if (node.is_sequence()) {
-    ConfigNode::seq_t seq_copy;
-    seq_copy.reserve(node.as_sequence().size());
-    for (const auto& child : node.as_sequence()) {
-      seq_copy.push_back(deep_copy_impl(child));
-    }
-    return ConfigNode(std::move(seq_copy));
-  }
-  if (node.is_mapping()) {
-    ConfigNode::map_t map_copy;
-    for (const auto& entry : node.as_mapping()) {
-      map_copy.emplace(entry.first, deep_copy_impl(entry.second));
-    }
-    return ConfigNode(std::move(map_copy));
-  }
-  return node;
+  overloaded copy{
+      [](const ConfigNode::seq_t& sequence) {
+        ConfigNode::seq_t seq_copy;
+        seq_copy.reserve(sequence.size());
+        for (const auto& child : sequence) {
+          seq_copy.push_back(deep_copy_impl(child));
+        }
+        return ConfigNode(std::move(seq_copy));
+      },
+      [](const ConfigNode::map_t& mapping) {
+        ConfigNode::map_t map_copy;
+        for (const auto& entry : mapping) {
+          map_copy.emplace_hint(map_copy.end(), entry.first,
+                                deep_copy_impl(entry.second));
+        }
+        return ConfigNode(std::move(map_copy));
+      },
+      [](const auto& scalar) { return ConfigNode(scalar); },
+  };
+  return visit(node, copy);
 }
 
 } // namespace
@@ -209,24 +208,21 @@ void merge_maps(ConfigNode::map_t& destination,
 } // namespace
 
 void merge(ConfigNode& destination, const ConfigNode& source) {
-  if (source.is_null()) {
-    destination = ConfigNode(nullptr);
-    return;
-  }
-
-  if (destination.is_null()) {
-    destination = deep_copy(source);
-    return;
-  }
-
-  if (destination.is_mapping() && source.is_mapping()) {
-    merge_maps(destination.as_mapping(), source.as_mapping());
-    return;
-  }
-
-  // Replace destination with source when types differ or are non-map
-  // containers.
-  destination = deep_copy(source);
+  overloaded merge_into{
+      [&](std::nullptr_t) { destination = ConfigNode(nullptr); },
+      [&](const ConfigNode::map_t& mapping) {
+        auto* target = std::get_if<ConfigNode::map_t>(&destination.variant());
+        if (target != nullptr) {
+          merge_maps(*target, mapping);
+        } else {
+          destination = deep_copy(source);
+        }
+      },
+      // Replace destination with source when types differ or are non-map
+      // containers.
+      [&](const auto&) { destination = deep_copy(source); },
+  };
+  visit(source, merge_into);
 }
 
 ConfigNode merged(const ConfigNode& base, const ConfigNode& override_node) {
@@ -260,64 +256,52 @@ bool parse_index(const std::string& component, size_t& index) {
 } // namespace
 
 ConfigNode* find_path(ConfigNode& root, const std::vector<std::string>& path) {
-  ConfigNode* current = &root;
-  for (const auto& component : path) {
-    if (current->is_mapping()) {
-      auto& mapping = current->as_mapping();
-      auto it       = mapping.find(component);
-      if (it == mapping.end()) {
-        return nullptr;
-      }
-      current = &it->second;
-      continue;
-    }
-    if (current->is_sequence()) {
-      size_t index = 0;
-      if (!parse_index(component, index)) {
-        return nullptr;
-      }
-      auto& sequence = current->as_sequence();
-      if (index >= sequence.size()) {
-        return nullptr;
-      }
-      current = &sequence[index];
-      continue;
-    }
-    return nullptr;
-  }
-  return current;
+  return const_cast<ConfigNode*>(
+      find_path(static_cast<const ConfigNode&>(root), path));
+}
+
+const ConfigNode* find_child(const ConfigNode& parent,
+                             const std::string& component) {
+  overloaded child{
+      [&](const ConfigNode::map_t& mapping) -> const ConfigNode* {
+        auto it = mapping.find(component);
+        return it != mapping.end() ? &it->second : nullptr;
+      },
+      [&](const ConfigNode::seq_t& sequence) -> const ConfigNode* {
+        size_t index = 0;
+        if (!parse_index(component, index)) {
+          return nullptr;
+        }
+        return index < sequence.size() ? &sequence[index] : nullptr;
+      },
+      [](const auto&) -> const ConfigNode* { return nullptr; },
+  };
+  return visit(parent, child);
 }
 
 const ConfigNode* find_path(const ConfigNode& root,
                             const std::vector<std::string>& path) {
+  track_access(path);
   const ConfigNode* current = &root;
   for (const auto& component : path) {
-    if (current->is_mapping()) {
-      const auto& mapping = current->as_mapping();
-      auto it             = mapping.find(component);
-      if (it == mapping.end()) {
-        return nullptr;
-      }
-      current = &it->second;
-      continue;
+    current = find_child(*current, component);
+    if (current == nullptr) {
+      return nullptr;
     }
-    if (current->is_sequence()) {
-      size_t index = 0;
-      if (!parse_index(component, index)) {
-        return nullptr;
-      }
-      const auto& sequence = current->as_sequence();
-      if (index >= sequence.size()) {
-        return nullptr;
-      }
-      current = &sequence[index];
-      continue;
-    }
-    return nullptr;
   }
   return current;
 }
 
+std::vector<std::string> path_components(WalkPath path) {
+  std::vector<std::string> components;
+  components.reserve(path.size());
+  for (const PathSegment& segment : path) {
+    components.push_back(segment.key != nullptr ? *segment.key
+                                                : std::to_string(segment.index));
+  }
+  return components;
+}
+
 void assign_path(ConfigNode& root, const std::vector<std::string>& path,
                  ConfigNode value, bool require_new) {
   if (path.empty()) {
@@ -1,11 +1,16 @@
 #include "hydra/config_utils.hpp"
 
-#include "hydra/interpolation.hpp"
-#include "hydra/overrides.hpp"
-#include "hydra/yaml_loader.hpp"
+#include "hydra/access_profile.hpp"
+#include "hydra/compose.hpp"
+#include "hydra/config_blob.hpp"
 
+#include <chrono>
 #include <filesystem>
+#include <future>
+#include <memory>
+#include <stdexcept>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace hydra::utils {
@@ -40,58 +45,71 @@ fs::path write_hydra_outputs(const ConfigNode& root,
   return run_dir;
 }
 
-ConfigNode initialize(int argc, char** argv,
-                      const std::string& default_config) {
-  // Parse command-line arguments
-  std::vector<fs::path> config_files;
-  std::vector<std::string> overrides;
-
+OverrideSet parse_command_line(int argc, char** argv) {
+  OverrideSet command_line;
   for (int i = 1; i < argc; ++i) {
     std::string arg = argv[i];
     if (arg == "-c" || arg == "--config") {
       if (i + 1 >= argc) {
         throw std::runtime_error("--config requires an argument");
       }
-      config_files.emplace_back(argv[++i]);
+      command_line.config_files.emplace_back(argv[++i]);
     } else if (arg.rfind("--config=", 0) == 0) {
-      config_files.emplace_back(arg.substr(9));
+      command_line.config_files.emplace_back(arg.substr(9));
     } else {
-      overrides.emplace_back(std::move(arg));
+      command_line.overrides.emplace_back(std::move(arg));
     }
   }
+  return command_line;
+}
 
-  if (config_files.empty() && !default_config.empty()) {
-    config_files.emplace_back(default_config);
-  }
-
-  // Load and merge config files
-  ConfigNode config = make_mapping();
-  for (const auto& path : config_files) {
-    ConfigNode loaded = load_yaml_file(path);
-    merge(config, loaded);
+ComposeContext process_context(int argc, char** argv) {
+  ComposeContext context = ComposeContext::from_process();
+  context.cache          = nullptr;
+  auto started           = std::chrono::system_clock::now();
+  context.clock          = [started] { return started; };
+  if (argc > 0 && argv != nullptr && argv[0] != nullptr) {
+    context.job_name = fs::path(argv[0]).filename().string();
   }
+  return context;
+}
 
-  // Apply overrides
-  for (const auto& expr : overrides) {
-    Override ov = parse_override(expr);
-    assign_path(config, ov.path, std::move(ov.value), ov.require_new);
-  }
+ConfigNode compose(const std::vector<fs::path>& config_files,
+                   const std::vector<std::string>& overrides) {
+  ComposeContext context;
+  context.cache = nullptr;
+  return context.compose_unresolved({config_files, overrides});
+}
 
-  // Set job name from program name if not already set
-  const ConfigNode* job_name_node = find_path(config, {"hydra", "job", "name"});
-  if (!job_name_node || job_name_node->is_null()) {
-    std::string job_name = "app"; // default fallback
-    if (argc > 0 && argv != nullptr && argv[0] != nullptr) {
-      // Extract basename from argv[0]
-      fs::path prog_path = argv[0];
-      job_name           = prog_path.filename().string();
-    }
-    assign_path(config, {"hydra", "job", "name"}, make_string(job_name), false);
-  }
+ConfigNode initialize(int argc, char** argv,
+                      const std::string& default_config) {
+  ComposeContext context = process_context(argc, argv);
+  context.default_config = default_config;
+  ConfigNode config      = context.compose(parse_command_line(argc, argv));
+  configure_access_tracking(config);
+  return config;
+}
 
-  // Resolve interpolations
-  resolve_interpolations(config);
+std::future<ConfigNode> initialize_async(int argc, char** argv,
+                                         const std::string& default_config) {
+  ComposeContext context = process_context(argc, argv);
+  context.default_config = default_config;
+  OverrideSet set        = parse_command_line(argc, argv);
+  return std::async(std::launch::async,
+                    [context = std::move(context), set = std::move(set)] {
+                      ConfigNode config = context.compose(set);
+                      configure_access_tracking(config);
+                      return config;
+                    });
+}
 
+ConfigNode initialize_embedded(int argc, char** argv, const void* blob,
+                               size_t size) {
+  ComposeContext context = process_context(argc, argv);
+  context.base =
+      std::make_shared<const ConfigNode>(deserialize_config(blob, size));
+  ConfigNode config = context.compose(parse_command_line(argc, argv));
+  configure_access_tracking(config);
   return config;
 }
 
@@ -2,34 +2,24 @@
 
 #include "hydra/overrides.hpp"
 #include "hydra/time_utils.hpp"
+#include "hydra/visit.hpp"
 
 #include <cctype>
+#include <chrono>
 #include <cstdlib>
+#include <optional>
 #include <set>
 #include <sstream>
 #include <stdexcept>
 #include <string_view>
 #include <utility>
+#include <variant>
 #include <vector>
 
 namespace hydra {
 
 namespace {
 
-std::string join_path(const std::vector<std::string>& path) {
-  if (path.empty()) {
-    return "<root>";
-  }
-  std::ostringstream oss;
-  for (size_t i = 0; i < path.size(); ++i) {
-    if (i > 0) {
-      oss << '.';
-    }
-    oss << path[i];
-  }
-  return oss.str();
-}
-
 std::string trim_copy(std::string text) {
   size_t begin = 0;
   while (begin < text.size() &&
@@ -65,131 +55,121 @@ std::string node_to_string(const ConfigNode& node) {
   throw std::runtime_error("Cannot interpolate complex node types");
 }
 
-std::string resolve_string(ConfigNode& root,
-                           const std::vector<std::string>& current_path,
-                           const std::string& value,
-                           std::set<std::string>& resolving,
-                           std::set<std::string>& resolved);
-
-void resolve_node(ConfigNode& root, ConfigNode& node,
-                  const std::vector<std::string>& path,
-                  std::set<std::string>& resolving,
-                  std::set<std::string>& resolved);
-
-std::string resolve_env_expression(ConfigNode& root,
-                                   const std::vector<std::string>& current_path,
-                                   const std::string& body,
-                                   std::set<std::string>& resolving,
-                                   std::set<std::string>& resolved) {
-  auto comma           = body.find(',');
-  std::string var      = trim_copy(body.substr(0, comma));
-  std::string fallback = comma == std::string::npos
-                             ? std::string()
-                             : trim_copy(body.substr(comma + 1));
-
-  const char* env_value = std::getenv(var.c_str());
-  if (env_value != nullptr && *env_value != '\0') {
-    return std::string(env_value);
-  }
-  if (fallback.empty()) {
-    return std::string{};
+// State of one resolve_interpolations call. Nodes are tracked by address:
+// resolution rewrites strings in place and never restructures the tree.
+struct Resolver {
+  ConfigNode& root;
+  const ResolveOptions& options;
+  std::set<const ConfigNode*> resolving;
+  std::set<const ConfigNode*> resolved;
+
+  std::optional<std::string> getenv(const std::string& name) const {
+    if (options.getenv) {
+      return options.getenv(name);
+    }
+    const char* value = std::getenv(name.c_str());
+    if (value == nullptr) {
+      return std::nullopt;
+    }
+    return std::string(value);
   }
-  return resolve_string(root, current_path, fallback, resolving, resolved);
-}
 
-std::string resolve_expression(ConfigNode& root,
-                               const std::vector<std::string>& current_path,
-                               const std::string& expression,
-                               std::set<std::string>& resolving,
-                               std::set<std::string>& resolved) {
-  if (expression.rfind("now:", 0) == 0) {
-    return format_now(expression.substr(4));
-  }
-  if (expression.rfind("oc.env:", 0) == 0) {
-    return resolve_env_expression(root, current_path, expression.substr(7),
-                                  resolving, resolved);
+  std::chrono::system_clock::time_point now() const {
+    return options.now ? options.now() : std::chrono::system_clock::now();
   }
 
-  std::vector<std::string> target_path = parse_override_path(expression);
-  ConfigNode* target                   = find_path(root, target_path);
-  if (target == nullptr) {
-    std::ostringstream oss;
-    oss << "Interpolation reference '" << expression << "' not found";
-    throw std::runtime_error(oss.str());
-  }
-  resolve_node(root, *target, target_path, resolving, resolved);
-  return node_to_string(*target);
-}
+  std::string resolve_env_expression(const std::string& body) {
+    auto comma           = body.find(',');
+    std::string var      = trim_copy(body.substr(0, comma));
+    std::string fallback = comma == std::string::npos
+                               ? std::string()
+                               : trim_copy(body.substr(comma + 1));
 
-std::string resolve_string(ConfigNode& root,
-                           const std::vector<std::string>& current_path,
-                           const std::string& value,
-                           std::set<std::string>& resolving,
-                           std::set<std::string>& resolved) {
-  std::string result;
-  size_t pos = 0;
-  while (pos < value.size()) {
-    size_t start = value.find("${", pos);
-    if (start == std::string::npos) {
-      result.append(value.substr(pos));
-      break;
+    std::optional<std::string> env_value = getenv(var);
+    if (env_value && !env_value->empty()) {
+      return std::move(*env_value);
     }
-    result.append(value.substr(pos, start - pos));
-    size_t end = value.find('}', start + 2);
-    if (end == std::string::npos) {
-      throw std::runtime_error("Unterminated ${...} placeholder");
+    if (fallback.empty()) {
+      return std::string{};
     }
-    std::string expr = value.substr(start + 2, end - (start + 2));
-    result.append(
-        resolve_expression(root, current_path, expr, resolving, resolved));
-    pos = end + 1;
+    return resolve_string(fallback);
   }
-  return result;
-}
 
-void resolve_node(ConfigNode& root, ConfigNode& node,
-                  const std::vector<std::string>& path,
-                  std::set<std::string>& resolving,
-                  std::set<std::string>& resolved) {
-  std::string key = join_path(path);
-  if (resolved.count(key)) {
-    return;
-  }
-  if (!resolving.insert(key).second) {
-    std::ostringstream oss;
-    oss << "Detected interpolation cycle involving '" << key << "'";
-    throw std::runtime_error(oss.str());
-  }
+  std::string resolve_expression(const std::string& expression) {
+    if (expression.rfind("now:", 0) == 0) {
+      return format_time(expression.substr(4), now());
+    }
+    if (expression.rfind("oc.env:", 0) == 0) {
+      return resolve_env_expression(expression.substr(7));
+    }
 
-  if (node.is_mapping()) {
-    for (auto& entry : node.as_mapping()) {
-      auto child_path = path;
-      child_path.push_back(entry.first);
-      resolve_node(root, entry.second, child_path, resolving, resolved);
+    std::vector<std::string> target_path = parse_override_path(expression);
+    ConfigNode* target                   = find_path(root, target_path);
+    if (target == nullptr) {
+      std::ostringstream oss;
+      oss << "Interpolation reference '" << expression << "' not found";
+      throw std::runtime_error(oss.str());
+    }
+    if (resolving.count(target)) {
+      std::ostringstream oss;
+      oss << "Detected interpolation cycle involving '" << expression << "'";
+      throw std::runtime_error(oss.str());
     }
-  } else if (node.is_sequence()) {
-    auto& seq = node.as_sequence();
-    for (size_t idx = 0; idx < seq.size(); ++idx) {
-      auto child_path = path;
-      child_path.push_back(std::to_string(idx));
-      resolve_node(root, seq[idx], child_path, resolving, resolved);
+    // Only strings need resolving; collections cannot be interpolated.
+    resolve_leaf(*target);
+    return node_to_string(*target);
+  }
+
+  std::string resolve_string(const std::string& value) {
+    std::string result;
+    size_t pos = 0;
+    while (pos < value.size()) {
+      size_t start = value.find("${", pos);
+      if (start == std::string::npos) {
+        result.append(value.substr(pos));
+        break;
+      }
+      result.append(value.substr(pos, start - pos));
+      size_t end = value.find('}', start + 2);
+      if (end == std::string::npos) {
+        throw std::runtime_error("Unterminated ${...} placeholder");
+      }
+      std::string expr = value.substr(start + 2, end - (start + 2));
+      result.append(resolve_expression(expr));
+      pos = end + 1;
     }
-  } else if (node.is_string()) {
-    std::string resolved_value =
-        resolve_string(root, path, node.as_string(), resolving, resolved);
-    node = make_string(std::move(resolved_value));
+    return result;
   }
 
-  resolving.erase(key);
-  resolved.insert(std::move(key));
-}
+  // Plain strings are left untouched so that pointers handed out by the C
+  // API stay valid across repeated resolution.
+  void resolve_leaf(ConfigNode& node) {
+    auto* text = std::get_if<std::string>(&node.variant());
+    if (text == nullptr || text->find("${") == std::string::npos ||
+        resolved.count(&node)) {
+      return;
+    }
+    resolving.insert(&node);
+    std::string resolved_value = resolve_string(*text);
+    *text                      = std::move(resolved_value);
+    resolving.erase(&node);
+    resolved.insert(&node);
+  }
+
+  void resolve_all() {
+    walk(root, [this](WalkPath, ConfigNode& node) { resolve_leaf(node); });
+  }
+};
 
 } // namespace
 
 void resolve_interpolations(ConfigNode& root) {
-  std::set<std::string> resolving;
-  std::set<std::string> resolved;
-  resolve_node(root, root, {}, resolving, resolved);
+  resolve_interpolations(root, ResolveOptions{});
+}
+
+void resolve_interpolations(ConfigNode& root, const ResolveOptions& options) {
+  Resolver resolver{root, options, {}, {}};
+  resolver.resolve_all();
 }
 
 } // namespace hydra
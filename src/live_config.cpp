@@ -0,0 +1,192 @@
+#include "hydra/live_config.hpp"
+
+#include "hydra/interpolation.hpp"
+#include "hydra/overrides.hpp"
+
+#include <string_view>
+#include <thread>
+#include <utility>
+
+namespace hydra {
+
+namespace {
+
+// FNV-1a over a type tag and the value of every node, keys included.
+struct Hasher {
+  uint64_t hash = 14695981039346656037ull;
+
+  void bytes(const void* data, size_t size) {
+    const auto* p = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i) {
+      hash = (hash ^ p[i]) * 1099511628211ull;
+    }
+  }
+
+  template <typename T> void value(T v) { bytes(&v, sizeof(v)); }
+
+  void text(std::string_view s) {
+    value<uint64_t>(s.size());
+    bytes(s.data(), s.size());
+  }
+
+  void node(const ConfigNode& n) {
+    if (n.is_bool()) {
+      value<uint8_t>(1);
+      value<uint8_t>(n.as_bool() ? 1 : 0);
+    } else if (n.is_int()) {
+      value<uint8_t>(2);
+      value<int64_t>(n.as_int());
+    } else if (n.is_double()) {
+      value<uint8_t>(3);
+      value<double>(n.as_double());
+    } else if (n.is_string()) {
+      value<uint8_t>(4);
+      text(n.as_string());
+    } else if (n.is_sequence()) {
+      value<uint8_t>(5);
+      value<uint64_t>(n.as_sequence().size());
+      for (const ConfigNode& item : n.as_sequence()) {
+        node(item);
+      }
+    } else if (n.is_mapping()) {
+      value<uint8_t>(6);
+      value<uint64_t>(n.as_mapping().size());
+      for (const auto& [key, item] : n.as_mapping()) {
+        text(key);
+        node(item);
+      }
+    } else {
+      value<uint8_t>(0);
+    }
+  }
+};
+
+// Hash of the subtree at `path`, or 0 when there is none.
+uint64_t subtree_hash(const ConfigNode& root,
+                      const std::vector<std::string>& path) {
+  const ConfigNode* node = find_path(root, path);
+  return node != nullptr ? hash_config(*node) : 0;
+}
+
+} // namespace
+
+uint64_t hash_config(const ConfigNode& node) {
+  Hasher hasher;
+  hasher.node(node);
+  // Keep 0 free to mean "no subtree".
+  return hasher.hash != 0 ? hasher.hash : 1;
+}
+
+LiveConfig::LiveConfig(ConfigNode source) : source_(std::move(source)) {
+  ConfigNode resolved = deep_copy(source_);
+  resolve_interpolations(resolved);
+  current_.store(
+      new Snapshot(std::make_shared<const ConfigNode>(std::move(resolved))));
+}
+
+LiveConfig::~LiveConfig() {
+  delete current_.load();
+}
+
+// The read-side section: every operation is sequentially consistent so that
+// synchronize() either sees this reader registered or this reader sees the
+// pointer published before synchronize() started.
+LiveConfig::Snapshot LiveConfig::snapshot() const {
+  std::atomic<int64_t>& readers = readers_[epoch_.load() & 1].value;
+  readers.fetch_add(1);
+  Snapshot snapshot = *current_.load();
+  readers.fetch_sub(1);
+  return snapshot;
+}
+
+// Called with mutex_ held. A reader may have read the epoch one flip before
+// it registers, so both parities are drained in turn, flipping before each.
+void LiveConfig::synchronize() {
+  for (int phase = 0; phase < 2; ++phase) {
+    uint64_t parity = epoch_.fetch_add(1) & 1;
+    while (readers_[parity].value.load() != 0) {
+      std::this_thread::yield();
+    }
+  }
+}
+
+LiveConfig::Snapshot
+LiveConfig::update(const std::vector<std::string>& overrides) {
+  return update([&](ConfigNode& source) {
+    for (const std::string& expression : overrides) {
+      Override parsed = parse_override(expression);
+      assign_path(source, parsed.path, std::move(parsed.value),
+                  parsed.require_new);
+    }
+  });
+}
+
+LiveConfig::Snapshot
+LiveConfig::update(const std::function<void(ConfigNode&)>& mutate) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ConfigNode source = deep_copy(source_);
+  mutate(source);
+  return publish(std::move(source));
+}
+
+// Called with mutex_ held.
+LiveConfig::Snapshot LiveConfig::publish(ConfigNode source) {
+  ConfigNode resolved = deep_copy(source);
+  resolve_interpolations(resolved);
+  Snapshot snapshot = std::make_shared<const ConfigNode>(std::move(resolved));
+
+  auto published = std::make_unique<const Snapshot>(snapshot);
+
+  // Nothing below throws before the swap, so a failed update leaves both
+  // the source and the published snapshot untouched.
+  source_ = std::move(source);
+  const Snapshot* previous = current_.exchange(published.release());
+  version_.fetch_add(1, std::memory_order_acq_rel);
+  synchronize();
+  delete previous;
+
+  // Subscribers sharing a prefix share one hash computation.
+  const std::vector<std::string>* last_path = nullptr;
+  uint64_t last_hash                        = 0;
+  for (Subscriber& subscriber : subscribers_) {
+    uint64_t hash = last_path != nullptr && *last_path == subscriber.path
+                        ? last_hash
+                        : subtree_hash(*snapshot, subscriber.path);
+    last_path = &subscriber.path;
+    last_hash = hash;
+    if (hash != subscriber.hash) {
+      subscriber.hash = hash;
+      subscriber.callback(snapshot);
+    }
+  }
+  return snapshot;
+}
+
+LiveConfig::Subscription LiveConfig::subscribe(const std::string& prefix,
+                                               Callback callback) {
+  std::vector<std::string> path =
+      prefix.empty() ? std::vector<std::string>{} : parse_override_path(prefix);
+  std::lock_guard<std::mutex> lock(mutex_);
+  Subscription id = next_subscription_++;
+  uint64_t hash   = subtree_hash(*snapshot(), path);
+  // Kept sorted by path so publish() hashes each prefix once.
+  auto it = subscribers_.begin();
+  while (it != subscribers_.end() && it->path <= path) {
+    ++it;
+  }
+  subscribers_.insert(it, Subscriber{id, std::move(path), hash,
+                                     std::move(callback)});
+  return id;
+}
+
+void LiveConfig::unsubscribe(Subscription subscription) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto it = subscribers_.begin(); it != subscribers_.end(); ++it) {
+    if (it->id == subscription) {
+      subscribers_.erase(it);
+      return;
+    }
+  }
+}
+
+} // namespace hydra
@@ -22,7 +22,30 @@
 
 #include "hydra/log.h"
 
+#include "log_internal.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <pthread.h>
+#include <sched.h>
+#include <spawn.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
 #define MAX_CALLBACKS 32
+#define ASYNC_BATCH 64
+#define RECORD_BUFFER_SIZE 1024
+#define SINK_BUFFER_SIZE 16384
+#define ASYNC_FIELDS_SIZE 256
+#define MAX_FIELDS 16
+#define FIELDS_TEXT_SIZE 512
+#define RATE_SUMMARY_NS 60000000000LL
 
 typedef struct {
   log_LogFn fn;
@@ -38,38 +61,626 @@ static struct {
   Callback callbacks[MAX_CALLBACKS];
 } L;
 
+/*
+ * Async mode: producers claim a slot of a bounded lock-free ring (Vyukov's
+ * MPMC queue, used here with a single consumer), format the message into it
+ * and publish it; one background thread formats the prefix, runs the sinks
+ * and flushes once per batch.
+ */
+typedef struct {
+  atomic_size_t sequence;
+  time_t time;
+  const char* file;
+  const char* logger;
+  int line;
+  int level;
+  int field_count;
+  char message[LOG_ASYNC_MESSAGE_SIZE];
+  char fields[ASYNC_FIELDS_SIZE]; /* see encode_fields */
+} AsyncSlot;
+
+static struct {
+  AsyncSlot* slots;
+  size_t capacity;
+  int overflow;
+  atomic_bool active;
+  /* Producers between their check of `active` and the end of their enqueue;
+   * log_stop_async waits for it to reach zero before stopping the consumer,
+   * so the ring is never reset or freed under a producer. */
+  atomic_size_t producers;
+  _Alignas(64) atomic_size_t enqueue_pos;
+  _Alignas(64) size_t dequeue_pos; /* consumer only */
+  atomic_size_t written_pos;       /* dispatched and flushed */
+  atomic_ullong dropped;
+  unsigned long long dropped_reported; /* consumer only */
+  atomic_bool consumer_idle;
+  bool stop;    /* guarded by mutex */
+  bool running; /* guarded by mutex */
+  pthread_t thread;
+  pthread_mutex_t mutex;
+  pthread_cond_t wake;    /* producers -> consumer */
+  pthread_cond_t drained; /* consumer -> log_flush */
+} A = {
+    .mutex   = PTHREAD_MUTEX_INITIALIZER,
+    .wake    = PTHREAD_COND_INITIALIZER,
+    .drained = PTHREAD_COND_INITIALIZER,
+};
+
+/* Set on the consumer thread, whose sinks leave flushing to the batch. */
+static _Thread_local bool in_consumer;
+
+/*
+ * Rotation of a file sink runs on its own thread: producers only count bytes
+ * and wake it. The thread renames the segments, opens a fresh file and
+ * switches the sink over to it; see sink_output for the handover.
+ */
+typedef struct {
+  char* path;
+  long long max_bytes; /* 0: no size limit */
+  int backup_count;
+  int when;
+  bool compress;
+  atomic_llong bytes;
+  atomic_bool pending;
+  bool stop; /* guarded by mutex */
+  pthread_t thread;
+  pthread_mutex_t mutex;
+  pthread_cond_t wake;
+} Rotation;
+
+/*
+ * Built-in sinks format a whole record into one buffer and hand it to the
+ * kernel with a single write(2). Depending on the flush policy the record is
+ * written at once or appended to a per-sink buffer that is written when it
+ * fills, when a record at or above `arg` arrives, or every `arg` ms.
+ *
+ * The descriptor lives in one of two slots selected by `generation`. A
+ * writer announces itself in `writers` of the slot it is about to use, so a
+ * rotation can publish a new descriptor in the other slot and close the old
+ * one as soon as the writers still using it are done, without a lock.
+ */
+typedef struct {
+  atomic_int fds[2];
+  atomic_uint generation;
+  atomic_int writers[2];
+  bool in_use;
+  FILE* fp; /* NULL for the console; owns fds[] only until the first rotation */
+  Rotation* rotation;
+  bool color;
+  bool date;
+  bool json;
+  char* json_fields; /* `,"key":"value"...` added to every JSON record */
+  int policy;
+  int arg;
+  pthread_mutex_t mutex;
+  char* buffer;
+  size_t used;
+  int64_t last_write_ms;
+} Sink;
+
+static Sink console_sink = {
+    .fds    = {STDERR_FILENO, STDERR_FILENO},
+    .in_use = true,
+#ifdef LOG_USE_COLOR
+    .color  = true,
+#endif
+    .policy = LOG_FLUSH_RECORD,
+    .mutex  = PTHREAD_MUTEX_INITIALIZER,
+};
+
+static Sink file_sinks[MAX_CALLBACKS];
+/*
+ * Guards L.callbacks and the file_sinks table. Dispatch and the flushers
+ * hold it shared while they walk the tables; adding or removing a callback
+ * or sink holds it exclusively, so nothing is torn down under a reader.
+ * Independent of log_set_lock, which hydra does not install.
+ *
+ * Readers stand aside while a writer waits (the default rwlock would let
+ * busy producers starve log_remove_fp), except when the thread already
+ * reads: a callback that logs re-enters without locking again.
+ */
+static pthread_rwlock_t tables_lock = PTHREAD_RWLOCK_INITIALIZER;
+static atomic_int tables_writers;
+static _Thread_local int tables_depth;
+
+static void tables_read_lock(void) {
+  if (tables_depth++ > 0) {
+    return;
+  }
+  while (atomic_load_explicit(&tables_writers, memory_order_acquire) != 0) {
+    sched_yield();
+  }
+  pthread_rwlock_rdlock(&tables_lock);
+}
+
+static void tables_read_unlock(void) {
+  if (--tables_depth == 0) {
+    pthread_rwlock_unlock(&tables_lock);
+  }
+}
+
+static void tables_write_lock(void) {
+  atomic_fetch_add(&tables_writers, 1);
+  pthread_rwlock_wrlock(&tables_lock);
+}
+
+static void tables_write_unlock(void) {
+  pthread_rwlock_unlock(&tables_lock);
+  atomic_fetch_sub(&tables_writers, 1);
+}
+/* Lowest level a text sink accepts; see log_refresh_enabled_level. */
+static atomic_int sink_level;
+int log_enabled_level;
+static int file_sink_count;
+static atomic_int flush_tick_ms;
+
+/* One formatted clock per second per thread instead of a localtime() and two
+ * strftime() calls per record. */
+typedef struct {
+  time_t second;
+  struct tm tm;
+  char clock[16];
+  char date_clock[32];
+  char iso_clock[32];
+} TimeCache;
+
+static _Thread_local TimeCache time_cache = {.second = (time_t)-1};
+
 static const char* level_strings[] = {"TRACE", "DEBUG", "INFO",
                                       "WARN",  "ERROR", "FATAL"};
 
+static const char* level_padded[] = {"TRACE", "DEBUG", "INFO ",
+                                     "WARN ", "ERROR", "FATAL"};
+
 #ifdef LOG_USE_COLOR
 static const char* level_colors[] = {"\x1b[94m", "\x1b[36m", "\x1b[32m",
                                      "\x1b[33m", "\x1b[31m", "\x1b[35m"};
 #endif
 
-static void stdout_callback(log_Event* ev) {
-  char buf[16];
-  buf[strftime(buf, sizeof(buf), "%H:%M:%S", ev->time)] = '\0';
+static TimeCache* cached_time(time_t now) {
+  if (time_cache.second != now) {
+    localtime_r(&now, &time_cache.tm);
+    strftime(time_cache.clock, sizeof(time_cache.clock), "%H:%M:%S",
+             &time_cache.tm);
+    strftime(time_cache.date_clock, sizeof(time_cache.date_clock),
+             "%Y-%m-%d %H:%M:%S", &time_cache.tm);
+    strftime(time_cache.iso_clock, sizeof(time_cache.iso_clock),
+             "%Y-%m-%dT%H:%M:%S%z", &time_cache.tm);
+    time_cache.second = now;
+  }
+  return &time_cache;
+}
+
+static int64_t now_ms(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void write_all(int fd, const char* data, size_t len) {
+  while (len > 0) {
+    ssize_t n = write(fd, data, len);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return;
+    }
+    data += n;
+    len -= (size_t)n;
+  }
+}
+
+static void rotation_account(Sink* sink, size_t len) {
+  Rotation* rot = sink->rotation;
+  if (rot->max_bytes == 0 ||
+      atomic_fetch_add_explicit(&rot->bytes, (long long)len,
+                                memory_order_relaxed) +
+              (long long)len <
+          rot->max_bytes ||
+      atomic_exchange_explicit(&rot->pending, true, memory_order_relaxed)) {
+    return;
+  }
+  pthread_mutex_lock(&rot->mutex);
+  pthread_cond_signal(&rot->wake);
+  pthread_mutex_unlock(&rot->mutex);
+}
+
+/* Writes to the sink's current descriptor; see Sink. */
+static void sink_output(Sink* sink, const char* data, size_t len) {
+  for (;;) {
+    unsigned gen = atomic_load(&sink->generation);
+    atomic_fetch_add(&sink->writers[gen & 1], 1);
+    if (atomic_load(&sink->generation) == gen) {
+      write_all(atomic_load_explicit(&sink->fds[gen & 1], memory_order_relaxed),
+                data, len);
+      atomic_fetch_sub_explicit(&sink->writers[gen & 1], 1,
+                                memory_order_release);
+      break;
+    }
+    atomic_fetch_sub(&sink->writers[gen & 1], 1);
+  }
+  if (sink->rotation != NULL) {
+    rotation_account(sink, len);
+  }
+}
+
+static void sink_flush_locked(Sink* sink) {
+  if (sink->used > 0) {
+    sink_output(sink, sink->buffer, sink->used);
+    sink->used = 0;
+  }
+  sink->last_write_ms = now_ms();
+}
+
+static void sink_write(Sink* sink, const char* data, size_t len, int level) {
+  /* The async consumer buffers everything and flushes once per batch. */
+  if (sink->policy == LOG_FLUSH_RECORD && !in_consumer) {
+    sink_output(sink, data, len);
+    return;
+  }
+  pthread_mutex_lock(&sink->mutex);
+  if (sink->buffer == NULL) {
+    sink->buffer        = malloc(SINK_BUFFER_SIZE);
+    sink->last_write_ms = now_ms();
+  }
+  if (sink->buffer == NULL || len > SINK_BUFFER_SIZE) {
+    if (sink->buffer != NULL) {
+      sink_flush_locked(sink);
+    }
+    sink_output(sink, data, len);
+    pthread_mutex_unlock(&sink->mutex);
+    return;
+  }
+  if (sink->used + len > SINK_BUFFER_SIZE) {
+    sink_flush_locked(sink);
+  }
+  memcpy(sink->buffer + sink->used, data, len);
+  sink->used += len;
+  if ((sink->policy == LOG_FLUSH_LEVEL && level >= sink->arg) ||
+      (sink->policy == LOG_FLUSH_INTERVAL &&
+       now_ms() - sink->last_write_ms >= sink->arg)) {
+    sink_flush_locked(sink);
+  }
+  pthread_mutex_unlock(&sink->mutex);
+}
+
+static void flush_sinks(bool only_due) {
+  int64_t now = only_due ? now_ms() : 0;
+  tables_read_lock();
+  for (int i = -1; i < file_sink_count; i++) {
+    Sink* sink = i < 0 ? &console_sink : &file_sinks[i];
+    if (!sink->in_use) {
+      continue;
+    }
+    pthread_mutex_lock(&sink->mutex);
+    if (sink->used > 0 &&
+        (!only_due || (sink->policy == LOG_FLUSH_INTERVAL &&
+                       now - sink->last_write_ms >= sink->arg))) {
+      sink_flush_locked(sink);
+    }
+    pthread_mutex_unlock(&sink->mutex);
+  }
+  tables_read_unlock();
+}
+
+typedef struct {
+  char* data;
+  size_t len;
+  size_t cap;
+} Record;
+
+static void record_append(Record* r, const char* text, size_t len) {
+  if (len > r->cap - r->len) {
+    len = r->cap - r->len;
+  }
+  memcpy(r->data + r->len, text, len);
+  r->len += len;
+}
+
+static void record_puts(Record* r, const char* text) {
+  record_append(r, text, strlen(text));
+}
+
+static void record_int(Record* r, int value) {
+  char digits[16];
+  char* p         = digits + sizeof(digits);
+  unsigned long v = value < 0 ? 0UL - (unsigned long)value
+                              : (unsigned long)value;
+  do {
+    *--p = (char)('0' + v % 10);
+    v /= 10;
+  } while (v != 0);
+  if (value < 0) {
+    *--p = '-';
+  }
+  record_append(r, p, (size_t)(digits + sizeof(digits) - p));
+}
+
+/*
+ * JSON string escaping. For every byte the table holds 0 if it is copied
+ * as is, the character that follows the backslash for the short escapes,
+ * or 'u' for a \u00XX escape.
+ */
+static const char json_escapes[256] = {
+    ['\0'] = 'u', [0x01] = 'u', [0x02] = 'u', [0x03] = 'u', [0x04] = 'u',
+    [0x05] = 'u', [0x06] = 'u', [0x07] = 'u', ['\b'] = 'b', ['\t'] = 't',
+    ['\n'] = 'n', [0x0b] = 'u', ['\f'] = 'f', ['\r'] = 'r', [0x0e] = 'u',
+    [0x0f] = 'u', [0x10] = 'u', [0x11] = 'u', [0x12] = 'u', [0x13] = 'u',
+    [0x14] = 'u', [0x15] = 'u', [0x16] = 'u', [0x17] = 'u', [0x18] = 'u',
+    [0x19] = 'u', [0x1a] = 'u', [0x1b] = 'u', [0x1c] = 'u', [0x1d] = 'u',
+    [0x1e] = 'u', [0x1f] = 'u', ['"'] = '"',  ['\\'] = '\\', [0x7f] = 'u',
+};
+
+/* Worst-case size of `len` bytes after record_json_string. */
+static size_t json_escaped_size(size_t len) {
+  return 6 * len + 2;
+}
+
+/* Appends `text` as a quoted JSON string, copying unescaped runs in bulk. */
+static void record_json_string(Record* r, const char* text, size_t len) {
+  static const char hex[] = "0123456789abcdef";
+  const unsigned char* p   = (const unsigned char*)text;
+  const unsigned char* end = p + len;
+  record_append(r, "\"", 1);
+  while (p < end) {
+    const unsigned char* run = p;
+    while (p < end && json_escapes[*p] == 0) {
+      p++;
+    }
+    record_append(r, (const char*)run, (size_t)(p - run));
+    if (p == end) {
+      break;
+    }
+    char escape = json_escapes[*p];
+    if (escape == 'u') {
+      char seq[6] = {'\\', 'u', '0', '0', hex[*p >> 4], hex[*p & 15]};
+      record_append(r, seq, sizeof(seq));
+    } else {
+      char seq[2] = {'\\', escape};
+      record_append(r, seq, sizeof(seq));
+    }
+    p++;
+  }
+  record_append(r, "\"", 1);
+}
+
+/* Appends the log_kv fields of `ev`: ` key=value` for text sinks,
+ * `,"key":value` for JSON sinks. */
+static void record_fields(Record* r, const log_Event* ev, bool json) {
+  for (size_t i = 0; i < ev->field_count; i++) {
+    const log_Field* field = &ev->fields[i];
+    const char* key        = field->key != NULL ? field->key : "";
+    if (json) {
+      record_append(r, ",", 1);
+      record_json_string(r, key, strlen(key));
+      record_append(r, ":", 1);
+    } else {
+      record_append(r, " ", 1);
+      record_puts(r, key);
+      record_append(r, "=", 1);
+    }
+    char number[32];
+    switch (field->type) {
+    case LOG_FIELD_INT:
+      snprintf(number, sizeof(number), "%lld", field->value.i);
+      record_puts(r, number);
+      break;
+    case LOG_FIELD_DOUBLE:
+      if (json && !isfinite(field->value.d)) {
+        record_puts(r, "null");
+      } else {
+        snprintf(number, sizeof(number), "%.17g", field->value.d);
+        record_puts(r, number);
+      }
+      break;
+    case LOG_FIELD_BOOL:
+      record_puts(r, field->value.b ? "true" : "false");
+      break;
+    case LOG_FIELD_STRING: {
+      const char* text = field->value.s != NULL ? field->value.s : "";
+      if (json) {
+        record_json_string(r, text, strlen(text));
+      } else {
+        record_puts(r, text);
+      }
+      break;
+    }
+    default:
+      record_puts(r, json ? "null" : "");
+      break;
+    }
+  }
+}
+
+/* Upper bound of what record_fields appends. */
+static size_t fields_size(const log_Event* ev) {
+  size_t size = 0;
+  for (size_t i = 0; i < ev->field_count; i++) {
+    const log_Field* field = &ev->fields[i];
+    size += json_escaped_size(field->key != NULL ? strlen(field->key) : 0) + 34;
+    if (field->type == LOG_FIELD_STRING && field->value.s != NULL) {
+      size += json_escaped_size(strlen(field->value.s));
+    }
+  }
+  return size;
+}
+
+/* Formats the message of `ev` into `stack` or, if it does not fit, into a
+ * heap buffer returned through `*heap`. Returns the message length. */
+static size_t format_message(log_Event* ev, char* stack, size_t size,
+                             char** out, char** heap) {
+  va_list ap;
+  va_copy(ap, ev->ap);
+  int n = vsnprintf(stack, size, ev->fmt, ap);
+  va_end(ap);
+  *out  = stack;
+  *heap = NULL;
+  if (n < 0) {
+    stack[0] = '\0';
+    return 0;
+  }
+  if ((size_t)n >= size) {
+    *heap = malloc((size_t)n + 1);
+    if (*heap == NULL) {
+      return size - 1;
+    }
+    vsnprintf(*heap, (size_t)n + 1, ev->fmt, ev->ap);
+    *out = *heap;
+  }
+  return (size_t)n;
+}
+
+/* One JSON object per line: ts, level, file, line, msg, the sink's fixed
+ * fields and the record's log_kv fields. */
+static void sink_emit_json(Sink* sink, log_Event* ev) {
+  char message_stack[RECORD_BUFFER_SIZE];
+  char* message;
+  char* message_heap;
+  size_t message_len = format_message(ev, message_stack, sizeof(message_stack),
+                                      &message, &message_heap);
+
+  const char* clock = ev->time == &time_cache.tm ? time_cache.iso_clock : NULL;
+  char clock_buf[32];
+  if (clock == NULL) {
+    strftime(clock_buf, sizeof(clock_buf), "%Y-%m-%dT%H:%M:%S%z", ev->time);
+    clock = clock_buf;
+  }
+
+  size_t need = 96 + strlen(clock) + json_escaped_size(strlen(ev->file)) +
+                json_escaped_size(message_len) + fields_size(ev) +
+                (ev->logger != NULL ? json_escaped_size(strlen(ev->logger))
+                                    : 0) +
+                (sink->json_fields != NULL ? strlen(sink->json_fields) : 0);
+  char stack[2 * RECORD_BUFFER_SIZE];
+  char* heap = need > sizeof(stack) ? malloc(need) : NULL;
+  Record r   = {heap != NULL ? heap : stack, 0,
+                heap != NULL ? need : sizeof(stack)};
+
+  record_puts(&r, "{\"ts\":\"");
+  record_puts(&r, clock);
+  record_puts(&r, "\",\"level\":\"");
+  record_puts(&r, level_strings[ev->level]);
+  record_puts(&r, "\",\"file\":");
+  record_json_string(&r, ev->file, strlen(ev->file));
+  record_puts(&r, ",\"line\":");
+  record_int(&r, ev->line);
+  if (ev->logger != NULL) {
+    record_puts(&r, ",\"logger\":");
+    record_json_string(&r, ev->logger, strlen(ev->logger));
+  }
+  record_puts(&r, ",\"msg\":");
+  record_json_string(&r, message, message_len);
+  if (sink->json_fields != NULL) {
+    record_puts(&r, sink->json_fields);
+  }
+  record_fields(&r, ev, true);
+  record_append(&r, "}\n", 2);
+  if (r.len == r.cap && r.data[r.len - 1] != '\n') {
+    r.data[r.len - 1] = '\n'; /* truncated: keep one record per line */
+  }
+
+  sink_write(sink, r.data, r.len, ev->level);
+  free(heap);
+  free(message_heap);
+}
+
+/* Formats prefix, message and newline into a stack buffer (or, for very long
+ * messages, one heap buffer) and writes it to `sink` in one piece. */
+static void sink_emit(Sink* sink, log_Event* ev) {
+  if (sink->json) {
+    sink_emit_json(sink, ev);
+    return;
+  }
+  char stack[RECORD_BUFFER_SIZE];
+  Record r = {stack, 0, sizeof(stack)};
+
+  char fields_buf[FIELDS_TEXT_SIZE];
+  Record fields = {fields_buf, 0, sizeof(fields_buf)};
+  record_fields(&fields, ev, false);
+
+  const char* clock;
+  char clock_buf[32];
+  if (ev->time == &time_cache.tm) {
+    clock = sink->date ? time_cache.date_clock : time_cache.clock;
+  } else {
+    strftime(clock_buf, sizeof(clock_buf),
+             sink->date ? "%Y-%m-%d %H:%M:%S" : "%H:%M:%S", ev->time);
+    clock = clock_buf;
+  }
+
 #ifdef LOG_USE_COLOR
-  fprintf(ev->udata, "%s %s%-5s\x1b[0m \x1b[90m%s:%d:\x1b[0m ", buf,
-          level_colors[ev->level], level_strings[ev->level], ev->file,
-          ev->line);
-#else
-  fprintf(ev->udata, "%s %-5s %s:%d: ", buf, level_strings[ev->level], ev->file,
-          ev->line);
+  if (sink->color) {
+    record_puts(&r, clock);
+    record_puts(&r, " ");
+    record_puts(&r, level_colors[ev->level]);
+    record_puts(&r, level_padded[ev->level]);
+    record_puts(&r, "\x1b[0m \x1b[90m");
+    record_puts(&r, ev->file);
+    record_puts(&r, ":");
+    record_int(&r, ev->line);
+    record_puts(&r, ":\x1b[0m ");
+    if (ev->logger != NULL) {
+      record_puts(&r, "\x1b[90m[");
+      record_puts(&r, ev->logger);
+      record_puts(&r, "]\x1b[0m ");
+    }
+  } else
 #endif
-  vfprintf(ev->udata, ev->fmt, ev->ap);
-  fprintf(ev->udata, "\n");
-  fflush(ev->udata);
+  {
+    record_puts(&r, clock);
+    record_puts(&r, " ");
+    record_puts(&r, level_padded[ev->level]);
+    record_puts(&r, " ");
+    record_puts(&r, ev->file);
+    record_puts(&r, ":");
+    record_int(&r, ev->line);
+    record_puts(&r, ": ");
+    if (ev->logger != NULL) {
+      record_puts(&r, "[");
+      record_puts(&r, ev->logger);
+      record_puts(&r, "] ");
+    }
+  }
+
+  va_list ap;
+  va_copy(ap, ev->ap);
+  size_t room = r.cap - r.len;
+  int n       = vsnprintf(r.data + r.len, room, ev->fmt, ap);
+  va_end(ap);
+  if (n < 0) {
+    n = 0;
+  }
+
+  char* heap = NULL;
+  if ((size_t)n + fields.len + 1 >= room) {
+    /* Too long for the stack buffer: re-format into one exact allocation. */
+    heap = malloc(r.len + (size_t)n + fields.len + 2);
+    if (heap != NULL) {
+      memcpy(heap, r.data, r.len);
+      r.data = heap;
+      r.cap  = r.len + (size_t)n + fields.len + 2;
+      vsnprintf(r.data + r.len, (size_t)n + 1, ev->fmt, ev->ap);
+      r.len += (size_t)n;
+    } else {
+      r.len = r.cap - 1 - fields.len; /* keep the truncated message */
+    }
+  } else {
+    r.len += (size_t)n;
+  }
+  record_append(&r, fields.data, fields.len);
+  r.data[r.len++] = '\n';
+
+  sink_write(sink, r.data, r.len, ev->level);
+  free(heap);
+}
+
+static void stdout_callback(log_Event* ev) {
+  sink_emit(&console_sink, ev);
 }
 
 static void file_callback(log_Event* ev) {
-  char buf[64];
-  buf[strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", ev->time)] = '\0';
-  fprintf(ev->udata, "%s %-5s %s:%d: ", buf, level_strings[ev->level], ev->file,
-          ev->line);
-  vfprintf(ev->udata, ev->fmt, ev->ap);
-  fprintf(ev->udata, "\n");
-  fflush(ev->udata);
+  sink_emit(ev->udata, ev);
 }
 
 static void lock(void) {
@@ -93,62 +704,934 @@ void log_set_lock(log_LockFn fn, void* udata) {
   L.udata = udata;
 }
 
+/* Lowest level any sink would accept, so producers can skip formatting. */
+static int min_sink_level(void) {
+  int level = L.quiet ? LOG_FATAL + 1 : L.level;
+  for (int i = 0; i < MAX_CALLBACKS && L.callbacks[i].fn; i++) {
+    if (L.callbacks[i].level < level) {
+      level = L.callbacks[i].level;
+    }
+  }
+  return level;
+}
+
+void log_refresh_enabled_level(void) {
+  int sinks  = min_sink_level();
+  int binary   = atomic_load(&log_binary_min_level);
+  int recorder = atomic_load(&log_recorder_min_level);
+  int enabled  = sinks < binary ? sinks : binary;
+  atomic_store_explicit(&sink_level, sinks, memory_order_relaxed);
+  __atomic_store_n(&log_enabled_level, enabled < recorder ? enabled : recorder,
+                   __ATOMIC_RELAXED);
+}
+
 void log_set_level(int level) {
   L.level = level;
+  log_refresh_enabled_level();
 }
 
 void log_set_quiet(bool enable) {
   L.quiet = enable;
+  log_refresh_enabled_level();
 }
 
-int log_add_callback(log_LogFn fn, void* udata, int level) {
+/* The *_locked helpers expect tables_lock held exclusively. */
+static int add_callback_locked(log_LogFn fn, void* udata, int level) {
   for (int i = 0; i < MAX_CALLBACKS; i++) {
     if (!L.callbacks[i].fn) {
       L.callbacks[i] = (Callback){fn, udata, level};
+      log_refresh_enabled_level();
       return 0;
     }
   }
   return -1;
 }
 
+static int remove_callback_locked(log_LogFn fn, void* udata) {
+  for (int i = 0; i < MAX_CALLBACKS && L.callbacks[i].fn; i++) {
+    if (L.callbacks[i].fn == fn && L.callbacks[i].udata == udata) {
+      memmove(&L.callbacks[i], &L.callbacks[i + 1],
+              (size_t)(MAX_CALLBACKS - i - 1) * sizeof(Callback));
+      L.callbacks[MAX_CALLBACKS - 1] = (Callback){0};
+      log_refresh_enabled_level();
+      return 0;
+    }
+  }
+  return -1;
+}
+
+int log_add_callback(log_LogFn fn, void* udata, int level) {
+  tables_write_lock();
+  int added = add_callback_locked(fn, udata, level);
+  tables_write_unlock();
+  return added;
+}
+
+int log_remove_callback(log_LogFn fn, void* udata) {
+  tables_write_lock();
+  int removed = remove_callback_locked(fn, udata);
+  tables_write_unlock();
+  return removed;
+}
+
+static int add_file_sink(FILE* fp, int level, bool json, char* json_fields) {
+  tables_write_lock();
+  Sink* sink = NULL;
+  for (int i = 0; i < MAX_CALLBACKS && sink == NULL; i++) {
+    if (!file_sinks[i].in_use) {
+      sink = &file_sinks[i];
+    }
+  }
+  if (sink == NULL) {
+    tables_write_unlock();
+    return -1;
+  }
+  /* Records bypass stdio from here on; write out what it still holds. */
+  fflush(fp);
+  int fd = fileno(fp);
+  *sink  = (Sink){
+      .fds         = {fd, fd},
+      .fp          = fp,
+      .date        = true,
+      .json        = json,
+      .json_fields = json_fields,
+  };
+  pthread_mutex_init(&sink->mutex, NULL);
+  if (add_callback_locked(file_callback, sink, level) != 0) {
+    pthread_mutex_destroy(&sink->mutex);
+    tables_write_unlock();
+    return -1;
+  }
+  sink->in_use = true;
+  if (sink - file_sinks >= file_sink_count) {
+    file_sink_count = (int)(sink - file_sinks) + 1;
+  }
+  tables_write_unlock();
+  return 0;
+}
+
 int log_add_fp(FILE* fp, int level) {
-  return log_add_callback(file_callback, fp, level);
+  return add_file_sink(fp, level, false, NULL);
+}
+
+int log_add_json_fp(FILE* fp, int level, const char* const* fields,
+                    size_t count) {
+  char* encoded = NULL;
+  if (count > 0) {
+    size_t need = 1;
+    for (size_t i = 0; i < 2 * count; i++) {
+      need += json_escaped_size(fields[i] != NULL ? strlen(fields[i]) : 0) + 2;
+    }
+    encoded = malloc(need);
+    if (encoded == NULL) {
+      return -1;
+    }
+    Record r = {encoded, 0, need};
+    for (size_t i = 0; i < count; i++) {
+      const char* key   = fields[2 * i] != NULL ? fields[2 * i] : "";
+      const char* value = fields[2 * i + 1] != NULL ? fields[2 * i + 1] : "";
+      record_append(&r, ",", 1);
+      record_json_string(&r, key, strlen(key));
+      record_append(&r, ":", 1);
+      record_json_string(&r, value, strlen(value));
+    }
+    encoded[r.len] = '\0';
+  }
+  if (add_file_sink(fp, level, true, encoded) != 0) {
+    free(encoded);
+    return -1;
+  }
+  return 0;
+}
+
+static Sink* find_file_sink(FILE* fp) {
+  for (int i = 0; i < file_sink_count; i++) {
+    if (file_sinks[i].in_use && file_sinks[i].fp == fp) {
+      return &file_sinks[i];
+    }
+  }
+  return NULL;
+}
+
+static void stop_rotation(Sink* sink);
+
+int log_remove_fp(FILE* fp) {
+  tables_write_lock();
+  Sink* sink = find_file_sink(fp);
+  if (sink == NULL || remove_callback_locked(file_callback, sink) != 0) {
+    tables_write_unlock();
+    return -1;
+  }
+  stop_rotation(sink);
+  pthread_mutex_lock(&sink->mutex);
+  sink_flush_locked(sink);
+  pthread_mutex_unlock(&sink->mutex);
+
+  int fd = atomic_load(&sink->fds[atomic_load(&sink->generation) & 1]);
+  if (fd != fileno(fp)) {
+    close(fd);
+  }
+  free(sink->buffer);
+  free(sink->json_fields);
+  pthread_mutex_destroy(&sink->mutex);
+  sink->in_use = false;
+  tables_write_unlock();
+  return 0;
+}
+
+/* ---- rotation ---- */
+
+static time_t next_midnight(time_t now) {
+  struct tm tm;
+  localtime_r(&now, &tm);
+  tm.tm_hour = 0;
+  tm.tm_min  = 0;
+  tm.tm_sec  = 0;
+  tm.tm_mday += 1;
+  tm.tm_isdst = -1;
+  return mktime(&tm);
+}
+
+static void segment_name(char* out, size_t size, const char* path, int index,
+                         const char* suffix) {
+  snprintf(out, size, "%s.%d%s", path, index, suffix);
+}
+
+static void compress_segment(const char* path) {
+  extern char** environ;
+  char* argv[] = {"gzip", "-f", "--", (char*)path, NULL};
+  pid_t pid;
+  if (posix_spawnp(&pid, "gzip", NULL, NULL, argv, environ) == 0) {
+    while (waitpid(pid, NULL, 0) < 0 && errno == EINTR) {
+    }
+  }
+}
+
+/* Shifts path.N (and path.N.gz) up by one, moves the live file to path.1,
+ * switches writers to a fresh file and retires the old descriptor. */
+static void rotate(Sink* sink) {
+  Rotation* rot = sink->rotation;
+  size_t size   = strlen(rot->path) + 32;
+  char* from    = malloc(size);
+  char* to      = malloc(size);
+  if (from == NULL || to == NULL) {
+    free(from);
+    free(to);
+    return;
+  }
+
+  if (rot->backup_count > 0) {
+    static const char* suffixes[] = {"", ".gz"};
+    for (int s = 0; s < 2; s++) {
+      segment_name(to, size, rot->path, rot->backup_count, suffixes[s]);
+      unlink(to);
+      for (int i = rot->backup_count - 1; i >= 1; i--) {
+        segment_name(from, size, rot->path, i, suffixes[s]);
+        segment_name(to, size, rot->path, i + 1, suffixes[s]);
+        rename(from, to);
+      }
+    }
+    segment_name(to, size, rot->path, 1, "");
+    rename(rot->path, to);
+  } else {
+    unlink(rot->path);
+  }
+
+  int fd = open(rot->path, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC,
+                0644);
+  if (fd >= 0) {
+    unsigned gen = atomic_load(&sink->generation);
+    int old      = atomic_load(&sink->fds[gen & 1]);
+    atomic_store(&sink->fds[(gen + 1) & 1], fd);
+    atomic_store(&sink->generation, gen + 1);
+    /* Writers that picked the old slot finish into the renamed file. */
+    while (atomic_load(&sink->writers[gen & 1]) != 0) {
+      sched_yield();
+    }
+    if (old != fileno(sink->fp)) {
+      close(old);
+    }
+    atomic_store(&rot->bytes, 0);
+  }
+
+  if (fd >= 0 && rot->compress && rot->backup_count > 0) {
+    compress_segment(to);
+  }
+  free(from);
+  free(to);
+}
+
+static void* rotation_thread(void* arg) {
+  Sink* sink    = arg;
+  Rotation* rot = sink->rotation;
+  time_t due    = rot->when == LOG_ROTATE_MIDNIGHT ? next_midnight(time(NULL))
+                                                   : 0;
+  pthread_mutex_lock(&rot->mutex);
+  while (!rot->stop) {
+    bool timed = due != 0 && time(NULL) >= due;
+    if (timed || atomic_load(&rot->pending)) {
+      pthread_mutex_unlock(&rot->mutex);
+      rotate(sink);
+      atomic_store(&rot->pending, false);
+      if (timed) {
+        due = next_midnight(time(NULL));
+      }
+      pthread_mutex_lock(&rot->mutex);
+      continue;
+    }
+    if (due != 0) {
+      struct timespec until = {due, 0};
+      pthread_cond_timedwait(&rot->wake, &rot->mutex, &until);
+    } else {
+      pthread_cond_wait(&rot->wake, &rot->mutex);
+    }
+  }
+  pthread_mutex_unlock(&rot->mutex);
+  return NULL;
+}
+
+static void stop_rotation(Sink* sink) {
+  Rotation* rot = sink->rotation;
+  if (rot == NULL) {
+    return;
+  }
+  pthread_mutex_lock(&rot->mutex);
+  rot->stop = true;
+  pthread_cond_signal(&rot->wake);
+  pthread_mutex_unlock(&rot->mutex);
+  pthread_join(rot->thread, NULL);
+  sink->rotation = NULL;
+  pthread_mutex_destroy(&rot->mutex);
+  pthread_cond_destroy(&rot->wake);
+  free(rot->path);
+  free(rot);
+}
+
+/* Swaps sink->rotation with tables_lock held exclusively: sink_output reads
+ * it under the shared lock. */
+static int set_rotation_locked(Sink* sink, const char* path,
+                               long long max_bytes, int backup_count, int when,
+                               bool compress) {
+  stop_rotation(sink);
+  if (max_bytes == 0 && when == LOG_ROTATE_NEVER) {
+    return 0;
+  }
+
+  Rotation* rot = calloc(1, sizeof(Rotation));
+  if (rot == NULL || (rot->path = strdup(path)) == NULL) {
+    free(rot);
+    return -1;
+  }
+  rot->max_bytes    = max_bytes;
+  rot->backup_count = backup_count;
+  rot->when         = when;
+  rot->compress     = compress;
+  struct stat info;
+  int fd = atomic_load(&sink->fds[atomic_load(&sink->generation) & 1]);
+  atomic_init(&rot->bytes, fstat(fd, &info) == 0 ? (long long)info.st_size : 0);
+  pthread_mutex_init(&rot->mutex, NULL);
+  pthread_cond_init(&rot->wake, NULL);
+
+  sink->rotation = rot;
+  if (pthread_create(&rot->thread, NULL, rotation_thread, sink) != 0) {
+    sink->rotation = NULL;
+    pthread_mutex_destroy(&rot->mutex);
+    pthread_cond_destroy(&rot->wake);
+    free(rot->path);
+    free(rot);
+    return -1;
+  }
+  return 0;
+}
+
+int log_set_rotation(FILE* fp, const char* path, long long max_bytes,
+                     int backup_count, int when, bool compress) {
+  if (path == NULL || max_bytes < 0 || backup_count < 0 ||
+      (when != LOG_ROTATE_NEVER && when != LOG_ROTATE_MIDNIGHT)) {
+    return -1;
+  }
+  tables_write_lock();
+  Sink* sink = find_file_sink(fp);
+  int result = sink != NULL ? set_rotation_locked(sink, path, max_bytes,
+                                                  backup_count, when, compress)
+                            : -1;
+  tables_write_unlock();
+  return result;
+}
+
+static void* interval_flusher(void* arg) {
+  (void)arg;
+  for (;;) {
+    int tick = atomic_load_explicit(&flush_tick_ms, memory_order_relaxed);
+    struct timespec ts = {tick / 1000, (long)(tick % 1000) * 1000000L};
+    nanosleep(&ts, NULL);
+    flush_sinks(true);
+  }
+  return NULL;
+}
+
+static void flush_at_exit(void) {
+  log_stop_async();
+  flush_sinks(false);
+}
+
+static void register_exit_flush(void) {
+  static bool registered = false;
+  if (!registered) {
+    atexit(flush_at_exit);
+    registered = true;
+  }
+}
+
+int log_set_flush(FILE* fp, int policy, int arg) {
+  if ((policy == LOG_FLUSH_INTERVAL && arg <= 0) ||
+      (policy != LOG_FLUSH_RECORD && policy != LOG_FLUSH_INTERVAL &&
+       policy != LOG_FLUSH_LEVEL)) {
+    return -1;
+  }
+  /* Exclusive: sink_write reads the policy without the sink mutex. */
+  int matched = 0;
+  tables_write_lock();
+  for (int i = -1; i < file_sink_count; i++) {
+    Sink* sink = i < 0 ? &console_sink : &file_sinks[i];
+    if (!sink->in_use || (i < 0 ? fp != stderr : sink->fp != fp)) {
+      continue;
+    }
+    pthread_mutex_lock(&sink->mutex);
+    if (sink->buffer != NULL) {
+      sink_flush_locked(sink);
+    }
+    sink->policy = policy;
+    sink->arg    = arg;
+    pthread_mutex_unlock(&sink->mutex);
+    matched++;
+  }
+  tables_write_unlock();
+  if (matched == 0) {
+    return -1;
+  }
+  register_exit_flush();
+
+  if (policy == LOG_FLUSH_INTERVAL) {
+    int tick = atomic_load(&flush_tick_ms);
+    if (tick == 0 || arg < tick) {
+      atomic_store(&flush_tick_ms, arg);
+    }
+    if (tick == 0) {
+      pthread_t thread;
+      if (pthread_create(&thread, NULL, interval_flusher, NULL) == 0) {
+        pthread_detach(thread);
+      }
+    }
+  }
+  return 0;
 }
 
 static void init_event(log_Event* ev, void* udata) {
   if (!ev->time) {
-    time_t t = time(NULL);
-    ev->time = localtime(&t);
+    ev->time = &cached_time(time(NULL))->tm;
   }
   ev->udata = udata;
 }
 
-void log_log(int level, const char* file, int line, const char* fmt, ...) {
+/* Runs every sink that admits ev->level. Each sink consumes its own copy of
+ * `ap`. */
+static void dispatch(log_Event* ev, va_list ap) {
+  /* Named loggers were already filtered by their own level. */
+  if (!L.quiet && (ev->logger != NULL || ev->level >= L.level)) {
+    init_event(ev, stderr);
+    va_copy(ev->ap, ap);
+    stdout_callback(ev);
+    va_end(ev->ap);
+  }
+
+  tables_read_lock();
+  for (int i = 0; i < MAX_CALLBACKS && L.callbacks[i].fn; i++) {
+    Callback* cb = &L.callbacks[i];
+    if (ev->level >= cb->level) {
+      init_event(ev, cb->udata);
+      va_copy(ev->ap, ap);
+      cb->fn(ev);
+      va_end(ev->ap);
+    }
+  }
+  tables_read_unlock();
+}
+
+static void dispatch_message(log_Event* ev, const char* fmt, ...) {
+  va_list ap;
+  va_start(ap, fmt);
+  dispatch(ev, ap);
+  va_end(ap);
+}
+
+static void wake_consumer(void) {
+  if (atomic_load_explicit(&A.consumer_idle, memory_order_seq_cst)) {
+    pthread_mutex_lock(&A.mutex);
+    pthread_cond_signal(&A.wake);
+    pthread_mutex_unlock(&A.mutex);
+  }
+}
+
+/*
+ * Async records carry their log_kv fields in AsyncSlot.fields as
+ * key '\0' type value, where strings are NUL-terminated and the other
+ * types are stored as raw bytes. Fields that do not fit are dropped.
+ */
+static int encode_fields(char* out, size_t size, const log_Field* fields,
+                         size_t count) {
+  size_t used = 0;
+  int encoded = 0;
+  for (size_t i = 0; i < count && encoded < MAX_FIELDS; i++) {
+    const log_Field* field = &fields[i];
+    if (field->type < LOG_FIELD_STRING || field->type > LOG_FIELD_BOOL) {
+      continue;
+    }
+    const char* key  = field->key != NULL ? field->key : "";
+    const char* text = field->type == LOG_FIELD_STRING && field->value.s != NULL
+                           ? field->value.s
+                           : "";
+    size_t key_len   = strlen(key) + 1;
+    size_t value_len = field->type == LOG_FIELD_STRING ? strlen(text) + 1
+                       : field->type == LOG_FIELD_BOOL ? 1
+                                                       : 8;
+    if (used + key_len + 1 + value_len > size) {
+      break;
+    }
+    memcpy(out + used, key, key_len);
+    used += key_len;
+    out[used++] = (char)field->type;
+    switch (field->type) {
+    case LOG_FIELD_STRING:
+      memcpy(out + used, text, value_len);
+      break;
+    case LOG_FIELD_BOOL:
+      out[used] = (char)field->value.b;
+      break;
+    case LOG_FIELD_INT:
+      memcpy(out + used, &field->value.i, 8);
+      break;
+    default:
+      memcpy(out + used, &field->value.d, 8);
+      break;
+    }
+    used += value_len;
+    encoded++;
+  }
+  return encoded;
+}
+
+static void decode_fields(const char* in, int count, log_Field* fields) {
+  for (int i = 0; i < count; i++) {
+    fields[i].key = in;
+    in += strlen(in) + 1;
+    fields[i].type = (unsigned char)*in++;
+    switch (fields[i].type) {
+    case LOG_FIELD_STRING:
+      fields[i].value.s = in;
+      in += strlen(in) + 1;
+      break;
+    case LOG_FIELD_BOOL:
+      fields[i].value.b = *in++ != 0;
+      break;
+    case LOG_FIELD_INT:
+      memcpy(&fields[i].value.i, in, 8);
+      in += 8;
+      break;
+    default:
+      memcpy(&fields[i].value.d, in, 8);
+      in += 8;
+      break;
+    }
+  }
+}
+
+static void async_enqueue(const char* logger, const log_Field* fields,
+                          size_t field_count, int level, const char* file,
+                          int line, const char* fmt, va_list ap) {
+  size_t mask = A.capacity - 1;
+  size_t pos  = atomic_load_explicit(&A.enqueue_pos, memory_order_relaxed);
+  AsyncSlot* slot;
+  for (;;) {
+    slot = &A.slots[pos & mask];
+    size_t seq =
+        atomic_load_explicit(&slot->sequence, memory_order_acquire);
+    intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+    if (diff == 0) {
+      if (atomic_compare_exchange_weak_explicit(&A.enqueue_pos, &pos, pos + 1,
+                                                memory_order_relaxed,
+                                                memory_order_relaxed)) {
+        break;
+      }
+    } else if (diff < 0) {
+      /* Full: the consumer still owns this slot from the previous lap. */
+      if (A.overflow == LOG_OVERFLOW_DROP) {
+        atomic_fetch_add_explicit(&A.dropped, 1, memory_order_relaxed);
+        return;
+      }
+      wake_consumer();
+      sched_yield();
+      pos = atomic_load_explicit(&A.enqueue_pos, memory_order_relaxed);
+    } else {
+      pos = atomic_load_explicit(&A.enqueue_pos, memory_order_relaxed);
+    }
+  }
+
+  slot->time   = time(NULL);
+  slot->file   = file;
+  slot->line   = line;
+  slot->level  = level;
+  slot->logger = logger;
+  slot->field_count =
+      encode_fields(slot->fields, sizeof(slot->fields), fields, field_count);
+  vsnprintf(slot->message, sizeof(slot->message), fmt, ap);
+  /* Publishing and the idle check in wake_consumer pair with async_wait as
+   * seq_cst operations (not fences, which TSan cannot model): either the
+   * consumer sees this slot or we see it idle and wake it. */
+  atomic_exchange_explicit(&slot->sequence, pos + 1, memory_order_seq_cst);
+  wake_consumer();
+}
+
+static bool async_slot_ready(size_t pos) {
+  AsyncSlot* slot = &A.slots[pos & (A.capacity - 1)];
+  return atomic_load_explicit(&slot->sequence, memory_order_seq_cst) ==
+         pos + 1;
+}
+
+/* Sleeps until a record is published or stop is requested. Returns false
+ * once the ring is drained and the consumer should exit. */
+static bool async_wait(void) {
+  pthread_mutex_lock(&A.mutex);
+  for (;;) {
+    atomic_exchange_explicit(&A.consumer_idle, true, memory_order_seq_cst);
+    if (async_slot_ready(A.dequeue_pos)) {
+      break;
+    }
+    if (A.stop &&
+        atomic_load_explicit(&A.enqueue_pos, memory_order_acquire) ==
+            A.dequeue_pos) {
+      atomic_store_explicit(&A.consumer_idle, false, memory_order_relaxed);
+      pthread_mutex_unlock(&A.mutex);
+      return false;
+    }
+    pthread_cond_wait(&A.wake, &A.mutex);
+  }
+  atomic_store_explicit(&A.consumer_idle, false, memory_order_relaxed);
+  pthread_mutex_unlock(&A.mutex);
+  return true;
+}
+
+static void report_dropped(void) {
+  unsigned long long dropped =
+      atomic_load_explicit(&A.dropped, memory_order_relaxed);
+  if (dropped == A.dropped_reported) {
+    return;
+  }
   log_Event ev = {
-      .fmt   = fmt,
-      .file  = file,
-      .line  = line,
-      .level = level,
+      .fmt   = "log queue full: %llu records dropped",
+      .file  = __FILE__,
+      .line  = __LINE__,
+      .time  = &cached_time(time(NULL))->tm,
+      .level = LOG_WARN,
   };
+  dispatch_message(&ev, ev.fmt, dropped - A.dropped_reported);
+  A.dropped_reported = dropped;
+}
 
-  lock();
+static void* async_consumer(void* arg) {
+  (void)arg;
+  in_consumer = true;
 
-  if (!L.quiet && level >= L.level) {
-    init_event(&ev, stderr);
-    va_start(ev.ap, fmt);
-    stdout_callback(&ev);
-    va_end(ev.ap);
+  while (async_wait()) {
+    lock();
+    for (int n = 0; n < ASYNC_BATCH && async_slot_ready(A.dequeue_pos); n++) {
+      AsyncSlot* slot = &A.slots[A.dequeue_pos & (A.capacity - 1)];
+      log_Field fields[MAX_FIELDS];
+      decode_fields(slot->fields, slot->field_count, fields);
+      log_Event ev = {
+          .fmt         = "%s",
+          .file        = slot->file,
+          .line        = slot->line,
+          .time        = &cached_time(slot->time)->tm,
+          .level       = slot->level,
+          .logger      = slot->logger,
+          .fields      = fields,
+          .field_count = (size_t)slot->field_count,
+      };
+      dispatch_message(&ev, "%s", slot->message);
+      /* Hand the slot back to producers for the next lap. */
+      atomic_store_explicit(&slot->sequence, A.dequeue_pos + A.capacity,
+                            memory_order_release);
+      A.dequeue_pos++;
+    }
+    report_dropped();
+    flush_sinks(false);
+    fflush(NULL);
+    unlock();
+
+    atomic_store_explicit(&A.written_pos, A.dequeue_pos,
+                          memory_order_release);
+    pthread_mutex_lock(&A.mutex);
+    pthread_cond_broadcast(&A.drained);
+    pthread_mutex_unlock(&A.mutex);
   }
 
-  for (int i = 0; i < MAX_CALLBACKS && L.callbacks[i].fn; i++) {
-    Callback* cb = &L.callbacks[i];
-    if (level >= cb->level) {
-      init_event(&ev, cb->udata);
-      va_start(ev.ap, fmt);
-      cb->fn(&ev);
-      va_end(ev.ap);
+  pthread_mutex_lock(&A.mutex);
+  A.running = false;
+  pthread_cond_broadcast(&A.drained);
+  pthread_mutex_unlock(&A.mutex);
+  return NULL;
+}
+
+int log_start_async(size_t queue_size, int overflow) {
+  pthread_mutex_lock(&A.mutex);
+  bool running = A.running;
+  pthread_mutex_unlock(&A.mutex);
+  if (running) {
+    return -1;
+  }
+
+  size_t capacity = 2;
+  while (capacity < queue_size) {
+    capacity <<= 1;
+  }
+  /* log_stop_async left no producer inside the ring, and none enters it
+   * before `active` is set below, so it can be reset or replaced. */
+  if (A.slots == NULL || A.capacity != capacity) {
+    AsyncSlot* slots = calloc(capacity, sizeof(AsyncSlot));
+    if (slots == NULL) {
+      return -1;
+    }
+    free(A.slots);
+    A.slots    = slots;
+    A.capacity = capacity;
+  }
+  for (size_t i = 0; i < capacity; i++) {
+    atomic_store_explicit(&A.slots[i].sequence, i, memory_order_relaxed);
+  }
+  A.overflow    = overflow;
+  A.dequeue_pos = 0;
+  A.stop        = false;
+  A.running     = true;
+  atomic_store(&A.enqueue_pos, 0);
+  atomic_store(&A.written_pos, 0);
+  atomic_store(&A.dropped, 0);
+  A.dropped_reported = 0;
+
+  if (pthread_create(&A.thread, NULL, async_consumer, NULL) != 0) {
+    A.running = false;
+    return -1;
+  }
+  atomic_store_explicit(&A.active, true, memory_order_release);
+
+  register_exit_flush();
+  return 0;
+}
+
+void log_stop_async(void) {
+  if (!atomic_exchange(&A.active, false)) {
+    return;
+  }
+  /* Producers that saw `active` before the exchange finish their enqueue
+   * while the consumer still runs; later ones see it cleared and log
+   * synchronously. */
+  while (atomic_load(&A.producers) != 0) {
+    sched_yield();
+  }
+  pthread_mutex_lock(&A.mutex);
+  A.stop = true;
+  pthread_cond_signal(&A.wake);
+  pthread_mutex_unlock(&A.mutex);
+  pthread_join(A.thread, NULL);
+}
+
+void log_flush(void) {
+  if (in_consumer) {
+    return;
+  }
+  log_binary_flush();
+  if (!atomic_load_explicit(&A.active, memory_order_acquire)) {
+    flush_sinks(false);
+    return;
+  }
+  size_t target = atomic_load_explicit(&A.enqueue_pos, memory_order_acquire);
+  pthread_mutex_lock(&A.mutex);
+  pthread_cond_signal(&A.wake);
+  while (A.running &&
+         atomic_load_explicit(&A.written_pos, memory_order_acquire) < target) {
+    pthread_cond_wait(&A.drained, &A.mutex);
+  }
+  pthread_mutex_unlock(&A.mutex);
+}
+
+unsigned long long log_dropped_count(void) {
+  return atomic_load_explicit(&A.dropped, memory_order_relaxed);
+}
+
+/* Everything after the level check shared by log_log and log_log_named. */
+static void log_va(const char* logger, const log_Field* fields,
+                   size_t field_count, int level, const char* file, int line,
+                   const char* fmt, va_list args) {
+  va_list ap;
+
+  if (level >= atomic_load_explicit(&log_recorder_min_level,
+                                    memory_order_relaxed)) {
+    va_copy(ap, args);
+    log_recorder_record(level, file, line, fmt, ap);
+    va_end(ap);
+  }
+
+  if (level >= atomic_load_explicit(&log_binary_min_level,
+                                    memory_order_relaxed)) {
+    va_copy(ap, args);
+    log_binary_record(level, file, line, fmt, ap);
+    va_end(ap);
+    if (level >= LOG_FATAL) {
+      log_binary_flush();
+    }
+  }
+
+  if (atomic_load_explicit(&A.active, memory_order_acquire)) {
+    if (logger == NULL &&
+        level < atomic_load_explicit(&sink_level, memory_order_relaxed)) {
+      return;
+    }
+    /* Announce ourselves, then check again: with both sides sequentially
+     * consistent, either log_stop_async sees us and waits, or we see it
+     * stopping and fall through to the synchronous path. */
+    atomic_fetch_add(&A.producers, 1);
+    if (atomic_load(&A.active)) {
+      va_copy(ap, args);
+      async_enqueue(logger, fields, field_count, level, file, line, fmt, ap);
+      va_end(ap);
+      atomic_fetch_sub_explicit(&A.producers, 1, memory_order_release);
+      if (level >= LOG_FATAL) {
+        log_flush();
+      }
+      return;
     }
+    atomic_fetch_sub_explicit(&A.producers, 1, memory_order_relaxed);
   }
 
+  log_Event ev = {
+      .fmt         = fmt,
+      .file        = file,
+      .line        = line,
+      .level       = level,
+      .logger      = logger,
+      .fields      = fields,
+      .field_count = field_count,
+  };
+
+  lock();
+  dispatch(&ev, args);
   unlock();
 }
+
+void log_log(int level, const char* file, int line, const char* fmt, ...) {
+  if (level < __atomic_load_n(&log_enabled_level, __ATOMIC_RELAXED)) {
+    return;
+  }
+  va_list ap;
+  va_start(ap, fmt);
+  log_va(NULL, NULL, 0, level, file, line, fmt, ap);
+  va_end(ap);
+}
+
+void log_log_named(const char* logger, int level, const char* file, int line,
+                   const char* fmt, ...) {
+  va_list ap;
+  va_start(ap, fmt);
+  log_va(logger, NULL, 0, level, file, line, fmt, ap);
+  va_end(ap);
+}
+
+void log_log_kv(int level, const char* file, int line, const log_Field* fields,
+                size_t count, const char* fmt, ...) {
+  if (level < __atomic_load_n(&log_enabled_level, __ATOMIC_RELAXED)) {
+    return;
+  }
+  va_list ap;
+  va_start(ap, fmt);
+  log_va(NULL, fields, count, level, file, line, fmt, ap);
+  va_end(ap);
+}
+
+/* ---- rate limiting ---- */
+
+static long long monotonic_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/* xorshift64*, seeded per thread; sampling needs speed, not quality. */
+static double sample_uniform(void) {
+  static _Thread_local uint64_t state;
+  if (state == 0) {
+    state = (uint64_t)monotonic_ns() ^ (uint64_t)(uintptr_t)&state;
+    state |= 1;
+  }
+  state ^= state >> 12;
+  state ^= state << 25;
+  state ^= state >> 27;
+  return (double)((state * 0x2545F4914F6CDD1DULL) >> 11) * 0x1.0p-53;
+}
+
+/* Claims the interval ending at next_ns; true for exactly one caller. */
+static bool claim_interval(log_RateState* state, long long interval_ns) {
+  long long now  = monotonic_ns();
+  long long next = __atomic_load_n(&state->next_ns, __ATOMIC_RELAXED);
+  return now >= next &&
+         __atomic_compare_exchange_n(&state->next_ns, &next, now + interval_ns,
+                                     false, __ATOMIC_RELAXED,
+                                     __ATOMIC_RELAXED);
+}
+
+bool log_rate_admit(log_RateState* state, int kind, double arg, int level,
+                    const char* file, int line,
+                    unsigned long long* suppressed) {
+  unsigned long long call =
+      __atomic_fetch_add(&state->calls, 1, __ATOMIC_RELAXED);
+  bool admit;
+  switch (kind) {
+  case LOG_RATE_EVERY_N:
+    admit = arg <= 1 || call % (unsigned long long)arg == 0;
+    break;
+  case LOG_RATE_FIRST_N:
+    admit = call < (unsigned long long)arg;
+    break;
+  case LOG_RATE_EVERY_SEC:
+    admit = claim_interval(state, (long long)(arg * 1e9));
+    break;
+  default:
+    admit = sample_uniform() < arg;
+    break;
+  }
+  if (admit) {
+    *suppressed = __atomic_exchange_n(&state->suppressed, 0, __ATOMIC_RELAXED);
+    return true;
+  }
+  __atomic_fetch_add(&state->suppressed, 1, __ATOMIC_RELAXED);
+
+  /* log_first_n never emits again, so it reports what it swallowed. */
+  if (kind == LOG_RATE_FIRST_N && call > (unsigned long long)arg &&
+      claim_interval(state, RATE_SUMMARY_NS)) {
+    unsigned long long count =
+        __atomic_exchange_n(&state->suppressed, 0, __ATOMIC_RELAXED);
+    log_Field field = log_field_int("suppressed", (long long)count);
+    log_log_kv(level, file, line, &field, 1,
+               "%llu more records suppressed after the first %.0f", count,
+               arg);
+  }
+  return false;
+}
+
+void log_log_rated(int level, const char* file, int line,
+                   unsigned long long suppressed, const char* fmt, ...) {
+  log_Field field = log_field_int("suppressed", (long long)suppressed);
+  va_list ap;
+  va_start(ap, fmt);
+  log_va(NULL, &field, suppressed > 0 ? 1 : 0, level, file, line, fmt, ap);
+  va_end(ap);
+}
@@ -0,0 +1,925 @@
+/*
+ * Deferred-format binary log handler.
+ *
+ * Instead of running printf, a record stores the call site id, a timestamp
+ * and the raw argument values in a per-thread buffer. Each call site
+ * (format string, file, line) is described once per file by a site record
+ * written when it is first seen. `hydra-cpp logcat` renders the file later.
+ *
+ * File layout (native byte order):
+ *   header  "HYDRABLG" u32 version
+ *   site    u8 1, u32 id, u32 line, u16 file_len, u16 fmt_len, file, fmt
+ *   event   u8 2, u8 level, u32 site_id, i64 unix_ns, u16 payload_len,
+ *           payload
+ * A payload holds one entry per conversion (and per `*` width/precision):
+ * 8 bytes for integers, floating point values and pointers; u32 length plus
+ * bytes for strings (UINT32_MAX for NULL). Sites whose format the encoder
+ * does not understand store the message pre-rendered as a single string.
+ */
+
+#include "log_internal.h"
+
+#include "hydra/log.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BLOG_MAGIC "HYDRABLG"
+#define BLOG_VERSION 1
+#define BLOG_MAX_ARGS 32
+#define BLOG_MAX_STRING 1024
+#define BLOG_BUFFER_SIZE 65536
+#define BLOG_CACHE_SIZE 256
+#define BLOG_SITE_BUCKETS 1024
+#define BLOG_EVENT_HEADER 16
+
+enum { REC_SITE = 1, REC_EVENT = 2 };
+
+enum {
+  ARG_INT,
+  ARG_LONG,
+  ARG_LLONG,
+  ARG_INTMAX,
+  ARG_SIZE,
+  ARG_PTRDIFF,
+  ARG_DOUBLE,
+  ARG_LDOUBLE,
+  ARG_STRING,
+  ARG_POINTER
+};
+
+typedef struct Site {
+  const char* fmt;
+  const char* file;
+  int line;
+  uint32_t id;
+  int argc; /* -1: stored pre-rendered */
+  uint8_t args[BLOG_MAX_ARGS];
+  /* File the site record was last written to; read by cache hits without
+   * site_mutex. */
+  atomic_uint generation;
+  struct Site* next;
+} Site;
+
+typedef struct ThreadBuffer {
+  pthread_mutex_t mutex;
+  size_t used;
+  unsigned generation; /* file the buffered records were written for */
+  struct ThreadBuffer* next;
+  struct {
+    const char* fmt;
+    const char* file;
+    int line;
+    Site* site;
+  } cache[BLOG_CACHE_SIZE];
+  char data[BLOG_BUFFER_SIZE];
+} ThreadBuffer;
+
+atomic_int log_binary_min_level = LOG_FATAL + 1;
+
+/* Lock order: list_mutex, a buffer's mutex, site_mutex, file_mutex. */
+static struct {
+  pthread_mutex_t list_mutex;
+  pthread_mutex_t site_mutex;
+  pthread_mutex_t file_mutex;
+  int fd;
+  atomic_uint generation;
+  ThreadBuffer* buffers;
+  Site* sites[BLOG_SITE_BUCKETS];
+  uint32_t next_site_id;
+  pthread_key_t key;
+  pthread_once_t key_once;
+} B = {
+    .list_mutex = PTHREAD_MUTEX_INITIALIZER,
+    .site_mutex = PTHREAD_MUTEX_INITIALIZER,
+    .file_mutex = PTHREAD_MUTEX_INITIALIZER,
+    .fd         = -1,
+    .key_once   = PTHREAD_ONCE_INIT,
+};
+
+static _Thread_local ThreadBuffer* thread_buffer;
+
+/* ---- format scanning (shared by encoder and decoder) ---- */
+
+typedef struct {
+  int stars;
+  int type;
+} Spec;
+
+/* Parses the conversion that starts right after a '%'. Returns a pointer
+ * past it, or NULL for conversions the binary format cannot carry (%n, wide
+ * characters, ...). `spec->type` is -1 for "%%". */
+static const char* parse_spec(const char* p, Spec* spec) {
+  spec->stars = 0;
+  spec->type  = -1;
+  if (*p == '%') {
+    return p + 1;
+  }
+  while (*p != '\0' && strchr("-+ #0'", *p) != NULL) {
+    p++;
+  }
+  if (*p == '*') {
+    spec->stars++;
+    p++;
+  } else {
+    while (*p >= '0' && *p <= '9') {
+      p++;
+    }
+  }
+  if (*p == '.') {
+    p++;
+    if (*p == '*') {
+      spec->stars++;
+      p++;
+    } else {
+      while (*p >= '0' && *p <= '9') {
+        p++;
+      }
+    }
+  }
+
+  char length = 0;
+  switch (*p) {
+  case 'h':
+    length = 'h';
+    p += p[1] == 'h' ? 2 : 1;
+    break;
+  case 'l':
+    length = p[1] == 'l' ? 'q' : 'l';
+    p += p[1] == 'l' ? 2 : 1;
+    break;
+  case 'q':
+  case 'j':
+  case 'z':
+  case 't':
+  case 'L':
+    length = *p == 'q' ? 'q' : *p;
+    p++;
+    break;
+  default:
+    break;
+  }
+
+  switch (*p) {
+  case 'd':
+  case 'i':
+  case 'o':
+  case 'u':
+  case 'x':
+  case 'X':
+    switch (length) {
+    case 'l':
+      spec->type = ARG_LONG;
+      break;
+    case 'q':
+      spec->type = ARG_LLONG;
+      break;
+    case 'j':
+      spec->type = ARG_INTMAX;
+      break;
+    case 'z':
+      spec->type = ARG_SIZE;
+      break;
+    case 't':
+      spec->type = ARG_PTRDIFF;
+      break;
+    case 'L':
+      return NULL;
+    default:
+      spec->type = ARG_INT;
+      break;
+    }
+    break;
+  case 'c':
+    if (length != 0) {
+      return NULL;
+    }
+    spec->type = ARG_INT;
+    break;
+  case 'f':
+  case 'F':
+  case 'e':
+  case 'E':
+  case 'g':
+  case 'G':
+  case 'a':
+  case 'A':
+    spec->type = length == 'L' ? ARG_LDOUBLE : ARG_DOUBLE;
+    break;
+  case 's':
+    if (length != 0) {
+      return NULL;
+    }
+    spec->type = ARG_STRING;
+    break;
+  case 'p':
+    spec->type = ARG_POINTER;
+    break;
+  default:
+    return NULL;
+  }
+  return p + 1;
+}
+
+/* Argument types of `fmt` in call order, or -1 if it cannot be encoded. */
+static int compile_format(const char* fmt, uint8_t* types) {
+  int n = 0;
+  for (const char* p = fmt; *p != '\0';) {
+    if (*p++ != '%') {
+      continue;
+    }
+    Spec spec;
+    p = parse_spec(p, &spec);
+    if (p == NULL || n + spec.stars + 1 > BLOG_MAX_ARGS) {
+      return -1;
+    }
+    if (spec.type < 0) {
+      continue;
+    }
+    for (int i = 0; i < spec.stars; i++) {
+      types[n++] = ARG_INT;
+    }
+    types[n++] = (uint8_t)spec.type;
+  }
+  return n;
+}
+
+/* ---- writing ---- */
+
+static void write_all(int fd, const void* data, size_t len) {
+  const char* p = data;
+  while (len > 0) {
+    ssize_t n = write(fd, p, len);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return;
+    }
+    p += n;
+    len -= (size_t)n;
+  }
+}
+
+static char* put(char* p, const void* value, size_t size) {
+  memcpy(p, value, size);
+  return p + size;
+}
+
+/* Caller holds buffer->mutex. Records buffered for an earlier file are
+ * dropped: their sites are described only there. */
+static void flush_buffer(ThreadBuffer* buffer) {
+  if (buffer->used == 0) {
+    return;
+  }
+  pthread_mutex_lock(&B.file_mutex);
+  if (B.fd >= 0 && buffer->generation == atomic_load(&B.generation)) {
+    write_all(B.fd, buffer->data, buffer->used);
+  }
+  pthread_mutex_unlock(&B.file_mutex);
+  buffer->used = 0;
+}
+
+static void write_site(Site* site) {
+  size_t file_len = strlen(site->file);
+  size_t fmt_len  = strlen(site->fmt);
+  file_len        = file_len > UINT16_MAX ? UINT16_MAX : file_len;
+  fmt_len         = fmt_len > UINT16_MAX ? UINT16_MAX : fmt_len;
+
+  char header[13];
+  char* p       = header;
+  uint8_t kind  = REC_SITE;
+  uint32_t line = (uint32_t)site->line;
+  uint16_t fl   = (uint16_t)file_len;
+  uint16_t ml   = (uint16_t)fmt_len;
+  p             = put(p, &kind, 1);
+  p             = put(p, &site->id, 4);
+  p             = put(p, &line, 4);
+  p             = put(p, &fl, 2);
+  put(p, &ml, 2);
+
+  pthread_mutex_lock(&B.file_mutex);
+  if (B.fd >= 0) {
+    write_all(B.fd, header, sizeof(header));
+    write_all(B.fd, site->file, file_len);
+    write_all(B.fd, site->fmt, fmt_len);
+  }
+  pthread_mutex_unlock(&B.file_mutex);
+}
+
+static Site* intern_site(const char* fmt, const char* file, int line,
+                         unsigned generation) {
+  size_t bucket =
+      (((uintptr_t)fmt >> 3) ^ ((uintptr_t)file >> 3) ^ (uintptr_t)line) %
+      BLOG_SITE_BUCKETS;
+
+  pthread_mutex_lock(&B.site_mutex);
+  Site* site = B.sites[bucket];
+  while (site != NULL &&
+         (site->fmt != fmt || site->file != file || site->line != line)) {
+    site = site->next;
+  }
+  if (site == NULL) {
+    site = calloc(1, sizeof(Site));
+    if (site == NULL) {
+      pthread_mutex_unlock(&B.site_mutex);
+      return NULL;
+    }
+    site->fmt         = fmt;
+    site->file        = file;
+    site->line        = line;
+    site->id          = B.next_site_id++;
+    site->argc        = compile_format(fmt, site->args);
+    atomic_init(&site->generation, generation - 1);
+    site->next      = B.sites[bucket];
+    B.sites[bucket] = site;
+  }
+  if (atomic_load_explicit(&site->generation, memory_order_relaxed) !=
+      generation) {
+    write_site(site);
+    atomic_store_explicit(&site->generation, generation, memory_order_relaxed);
+  }
+  pthread_mutex_unlock(&B.site_mutex);
+  return site;
+}
+
+static void release_thread_buffer(void* value) {
+  ThreadBuffer* buffer = value;
+  pthread_mutex_lock(&B.list_mutex);
+  for (ThreadBuffer** link = &B.buffers; *link != NULL;
+       link                = &(*link)->next) {
+    if (*link == buffer) {
+      *link = buffer->next;
+      break;
+    }
+  }
+  pthread_mutex_lock(&buffer->mutex);
+  flush_buffer(buffer);
+  pthread_mutex_unlock(&buffer->mutex);
+  pthread_mutex_unlock(&B.list_mutex);
+  pthread_mutex_destroy(&buffer->mutex);
+  free(buffer);
+}
+
+static void create_key(void) {
+  pthread_key_create(&B.key, release_thread_buffer);
+}
+
+static ThreadBuffer* get_thread_buffer(void) {
+  if (thread_buffer != NULL) {
+    return thread_buffer;
+  }
+  ThreadBuffer* buffer = calloc(1, sizeof(ThreadBuffer));
+  if (buffer == NULL) {
+    return NULL;
+  }
+  pthread_mutex_init(&buffer->mutex, NULL);
+  pthread_once(&B.key_once, create_key);
+  pthread_setspecific(B.key, buffer);
+
+  pthread_mutex_lock(&B.list_mutex);
+  buffer->next = B.buffers;
+  B.buffers    = buffer;
+  pthread_mutex_unlock(&B.list_mutex);
+  thread_buffer = buffer;
+  return buffer;
+}
+
+static size_t clamp_string(const char* s) {
+  return strnlen(s, BLOG_MAX_STRING);
+}
+
+static size_t payload_size(const Site* site, va_list ap) {
+  size_t size = 0;
+  for (int i = 0; i < site->argc; i++) {
+    switch (site->args[i]) {
+    case ARG_INT:
+      (void)va_arg(ap, int);
+      size += 8;
+      break;
+    case ARG_LONG:
+      (void)va_arg(ap, long);
+      size += 8;
+      break;
+    case ARG_LLONG:
+      (void)va_arg(ap, long long);
+      size += 8;
+      break;
+    case ARG_INTMAX:
+      (void)va_arg(ap, intmax_t);
+      size += 8;
+      break;
+    case ARG_SIZE:
+      (void)va_arg(ap, size_t);
+      size += 8;
+      break;
+    case ARG_PTRDIFF:
+      (void)va_arg(ap, ptrdiff_t);
+      size += 8;
+      break;
+    case ARG_DOUBLE:
+      (void)va_arg(ap, double);
+      size += 8;
+      break;
+    case ARG_LDOUBLE:
+      (void)va_arg(ap, long double);
+      size += 8;
+      break;
+    case ARG_POINTER:
+      (void)va_arg(ap, void*);
+      size += 8;
+      break;
+    case ARG_STRING: {
+      const char* s = va_arg(ap, const char*);
+      size += 4 + (s != NULL ? clamp_string(s) : 0);
+      break;
+    }
+    }
+  }
+  return size;
+}
+
+static char* encode_args(char* p, const Site* site, va_list ap) {
+  for (int i = 0; i < site->argc; i++) {
+    int64_t integer;
+    double real;
+    switch (site->args[i]) {
+    case ARG_INT:
+      integer = va_arg(ap, int);
+      p       = put(p, &integer, 8);
+      break;
+    case ARG_LONG:
+      integer = va_arg(ap, long);
+      p       = put(p, &integer, 8);
+      break;
+    case ARG_LLONG:
+      integer = va_arg(ap, long long);
+      p       = put(p, &integer, 8);
+      break;
+    case ARG_INTMAX:
+      integer = va_arg(ap, intmax_t);
+      p       = put(p, &integer, 8);
+      break;
+    case ARG_SIZE:
+      integer = (int64_t)va_arg(ap, size_t);
+      p       = put(p, &integer, 8);
+      break;
+    case ARG_PTRDIFF:
+      integer = va_arg(ap, ptrdiff_t);
+      p       = put(p, &integer, 8);
+      break;
+    case ARG_DOUBLE:
+      real = va_arg(ap, double);
+      p    = put(p, &real, 8);
+      break;
+    case ARG_LDOUBLE:
+      real = (double)va_arg(ap, long double);
+      p    = put(p, &real, 8);
+      break;
+    case ARG_POINTER:
+      integer = (int64_t)(uintptr_t)va_arg(ap, void*);
+      p       = put(p, &integer, 8);
+      break;
+    case ARG_STRING: {
+      const char* s = va_arg(ap, const char*);
+      uint32_t len  = s != NULL ? (uint32_t)clamp_string(s) : UINT32_MAX;
+      p             = put(p, &len, 4);
+      if (s != NULL) {
+        p = put(p, s, len);
+      }
+      break;
+    }
+    }
+  }
+  return p;
+}
+
+void log_binary_record(int level, const char* file, int line, const char* fmt,
+                       va_list ap) {
+  ThreadBuffer* buffer = get_thread_buffer();
+  if (buffer == NULL) {
+    return;
+  }
+  struct timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+
+  pthread_mutex_lock(&buffer->mutex);
+  unsigned generation = atomic_load(&B.generation);
+
+  size_t slot = (((uintptr_t)fmt >> 3) ^ (uintptr_t)line) % BLOG_CACHE_SIZE;
+  Site* site  = buffer->cache[slot].site;
+  if (site == NULL || buffer->cache[slot].fmt != fmt ||
+      buffer->cache[slot].file != file || buffer->cache[slot].line != line ||
+      atomic_load_explicit(&site->generation, memory_order_relaxed) !=
+          generation) {
+    site = intern_site(fmt, file, line, generation);
+    if (site == NULL) {
+      pthread_mutex_unlock(&buffer->mutex);
+      return;
+    }
+    buffer->cache[slot].fmt  = fmt;
+    buffer->cache[slot].file = file;
+    buffer->cache[slot].line = line;
+    buffer->cache[slot].site = site;
+  }
+
+  char rendered[BLOG_MAX_STRING];
+  uint32_t rendered_len = 0;
+  size_t payload;
+  if (site->argc < 0) {
+    int n        = vsnprintf(rendered, sizeof(rendered), fmt, ap);
+    rendered_len = n < 0 ? 0
+                         : (uint32_t)((size_t)n < sizeof(rendered)
+                                          ? (size_t)n
+                                          : sizeof(rendered) - 1);
+    payload      = 4 + rendered_len;
+  } else {
+    va_list sizing;
+    va_copy(sizing, ap);
+    payload = payload_size(site, sizing);
+    va_end(sizing);
+  }
+
+  if (buffer->generation != generation ||
+      buffer->used + BLOG_EVENT_HEADER + payload > BLOG_BUFFER_SIZE) {
+    flush_buffer(buffer);
+    buffer->generation = generation;
+  }
+  char* p           = buffer->data + buffer->used;
+  uint8_t kind      = REC_EVENT;
+  uint8_t lvl       = (uint8_t)level;
+  int64_t unix_ns   = (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+  uint16_t size_u16 = (uint16_t)payload;
+  p                 = put(p, &kind, 1);
+  p                 = put(p, &lvl, 1);
+  p                 = put(p, &site->id, 4);
+  p                 = put(p, &unix_ns, 8);
+  p                 = put(p, &size_u16, 2);
+  if (site->argc < 0) {
+    p = put(p, &rendered_len, 4);
+    p = put(p, rendered, rendered_len);
+  } else {
+    p = encode_args(p, site, ap);
+  }
+  buffer->used = (size_t)(p - buffer->data);
+  pthread_mutex_unlock(&buffer->mutex);
+}
+
+void log_binary_flush(void) {
+  pthread_mutex_lock(&B.list_mutex);
+  for (ThreadBuffer* buffer = B.buffers; buffer != NULL;
+       buffer               = buffer->next) {
+    pthread_mutex_lock(&buffer->mutex);
+    flush_buffer(buffer);
+    pthread_mutex_unlock(&buffer->mutex);
+  }
+  pthread_mutex_unlock(&B.list_mutex);
+}
+
+int log_start_binary(const char* path, int level) {
+  static bool atexit_registered = false;
+
+  log_stop_binary();
+  int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    return -1;
+  }
+  uint32_t version = BLOG_VERSION;
+  write_all(fd, BLOG_MAGIC, 8);
+  write_all(fd, &version, 4);
+
+  /* Every site is described again in the new file. The generation changes
+   * with the fd, so no record is written to a file its site never was. */
+  pthread_mutex_lock(&B.file_mutex);
+  atomic_fetch_add(&B.generation, 1);
+  B.fd = fd;
+  pthread_mutex_unlock(&B.file_mutex);
+  atomic_store(&log_binary_min_level, level);
+  log_refresh_enabled_level();
+
+  if (!atexit_registered) {
+    atexit(log_stop_binary);
+    atexit_registered = true;
+  }
+  return 0;
+}
+
+void log_stop_binary(void) {
+  if (atomic_exchange(&log_binary_min_level, LOG_FATAL + 1) > LOG_FATAL) {
+    return;
+  }
+  log_refresh_enabled_level();
+  log_binary_flush();
+  pthread_mutex_lock(&B.file_mutex);
+  close(B.fd);
+  B.fd = -1;
+  pthread_mutex_unlock(&B.file_mutex);
+}
+
+/* ---- decoding ---- */
+
+typedef struct {
+  char* file;
+  char* fmt;
+  int line;
+  int argc;
+  uint8_t args[BLOG_MAX_ARGS];
+} DecodedSite;
+
+typedef struct {
+  int64_t unix_ns;
+  size_t order;
+  int level;
+  uint32_t site;
+  const char* payload;
+  uint16_t payload_len;
+} DecodedEvent;
+
+static int compare_events(const void* a, const void* b) {
+  const DecodedEvent* x = a;
+  const DecodedEvent* y = b;
+  if (x->unix_ns != y->unix_ns) {
+    return x->unix_ns < y->unix_ns ? -1 : 1;
+  }
+  return x->order < y->order ? -1 : (x->order > y->order ? 1 : 0);
+}
+
+typedef struct {
+  const char* p;
+  const char* end;
+} Reader;
+
+static bool take(Reader* r, void* out, size_t size) {
+  if ((size_t)(r->end - r->p) < size) {
+    return false;
+  }
+  memcpy(out, r->p, size);
+  r->p += size;
+  return true;
+}
+
+static char* take_string(Reader* r, size_t len) {
+  if ((size_t)(r->end - r->p) < len) {
+    return NULL;
+  }
+  char* s = malloc(len + 1);
+  if (s != NULL) {
+    memcpy(s, r->p, len);
+    s[len] = '\0';
+  }
+  r->p += len;
+  return s;
+}
+
+#define EMIT(value)                                                            \
+  (spec.stars == 0   ? fprintf(out, piece, value)                              \
+   : spec.stars == 1 ? fprintf(out, piece, stars[0], value)                    \
+                     : fprintf(out, piece, stars[0], stars[1], value))
+
+static void render_message(FILE* out, const DecodedSite* site,
+                           const DecodedEvent* ev) {
+  Reader r = {ev->payload, ev->payload + ev->payload_len};
+  if (site->argc < 0) {
+    uint32_t len = 0;
+    if (take(&r, &len, 4) && len <= (size_t)(r.end - r.p)) {
+      fwrite(r.p, 1, len, out);
+    }
+    return;
+  }
+
+  for (const char* p = site->fmt; *p != '\0';) {
+    const char* start = p;
+    while (*p != '\0' && *p != '%') {
+      p++;
+    }
+    fwrite(start, 1, (size_t)(p - start), out);
+    if (*p == '\0') {
+      break;
+    }
+    start = p++;
+    Spec spec;
+    p = parse_spec(p, &spec);
+    if (p == NULL) {
+      return;
+    }
+    if (spec.type < 0) {
+      fputc('%', out);
+      continue;
+    }
+    char piece[64];
+    size_t piece_len = (size_t)(p - start);
+    if (piece_len >= sizeof(piece)) {
+      return;
+    }
+    memcpy(piece, start, piece_len);
+    piece[piece_len] = '\0';
+
+    int stars[2] = {0, 0};
+    for (int i = 0; i < spec.stars; i++) {
+      int64_t value = 0;
+      if (!take(&r, &value, 8)) {
+        return;
+      }
+      stars[i] = (int)value;
+    }
+
+    int64_t integer = 0;
+    double real     = 0.0;
+    switch (spec.type) {
+    case ARG_STRING: {
+      uint32_t len = 0;
+      if (!take(&r, &len, 4)) {
+        return;
+      }
+      if (len == UINT32_MAX) {
+        EMIT("(null)");
+        break;
+      }
+      char* text = take_string(&r, len);
+      if (text == NULL) {
+        return;
+      }
+      EMIT(text);
+      free(text);
+      break;
+    }
+    case ARG_DOUBLE:
+    case ARG_LDOUBLE:
+      if (!take(&r, &real, 8)) {
+        return;
+      }
+      if (spec.type == ARG_DOUBLE) {
+        EMIT(real);
+      } else {
+        EMIT((long double)real);
+      }
+      break;
+    default:
+      if (!take(&r, &integer, 8)) {
+        return;
+      }
+      switch (spec.type) {
+      case ARG_INT:
+        EMIT((int)integer);
+        break;
+      case ARG_LONG:
+        EMIT((long)integer);
+        break;
+      case ARG_LLONG:
+        EMIT((long long)integer);
+        break;
+      case ARG_INTMAX:
+        EMIT((intmax_t)integer);
+        break;
+      case ARG_SIZE:
+        EMIT((size_t)integer);
+        break;
+      case ARG_PTRDIFF:
+        EMIT((ptrdiff_t)integer);
+        break;
+      case ARG_POINTER:
+        EMIT((void*)(uintptr_t)integer);
+        break;
+      }
+      break;
+    }
+  }
+}
+
+#undef EMIT
+
+long log_decode_binary(const char* path, FILE* out) {
+  FILE* in = fopen(path, "rb");
+  if (in == NULL) {
+    return -1;
+  }
+  char* data  = NULL;
+  size_t size = 0;
+  for (;;) {
+    char* grown = realloc(data, size + 65536);
+    if (grown == NULL) {
+      free(data);
+      fclose(in);
+      return -1;
+    }
+    data = grown;
+    size_t n = fread(data + size, 1, 65536, in);
+    size += n;
+    if (n < 65536) {
+      break;
+    }
+  }
+  fclose(in);
+
+  long result           = -1;
+  DecodedSite* sites    = NULL;
+  size_t site_count     = 0;
+  DecodedEvent* events  = NULL;
+  size_t event_count    = 0;
+  size_t event_capacity = 0;
+
+  Reader r = {data, data + size};
+  char magic[8];
+  uint32_t version = 0;
+  if (!take(&r, magic, 8) || memcmp(magic, BLOG_MAGIC, 8) != 0 ||
+      !take(&r, &version, 4) || version != BLOG_VERSION) {
+    goto done;
+  }
+
+  while (r.p < r.end) {
+    uint8_t kind = 0;
+    take(&r, &kind, 1);
+    if (kind == REC_SITE) {
+      uint32_t id = 0, line = 0;
+      uint16_t file_len = 0, fmt_len = 0;
+      if (!take(&r, &id, 4) || !take(&r, &line, 4) || !take(&r, &file_len, 2) ||
+          !take(&r, &fmt_len, 2) || id > UINT16_MAX * 256u) {
+        break;
+      }
+      if (id >= site_count) {
+        DecodedSite* grown = realloc(sites, (id + 1) * sizeof(DecodedSite));
+        if (grown == NULL) {
+          goto done;
+        }
+        memset(grown + site_count, 0,
+               (id + 1 - site_count) * sizeof(DecodedSite));
+        sites      = grown;
+        site_count = id + 1;
+      }
+      DecodedSite* site = &sites[id];
+      free(site->file);
+      free(site->fmt);
+      site->file = take_string(&r, file_len);
+      site->fmt  = take_string(&r, fmt_len);
+      if (site->file == NULL || site->fmt == NULL) {
+        break;
+      }
+      site->line = (int)line;
+      site->argc = compile_format(site->fmt, site->args);
+    } else if (kind == REC_EVENT) {
+      DecodedEvent ev;
+      uint8_t level = 0;
+      if (!take(&r, &level, 1) || !take(&r, &ev.site, 4) ||
+          !take(&r, &ev.unix_ns, 8) || !take(&r, &ev.payload_len, 2) ||
+          (size_t)(r.end - r.p) < ev.payload_len) {
+        break;
+      }
+      ev.level   = level <= LOG_FATAL ? level : LOG_FATAL;
+      ev.payload = r.p;
+      ev.order   = event_count;
+      r.p += ev.payload_len;
+      if (event_count == event_capacity) {
+        size_t capacity     = event_capacity ? event_capacity * 2 : 1024;
+        DecodedEvent* grown = realloc(events, capacity * sizeof(DecodedEvent));
+        if (grown == NULL) {
+          goto done;
+        }
+        events         = grown;
+        event_capacity = capacity;
+      }
+      events[event_count++] = ev;
+    } else {
+      break;
+    }
+  }
+
+  /* A process that crashed leaves a truncated last record; everything before
+   * it is still rendered. Threads flush their buffers independently, so
+   * restore time order. */
+  qsort(events, event_count, sizeof(DecodedEvent), compare_events);
+  for (size_t i = 0; i < event_count; i++) {
+    const DecodedEvent* ev = &events[i];
+    if (ev->site >= site_count || sites[ev->site].fmt == NULL) {
+      continue;
+    }
+    const DecodedSite* site = &sites[ev->site];
+    time_t seconds          = (time_t)(ev->unix_ns / 1000000000);
+    struct tm tm;
+    char clock[32];
+    localtime_r(&seconds, &tm);
+    strftime(clock, sizeof(clock), "%Y-%m-%d %H:%M:%S", &tm);
+    fprintf(out, "%s.%06ld %-5s %s:%d: ", clock,
+            (long)(ev->unix_ns % 1000000000 / 1000),
+            log_level_string(ev->level), site->file, site->line);
+    render_message(out, site, ev);
+    fputc('\n', out);
+  }
+  result = (long)event_count;
+
+done:
+  for (size_t i = 0; i < site_count; i++) {
+    free(sites[i].file);
+    free(sites[i].fmt);
+  }
+  free(sites);
+  free(events);
+  free(data);
+  return result;
+}
@@ -0,0 +1,26 @@
+#ifndef LOG_INTERNAL_H
+#define LOG_INTERNAL_H
+
+/* Private hooks between log.c and the handlers in log_binary.c and
+ * log_recorder.c; not installed. */
+
+#include <stdarg.h>
+#include <stdatomic.h>
+
+/* Lowest level the binary handler records; above LOG_FATAL while stopped. */
+extern atomic_int log_binary_min_level;
+
+void log_binary_record(int level, const char* file, int line, const char* fmt,
+                       va_list ap);
+void log_binary_flush(void);
+
+/* Lowest level the flight recorder keeps; above LOG_FATAL while stopped. */
+extern atomic_int log_recorder_min_level;
+
+void log_recorder_record(int level, const char* file, int line,
+                         const char* fmt, va_list ap);
+
+/* Recomputes log_enabled_level after a sink or the binary level changed. */
+void log_refresh_enabled_level(void);
+
+#endif
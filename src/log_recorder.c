@@ -0,0 +1,579 @@
+/*
+ * Flight recorder: the most recent records of every thread, at every level,
+ * kept in fixed-size rings so that a crash still leaves the lead-up behind.
+ *
+ * Each thread owns one ring of formatted slots and overwrites the oldest
+ * slot; there is no lock on the record path. The rings live in one region
+ * which is either anonymous memory or a shared mapping of a file, which the
+ * kernel keeps even if the process dies. On a fatal signal the handler
+ * writes the rings as text with write(2) only, then re-raises the signal.
+ *
+ * Region layout (native byte order):
+ *   header  "HYDRAFLT" u32 version, u32 ring_count, u32 slots, u32 slot_size,
+ *           i32 signal, label[64], padding to 128 bytes
+ *   ring    u64 head, i32 tid, i32 owned, padding to 64 bytes, slots
+ *   slot    i64 unix_ns, u8 level, u8 0, u16 len, u32 0, text[240]
+ * `head` counts the records a ring has ever taken; slot `n % slots` holds
+ * record n. A slot written while the process died may be torn.
+ */
+
+#include "log_internal.h"
+
+#include "hydra/log.h"
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#define FLT_MAGIC "HYDRAFLT"
+#define FLT_VERSION 1
+#define FLT_MAX_RINGS 64
+#define FLT_SLOT_SIZE 256
+#define FLT_TEXT (FLT_SLOT_SIZE - 16)
+#define FLT_LABEL 64
+#define FLT_HEADER_SIZE 128
+#define FLT_RING_HEADER_SIZE 64
+#define FLT_PATH 4096
+#define FLT_ALTSTACK_SIZE (64 * 1024)
+
+typedef struct {
+  char magic[8];
+  uint32_t version;
+  uint32_t ring_count;
+  uint32_t slots;
+  uint32_t slot_size;
+  atomic_int signal;
+  char label[FLT_LABEL];
+} Header;
+
+typedef struct {
+  _Atomic uint64_t head;
+  int32_t tid;
+  atomic_int owned;
+} RingHeader;
+
+typedef struct {
+  int64_t unix_ns;
+  uint8_t level;
+  uint8_t reserved;
+  uint16_t len;
+  uint32_t reserved2;
+  char text[FLT_TEXT];
+} Slot;
+
+_Static_assert(sizeof(Header) <= FLT_HEADER_SIZE, "header too large");
+_Static_assert(sizeof(RingHeader) <= FLT_RING_HEADER_SIZE, "ring too large");
+_Static_assert(sizeof(Slot) == FLT_SLOT_SIZE, "slot size");
+
+static const int fatal_signals[] = {SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT};
+#define FATAL_SIGNAL_COUNT                                                     \
+  (sizeof(fatal_signals) / sizeof(fatal_signals[0]))
+
+atomic_int log_recorder_min_level = LOG_FATAL + 1;
+
+static struct {
+  pthread_mutex_t mutex;
+  _Atomic(char*) region;
+  size_t region_size;
+  atomic_uint generation;
+  char dump_path[FLT_PATH];
+  struct sigaction previous[FATAL_SIGNAL_COUNT];
+  bool handlers_installed;
+  atomic_int dumping;
+  pthread_key_t key;
+  pthread_key_t altstack_key;
+  pthread_once_t key_once;
+} R = {
+    .mutex    = PTHREAD_MUTEX_INITIALIZER,
+    .key_once = PTHREAD_ONCE_INIT,
+};
+
+/* Producers writing into ring i, counted in inside[i] (one cache line
+ * each, as a ring has one owner) so that log_stop_recorder can wait for
+ * them before unmapping the region. */
+typedef struct {
+  _Alignas(64) atomic_uint inside;
+} RingUse;
+static RingUse ring_use[FLT_MAX_RINGS];
+
+static _Thread_local RingHeader* thread_ring;
+static _Thread_local uint32_t thread_index;
+static _Thread_local uint32_t thread_slots;
+static _Thread_local unsigned thread_generation;
+
+static size_t ring_bytes(uint32_t slots) {
+  return FLT_RING_HEADER_SIZE + (size_t)slots * FLT_SLOT_SIZE;
+}
+
+static RingHeader* ring_at(const char* region, uint32_t index) {
+  const Header* header = (const Header*)region;
+  return (RingHeader*)(region + FLT_HEADER_SIZE +
+                       index * ring_bytes(header->slots));
+}
+
+static Slot* slot_at(RingHeader* ring, uint64_t n, uint32_t slots) {
+  return (Slot*)((char*)ring + FLT_RING_HEADER_SIZE) + n % slots;
+}
+
+/* ---- recording ---- */
+
+static void release_thread_ring(void* value) {
+  /* A ring from an earlier start may be unmapped already. */
+  pthread_mutex_lock(&R.mutex);
+  if (thread_generation == atomic_load(&R.generation)) {
+    atomic_store_explicit(&((RingHeader*)value)->owned, 0,
+                          memory_order_release);
+  }
+  pthread_mutex_unlock(&R.mutex);
+}
+
+static void release_altstack(void* value) {
+  stack_t none;
+  memset(&none, 0, sizeof(none));
+  none.ss_flags = SS_DISABLE;
+  sigaltstack(&none, NULL);
+  free(value);
+}
+
+static void create_key(void) {
+  pthread_key_create(&R.key, release_thread_ring);
+  pthread_key_create(&R.altstack_key, release_altstack);
+}
+
+/* The handlers run with SA_ONSTACK so that a stack overflow still dumps;
+ * give each recording thread a stack unless it already has one. */
+static void ensure_altstack(void) {
+  stack_t current;
+  if (pthread_getspecific(R.altstack_key) != NULL ||
+      sigaltstack(NULL, &current) != 0 || !(current.ss_flags & SS_DISABLE)) {
+    return;
+  }
+  stack_t stack;
+  memset(&stack, 0, sizeof(stack));
+  stack.ss_sp   = malloc(FLT_ALTSTACK_SIZE);
+  stack.ss_size = FLT_ALTSTACK_SIZE;
+  if (stack.ss_sp == NULL || sigaltstack(&stack, NULL) != 0) {
+    free(stack.ss_sp);
+    return;
+  }
+  pthread_setspecific(R.altstack_key, stack.ss_sp);
+}
+
+/* Claims an unused ring, then one left behind by an exited thread. */
+static RingHeader* claim_ring(char* region, uint32_t* index) {
+  const Header* header = (const Header*)region;
+  RingHeader* found    = NULL;
+  for (int pass = 0; pass < 2 && found == NULL; pass++) {
+    for (uint32_t i = 0; i < header->ring_count; i++) {
+      RingHeader* ring = ring_at(region, i);
+      if (atomic_load(&ring->owned) == 0 &&
+          (pass == 1 || atomic_load(&ring->head) == 0)) {
+        found  = ring;
+        *index = i;
+        break;
+      }
+    }
+  }
+  if (found != NULL) {
+    atomic_store(&found->owned, 1);
+    atomic_store(&found->head, 0);
+#ifdef SYS_gettid
+    found->tid = (int32_t)syscall(SYS_gettid);
+#else
+    found->tid = 0;
+#endif
+  }
+  return found;
+}
+
+/* Returns this thread's ring with ring_use[thread_index] held, which
+ * leave_ring releases. Entering before checking the generation pairs with
+ * log_stop_recorder (both seq_cst): either the stop is seen here or the
+ * stop waits for this record. */
+static RingHeader* enter_ring(void) {
+  if (thread_ring != NULL) {
+    atomic_fetch_add(&ring_use[thread_index].inside, 1);
+    if (thread_generation == atomic_load(&R.generation)) {
+      return thread_ring;
+    }
+    atomic_fetch_sub(&ring_use[thread_index].inside, 1);
+  } else if (thread_generation == atomic_load(&R.generation)) {
+    /* A thread that found every ring taken stays silent until a restart. */
+    return NULL;
+  }
+  pthread_once(&R.key_once, create_key);
+  pthread_mutex_lock(&R.mutex);
+  char* region = atomic_load(&R.region);
+  thread_ring  = region != NULL ? claim_ring(region, &thread_index) : NULL;
+  thread_slots = region != NULL ? ((const Header*)region)->slots : 0;
+  if (thread_ring != NULL) {
+    atomic_fetch_add(&ring_use[thread_index].inside, 1);
+  }
+  thread_generation = atomic_load(&R.generation);
+  pthread_mutex_unlock(&R.mutex);
+  pthread_setspecific(R.key, thread_ring);
+  if (thread_ring != NULL) {
+    ensure_altstack();
+  }
+  return thread_ring;
+}
+
+static void leave_ring(void) {
+  atomic_fetch_sub_explicit(&ring_use[thread_index].inside, 1,
+                            memory_order_release);
+}
+
+void log_recorder_record(int level, const char* file, int line,
+                         const char* fmt, va_list ap) {
+  RingHeader* ring = enter_ring();
+  if (ring == NULL) {
+    return;
+  }
+  struct timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+
+  uint64_t n       = atomic_load_explicit(&ring->head, memory_order_relaxed);
+  Slot* slot       = slot_at(ring, n, thread_slots);
+  const char* base = strrchr(file, '/');
+  base             = base != NULL ? base + 1 : file;
+
+  /* "file:line: " by hand; snprintf would cost as much as the message. */
+  char digits[12];
+  int digit_count = 0;
+  unsigned value  = line > 0 ? (unsigned)line : 0;
+  do {
+    digits[digit_count++] = (char)('0' + value % 10);
+    value /= 10;
+  } while (value != 0);
+  int len = (int)strnlen(base, FLT_TEXT / 2);
+  memcpy(slot->text, base, (size_t)len);
+  slot->text[len++] = ':';
+  while (digit_count > 0) {
+    slot->text[len++] = digits[--digit_count];
+  }
+  slot->text[len++] = ':';
+  slot->text[len++] = ' ';
+  int message = vsnprintf(slot->text + len, FLT_TEXT - (size_t)len, fmt, ap);
+  if (message > 0) {
+    len += message < FLT_TEXT - len ? message : FLT_TEXT - len - 1;
+  }
+  slot->unix_ns = (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+  slot->level   = (uint8_t)level;
+  slot->len     = (uint16_t)len;
+  atomic_store_explicit(&ring->head, n + 1, memory_order_release);
+  leave_ring();
+}
+
+/* ---- reading (shared by the crash dump and the decoder) ---- */
+
+typedef struct {
+  uint64_t next[FLT_MAX_RINGS];
+  uint64_t end[FLT_MAX_RINGS];
+} Cursor;
+
+static void cursor_init(Cursor* cursor, const char* region) {
+  const Header* header = (const Header*)region;
+  for (uint32_t i = 0; i < header->ring_count; i++) {
+    uint64_t head   = atomic_load(&ring_at(region, i)->head);
+    cursor->end[i]  = head;
+    cursor->next[i] = head > header->slots ? head - header->slots : 0;
+  }
+}
+
+/* The oldest record not yet visited across all rings, or NULL. */
+static const Slot* cursor_next(Cursor* cursor, const char* region,
+                               uint32_t* ring_index) {
+  const Header* header = (const Header*)region;
+  const Slot* best     = NULL;
+  for (uint32_t i = 0; i < header->ring_count; i++) {
+    if (cursor->next[i] == cursor->end[i]) {
+      continue;
+    }
+    const Slot* slot =
+        slot_at(ring_at(region, i), cursor->next[i], header->slots);
+    if (best == NULL || slot->unix_ns < best->unix_ns) {
+      best        = slot;
+      *ring_index = i;
+    }
+  }
+  if (best != NULL) {
+    cursor->next[*ring_index]++;
+  }
+  return best;
+}
+
+static const char* slot_level(const Slot* slot) {
+  return log_level_string(slot->level <= LOG_FATAL ? slot->level : LOG_FATAL);
+}
+
+static size_t slot_len(const Slot* slot) {
+  return slot->len < FLT_TEXT ? slot->len : FLT_TEXT - 1;
+}
+
+/* ---- crash dump: async-signal-safe, no stdio and no allocation ---- */
+
+static void dump_write(int fd, const char* s, size_t len) {
+  while (len > 0) {
+    ssize_t n = write(fd, s, len);
+    if (n <= 0) {
+      return;
+    }
+    s += n;
+    len -= (size_t)n;
+  }
+}
+
+static void dump_string(int fd, const char* s) {
+  dump_write(fd, s, strlen(s));
+}
+
+/* Writes `value` in decimal, zero-padded to `width` digits. */
+static void dump_number(int fd, uint64_t value, int width) {
+  char digits[24];
+  int i = (int)sizeof(digits);
+  do {
+    digits[--i] = (char)('0' + value % 10);
+    value /= 10;
+    width--;
+  } while (value != 0 || width > 0);
+  dump_write(fd, digits + i, sizeof(digits) - (size_t)i);
+}
+
+static void dump_region(int fd, const char* region, int sig) {
+  const Header* header = (const Header*)region;
+  dump_string(fd, "--- hydra flight recorder: signal ");
+  dump_number(fd, (uint64_t)sig, 0);
+  if (header->label[0] != '\0') {
+    dump_string(fd, ", ");
+    dump_write(fd, header->label, strnlen(header->label, FLT_LABEL));
+  }
+  dump_string(fd, " ---\n");
+
+  Cursor cursor;
+  uint32_t index = 0;
+  cursor_init(&cursor, region);
+  for (const Slot* slot; (slot = cursor_next(&cursor, region, &index));) {
+    uint64_t ns = (uint64_t)slot->unix_ns;
+    dump_number(fd, ns / 1000000000, 0);
+    dump_string(fd, ".");
+    dump_number(fd, ns % 1000000000 / 1000, 6);
+    dump_string(fd, " ");
+    dump_string(fd, slot_level(slot));
+    dump_string(fd, " [");
+    dump_number(fd, (uint64_t)ring_at(region, index)->tid, 0);
+    dump_string(fd, "] ");
+    dump_write(fd, slot->text, slot_len(slot));
+    dump_string(fd, "\n");
+  }
+}
+
+static void on_fatal_signal(int sig) {
+  /* Claim the dump before looking at the region: log_stop_recorder leaves
+   * the region mapped once a dump has started. */
+  char* region = NULL;
+  if (atomic_exchange(&R.dumping, 1) == 0 &&
+      (region = atomic_load(&R.region)) != NULL) {
+    atomic_store(&((Header*)region)->signal, sig);
+    int fd = -1;
+    if (R.dump_path[0] != '\0') {
+      fd = open(R.dump_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    }
+    dump_region(fd >= 0 ? fd : STDERR_FILENO, region, sig);
+    if (fd >= 0) {
+      close(fd);
+      dump_string(STDERR_FILENO, "hydra: flight recorder written to ");
+      dump_string(STDERR_FILENO, R.dump_path);
+      dump_string(STDERR_FILENO, "\n");
+    }
+  }
+  /* Hand the signal to whoever had it before; a fault re-raises itself when
+   * the handler returns, abort() raises again. */
+  for (size_t i = 0; i < FATAL_SIGNAL_COUNT; i++) {
+    if (fatal_signals[i] == sig) {
+      sigaction(sig, &R.previous[i], NULL);
+    }
+  }
+  raise(sig);
+}
+
+static void install_handlers(void) {
+  if (R.handlers_installed) {
+    return;
+  }
+  struct sigaction action;
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = on_fatal_signal;
+  action.sa_flags   = SA_ONSTACK;
+  sigemptyset(&action.sa_mask);
+  for (size_t i = 0; i < FATAL_SIGNAL_COUNT; i++) {
+    sigaction(fatal_signals[i], &action, &R.previous[i]);
+  }
+  R.handlers_installed = true;
+}
+
+static void restore_handlers(void) {
+  if (!R.handlers_installed) {
+    return;
+  }
+  for (size_t i = 0; i < FATAL_SIGNAL_COUNT; i++) {
+    sigaction(fatal_signals[i], &R.previous[i], NULL);
+  }
+  R.handlers_installed = false;
+}
+
+/* ---- control ---- */
+
+int log_start_recorder(const char* path, size_t records_per_thread, int level,
+                       const char* label) {
+  if (records_per_thread == 0 || records_per_thread > UINT32_MAX / 2) {
+    return -1;
+  }
+  log_stop_recorder();
+
+  uint32_t slots = (uint32_t)records_per_thread;
+  size_t size    = FLT_HEADER_SIZE + FLT_MAX_RINGS * ring_bytes(slots);
+  char* region   = MAP_FAILED;
+  if (path != NULL) {
+    /* A fresh inode: the file of an earlier start is left as it was. */
+    unlink(path);
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+      return -1;
+    }
+    if (ftruncate(fd, (off_t)size) == 0) {
+      region = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+  } else {
+    region = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                  MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  }
+  if (region == MAP_FAILED) {
+    return -1;
+  }
+
+  Header* header = (Header*)region;
+  memcpy(header->magic, FLT_MAGIC, 8);
+  header->version    = FLT_VERSION;
+  header->ring_count = FLT_MAX_RINGS;
+  header->slots      = slots;
+  header->slot_size  = FLT_SLOT_SIZE;
+  if (label != NULL) {
+    strncpy(header->label, label, FLT_LABEL - 1);
+  }
+
+  pthread_mutex_lock(&R.mutex);
+  R.dump_path[0] = '\0';
+  if (path != NULL && strlen(path) + sizeof(".dump") <= FLT_PATH) {
+    strcpy(R.dump_path, path);
+    strcat(R.dump_path, ".dump");
+  }
+  R.region_size = size;
+  atomic_store(&R.dumping, 0);
+  atomic_store(&R.region, region);
+  atomic_fetch_add(&R.generation, 1);
+  install_handlers();
+  pthread_mutex_unlock(&R.mutex);
+
+  atomic_store(&log_recorder_min_level, level);
+  log_refresh_enabled_level();
+  return 0;
+}
+
+void log_stop_recorder(void) {
+  if (atomic_exchange(&log_recorder_min_level, LOG_FATAL + 1) > LOG_FATAL) {
+    return;
+  }
+  log_refresh_enabled_level();
+  pthread_mutex_lock(&R.mutex);
+  restore_handlers();
+  char* region = atomic_exchange(&R.region, NULL);
+  atomic_fetch_add(&R.generation, 1);
+  /* New records see the new generation; wait out the ones already inside a
+   * ring, then the region can go (a file-backed one stays on disk). */
+  for (size_t i = 0; i < FLT_MAX_RINGS; i++) {
+    while (atomic_load(&ring_use[i].inside) != 0) {
+      sched_yield();
+    }
+  }
+  if (region != NULL && atomic_load(&R.dumping) == 0) {
+    munmap(region, R.region_size);
+  }
+  pthread_mutex_unlock(&R.mutex);
+}
+
+int log_dump_recorder(int fd) {
+  /* R.mutex keeps log_stop_recorder from unmapping the region meanwhile. */
+  pthread_mutex_lock(&R.mutex);
+  char* region = atomic_load(&R.region);
+  if (region != NULL) {
+    dump_region(fd, region, 0);
+  }
+  pthread_mutex_unlock(&R.mutex);
+  return region != NULL ? 0 : -1;
+}
+
+/* ---- decoding ---- */
+
+long log_decode_recorder(const char* path, FILE* out) {
+  FILE* in = fopen(path, "rb");
+  if (in == NULL) {
+    return -1;
+  }
+  Header header;
+  long count = -1;
+  char* data = NULL;
+  if (fread(&header, sizeof(header), 1, in) != 1 ||
+      memcmp(header.magic, FLT_MAGIC, 8) != 0 ||
+      header.version != FLT_VERSION || header.ring_count > FLT_MAX_RINGS ||
+      header.slot_size != FLT_SLOT_SIZE || header.slots == 0 ||
+      header.slots > UINT32_MAX / 2) {
+    goto done;
+  }
+  size_t size = FLT_HEADER_SIZE + header.ring_count * ring_bytes(header.slots);
+  data        = malloc(size);
+  if (data == NULL || fseek(in, 0, SEEK_SET) != 0 ||
+      fread(data, 1, size, in) != size) {
+    goto done;
+  }
+  header.label[FLT_LABEL - 1] = '\0';
+
+  fprintf(out, "--- hydra flight recorder");
+  int sig = atomic_load(&header.signal);
+  if (sig != 0) {
+    fprintf(out, ": signal %d", sig);
+  }
+  if (header.label[0] != '\0') {
+    fprintf(out, ", %s", header.label);
+  }
+  fprintf(out, " ---\n");
+
+  Cursor cursor;
+  uint32_t index = 0;
+  count          = 0;
+  cursor_init(&cursor, data);
+  for (const Slot* slot; (slot = cursor_next(&cursor, data, &index));) {
+    time_t seconds = (time_t)(slot->unix_ns / 1000000000);
+    struct tm tm;
+    char clock[32];
+    localtime_r(&seconds, &tm);
+    strftime(clock, sizeof(clock), "%Y-%m-%d %H:%M:%S", &tm);
+    fprintf(out, "%s.%06ld %-5s [%d] %.*s\n", clock,
+            (long)(slot->unix_ns % 1000000000 / 1000), slot_level(slot),
+            (int)ring_at(data, index)->tid, (int)slot_len(slot), slot->text);
+    count++;
+  }
+
+done:
+  free(data);
+  fclose(in);
+  return count;
+}
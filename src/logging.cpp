@@ -1,27 +1,36 @@
 #include "hydra/logging.h"
 
+#include "c_api_internal.hpp"
 #include "hydra/config_node.hpp"
 #include "hydra/config_utils.hpp"
 #include "hydra/log.h"
 #include "hydra/logging.hpp"
 
+#include <cstdint>
+#include <cstdio>
 #include <cstdlib>
 #include <cstring>
 #include <filesystem>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <new>
 #include <sstream>
 #include <string>
+#include <tuple>
+#include <unordered_map>
 
 namespace fs = std::filesystem;
 
-struct hydra_config {
-  hydra::ConfigNode node;
-};
-
 namespace {
 
+// Held by init_logging and hydra_logging_setup_file, which swap the sinks
+// below, so that concurrent callers do not close each other's files.
+std::mutex sink_mutex;
 FILE* log_file_handle = nullptr;
 std::string current_log_file_path;
-int log_file_callback_index = -1; // Track registered callback index
+FILE* json_file_handle = nullptr;
+std::string current_json_file_path;
 
 int parse_log_level(const char* level_str) {
   if (level_str == nullptr) {
@@ -59,21 +68,262 @@ int parse_log_level(const char* level_str) {
   return LOG_INFO;
 }
 
-void assign_error(char** error_message, const std::string& msg) {
-  if (error_message != nullptr) {
-    size_t len = msg.length();
-    char* copy = static_cast<char*>(std::malloc(len + 1));
-    if (copy != nullptr) {
-      std::memcpy(copy, msg.c_str(), len + 1);
+// Async backend settings from the last init_logging call.
+bool async_enabled      = false;
+size_t async_queue_size = 8192;
+int async_overflow      = LOG_OVERFLOW_BLOCK;
+
+// Reads hydra.job_logging.async together with queue_size and overflow
+// ("block" or "drop").
+void configure_async_logging(const hydra::ConfigNode& config) {
+  const hydra::ConfigNode* async_node =
+      hydra::find_path(config, {"hydra", "job_logging", "async"});
+  async_enabled = async_node != nullptr && async_node->is_bool() &&
+                  async_node->as_bool();
+
+  size_t queue_size = 8192;
+  const hydra::ConfigNode* size_node =
+      hydra::find_path(config, {"hydra", "job_logging", "queue_size"});
+  if (size_node != nullptr && size_node->is_int() && size_node->as_int() > 0) {
+    queue_size = static_cast<size_t>(size_node->as_int());
+  }
+
+  int overflow = LOG_OVERFLOW_BLOCK;
+  const hydra::ConfigNode* overflow_node =
+      hydra::find_path(config, {"hydra", "job_logging", "overflow"});
+  if (overflow_node != nullptr && overflow_node->is_string() &&
+      overflow_node->as_string() == "drop") {
+    overflow = LOG_OVERFLOW_DROP;
+  }
+
+  async_queue_size = queue_size;
+  async_overflow   = overflow;
+}
+
+// Applies hydra.job_logging.handlers.<handler>.flush ("record", "interval" or
+// "level", with flush_interval_ms / flush_level) to the sinks writing to
+// `stream`.
+void configure_flush(const hydra::ConfigNode& config, const char* handler,
+                     FILE* stream) {
+  const hydra::ConfigNode* handler_node =
+      hydra::find_path(config, {"hydra", "job_logging", "handlers", handler});
+  if (stream == nullptr || handler_node == nullptr ||
+      !handler_node->is_mapping()) {
+    return;
+  }
+  const hydra::ConfigNode* flush_node =
+      hydra::find_path(*handler_node, {"flush"});
+  std::string policy = flush_node != nullptr && flush_node->is_string()
+                           ? flush_node->as_string()
+                           : "record";
+
+  if (policy == "interval") {
+    const hydra::ConfigNode* interval_node =
+        hydra::find_path(*handler_node, {"flush_interval_ms"});
+    int64_t interval = interval_node != nullptr && interval_node->is_int()
+                           ? interval_node->as_int()
+                           : 1000;
+    log_set_flush(stream, LOG_FLUSH_INTERVAL, static_cast<int>(interval));
+  } else if (policy == "level") {
+    const hydra::ConfigNode* level_node =
+        hydra::find_path(*handler_node, {"flush_level"});
+    int level = parse_log_level(level_node != nullptr && level_node->is_string()
+                                    ? level_node->as_string().c_str()
+                                    : "WARN");
+    log_set_flush(stream, LOG_FLUSH_LEVEL, level);
+  } else {
+    log_set_flush(stream, LOG_FLUSH_RECORD, 0);
+  }
+}
+
+// Applies hydra.job_logging.handlers.file.{max_bytes, backup_count, when,
+// compress} to the sink writing `stream`, which was opened at `path`.
+void configure_rotation(const hydra::ConfigNode& config, FILE* stream,
+                        const std::string& path) {
+  const hydra::ConfigNode* handler_node =
+      hydra::find_path(config, {"hydra", "job_logging", "handlers", "file"});
+  if (stream == nullptr || handler_node == nullptr ||
+      !handler_node->is_mapping()) {
+    return;
+  }
+  auto int_option = [&](const char* key, int64_t fallback) {
+    const hydra::ConfigNode* node = hydra::find_path(*handler_node, {key});
+    return node != nullptr && node->is_int() ? node->as_int() : fallback;
+  };
+  const hydra::ConfigNode* when_node =
+      hydra::find_path(*handler_node, {"when"});
+  const hydra::ConfigNode* compress_node =
+      hydra::find_path(*handler_node, {"compress"});
+
+  int when = when_node != nullptr && when_node->is_string() &&
+                     when_node->as_string() == "midnight"
+                 ? LOG_ROTATE_MIDNIGHT
+                 : LOG_ROTATE_NEVER;
+  bool compress = compress_node != nullptr && compress_node->is_bool() &&
+                  compress_node->as_bool();
+  log_set_rotation(stream, path.c_str(), int_option("max_bytes", 0),
+                   static_cast<int>(int_option("backup_count", 5)), when,
+                   compress);
+}
+
+// Detaches a file sink from log.c and closes it.
+void close_log_file(FILE*& handle, std::string& path) {
+  if (handle == nullptr) {
+    return;
+  }
+  log_flush();
+  log_remove_fp(handle);
+  std::fclose(handle);
+  handle = nullptr;
+  path.clear();
+}
+
+std::string config_string(const hydra::ConfigNode& config,
+                          std::initializer_list<std::string> path,
+                          const char* fallback) {
+  const hydra::ConfigNode* node = hydra::find_path(config, path);
+  return node != nullptr && node->is_string() ? node->as_string() : fallback;
+}
+
+// hydra.job_logging.handlers.<handler>.filename, defaulting to
+// ${hydra.run.dir}/${hydra.job.name}<extension>.
+std::string handler_filename(const hydra::ConfigNode& config,
+                             const char* handler, const char* extension) {
+  const hydra::ConfigNode* filename_node = hydra::find_path(
+      config, {"hydra", "job_logging", "handlers", handler, "filename"});
+  if (filename_node && filename_node->is_string()) {
+    return filename_node->as_string();
+  }
+
+  return config_string(config, {"hydra", "run", "dir"}, ".") + "/" +
+         config_string(config, {"hydra", "job", "name"}, "app") + extension;
+}
+
+// FNV-1a of the resolved config as YAML, so a crash dump names the exact
+// configuration the job ran with.
+std::string config_hash(const hydra::ConfigNode& config) {
+  std::ostringstream yaml;
+  hydra::utils::write_yaml(yaml, config);
+  uint64_t hash = 14695981039346656037ull;
+  for (unsigned char c : yaml.str()) {
+    hash = (hash ^ c) * 1099511628211ull;
+  }
+  char text[32];
+  std::snprintf(text, sizeof(text), "config=%016llx",
+                static_cast<unsigned long long>(hash));
+  return text;
+}
+
+// Starts the flight recorder from hydra.job_logging.handlers.recorder
+// {filename, records_per_thread, level}. A null filename keeps the rings in
+// memory only; the crash dump then goes to stderr.
+void configure_recorder(const hydra::ConfigNode& config, bool enabled) {
+  const hydra::ConfigNode* handler_node = hydra::find_path(
+      config, {"hydra", "job_logging", "handlers", "recorder"});
+  if (!enabled) {
+    log_stop_recorder();
+    return;
+  }
+  const hydra::ConfigNode* filename_node =
+      handler_node != nullptr && handler_node->is_mapping()
+          ? hydra::find_path(*handler_node, {"filename"})
+          : nullptr;
+  bool in_memory = filename_node != nullptr && filename_node->is_null();
+  std::string path =
+      in_memory ? "" : handler_filename(config, "recorder", ".flight");
+  const hydra::ConfigNode* records_node =
+      hydra::find_path(config, {"hydra", "job_logging", "handlers", "recorder",
+                                "records_per_thread"});
+  size_t records = records_node != nullptr && records_node->is_int() &&
+                           records_node->as_int() > 0
+                       ? static_cast<size_t>(records_node->as_int())
+                       : 256;
+  int level = parse_log_level(
+      config_string(config,
+                    {"hydra", "job_logging", "handlers", "recorder", "level"},
+                    "TRACE")
+          .c_str());
+
+  if (log_start_recorder(in_memory ? nullptr : path.c_str(), records, level,
+                         config_hash(config).c_str()) != 0) {
+    log_stop_recorder();
+  }
+}
+
+// Drains and stops the async consumer while the sinks it writes to are
+// swapped, then restarts it if the current settings ask for it.
+struct AsyncLoggingPause {
+  AsyncLoggingPause() { log_stop_async(); }
+  ~AsyncLoggingPause() {
+    if (async_enabled) {
+      log_start_async(async_queue_size, async_overflow);
+    }
+  }
+};
+
+// Named loggers. Handles are never freed: callers cache them and queued
+// async records keep pointing at their names.
+struct LoggerRegistry {
+  std::mutex mutex;
+  std::unordered_map<std::string, std::unique_ptr<hydra_logger_t>> loggers;
+  // hydra.job_logging.loggers.<name>.level from the last init_logging call.
+  std::unordered_map<std::string, int> configured;
+  int root_level = LOG_TRACE;
+};
+
+LoggerRegistry& logger_registry() {
+  static auto* registry = new LoggerRegistry();
+  return *registry;
+}
+
+// Level of the nearest configured dotted prefix of `name`, else the root.
+int resolve_logger_level(const LoggerRegistry& registry, std::string name) {
+  for (;;) {
+    auto it = registry.configured.find(name);
+    if (it != registry.configured.end()) {
+      return it->second;
     }
-    *error_message = copy;
+    size_t dot = name.rfind('.');
+    if (dot == std::string::npos) {
+      return registry.root_level;
+    }
+    name.resize(dot);
   }
 }
 
+void configure_loggers(const hydra::ConfigNode& config, int root_level) {
+  std::unordered_map<std::string, int> configured;
+  const hydra::ConfigNode* loggers_node =
+      hydra::find_path(config, {"hydra", "job_logging", "loggers"});
+  if (loggers_node != nullptr && loggers_node->is_mapping()) {
+    for (const auto& [name, logger] : loggers_node->as_mapping()) {
+      const hydra::ConfigNode* level_node = hydra::find_path(logger, {"level"});
+      if (level_node != nullptr && level_node->is_string()) {
+        configured[name] = parse_log_level(level_node->as_string().c_str());
+      }
+    }
+  }
+
+  LoggerRegistry& registry = logger_registry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  registry.configured = std::move(configured);
+  registry.root_level = root_level;
+  for (auto& [name, logger] : registry.loggers) {
+    __atomic_store_n(&logger->level, resolve_logger_level(registry, name),
+                     __ATOMIC_RELAXED);
+  }
+}
+
+using hydra::capi::fail;
+
 } // namespace
 
 // C++ API
 void hydra::init_logging(const ConfigNode& config) {
+  std::lock_guard<std::mutex> lock(sink_mutex);
+  AsyncLoggingPause pause;
+  configure_async_logging(config);
+
   std::string level_str = "INFO";
 
   try {
@@ -90,85 +340,108 @@ void hydra::init_logging(const ConfigNode& config) {
 
   int log_level = parse_log_level(level_str.c_str());
   log_set_level(log_level);
-
-  // Check if file handler is enabled in hydra.job_logging.root.handlers
-  bool enable_file_logging = false;
+  configure_loggers(config, log_level);
+
+  // Check which handlers are enabled in hydra.job_logging.root.handlers
+  bool enable_file_logging    = false;
+  bool enable_binary_logging  = false;
+  bool enable_recorder        = false;
+  bool enable_json_logging    = false;
+  bool enable_console_logging = true;
   try {
     const ConfigNode* handlers_node =
         find_path(config, {"hydra", "job_logging", "root", "handlers"});
     if (handlers_node && handlers_node->is_sequence()) {
-      const auto& handlers = handlers_node->as_sequence();
-      for (const auto& handler : handlers) {
-        if (handler.is_string() && handler.as_string() == "file") {
-          enable_file_logging = true;
-          break;
+      enable_console_logging = false;
+      for (const auto& handler : handlers_node->as_sequence()) {
+        if (!handler.is_string()) {
+          continue;
         }
+        const std::string& name = handler.as_string();
+        enable_file_logging |= name == "file";
+        enable_binary_logging |= name == "binary";
+        enable_recorder |= name == "recorder";
+        enable_json_logging |= name == "json";
+        enable_console_logging |= name == "console";
       }
     }
   } catch (...) {
     // If handlers config is missing or invalid, disable file logging
-    enable_file_logging = false;
+    enable_file_logging   = false;
+    enable_binary_logging = false;
+    enable_json_logging   = false;
+    enable_recorder       = false;
   }
+  log_set_quiet(!enable_console_logging);
 
   // Setup file logging if enabled
   if (enable_file_logging) {
     try {
-      // Read filename from config (hydra.job_logging.handlers.file.filename)
-      std::string log_path_str;
-      const ConfigNode* filename_node = find_path(
-          config, {"hydra", "job_logging", "handlers", "file", "filename"});
-
-      if (filename_node && filename_node->is_string()) {
-        log_path_str = filename_node->as_string();
-      } else {
-        // Default filename if not specified
-        const ConfigNode* run_dir_node =
-            find_path(config, {"hydra", "run", "dir"});
-        const ConfigNode* job_name_node =
-            find_path(config, {"hydra", "job", "name"});
-
-        std::string run_dir  = run_dir_node && run_dir_node->is_string()
-                                   ? run_dir_node->as_string()
-                                   : ".";
-        std::string job_name = job_name_node && job_name_node->is_string()
-                                   ? job_name_node->as_string()
-                                   : "app";
-
-        log_path_str = run_dir + "/" + job_name + ".log";
-      }
+      std::string log_path_str = handler_filename(config, "file", ".log");
 
       if (!log_path_str.empty() && log_path_str != "null") {
         fs::path log_path = log_path_str;
 
         // Skip if already logging to the same file
-        if (log_file_handle != nullptr &&
-            current_log_file_path == log_path.string()) {
-          // Already logging to this file, nothing to do
-          return;
-        }
+        bool same_file = log_file_handle != nullptr &&
+                         current_log_file_path == log_path.string();
 
         // Close existing log file if opening a different file
-        if (log_file_handle != nullptr) {
-          std::fclose(log_file_handle);
-          log_file_handle = nullptr;
-          current_log_file_path.clear();
+        if (!same_file) {
+          close_log_file(log_file_handle, current_log_file_path);
         }
 
         // Open log file for writing
-        log_file_handle = std::fopen(log_path.string().c_str(), "w");
-        if (log_file_handle != nullptr) {
+        if (!same_file) {
+          log_file_handle = std::fopen(log_path.string().c_str(), "w");
+        }
+        if (!same_file && log_file_handle != nullptr) {
           current_log_file_path = log_path.string();
-          // Add file callback only on first initialization
-          // (log.c doesn't provide callback removal, so we reuse the same
-          // callback)
-          if (log_file_callback_index < 0) {
-            log_file_callback_index = log_add_fp(log_file_handle, LOG_TRACE);
-          }
+          log_add_fp(log_file_handle, LOG_TRACE);
         }
+        configure_rotation(config, log_file_handle, current_log_file_path);
       }
     } catch (...) {
       // Silently ignore file logging errors - console logging still works
     }
+  } else {
+    close_log_file(log_file_handle, current_log_file_path);
+  }
+
+  std::string json_path =
+      enable_json_logging ? handler_filename(config, "json", ".jsonl") : "";
+  if (json_path.empty() || json_path == "null") {
+    close_log_file(json_file_handle, current_json_file_path);
+  } else if (json_path != current_json_file_path) {
+    close_log_file(json_file_handle, current_json_file_path);
+    json_file_handle = std::fopen(json_path.c_str(), "w");
+    if (json_file_handle != nullptr) {
+      current_json_file_path = json_path;
+      std::string job     = config_string(config, {"hydra", "job", "name"}, "");
+      std::string run_dir = config_string(config, {"hydra", "run", "dir"}, "");
+      const char* fields[] = {"job", job.c_str(), "run_dir", run_dir.c_str()};
+      log_add_json_fp(json_file_handle, LOG_TRACE, fields, 2);
+    }
+  }
+
+  if (enable_binary_logging) {
+    std::string blog_path = handler_filename(config, "binary", ".blog");
+    if (blog_path.empty() || blog_path == "null" ||
+        log_start_binary(blog_path.c_str(), log_level) != 0) {
+      log_stop_binary();
+    }
+  } else {
+    log_stop_binary();
+  }
+
+  configure_recorder(config, enable_recorder);
+
+  configure_flush(config, "console", stderr);
+  if (enable_file_logging) {
+    configure_flush(config, "file", log_file_handle);
+  }
+  if (json_file_handle != nullptr) {
+    configure_flush(config, "json", json_file_handle);
   }
 }
 
@@ -200,11 +473,38 @@ void hydra::setup_log_file(const std::string& run_dir) {
 }
 
 // C API
+extern "C" hydra_logger_t* hydra_logger_get(const char* name) {
+  if (name == nullptr) {
+    return nullptr;
+  }
+  LoggerRegistry& registry = logger_registry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  decltype(registry.loggers)::iterator it;
+  try {
+    bool inserted = false;
+    std::tie(it, inserted) = registry.loggers.try_emplace(name);
+    if (!inserted) {
+      return it->second.get();
+    }
+  } catch (const std::bad_alloc&) {
+    return nullptr;
+  }
+  auto* logger = new (std::nothrow) hydra_logger_t{};
+  if (logger == nullptr) {
+    registry.loggers.erase(it);
+    return nullptr;
+  }
+  logger->name  = it->first.c_str();
+  logger->level = resolve_logger_level(registry, it->first);
+  it->second.reset(logger);
+  return logger;
+}
+
 extern "C" hydra_status_t hydra_init_logging(const hydra_config_t* config,
                                              char** error_message) {
   if (config == nullptr) {
-    assign_error(error_message, "Config is null");
-    return HYDRA_STATUS_ERROR;
+    return fail(error_message, HYDRA_STATUS_INVALID_ARGUMENT,
+                "Config is null");
   }
 
   if (error_message != nullptr) {
@@ -213,19 +513,18 @@ extern "C" hydra_status_t hydra_init_logging(const hydra_config_t* config,
 
   try {
     // Use C++ API internally
-    hydra::init_logging(config->node);
+    hydra::init_logging(hydra::capi::root_of(config));
     return HYDRA_STATUS_OK;
   } catch (const std::exception& ex) {
-    assign_error(error_message, ex.what());
-    return HYDRA_STATUS_ERROR;
+    return fail(error_message, HYDRA_STATUS_ERROR, ex.what());
   }
 }
 
 extern "C" hydra_status_t hydra_log_config(const hydra_config_t* config,
                                            char** error_message) {
   if (config == nullptr) {
-    assign_error(error_message, "Config is null");
-    return HYDRA_STATUS_ERROR;
+    return fail(error_message, HYDRA_STATUS_INVALID_ARGUMENT,
+                "Config is null");
   }
 
   if (error_message != nullptr) {
@@ -234,7 +533,7 @@ extern "C" hydra_status_t hydra_log_config(const hydra_config_t* config,
 
   char* yaml_str = hydra_config_to_yaml_string(config, error_message);
   if (yaml_str == nullptr) {
-    return HYDRA_STATUS_ERROR;
+    return hydra_last_status();
   }
 
   log_debug("--- resolved config ---");
@@ -261,8 +560,8 @@ extern "C" hydra_status_t hydra_log_config(const hydra_config_t* config,
 extern "C" hydra_status_t hydra_logging_setup_file(const char* run_dir,
                                                    char** error_message) {
   if (run_dir == nullptr) {
-    assign_error(error_message, "Run directory is null");
-    return HYDRA_STATUS_ERROR;
+    return fail(error_message, HYDRA_STATUS_INVALID_ARGUMENT,
+                "Run directory is null");
   }
 
   if (error_message != nullptr) {
@@ -270,33 +569,27 @@ extern "C" hydra_status_t hydra_logging_setup_file(const char* run_dir,
   }
 
   try {
+    std::lock_guard<std::mutex> lock(sink_mutex);
+    AsyncLoggingPause pause;
     fs::path run_path = run_dir;
     fs::path log_path = run_path / "app.log"; // Default to app.log
 
     // Close existing log file if any
-    if (log_file_handle != nullptr) {
-      std::fclose(log_file_handle);
-      log_file_handle = nullptr;
-    }
+    close_log_file(log_file_handle, current_log_file_path);
 
     // Open log file for writing
     log_file_handle = std::fopen(log_path.string().c_str(), "w");
     if (log_file_handle == nullptr) {
-      assign_error(error_message,
-                   "Failed to open log file: " + log_path.string());
-      return HYDRA_STATUS_ERROR;
+      return fail(error_message, HYDRA_STATUS_IO_ERROR,
+                  "Failed to open log file: " + log_path.string());
     }
 
-    // Add file callback only on first initialization
-    // (log.c doesn't provide callback removal, so we reuse the same callback)
-    if (log_file_callback_index < 0) {
-      log_file_callback_index = log_add_fp(log_file_handle, LOG_TRACE);
-    }
+    current_log_file_path = log_path.string();
+    log_add_fp(log_file_handle, LOG_TRACE);
 
     return HYDRA_STATUS_OK;
   } catch (const std::exception& ex) {
-    assign_error(error_message,
-                 std::string("Failed to setup log file: ") + ex.what());
-    return HYDRA_STATUS_ERROR;
+    return fail(error_message, HYDRA_STATUS_IO_ERROR,
+                std::string("Failed to setup log file: ") + ex.what());
   }
 }
@@ -1,10 +1,14 @@
 #include "hydra/config_node.hpp"
 #include "hydra/interpolation.hpp"
+#include "hydra/log.h"
 #include "hydra/overrides.hpp"
+#include "hydra/query.hpp"
 #include "hydra/yaml_emitter.hpp"
 #include "hydra/yaml_loader.hpp"
 
 #include <filesystem>
+#include <cstdio>
+#include <cstring>
 #include <iostream>
 #include <optional>
 #include <sstream>
@@ -29,16 +33,23 @@ namespace {
 
 struct Options {
   std::vector<fs::path> config_files;
+  std::optional<std::string> select;
   bool show_help = false;
 };
 
 void print_usage() {
   std::cout << "hydra-cpp - lightweight configuration orchestration\n\n"
             << "Usage:\n"
-            << "  hydra-cpp [options] [overrides]\n\n"
+            << "  hydra-cpp [options] [overrides]\n"
+            << "  hydra-cpp logcat <file>  Render a .blog or .flight log as text\n\n"
             << "Options:\n"
             << "  -c, --config <file>       Load a configuration YAML file "
                "(can be repeated)\n"
+            << "  -s, --select <query>      Print only the nodes matching a "
+               "query such as\n"
+            << "                            `model.layers[*].units` (see "
+               "hydra/query.hpp);\n"
+            << "                            no run directory is written\n"
             << "  -h, --help                Show this help message\n\n"
             << "Overrides:\n"
             << "  Provide override expressions like `trainer.max_epochs=100` "
@@ -118,6 +129,26 @@ void write_hydra_artifacts(const ConfigNode& config,
             << "\n";
 }
 
+// Each match as YAML keyed by its path, so the output stays one document.
+void print_matches(const ConfigNode& config, const hydra::Query& query) {
+  query.for_each(config, [](const std::vector<std::string>& path,
+                            const ConfigNode& node) {
+    std::string rendered;
+    if (path.empty()) {
+      rendered = to_yaml_string(node);
+    } else {
+      ConfigNode entry = make_mapping();
+      entry.as_mapping().emplace(hydra::format_override_path(path), node);
+      rendered = to_yaml_string(entry);
+    }
+    std::cout << rendered;
+    if (!rendered.empty() && rendered.back() != '\n') {
+      std::cout << "\n";
+    }
+    return true;
+  });
+}
+
 void ensure_hydra_defaults(ConfigNode& config) {
   if (config.is_null()) {
     config = make_mapping();
@@ -169,6 +200,11 @@ Options parse_options(int argc, char** argv,
         throw std::runtime_error("Missing argument for --config");
       }
       options.config_files.emplace_back(argv[++i]);
+    } else if (arg == "-s" || arg == "--select") {
+      if (i + 1 >= argc) {
+        throw std::runtime_error("Missing argument for --select");
+      }
+      options.select = argv[++i];
     } else if (!arg.empty() && arg.front() == '-') {
       std::ostringstream oss;
       oss << "Unknown option '" << arg << "'";
@@ -185,9 +221,25 @@ bool file_exists(const fs::path& path) {
   return fs::exists(path, ec);
 }
 
+int logcat(int argc, char** argv) {
+  if (argc != 3) {
+    std::cerr << "Usage: hydra-cpp logcat <file.blog|file.flight>\n";
+    return 1;
+  }
+  if (log_decode_binary(argv[2], stdout) < 0 &&
+      log_decode_recorder(argv[2], stdout) < 0) {
+    std::cerr << "Error: cannot decode log " << argv[2] << "\n";
+    return 1;
+  }
+  return 0;
+}
+
 } // namespace
 
 int main(int argc, char** argv) {
+  if (argc > 1 && std::strcmp(argv[1], "logcat") == 0) {
+    return logcat(argc, argv);
+  }
   try {
     std::vector<std::string> override_expressions;
     Options options = parse_options(argc, argv, override_expressions);
@@ -197,6 +249,11 @@ int main(int argc, char** argv) {
       return 0;
     }
 
+    std::optional<hydra::Query> query;
+    if (options.select) {
+      query = hydra::Query::compile(*options.select);
+    }
+
     if (options.config_files.empty()) {
       if (file_exists("config.yaml")) {
         options.config_files.emplace_back("config.yaml");
@@ -240,6 +297,11 @@ int main(int argc, char** argv) {
       assign_path(config, {"hydra", "run", "dir"}, make_null(), false);
     }
 
+    if (query) {
+      print_matches(config, *query);
+      return 0;
+    }
+
     std::string rendered = to_yaml_string(config);
     std::cout << rendered;
     if (!rendered.empty() && rendered.back() != '\n') {
@@ -0,0 +1,397 @@
+#include "hydra/metrics.h"
+
+#include "c_api_internal.hpp"
+#include "hydra/config_node.hpp"
+#include "hydra/config_utils.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <exception>
+#include <filesystem>
+#include <mutex>
+#include <new>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+using hydra::capi::fail;
+
+constexpr char kMagic[8]       = {'H', 'Y', 'D', 'R', 'A', 'M', 'E', 'T'};
+constexpr uint32_t kVersion    = 1;
+constexpr size_t kDefaultBatch = 65536;
+constexpr auto kWritePeriod    = std::chrono::seconds(1);
+
+// One batch in column order, so the binary writer emits it as is.
+struct Batch {
+  std::vector<int64_t> steps;
+  std::vector<uint32_t> ids;
+  std::vector<double> values;
+
+  size_t size() const { return steps.size(); }
+
+  void reserve(size_t capacity) {
+    steps.reserve(capacity);
+    ids.reserve(capacity);
+    values.reserve(capacity);
+  }
+
+  void clear() {
+    steps.clear();
+    ids.clear();
+    values.clear();
+  }
+};
+
+} // namespace
+
+struct hydra_metrics {
+  fs::path run_dir;
+  hydra_metrics_format_t format = HYDRA_METRICS_BINARY;
+  size_t capacity               = kDefaultBatch;
+  FILE* out                     = nullptr;
+
+  // Producers fill `active`; a full one is swapped into `pending` for the
+  // writer thread, which owns `writing` while it is on disk.
+  std::mutex mutex;
+  std::condition_variable wake;
+  std::condition_variable space;
+  std::condition_variable flushed;
+  Batch active;
+  Batch pending;
+  bool pending_full        = false;
+  bool stop                = false;
+  uint64_t flush_requested = 0;
+  uint64_t flush_done      = 0;
+  std::string error;
+
+  std::mutex names_mutex;
+  std::unordered_map<std::string, int32_t> ids;
+  std::vector<std::string> names;
+
+  // Writer thread only.
+  Batch writing;
+  std::vector<std::string> written_names;
+  std::thread thread;
+};
+
+namespace {
+
+// Rewrites .hydra/metrics.yaml if names were interned since the last call.
+void write_names(hydra_metrics_t* metrics, bool force) {
+  {
+    std::lock_guard<std::mutex> lock(metrics->names_mutex);
+    if (!force && metrics->names.size() == metrics->written_names.size()) {
+      return;
+    }
+    metrics->written_names = metrics->names;
+  }
+  hydra::ConfigNode::seq_t names;
+  names.reserve(metrics->written_names.size());
+  for (const std::string& name : metrics->written_names) {
+    names.emplace_back(name);
+  }
+  hydra::ConfigNode::map_t registry;
+  registry["file"] = hydra::ConfigNode(
+      metrics->format == HYDRA_METRICS_CSV ? "metrics.csv" : "metrics.bin");
+  registry["names"] = hydra::ConfigNode(std::move(names));
+  hydra::utils::write_yaml(hydra::ConfigNode(std::move(registry)),
+                           metrics->run_dir / ".hydra" / "metrics.yaml");
+}
+
+bool write_batch(hydra_metrics_t* metrics, const Batch& batch) {
+  FILE* out    = metrics->out;
+  size_t count = batch.size();
+  if (metrics->format == HYDRA_METRICS_BINARY) {
+    uint32_t count_u32 = static_cast<uint32_t>(count);
+    return std::fwrite(&count_u32, sizeof(count_u32), 1, out) == 1 &&
+           std::fwrite(batch.steps.data(), sizeof(int64_t), count, out) ==
+               count &&
+           std::fwrite(batch.ids.data(), sizeof(uint32_t), count, out) ==
+               count &&
+           std::fwrite(batch.values.data(), sizeof(double), count, out) ==
+               count &&
+           std::fflush(out) == 0;
+  }
+  const std::vector<std::string>& names = metrics->written_names;
+  for (size_t i = 0; i < count; ++i) {
+    // Ids that were never interned are written as an empty name.
+    const char* name = batch.ids[i] < names.size()
+                           ? names[batch.ids[i]].c_str()
+                           : "";
+    if (std::fprintf(out, "%lld,%s,%.17g\n",
+                     static_cast<long long>(batch.steps[i]), name,
+                     batch.values[i]) < 0) {
+      return false;
+    }
+  }
+  return std::fflush(out) == 0;
+}
+
+void writer_loop(hydra_metrics_t* metrics) {
+  std::unique_lock<std::mutex> lock(metrics->mutex);
+  for (;;) {
+    metrics->wake.wait_for(lock, kWritePeriod, [&] {
+      return metrics->pending_full || metrics->stop ||
+             metrics->flush_requested != metrics->flush_done;
+    });
+    // Anything not yet full goes out on the timer, a flush or at close.
+    if (!metrics->pending_full && metrics->active.size() > 0) {
+      std::swap(metrics->active, metrics->pending);
+      metrics->pending_full = true;
+    }
+    uint64_t flush_target = metrics->flush_requested;
+    if (metrics->pending_full) {
+      std::swap(metrics->pending, metrics->writing);
+      metrics->pending_full = false;
+      metrics->space.notify_all();
+      lock.unlock();
+
+      bool ok = true;
+      try {
+        write_names(metrics, false);
+      } catch (const std::exception&) {
+        ok = false;
+      }
+      ok = write_batch(metrics, metrics->writing) && ok;
+      metrics->writing.clear();
+
+      lock.lock();
+      if (!ok && metrics->error.empty()) {
+        metrics->error = "Failed to write metrics in " +
+                         metrics->run_dir.string();
+      }
+      // A full batch may have arrived meanwhile; go round again before
+      // reporting the flush.
+      if (metrics->pending_full ||
+          (flush_target != metrics->flush_done &&
+           metrics->active.size() > 0)) {
+        continue;
+      }
+    }
+    metrics->flush_done = flush_target;
+    metrics->flushed.notify_all();
+    if (metrics->stop && metrics->active.size() == 0) {
+      return;
+    }
+  }
+}
+
+hydra_status_t report_error(hydra_metrics_t* metrics, char** error_message) {
+  std::lock_guard<std::mutex> lock(metrics->mutex);
+  if (!metrics->error.empty()) {
+    return fail(error_message, HYDRA_STATUS_IO_ERROR, metrics->error);
+  }
+  return HYDRA_STATUS_OK;
+}
+
+} // namespace
+
+extern "C" {
+
+hydra_metrics_t* hydra_metrics_open(const char* run_dir,
+                                    hydra_metrics_format_t format,
+                                    size_t batch_records,
+                                    char** error_message) {
+  if (run_dir == nullptr ||
+      (format != HYDRA_METRICS_BINARY && format != HYDRA_METRICS_CSV) ||
+      batch_records > UINT32_MAX) {
+    fail(error_message, HYDRA_STATUS_INVALID_ARGUMENT,
+         "Run directory is null or format/batch size is invalid");
+    return nullptr;
+  }
+  hydra_metrics_t* metrics = new (std::nothrow) hydra_metrics();
+  if (metrics == nullptr) {
+    fail(error_message, HYDRA_STATUS_OUT_OF_MEMORY,
+         "Failed to allocate metrics writer");
+    return nullptr;
+  }
+  metrics->run_dir  = run_dir;
+  metrics->format   = format;
+  metrics->capacity = batch_records != 0 ? batch_records : kDefaultBatch;
+
+  try {
+    fs::create_directories(metrics->run_dir / ".hydra");
+    metrics->active.reserve(metrics->capacity);
+    metrics->pending.reserve(metrics->capacity);
+    metrics->writing.reserve(metrics->capacity);
+    write_names(metrics, true);
+  } catch (const std::bad_alloc&) {
+    delete metrics;
+    fail(error_message, HYDRA_STATUS_OUT_OF_MEMORY,
+         "Failed to allocate metrics batches");
+    return nullptr;
+  } catch (const std::exception& ex) {
+    delete metrics;
+    fail(error_message, HYDRA_STATUS_IO_ERROR, ex.what());
+    return nullptr;
+  }
+
+  fs::path path = metrics->run_dir / (format == HYDRA_METRICS_CSV
+                                          ? "metrics.csv"
+                                          : "metrics.bin");
+  metrics->out  = std::fopen(path.string().c_str(), "wb");
+  if (metrics->out == nullptr) {
+    delete metrics;
+    fail(error_message, HYDRA_STATUS_IO_ERROR,
+         "Failed to open " + path.string());
+    return nullptr;
+  }
+  if (format == HYDRA_METRICS_BINARY) {
+    std::fwrite(kMagic, 1, sizeof(kMagic), metrics->out);
+    std::fwrite(&kVersion, sizeof(kVersion), 1, metrics->out);
+  } else {
+    std::fputs("step,name,value\n", metrics->out);
+  }
+
+  try {
+    metrics->thread = std::thread(writer_loop, metrics);
+  } catch (const std::exception& ex) {
+    std::fclose(metrics->out);
+    delete metrics;
+    fail(error_message, HYDRA_STATUS_ERROR, ex.what());
+    return nullptr;
+  }
+  return metrics;
+}
+
+hydra_metrics_t* hydra_metrics_open_config(const hydra_config_t* config,
+                                           char** error_message) {
+  if (config == nullptr) {
+    fail(error_message, HYDRA_STATUS_INVALID_ARGUMENT, "Config is null");
+    return nullptr;
+  }
+  std::string run_dir;
+  hydra_metrics_format_t format = HYDRA_METRICS_BINARY;
+  size_t batch                  = 0;
+  try {
+    // hydra.run.dir usually interpolates, e.g. ${now:...}.
+    hydra::capi::materialize(config);
+    hydra::capi::ensure_resolved(config);
+    const hydra::ConfigNode& root = hydra::capi::root_of(config);
+    const hydra::ConfigNode* run_dir_node =
+        hydra::find_path(root, {"hydra", "run", "dir"});
+    if (run_dir_node == nullptr || !run_dir_node->is_string()) {
+      fail(error_message, HYDRA_STATUS_NOT_FOUND,
+           "hydra.run.dir is missing or not a string");
+      return nullptr;
+    }
+    run_dir = run_dir_node->as_string();
+    const hydra::ConfigNode* format_node =
+        hydra::find_path(root, {"hydra", "metrics", "format"});
+    const hydra::ConfigNode* batch_node =
+        hydra::find_path(root, {"hydra", "metrics", "batch_records"});
+    if (format_node != nullptr && format_node->is_string() &&
+        format_node->as_string() == "csv") {
+      format = HYDRA_METRICS_CSV;
+    }
+    if (batch_node != nullptr && batch_node->is_int() &&
+        batch_node->as_int() > 0) {
+      batch = static_cast<size_t>(batch_node->as_int());
+    }
+  } catch (const std::bad_alloc&) {
+    fail(error_message, HYDRA_STATUS_OUT_OF_MEMORY, "Out of memory");
+    return nullptr;
+  } catch (const std::exception& ex) {
+    fail(error_message, HYDRA_STATUS_ERROR, ex.what());
+    return nullptr;
+  }
+  return hydra_metrics_open(run_dir.c_str(), format, batch, error_message);
+}
+
+int32_t hydra_metrics_intern(hydra_metrics_t* metrics, const char* name) {
+  if (metrics == nullptr || name == nullptr) {
+    fail(nullptr, HYDRA_STATUS_INVALID_ARGUMENT, "Metrics or name is null");
+    return -1;
+  }
+  try {
+    std::lock_guard<std::mutex> lock(metrics->names_mutex);
+    auto [it, inserted] = metrics->ids.try_emplace(
+        name, static_cast<int32_t>(metrics->names.size()));
+    if (inserted) {
+      metrics->names.emplace_back(name);
+    }
+    return it->second;
+  } catch (const std::bad_alloc&) {
+    fail(nullptr, HYDRA_STATUS_OUT_OF_MEMORY, "Failed to intern metric name");
+    return -1;
+  }
+}
+
+hydra_status_t hydra_metrics_write(hydra_metrics_t* metrics, int64_t step,
+                                   int32_t metric, double value) {
+  if (metrics == nullptr || metric < 0) {
+    return fail(nullptr, HYDRA_STATUS_INVALID_ARGUMENT,
+                "Metrics is null or metric id is invalid");
+  }
+  std::unique_lock<std::mutex> lock(metrics->mutex);
+  if (metrics->active.size() == metrics->capacity) {
+    metrics->space.wait(lock, [&] { return !metrics->pending_full; });
+    std::swap(metrics->active, metrics->pending);
+    metrics->pending_full = true;
+    metrics->wake.notify_one();
+  }
+  // Capacity is reserved up front, so these never allocate.
+  metrics->active.steps.push_back(step);
+  metrics->active.ids.push_back(static_cast<uint32_t>(metric));
+  metrics->active.values.push_back(value);
+  return HYDRA_STATUS_OK;
+}
+
+hydra_status_t hydra_metrics_log(hydra_metrics_t* metrics, int64_t step,
+                                 const char* name, double value) {
+  int32_t metric = hydra_metrics_intern(metrics, name);
+  if (metric < 0) {
+    return hydra_last_status();
+  }
+  return hydra_metrics_write(metrics, step, metric, value);
+}
+
+hydra_status_t hydra_metrics_flush(hydra_metrics_t* metrics,
+                                   char** error_message) {
+  if (metrics == nullptr) {
+    return fail(error_message, HYDRA_STATUS_INVALID_ARGUMENT,
+                "Metrics is null");
+  }
+  {
+    std::unique_lock<std::mutex> lock(metrics->mutex);
+    uint64_t target = ++metrics->flush_requested;
+    metrics->wake.notify_one();
+    metrics->flushed.wait(lock,
+                          [&] { return metrics->flush_done >= target; });
+  }
+  return report_error(metrics, error_message);
+}
+
+hydra_status_t hydra_metrics_close(hydra_metrics_t* metrics,
+                                   char** error_message) {
+  if (metrics == nullptr) {
+    return fail(error_message, HYDRA_STATUS_INVALID_ARGUMENT,
+                "Metrics is null");
+  }
+  {
+    std::lock_guard<std::mutex> lock(metrics->mutex);
+    metrics->stop = true;
+    metrics->wake.notify_one();
+  }
+  metrics->thread.join();
+  try {
+    write_names(metrics, false);
+  } catch (const std::exception& ex) {
+    metrics->error = ex.what();
+  }
+  if (std::fclose(metrics->out) != 0 && metrics->error.empty()) {
+    metrics->error = "Failed to close metrics in " + metrics->run_dir.string();
+  }
+  hydra_status_t status = report_error(metrics, error_message);
+  delete metrics;
+  return status;
+}
+
+} // extern "C"
@@ -63,6 +63,22 @@ std::vector<std::string> parse_override_path(const std::string& expression) {
   return split_path_expression(expression);
 }
 
+std::string format_override_path(const std::vector<std::string>& path) {
+  std::string rendered;
+  for (size_t i = 0; i < path.size(); ++i) {
+    if (i > 0) {
+      rendered.push_back('.');
+    }
+    for (char ch : path[i]) {
+      if (ch == '.' || ch == '\\') {
+        rendered.push_back('\\');
+      }
+      rendered.push_back(ch);
+    }
+  }
+  return rendered;
+}
+
 Override parse_override(const std::string& expression) {
   if (expression.empty()) {
     throw std::runtime_error("Empty override expression");
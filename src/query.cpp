@@ -0,0 +1,622 @@
+#include "hydra/query.hpp"
+
+#include "c_api_internal.hpp"
+#include "hydra/overrides.hpp"
+#include "hydra/query.h"
+#include "hydra/visit.hpp"
+
+#include <cctype>
+#include <charconv>
+#include <cstdint>
+#include <cstdlib>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+namespace hydra {
+
+struct Query::Step {
+  enum class Kind { Key, Wildcard, Descend, Index, Slice, Filter };
+  enum class Op { Exists, Eq, Ne, Lt, Le, Gt, Ge };
+
+  Kind kind = Kind::Key;
+  std::string key;   // Key
+  int64_t index = 0; // Index
+  // Slice
+  std::optional<int64_t> start;
+  std::optional<int64_t> stop;
+  int64_t stride = 1;
+  // Filter
+  std::vector<std::string> filter_path;
+  Op op = Op::Exists;
+  ConfigNode value;
+};
+
+struct Query::Compiled {
+  std::string expression;
+  std::vector<Step> steps;
+};
+
+namespace {
+
+using Step = Query::Step;
+
+class Parser {
+public:
+  explicit Parser(std::string_view text) : text_(text) {}
+
+  std::vector<Step> parse() {
+    std::vector<Step> steps;
+    if (text_.empty()) {
+      return steps;
+    }
+    while (true) {
+      parse_segment(steps);
+      if (at_end()) {
+        break;
+      }
+      expect('.');
+      if (at_end()) {
+        error("expected a segment after '.'");
+      }
+    }
+    return steps;
+  }
+
+private:
+  bool at_end() const { return pos_ >= text_.size(); }
+  char peek() const { return at_end() ? '\0' : text_[pos_]; }
+
+  [[noreturn]] void error(const std::string& message) const {
+    std::ostringstream oss;
+    oss << "Invalid query '" << text_ << "' at position " << pos_ << ": "
+        << message;
+    throw std::runtime_error(oss.str());
+  }
+
+  void expect(char ch) {
+    if (peek() != ch) {
+      error(std::string("expected '") + ch + "'");
+    }
+    ++pos_;
+  }
+
+  void parse_segment(std::vector<Step>& steps) {
+    if (peek() == '*') {
+      Step step;
+      ++pos_;
+      if (peek() == '*') {
+        ++pos_;
+        step.kind = Step::Kind::Descend;
+      } else {
+        step.kind = Step::Kind::Wildcard;
+      }
+      // `**.**` matches what `**` does, only repeatedly.
+      if (step.kind != Step::Kind::Descend || steps.empty() ||
+          steps.back().kind != Step::Kind::Descend) {
+        steps.push_back(std::move(step));
+      }
+    } else if (peek() != '[') {
+      Step step;
+      step.key = parse_name();
+      steps.push_back(std::move(step));
+    }
+    while (peek() == '[') {
+      steps.push_back(parse_bracket());
+    }
+    if (!at_end() && peek() != '.') {
+      error("expected '.', '[' or the end of the query");
+    }
+  }
+
+  std::string parse_name() {
+    std::string name;
+    while (!at_end() && peek() != '.' && peek() != '[') {
+      char ch = text_[pos_++];
+      if (ch == '\\') {
+        if (at_end()) {
+          error("dangling escape");
+        }
+        ch = text_[pos_++];
+      } else if (ch == ']' || ch == '*') {
+        --pos_;
+        error(std::string("unexpected '") + ch + "'");
+      }
+      name.push_back(ch);
+    }
+    if (name.empty()) {
+      error("expected a key");
+    }
+    return name;
+  }
+
+  std::string parse_quoted() {
+    char quote = text_[pos_++];
+    std::string value;
+    while (!at_end() && peek() != quote) {
+      char ch = text_[pos_++];
+      if (ch == '\\' && !at_end()) {
+        ch = text_[pos_++];
+      }
+      value.push_back(ch);
+    }
+    expect(quote);
+    return value;
+  }
+
+  std::optional<int64_t> parse_int() {
+    size_t begin = pos_;
+    if (peek() == '-' || peek() == '+') {
+      ++pos_;
+    }
+    while (std::isdigit(static_cast<unsigned char>(peek()))) {
+      ++pos_;
+    }
+    if (pos_ == begin) {
+      return std::nullopt;
+    }
+    int64_t value  = 0;
+    const char* first = text_.data() + begin + (text_[begin] == '+');
+    auto [end, ec] = std::from_chars(first, text_.data() + pos_, value);
+    if (ec != std::errc() || end != text_.data() + pos_) {
+      pos_ = begin;
+      error("expected an integer");
+    }
+    return value;
+  }
+
+  Step parse_bracket() {
+    expect('[');
+    Step step;
+    if (peek() == '*') {
+      ++pos_;
+      step.kind = Step::Kind::Wildcard;
+    } else if (peek() == '\'' || peek() == '"') {
+      step.key = parse_quoted();
+    } else if (peek() == '?') {
+      ++pos_;
+      parse_filter(step);
+    } else {
+      std::optional<int64_t> first = parse_int();
+      if (peek() == ':') {
+        step.kind  = Step::Kind::Slice;
+        step.start = first;
+        ++pos_;
+        step.stop = parse_int();
+        if (peek() == ':') {
+          ++pos_;
+          if (std::optional<int64_t> stride = parse_int()) {
+            step.stride = *stride;
+          }
+          if (step.stride == 0) {
+            error("slice step cannot be zero");
+          }
+        }
+      } else if (first) {
+        step.kind  = Step::Kind::Index;
+        step.index = *first;
+      } else {
+        error("expected an index, slice, '*', '?' or quoted key");
+      }
+    }
+    expect(']');
+    return step;
+  }
+
+  void skip_spaces() {
+    while (peek() == ' ') {
+      ++pos_;
+    }
+  }
+
+  void parse_filter(Step& step) {
+    step.kind = Step::Kind::Filter;
+    skip_spaces();
+    size_t begin = pos_;
+    while (!at_end() && peek() != ']' && peek() != ' ' &&
+           std::string_view("=!<>").find(peek()) == std::string_view::npos) {
+      pos_ += peek() == '\\' ? 2 : 1;
+    }
+    if (pos_ == begin || pos_ > text_.size()) {
+      error("expected a path in the filter");
+    }
+    try {
+      step.filter_path =
+          parse_override_path(std::string(text_.substr(begin, pos_ - begin)));
+    } catch (const std::runtime_error& ex) {
+      error(ex.what());
+    }
+    skip_spaces();
+    if (peek() == ']') {
+      return;
+    }
+
+    static constexpr std::pair<std::string_view, Step::Op> kOps[] = {
+        {"==", Step::Op::Eq}, {"!=", Step::Op::Ne}, {"<=", Step::Op::Le},
+        {">=", Step::Op::Ge}, {"<", Step::Op::Lt},  {">", Step::Op::Gt}};
+    bool found = false;
+    for (const auto& [token, op] : kOps) {
+      if (text_.substr(pos_, token.size()) == token) {
+        step.op = op;
+        pos_ += token.size();
+        found = true;
+        break;
+      }
+    }
+    if (!found) {
+      error("expected a comparison operator");
+    }
+    skip_spaces();
+    step.value = parse_literal();
+    skip_spaces();
+  }
+
+  ConfigNode parse_literal() {
+    if (peek() == '\'' || peek() == '"') {
+      return make_string(parse_quoted());
+    }
+    size_t begin = pos_;
+    while (!at_end() && peek() != ']' && peek() != ' ') {
+      ++pos_;
+    }
+    std::string token(text_.substr(begin, pos_ - begin));
+    if (token == "true" || token == "false") {
+      return make_bool(token == "true");
+    }
+    if (token == "null") {
+      return make_null();
+    }
+    int64_t integer = 0;
+    auto [end, ec]  = std::from_chars(token.data(),
+                                      token.data() + token.size(), integer);
+    if (!token.empty() && ec == std::errc() &&
+        end == token.data() + token.size()) {
+      return make_int(integer);
+    }
+    char* double_end = nullptr;
+    double real      = std::strtod(token.c_str(), &double_end);
+    if (!token.empty() && double_end == token.c_str() + token.size()) {
+      return make_double(real);
+    }
+    pos_ = begin;
+    error("expected a number, true, false, null or a quoted string");
+  }
+
+  std::string_view text_;
+  size_t pos_ = 0;
+};
+
+bool is_number(const ConfigNode& node) {
+  return node.is_int() || node.is_double();
+}
+
+double to_double(const ConfigNode& node) {
+  return node.is_int() ? static_cast<double>(node.as_int())
+                       : node.as_double();
+}
+
+// <0, 0 or >0 as `a` orders before, like or after `b`; nullopt when they do
+// not compare (different kinds, or containers).
+std::optional<int> compare(const ConfigNode& a, const ConfigNode& b) {
+  if (a.is_int() && b.is_int()) {
+    return a.as_int() < b.as_int() ? -1 : a.as_int() > b.as_int() ? 1 : 0;
+  }
+  if (is_number(a) && is_number(b)) {
+    double x = to_double(a);
+    double y = to_double(b);
+    return x < y ? -1 : x > y ? 1 : 0;
+  }
+  if (a.is_string() && b.is_string()) {
+    return a.as_string().compare(b.as_string());
+  }
+  if (a.is_bool() && b.is_bool()) {
+    return static_cast<int>(a.as_bool()) - static_cast<int>(b.as_bool());
+  }
+  if (a.is_null() && b.is_null()) {
+    return 0;
+  }
+  return std::nullopt;
+}
+
+bool matches(const Step& step, const ConfigNode& candidate) {
+  const ConfigNode* target = &candidate;
+  for (const std::string& component : step.filter_path) {
+    target = find_child(*target, component);
+    if (target == nullptr) {
+      return false;
+    }
+  }
+  if (step.op == Step::Op::Exists) {
+    return true;
+  }
+  std::optional<int> order = compare(*target, step.value);
+  if (!order) {
+    return step.op == Step::Op::Ne;
+  }
+  bool ordered = !step.value.is_bool() && !step.value.is_null();
+  switch (step.op) {
+  case Step::Op::Eq:
+    return *order == 0;
+  case Step::Op::Ne:
+    return *order != 0;
+  case Step::Op::Lt:
+    return ordered && *order < 0;
+  case Step::Op::Le:
+    return ordered && *order <= 0;
+  case Step::Op::Gt:
+    return ordered && *order > 0;
+  case Step::Op::Ge:
+    return ordered && *order >= 0;
+  case Step::Op::Exists:
+    break;
+  }
+  return true;
+}
+
+// Depth-first evaluation; `path` is the one buffer every match sees.
+class Evaluator {
+public:
+  Evaluator(const std::vector<Step>& steps, const Query::Visitor& visit)
+      : steps_(steps), visit_(visit) {}
+
+  bool walk(const ConfigNode& node, size_t index) {
+    if (index == steps_.size()) {
+      return visit_(path_, node);
+    }
+    const Step& step = steps_[index];
+    switch (step.kind) {
+    case Step::Kind::Key:
+      if (const ConfigNode* child = find_child(node, step.key)) {
+        return descend(*child, step.key, index + 1);
+      }
+      return true;
+    case Step::Kind::Wildcard:
+      return each_child(node, [&](const std::string& name,
+                                  const ConfigNode& child) {
+        return descend(child, name, index + 1);
+      });
+    case Step::Kind::Descend:
+      if (!walk(node, index + 1)) {
+        return false;
+      }
+      return each_child(node, [&](const std::string& name,
+                                  const ConfigNode& child) {
+        return descend(child, name, index);
+      });
+    case Step::Kind::Filter:
+      return each_child(node, [&](const std::string& name,
+                                  const ConfigNode& child) {
+        return !matches(step, child) || descend(child, name, index + 1);
+      });
+    case Step::Kind::Index:
+      if (node.is_sequence()) {
+        const auto& items = node.as_sequence();
+        int64_t size      = static_cast<int64_t>(items.size());
+        int64_t position  = step.index < 0 ? size + step.index : step.index;
+        if (position >= 0 && position < size) {
+          return descend(items[position], std::to_string(position),
+                         index + 1);
+        }
+      }
+      return true;
+    case Step::Kind::Slice:
+      return slice(node, step, index);
+    }
+    return true;
+  }
+
+private:
+  bool descend(const ConfigNode& child, const std::string& name,
+               size_t index) {
+    path_.push_back(name);
+    bool keep_going = walk(child, index);
+    path_.pop_back();
+    return keep_going;
+  }
+
+  template <typename Fn> bool each_child(const ConfigNode& node, Fn&& fn) {
+    overloaded children{
+        [&](const ConfigNode::map_t& mapping) {
+          for (const auto& [key, child] : mapping) {
+            if (!fn(key, child)) {
+              return false;
+            }
+          }
+          return true;
+        },
+        [&](const ConfigNode::seq_t& items) {
+          for (size_t i = 0; i < items.size(); ++i) {
+            if (!fn(std::to_string(i), items[i])) {
+              return false;
+            }
+          }
+          return true;
+        },
+        [](const auto&) { return true; },
+    };
+    return visit(node, children);
+  }
+
+  bool slice(const ConfigNode& node, const Step& step, size_t index) {
+    if (!node.is_sequence()) {
+      return true;
+    }
+    const auto& items = node.as_sequence();
+    int64_t size      = static_cast<int64_t>(items.size());
+    // Python's rules: negative bounds count from the end, then clamp.
+    auto bound = [&](std::optional<int64_t> value, int64_t fallback,
+                     int64_t low, int64_t high) {
+      if (!value) {
+        return fallback;
+      }
+      int64_t position = *value < 0 ? *value + size : *value;
+      return std::min(std::max(position, low), high);
+    };
+    if (step.stride > 0) {
+      int64_t begin = bound(step.start, 0, 0, size);
+      int64_t end   = bound(step.stop, size, 0, size);
+      for (int64_t i = begin; i < end; i += step.stride) {
+        if (!descend(items[i], std::to_string(i), index + 1)) {
+          return false;
+        }
+      }
+    } else {
+      int64_t begin = bound(step.start, size - 1, -1, size - 1);
+      int64_t end   = bound(step.stop, -1, -1, size - 1);
+      for (int64_t i = begin; i > end; i += step.stride) {
+        if (!descend(items[i], std::to_string(i), index + 1)) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  const std::vector<Step>& steps_;
+  const Query::Visitor& visit_;
+  std::vector<std::string> path_;
+};
+
+} // namespace
+
+Query::Query(std::shared_ptr<const Compiled> compiled)
+    : compiled_(std::move(compiled)) {}
+
+Query Query::compile(std::string_view expression) {
+  auto compiled        = std::make_shared<Compiled>();
+  compiled->expression = std::string(expression);
+  compiled->steps      = Parser(compiled->expression).parse();
+  return Query(std::move(compiled));
+}
+
+const std::string& Query::expression() const {
+  return compiled_->expression;
+}
+
+bool Query::for_each(const ConfigNode& root, const Visitor& visit) const {
+  return Evaluator(compiled_->steps, visit).walk(root, 0);
+}
+
+std::vector<const ConfigNode*> Query::select(const ConfigNode& root) const {
+  std::vector<const ConfigNode*> matches;
+  for_each(root, [&](const std::vector<std::string>&, const ConfigNode& node) {
+    matches.push_back(&node);
+    return true;
+  });
+  return matches;
+}
+
+std::vector<const ConfigNode*> select(const ConfigNode& root,
+                                      std::string_view expression) {
+  return Query::compile(expression).select(root);
+}
+
+} // namespace hydra
+
+struct hydra_query {
+  hydra::Query query;
+};
+
+namespace {
+
+using hydra::capi::fail;
+
+size_t run(const hydra::Query& query, const hydra_config_t* config,
+           hydra_query_visitor_t visit, void* user_data) {
+  // Queries may reach anywhere, so a profiled config is completed first;
+  // predicates compare resolved values.
+  hydra::capi::materialize(config);
+  hydra::capi::ensure_resolved(config);
+  size_t count = 0;
+  query.for_each(
+      hydra::capi::root_of(config),
+      [&](const std::vector<std::string>& path, const hydra::ConfigNode& node) {
+        ++count;
+        if (visit == nullptr) {
+          return true;
+        }
+        std::string rendered = hydra::format_override_path(path);
+        hydra_value_t value  = hydra::capi::describe(node);
+        return visit(rendered.c_str(), &value, user_data) != 0;
+      });
+  return count;
+}
+
+} // namespace
+
+extern "C" {
+
+hydra_query_t* hydra_query_compile(const char* expression,
+                                   char** error_message) {
+  if (expression == nullptr) {
+    fail(error_message, HYDRA_STATUS_INVALID_ARGUMENT, "Query is null");
+    return nullptr;
+  }
+  try {
+    return new hydra_query{hydra::Query::compile(expression)};
+  } catch (const std::bad_alloc&) {
+    fail(error_message, HYDRA_STATUS_OUT_OF_MEMORY, "Out of memory");
+  } catch (const std::exception& ex) {
+    fail(error_message, HYDRA_STATUS_PARSE_ERROR, ex.what());
+  }
+  return nullptr;
+}
+
+hydra_status_t hydra_query_run(const hydra_query_t* query,
+                               const hydra_config_t* config,
+                               hydra_query_visitor_t visit, void* user_data,
+                               size_t* match_count, char** error_message) {
+  if (query == nullptr || config == nullptr) {
+    return fail(error_message, HYDRA_STATUS_INVALID_ARGUMENT,
+                "Query or config is null");
+  }
+  try {
+    size_t count = run(query->query, config, visit, user_data);
+    if (match_count != nullptr) {
+      *match_count = count;
+    }
+    return HYDRA_STATUS_OK;
+  } catch (const std::bad_alloc&) {
+    return fail(error_message, HYDRA_STATUS_OUT_OF_MEMORY, "Out of memory");
+  } catch (const std::exception& ex) {
+    return fail(error_message, HYDRA_STATUS_ERROR, ex.what());
+  }
+}
+
+hydra_status_t hydra_config_select(const hydra_config_t* config,
+                                   const char* expression,
+                                   hydra_query_visitor_t visit,
+                                   void* user_data, size_t* match_count,
+                                   char** error_message) {
+  if (config == nullptr || expression == nullptr) {
+    return fail(error_message, HYDRA_STATUS_INVALID_ARGUMENT,
+                "Config or query is null");
+  }
+  // Only the expression is a parse error; resolving the config is not.
+  std::optional<hydra::Query> query;
+  try {
+    query.emplace(hydra::Query::compile(expression));
+  } catch (const std::bad_alloc&) {
+    return fail(error_message, HYDRA_STATUS_OUT_OF_MEMORY, "Out of memory");
+  } catch (const std::exception& ex) {
+    return fail(error_message, HYDRA_STATUS_PARSE_ERROR, ex.what());
+  }
+  try {
+    size_t count = run(*query, config, visit, user_data);
+    if (match_count != nullptr) {
+      *match_count = count;
+    }
+    return HYDRA_STATUS_OK;
+  } catch (const std::bad_alloc&) {
+    return fail(error_message, HYDRA_STATUS_OUT_OF_MEMORY, "Out of memory");
+  } catch (const std::exception& ex) {
+    return fail(error_message, HYDRA_STATUS_ERROR, ex.what());
+  }
+}
+
+void hydra_query_destroy(hydra_query_t* query) {
+  delete query;
+}
+
+} // extern "C"
@@ -0,0 +1,448 @@
+#include "hydra/schema.hpp"
+
+#include "c_api_internal.hpp"
+#include "hydra/schema.h"
+#include "hydra/yaml_loader.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <new>
+#include <optional>
+#include <regex>
+#include <sstream>
+#include <string_view>
+#include <utility>
+#include <variant>
+
+namespace hydra {
+
+enum class RuleType { Any, Null, Bool, Int, Double, String, Sequence, Mapping };
+
+struct Schema::Rule {
+  RuleType type = RuleType::Any;
+  bool required = true;
+  bool nullable = false;
+  std::optional<double> min;
+  std::optional<double> max;
+  std::vector<ConfigNode> allowed;
+  std::string allowed_text;
+  std::optional<std::regex> pattern;
+  std::string pattern_text;
+  std::unique_ptr<Rule> items;
+  // Sorted by key, like ConfigNode::map_t.
+  std::vector<std::pair<std::string, Rule>> fields;
+};
+
+namespace {
+
+using Rule = Schema::Rule;
+
+struct TypeName {
+  const char* name;
+  RuleType type;
+};
+
+constexpr TypeName kTypeNames[] = {
+    {"any", RuleType::Any},           {"null", RuleType::Null},
+    {"bool", RuleType::Bool},         {"int", RuleType::Int},
+    {"double", RuleType::Double},     {"string", RuleType::String},
+    {"sequence", RuleType::Sequence}, {"mapping", RuleType::Mapping}};
+
+const char* type_name(RuleType type) {
+  for (const TypeName& entry : kTypeNames) {
+    if (entry.type == type) {
+      return entry.name;
+    }
+  }
+  return "any";
+}
+
+std::string join(const std::string& parent, const std::string& key) {
+  return parent.empty() ? key : parent + "." + key;
+}
+
+std::string describe(const ConfigNode& node) {
+  if (node.is_string()) {
+    return "'" + node.as_string() + "'";
+  }
+  if (node.is_bool()) {
+    return node.as_bool() ? "true" : "false";
+  }
+  if (node.is_int()) {
+    return std::to_string(node.as_int());
+  }
+  if (node.is_double()) {
+    std::ostringstream out;
+    out << node.as_double();
+    return out.str();
+  }
+  return node.type_name();
+}
+
+bool is_rule(const ConfigNode& spec) {
+  if (!spec.is_mapping()) {
+    return false;
+  }
+  auto it = spec.as_mapping().find("type");
+  return it != spec.as_mapping().end() && it->second.is_string();
+}
+
+double number(const ConfigNode& node, const std::string& where) {
+  if (node.is_int()) {
+    return static_cast<double>(node.as_int());
+  }
+  if (node.is_double()) {
+    return node.as_double();
+  }
+  throw std::runtime_error("Schema " + where + " must be a number");
+}
+
+bool flag(const ConfigNode& node, const std::string& where) {
+  if (!node.is_bool()) {
+    throw std::runtime_error("Schema " + where + " must be a boolean");
+  }
+  return node.as_bool();
+}
+
+void compile_fields(const ConfigNode& spec, const std::string& path,
+                    Rule& rule);
+
+Rule compile_rule(const ConfigNode& spec, const std::string& path) {
+  Rule rule;
+  if (!is_rule(spec)) {
+    // A bare mapping of field rules.
+    rule.type = RuleType::Mapping;
+    compile_fields(spec, path, rule);
+    return rule;
+  }
+
+  for (const auto& [key, value] : spec.as_mapping()) {
+    std::string where = "'" + join(path, key) + "'";
+    if (key == "type") {
+      const std::string& name = value.as_string();
+      auto it = std::find_if(std::begin(kTypeNames), std::end(kTypeNames),
+                             [&](const TypeName& entry) {
+                               return name == entry.name;
+                             });
+      if (it == std::end(kTypeNames)) {
+        throw std::runtime_error("Schema " + where + " names unknown type '" +
+                                 name + "'");
+      }
+      rule.type = it->type;
+    } else if (key == "required") {
+      rule.required = flag(value, where);
+    } else if (key == "nullable") {
+      rule.nullable = flag(value, where);
+    } else if (key == "min") {
+      rule.min = number(value, where);
+    } else if (key == "max") {
+      rule.max = number(value, where);
+    } else if (key == "enum") {
+      if (!value.is_sequence() || value.as_sequence().empty()) {
+        throw std::runtime_error("Schema " + where +
+                                 " must be a non-empty sequence");
+      }
+      for (const ConfigNode& item : value.as_sequence()) {
+        if (item.is_sequence() || item.is_mapping()) {
+          throw std::runtime_error("Schema " + where +
+                                   " may only list scalars");
+        }
+        rule.allowed.push_back(item);
+        rule.allowed_text += rule.allowed_text.empty() ? "" : ", ";
+        rule.allowed_text += describe(item);
+      }
+    } else if (key == "pattern") {
+      if (!value.is_string()) {
+        throw std::runtime_error("Schema " + where + " must be a string");
+      }
+      try {
+        rule.pattern.emplace(value.as_string(),
+                             std::regex::ECMAScript | std::regex::optimize);
+      } catch (const std::regex_error& ex) {
+        throw std::runtime_error("Schema " + where + " is not a valid regex: " +
+                                 ex.what());
+      }
+      rule.pattern_text = value.as_string();
+    } else if (key == "items") {
+      rule.items = std::make_unique<Rule>(
+          compile_rule(value, join(path, "items")));
+    } else if (key == "fields") {
+      compile_fields(value, join(path, "fields"), rule);
+    } else {
+      throw std::runtime_error("Schema " + where + " is not a rule key");
+    }
+  }
+
+  const char* misplaced = nullptr;
+  if ((rule.min || rule.max) && rule.type != RuleType::Int &&
+      rule.type != RuleType::Double) {
+    misplaced = "min/max need type int or double";
+  } else if (rule.pattern && rule.type != RuleType::String) {
+    misplaced = "pattern needs type string";
+  } else if (rule.items && rule.type != RuleType::Sequence) {
+    misplaced = "items needs type sequence";
+  } else if (!rule.fields.empty() && rule.type != RuleType::Mapping) {
+    misplaced = "fields needs type mapping";
+  }
+  if (misplaced != nullptr) {
+    throw std::runtime_error("Schema '" + path + "': " + misplaced);
+  }
+  return rule;
+}
+
+void compile_fields(const ConfigNode& spec, const std::string& path,
+                    Rule& rule) {
+  if (!spec.is_mapping()) {
+    throw std::runtime_error("Schema '" + path + "' must be a mapping");
+  }
+  // map_t iterates in key order, so the fields come out sorted.
+  for (const auto& [key, value] : spec.as_mapping()) {
+    rule.fields.emplace_back(key, compile_rule(value, join(path, key)));
+  }
+}
+
+// Path of the node being checked; only turned into a string for errors.
+class Path {
+public:
+  void push(std::string_view key) { parts_.emplace_back(key); }
+  void push(size_t index) { parts_.emplace_back(index); }
+  void pop() { parts_.pop_back(); }
+
+  std::string str() const {
+    std::string out;
+    for (const auto& part : parts_) {
+      if (!out.empty()) {
+        out += '.';
+      }
+      if (const auto* key = std::get_if<std::string_view>(&part)) {
+        out += *key;
+      } else {
+        out += std::to_string(std::get<size_t>(part));
+      }
+    }
+    return out.empty() ? "<root>" : out;
+  }
+
+private:
+  std::vector<std::variant<std::string_view, size_t>> parts_;
+};
+
+bool same_scalar(const ConfigNode& a, const ConfigNode& b) {
+  if ((a.is_int() || a.is_double()) && (b.is_int() || b.is_double())) {
+    double x = a.is_int() ? static_cast<double>(a.as_int()) : a.as_double();
+    double y = b.is_int() ? static_cast<double>(b.as_int()) : b.as_double();
+    return x == y;
+  }
+  if (a.is_string() && b.is_string()) {
+    return a.as_string() == b.as_string();
+  }
+  if (a.is_bool() && b.is_bool()) {
+    return a.as_bool() == b.as_bool();
+  }
+  return a.is_null() && b.is_null();
+}
+
+bool has_type(const ConfigNode& node, RuleType type) {
+  switch (type) {
+  case RuleType::Any:
+    return true;
+  case RuleType::Null:
+    return node.is_null();
+  case RuleType::Bool:
+    return node.is_bool();
+  case RuleType::Int:
+    return node.is_int();
+  case RuleType::Double:
+    return node.is_double() || node.is_int();
+  case RuleType::String:
+    return node.is_string();
+  case RuleType::Sequence:
+    return node.is_sequence();
+  case RuleType::Mapping:
+    return node.is_mapping();
+  }
+  return false;
+}
+
+void check_node(const ConfigNode& node, const Rule& rule, Path& path,
+                std::vector<std::string>& errors) {
+  if (node.is_null() && rule.nullable) {
+    return;
+  }
+  if (!has_type(node, rule.type)) {
+    errors.push_back(path.str() + ": expected " + type_name(rule.type) +
+                     ", got " + node.type_name());
+    return;
+  }
+
+  if (rule.min || rule.max) {
+    double value = node.is_int() ? static_cast<double>(node.as_int())
+                                 : node.as_double();
+    if (rule.min && value < *rule.min) {
+      errors.push_back(path.str() + ": " + describe(node) +
+                       " is below the minimum " +
+                       describe(ConfigNode(*rule.min)));
+    } else if (rule.max && value > *rule.max) {
+      errors.push_back(path.str() + ": " + describe(node) +
+                       " is above the maximum " +
+                       describe(ConfigNode(*rule.max)));
+    }
+  }
+  if (!rule.allowed.empty() &&
+      std::none_of(rule.allowed.begin(), rule.allowed.end(),
+                   [&](const ConfigNode& allowed) {
+                     return same_scalar(node, allowed);
+                   })) {
+    errors.push_back(path.str() + ": " + describe(node) + " is not one of " +
+                     rule.allowed_text);
+  }
+  if (rule.pattern && !std::regex_match(node.as_string(), *rule.pattern)) {
+    errors.push_back(path.str() + ": " + describe(node) +
+                     " does not match '" + rule.pattern_text + "'");
+  }
+
+  if (rule.items) {
+    const ConfigNode::seq_t& items = node.as_sequence();
+    for (size_t i = 0; i < items.size(); ++i) {
+      path.push(i);
+      check_node(items[i], *rule.items, path, errors);
+      path.pop();
+    }
+  }
+
+  if (!rule.fields.empty()) {
+    // Both sides are sorted by key: walk them together.
+    const ConfigNode::map_t& mapping = node.as_mapping();
+    auto entry                       = mapping.begin();
+    for (const auto& [key, field] : rule.fields) {
+      while (entry != mapping.end() && entry->first < key) {
+        ++entry;
+      }
+      path.push(key);
+      if (entry != mapping.end() && entry->first == key) {
+        check_node(entry->second, field, path, errors);
+      } else if (field.required) {
+        errors.push_back(path.str() + ": missing");
+      }
+      path.pop();
+    }
+  }
+}
+
+std::string format_errors(const std::vector<std::string>& errors) {
+  std::string message = "Configuration does not match the schema:";
+  for (const std::string& error : errors) {
+    message += "\n  " + error;
+  }
+  return message;
+}
+
+} // namespace
+
+SchemaError::SchemaError(std::vector<std::string> errors)
+    : std::runtime_error(format_errors(errors)), errors_(std::move(errors)) {
+}
+
+Schema::Schema(std::shared_ptr<const Rule> root) : root_(std::move(root)) {
+}
+
+Schema Schema::compile(const ConfigNode& spec) {
+  if (!spec.is_mapping()) {
+    throw std::runtime_error("Schema must be a mapping");
+  }
+  return Schema(std::make_shared<const Rule>(compile_rule(spec, "")));
+}
+
+Schema Schema::load_file(const std::filesystem::path& path) {
+  return compile(load_yaml_file(path));
+}
+
+std::vector<std::string> Schema::validate(const ConfigNode& config) const {
+  std::vector<std::string> errors;
+  Path path;
+  check_node(config, *root_, path, errors);
+  return errors;
+}
+
+void Schema::check(const ConfigNode& config) const {
+  std::vector<std::string> errors = validate(config);
+  if (!errors.empty()) {
+    throw SchemaError(std::move(errors));
+  }
+}
+
+} // namespace hydra
+
+struct hydra_schema {
+  hydra::Schema schema;
+};
+
+extern "C" {
+
+using hydra::capi::fail;
+
+hydra_schema_t* hydra_schema_compile_file(const char* path,
+                                          char** error_message) {
+  if (path == nullptr) {
+    fail(error_message, HYDRA_STATUS_INVALID_ARGUMENT, "Path is null");
+    return nullptr;
+  }
+  try {
+    return new hydra_schema{hydra::Schema::load_file(path)};
+  } catch (const std::bad_alloc&) {
+    fail(error_message, HYDRA_STATUS_OUT_OF_MEMORY, "Out of memory");
+  } catch (const std::exception& ex) {
+    fail(error_message, HYDRA_STATUS_PARSE_ERROR, ex.what());
+  }
+  return nullptr;
+}
+
+hydra_schema_t* hydra_schema_compile_string(const char* yaml,
+                                            char** error_message) {
+  if (yaml == nullptr) {
+    fail(error_message, HYDRA_STATUS_INVALID_ARGUMENT, "Schema is null");
+    return nullptr;
+  }
+  try {
+    return new hydra_schema{
+        hydra::Schema::compile(hydra::load_yaml_string(yaml, "<schema>"))};
+  } catch (const std::bad_alloc&) {
+    fail(error_message, HYDRA_STATUS_OUT_OF_MEMORY, "Out of memory");
+  } catch (const std::exception& ex) {
+    fail(error_message, HYDRA_STATUS_PARSE_ERROR, ex.what());
+  }
+  return nullptr;
+}
+
+hydra_status_t hydra_schema_validate(const hydra_schema_t* schema,
+                                     const hydra_config_t* config,
+                                     char** error_message) {
+  if (schema == nullptr || config == nullptr) {
+    return fail(error_message, HYDRA_STATUS_INVALID_ARGUMENT,
+                "Schema or config is null");
+  }
+  try {
+    // Validation covers the whole tree, as written after interpolation, so
+    // a profiled config is completed and resolved first.
+    hydra::capi::materialize(config);
+    hydra::capi::ensure_resolved(config);
+    std::vector<std::string> errors =
+        schema->schema.validate(hydra::capi::root_of(config));
+    if (!errors.empty()) {
+      return fail(error_message, HYDRA_STATUS_ERROR,
+                  hydra::SchemaError(std::move(errors)).what());
+    }
+    return HYDRA_STATUS_OK;
+  } catch (const std::bad_alloc&) {
+    return fail(error_message, HYDRA_STATUS_OUT_OF_MEMORY, "Out of memory");
+  } catch (const std::exception& ex) {
+    return fail(error_message, HYDRA_STATUS_ERROR, ex.what());
+  }
+}
+
+void hydra_schema_destroy(hydra_schema_t* schema) {
+  delete schema;
+}
+
+} // extern "C"
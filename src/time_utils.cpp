@@ -7,9 +7,9 @@
 
 namespace hydra {
 
-std::string format_now(const std::string& format) {
-  auto now      = std::chrono::system_clock::now();
-  std::time_t t = std::chrono::system_clock::to_time_t(now);
+std::string format_time(const std::string& format,
+                        std::chrono::system_clock::time_point time) {
+  std::time_t t = std::chrono::system_clock::to_time_t(time);
   std::tm tm{};
 #ifdef _WIN32
   localtime_s(&tm, &t);
@@ -30,4 +30,8 @@ std::string format_now(const std::string& format) {
   }
 }
 
+std::string format_now(const std::string& format) {
+  return format_time(format, std::chrono::system_clock::now());
+}
+
 } // namespace hydra
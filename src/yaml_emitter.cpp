@@ -1,5 +1,7 @@
 #include "hydra/yaml_emitter.hpp"
 
+#include "hydra/visit.hpp"
+
 #include <cstdlib>
 #include <fstream>
 #include <iomanip>
@@ -82,30 +84,27 @@ std::string escape_string(const std::string& value) {
   return oss.str();
 }
 
-std::string format_scalar(const ConfigNode& node) {
-  if (node.is_null()) {
-    return "null";
-  }
-  if (node.is_bool()) {
-    return node.as_bool() ? "true" : "false";
-  }
-  if (node.is_int()) {
-    return std::to_string(node.as_int());
-  }
-  if (node.is_double()) {
+// Flow text of a scalar value.
+struct ScalarText {
+  std::string operator()(std::nullptr_t) const { return "null"; }
+  std::string operator()(bool value) const { return value ? "true" : "false"; }
+  std::string operator()(int64_t value) const { return std::to_string(value); }
+  std::string operator()(double value) const {
     std::ostringstream oss;
-    oss << std::setprecision(15) << node.as_double();
+    oss << std::setprecision(15) << value;
     return oss.str();
   }
-  if (node.is_string()) {
-    const std::string& value = node.as_string();
+  std::string operator()(const std::string& value) const {
     if (needs_quoting(value, false)) {
       return escape_string(value);
     }
     return value;
   }
-  throw std::runtime_error("Cannot format non-scalar node directly");
-}
+  template <typename Container>
+  std::string operator()(const Container&) const {
+    throw std::runtime_error("Cannot format non-scalar node directly");
+  }
+};
 
 std::string format_key(const std::string& key) {
   if (needs_quoting(key, true)) {
@@ -114,7 +113,35 @@ std::string format_key(const std::string& key) {
   return key;
 }
 
-void emit_node(const ConfigNode& node, std::ostream& out, int indent);
+void emit_sequence(const ConfigNode::seq_t& seq, std::ostream& out,
+                   int indent);
+void emit_mapping(const ConfigNode::map_t& map, std::ostream& out, int indent);
+
+// What follows "-" or "key:": a scalar on the same line, a block collection
+// on the lines below, or an empty collection in flow style.
+void emit_entry_value(const ConfigNode& value, std::ostream& out,
+                      int indent) {
+  overloaded emit{
+      [&](const ConfigNode::map_t& map) {
+        if (map.empty()) {
+          out << " {}\n";
+        } else {
+          out << "\n";
+          emit_mapping(map, out, indent + 2);
+        }
+      },
+      [&](const ConfigNode::seq_t& seq) {
+        if (seq.empty()) {
+          out << " []\n";
+        } else {
+          out << "\n";
+          emit_sequence(seq, out, indent + 2);
+        }
+      },
+      [&](const auto& scalar) { out << " " << ScalarText{}(scalar) << "\n"; },
+  };
+  visit(value, emit);
+}
 
 void emit_sequence(const ConfigNode::seq_t& seq, std::ostream& out,
                    int indent) {
@@ -124,23 +151,7 @@ void emit_sequence(const ConfigNode::seq_t& seq, std::ostream& out,
   }
   for (const auto& item : seq) {
     out << indentation(indent) << "-";
-    if (item.is_mapping()) {
-      if (item.as_mapping().empty()) {
-        out << " {}\n";
-      } else {
-        out << "\n";
-        emit_node(item, out, indent + 2);
-      }
-    } else if (item.is_sequence()) {
-      if (item.as_sequence().empty()) {
-        out << " []\n";
-      } else {
-        out << "\n";
-        emit_node(item, out, indent + 2);
-      }
-    } else {
-      out << " " << format_scalar(item) << "\n";
-    }
+    emit_entry_value(item, out, indent);
   }
 }
 
@@ -150,37 +161,20 @@ void emit_mapping(const ConfigNode::map_t& map, std::ostream& out, int indent) {
     return;
   }
   for (const auto& entry : map) {
-    const auto& key   = entry.first;
-    const auto& value = entry.second;
-    out << indentation(indent) << format_key(key) << ":";
-    if (value.is_mapping()) {
-      if (value.as_mapping().empty()) {
-        out << " {}\n";
-      } else {
-        out << "\n";
-        emit_node(value, out, indent + 2);
-      }
-    } else if (value.is_sequence()) {
-      if (value.as_sequence().empty()) {
-        out << " []\n";
-      } else {
-        out << "\n";
-        emit_node(value, out, indent + 2);
-      }
-    } else {
-      out << " " << format_scalar(value) << "\n";
-    }
+    out << indentation(indent) << format_key(entry.first) << ":";
+    emit_entry_value(entry.second, out, indent);
   }
 }
 
 void emit_node(const ConfigNode& node, std::ostream& out, int indent) {
-  if (node.is_mapping()) {
-    emit_mapping(node.as_mapping(), out, indent);
-  } else if (node.is_sequence()) {
-    emit_sequence(node.as_sequence(), out, indent);
-  } else {
-    out << indentation(indent) << format_scalar(node) << "\n";
-  }
+  overloaded emit{
+      [&](const ConfigNode::map_t& map) { emit_mapping(map, out, indent); },
+      [&](const ConfigNode::seq_t& seq) { emit_sequence(seq, out, indent); },
+      [&](const auto& scalar) {
+        out << indentation(indent) << ScalarText{}(scalar) << "\n";
+      },
+  };
+  visit(node, emit);
 }
 
 } // namespace
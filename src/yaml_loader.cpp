@@ -9,6 +9,8 @@
 #include <cstring>
 #include <filesystem>
 #include <fstream>
+#include <memory>
+#include <mutex>
 #include <optional>
 #include <set>
 #include <sstream>
@@ -401,8 +403,14 @@ DefaultSpec parse_default_entry(const ConfigNode& entry,
 }
 
 ConfigNode load_with_includes(const std::filesystem::path& path,
-                              std::set<std::filesystem::path>& stack) {
+                              std::set<std::filesystem::path>& stack,
+                              YamlFileCache* cache) {
   std::filesystem::path normalized = normalize_path(path);
+  if (cache != nullptr) {
+    if (auto cached = cache->find(normalized)) {
+      return *cached;
+    }
+  }
   if (!stack.insert(normalized).second) {
     std::ostringstream oss;
     oss << "Detected recursive configuration include involving '" << normalized
@@ -439,7 +447,7 @@ ConfigNode load_with_includes(const std::filesystem::path& path,
               << "' not found";
           throw std::runtime_error(oss.str());
         }
-        ConfigNode child = load_with_includes(spec.include_path, stack);
+        ConfigNode child = load_with_includes(spec.include_path, stack, cache);
         if (spec.target_path) {
           ConfigNode* existing = find_path(result, *spec.target_path);
           if (existing == nullptr) {
@@ -460,14 +468,42 @@ ConfigNode load_with_includes(const std::filesystem::path& path,
   }
 
   stack.erase(normalized);
+  if (cache != nullptr) {
+    cache->insert(normalized, result);
+  }
   return result;
 }
 
 } // namespace
 
+std::shared_ptr<const ConfigNode>
+YamlFileCache::find(const std::filesystem::path& normalized) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = entries_.find(normalized);
+  return it == entries_.end() ? nullptr : it->second;
+}
+
+void YamlFileCache::insert(const std::filesystem::path& normalized,
+                           ConfigNode node) {
+  auto entry = std::make_shared<const ConfigNode>(std::move(node));
+  std::lock_guard<std::mutex> lock(mutex_);
+  entries_.emplace(normalized, std::move(entry));
+}
+
+void YamlFileCache::clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  entries_.clear();
+}
+
 ConfigNode load_yaml_file(const std::filesystem::path& path) {
   std::set<std::filesystem::path> stack;
-  return load_with_includes(path, stack);
+  return load_with_includes(path, stack, nullptr);
+}
+
+ConfigNode load_yaml_file(const std::filesystem::path& path,
+                          YamlFileCache& cache) {
+  std::set<std::filesystem::path> stack;
+  return load_with_includes(path, stack, &cache);
 }
 
 ConfigNode load_yaml_string(const std::string& content,
@@ -1,4 +1,7 @@
 #include "hydra/c_api.h"
+#include "hydra/metrics.h"
+#include "hydra/query.h"
+#include "hydra/schema.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -42,6 +45,419 @@ static void fail_with(const char* step, const char* message) {
   exit(1);
 }
 
+static void check_status_codes(hydra_config_t* cfg) {
+  int64_t value = 0;
+  hydra_status_t status =
+      hydra_config_get_int(cfg, "trainer.missing", &value, NULL);
+  if (status != HYDRA_STATUS_NOT_FOUND) {
+    fail_with("status codes", "missing key should report NOT_FOUND");
+  }
+  if (hydra_last_status() != HYDRA_STATUS_NOT_FOUND ||
+      strstr(hydra_last_error(), "does not exist") == NULL) {
+    fail_with("status codes", "last error not recorded for missing key");
+  }
+
+  status = hydra_config_get_int(cfg, "visualization.layouts.primary", &value,
+                                NULL);
+  if (status != HYDRA_STATUS_TYPE_MISMATCH) {
+    fail_with("status codes", "string read as int should be TYPE_MISMATCH");
+  }
+
+  if (hydra_config_merge_string(cfg, "key: [unterminated", "bad", NULL) !=
+      HYDRA_STATUS_PARSE_ERROR) {
+    fail_with("status codes", "malformed YAML should be PARSE_ERROR");
+  }
+
+  if (hydra_config_get_int_or_default(cfg, "trainer.batch_size", 1) != 16 ||
+      hydra_config_get_int_or_default(cfg, "trainer.missing", 7) != 7 ||
+      hydra_config_get_bool_or_default(cfg, "trainer.missing", 1) != 1 ||
+      hydra_config_get_double_or_default(cfg, "params.alpha", 0.0) != 10.0) {
+    fail_with("or_default", "unexpected numeric value");
+  }
+  const char* layout = hydra_config_get_string_or_default(
+      cfg, "visualization.layouts.primary", "none");
+  const char* fallback =
+      hydra_config_get_string_or_default(cfg, "visualization.missing", "none");
+  if (strcmp(layout, "grid") != 0 || strcmp(fallback, "none") != 0) {
+    fail_with("or_default", "unexpected string value");
+  }
+}
+
+static void check_resolution_after_writes(void) {
+  hydra_config_t* cfg = hydra_config_create();
+  if (hydra_config_merge_string(cfg, "a: 1\nb: '${a}'\n", "resolve", NULL) !=
+          HYDRA_STATUS_OK ||
+      hydra_config_has(cfg, "missing") ||
+      strcmp(hydra_config_get_string_or_default(cfg, "b", ""), "1") != 0) {
+    fail_with("resolution", "first read not resolved");
+  }
+  // Writes after a read must be resolved again by the next read.
+  if (hydra_config_merge_string(cfg, "c: 'x${a}'\n", "resolve", NULL) !=
+          HYDRA_STATUS_OK ||
+      hydra_config_apply_override(cfg, "a=2", NULL) != HYDRA_STATUS_OK ||
+      strcmp(hydra_config_get_string_or_default(cfg, "c", ""), "x2") != 0) {
+    fail_with("resolution", "write after read not resolved");
+  }
+  hydra_config_destroy(cfg);
+}
+
+static void check_bulk_access(hydra_config_t* cfg) {
+  const char* paths[] = {"trainer.tags.1", "trainer.batch_size",
+                         "trainer.missing", "trainer.tags",
+                         "visualization.layouts.primary"};
+  hydra_value_t values[5];
+  if (hydra_config_get_many(cfg, paths, 5, values, NULL) != HYDRA_STATUS_OK) {
+    fail_with("get_many", hydra_last_error());
+  }
+  if (values[0].type != HYDRA_VALUE_STRING ||
+      strcmp(values[0].as.string.data, "sweep") != 0 ||
+      values[1].type != HYDRA_VALUE_INT || values[1].as.integer != 16 ||
+      values[2].type != HYDRA_VALUE_MISSING ||
+      values[3].type != HYDRA_VALUE_SEQUENCE || values[3].as.size != 2 ||
+      values[4].type != HYDRA_VALUE_STRING ||
+      values[4].as.string.length != 4) {
+    fail_with("get_many", "unexpected values");
+  }
+
+  hydra_config_flat_t flat;
+  if (hydra_config_flatten(cfg, &flat, NULL) != HYDRA_STATUS_OK) {
+    fail_with("flatten", hydra_last_error());
+  }
+  int found = 0;
+  for (size_t i = 0; i < flat.count; ++i) {
+    if (strcmp(flat.paths[i], "plots.1.title") == 0) {
+      found = flat.values[i].type == HYDRA_VALUE_STRING &&
+              strcmp(flat.values[i].as.string.data, "Loss") == 0;
+    }
+    if (flat.values[i].type == HYDRA_VALUE_MAPPING) {
+      fail_with("flatten", "non-empty mapping reported as a leaf");
+    }
+  }
+  hydra_config_flat_free(&flat);
+  if (!found) {
+    fail_with("flatten", "plots.1.title missing");
+  }
+}
+
+static size_t live_allocations = 0;
+
+static void* counting_allocate(size_t size, void* user_data) {
+  (void)user_data;
+  ++live_allocations;
+  return malloc(size);
+}
+
+static void counting_deallocate(void* ptr, void* user_data) {
+  (void)user_data;
+  --live_allocations;
+  free(ptr);
+}
+
+static void check_allocators(hydra_config_t* cfg) {
+  hydra_allocator_t allocator = {counting_allocate, counting_deallocate, NULL};
+  hydra_set_allocator(&allocator);
+
+  char* value = NULL;
+  if (hydra_config_get_string(cfg, "visualization.layouts.primary", &value,
+                              NULL) != HYDRA_STATUS_OK ||
+      live_allocations != 1) {
+    fail_with("allocator", "string not allocated through hooks");
+  }
+  hydra_string_free(value);
+
+  hydra_arena_t* arena = hydra_arena_create(0);
+  char** tags          = NULL;
+  size_t count         = 0;
+  if (hydra_config_get_string_arena(cfg, "visualization.layouts.primary",
+                                    arena, &value, NULL) != HYDRA_STATUS_OK ||
+      strcmp(value, "grid") != 0 ||
+      hydra_config_clone_string_list_arena(cfg, "trainer.tags", arena, &tags,
+                                           &count, NULL) != HYDRA_STATUS_OK ||
+      count != 2 || strcmp(tags[1], "sweep") != 0) {
+    fail_with("arena", "unexpected arena results");
+  }
+  if (hydra_arena_bytes_used(arena) == 0) {
+    fail_with("arena", "no bytes accounted");
+  }
+  hydra_arena_reset(arena);
+  if (hydra_arena_bytes_used(arena) != 0) {
+    fail_with("arena", "reset did not release");
+  }
+  hydra_arena_destroy(arena);
+
+  hydra_set_allocator(NULL);
+  if (live_allocations != 0) {
+    fail_with("allocator", "allocations leaked");
+  }
+}
+
+static char* read_text_file(const char* path, size_t* size_out) {
+  FILE* in = fopen(path, "rb");
+  if (in == NULL) {
+    return NULL;
+  }
+  char* data = malloc(1 << 16);
+  if (data == NULL) {
+    fclose(in);
+    return NULL;
+  }
+  size_t size = fread(data, 1, (1 << 16) - 1, in);
+  fclose(in);
+  data[size] = '\0';
+  if (size_out != NULL) {
+    *size_out = size;
+  }
+  return data;
+}
+
+static void check_metrics(hydra_config_t* cfg) {
+  char* error = NULL;
+  if (hydra_metrics_open_config(cfg, NULL) != NULL ||
+      hydra_last_status() != HYDRA_STATUS_NOT_FOUND) {
+    fail_with("metrics", "config without hydra.run.dir accepted");
+  }
+
+  // A batch of 4 makes the 10 records below cross the writer thread twice.
+  hydra_metrics_t* metrics =
+      hydra_metrics_open("outputs/c_api_metrics", HYDRA_METRICS_BINARY, 4,
+                         &error);
+  if (metrics == NULL) {
+    fail_with("metrics open", error ? error : "(unknown)");
+  }
+  int32_t loss = hydra_metrics_intern(metrics, "loss");
+  if (loss != 0 || hydra_metrics_intern(metrics, "loss") != 0) {
+    fail_with("metrics", "interned ids not dense or not stable");
+  }
+  for (int64_t step = 0; step < 5; ++step) {
+    assert_status("metrics write",
+                  hydra_metrics_write(metrics, step, loss, 1.0 / (step + 1)),
+                  NULL);
+    assert_status("metrics log",
+                  hydra_metrics_log(metrics, step, "acc", 0.1 * step), NULL);
+  }
+  assert_status("metrics flush", hydra_metrics_flush(metrics, &error), error);
+  assert_status("metrics close", hydra_metrics_close(metrics, &error), error);
+
+  size_t size = 0;
+  char* data  = read_text_file("outputs/c_api_metrics/metrics.bin", &size);
+  if (data == NULL || size < 12 || memcmp(data, "HYDRAMET", 8) != 0) {
+    fail_with("metrics", "binary header missing");
+  }
+  size_t offset = 12, records = 0;
+  double loss_sum = 0.0;
+  while (offset + 4 <= size) {
+    uint32_t count = 0;
+    memcpy(&count, data + offset, 4);
+    const char* steps  = data + offset + 4;
+    const char* ids    = steps + count * 8;
+    const char* values = ids + count * 4;
+    for (uint32_t i = 0; i < count; ++i) {
+      uint32_t id  = 0;
+      double value = 0.0;
+      memcpy(&id, ids + i * 4, 4);
+      memcpy(&value, values + i * 8, 8);
+      if (id == 0) {
+        loss_sum += value;
+      }
+    }
+    records += count;
+    offset += 4 + (size_t)count * 20;
+  }
+  free(data);
+  if (records != 10 || offset != size ||
+      loss_sum < 2.28 || loss_sum > 2.29) {
+    fail_with("metrics", "binary columns do not hold the records");
+  }
+  data = read_text_file("outputs/c_api_metrics/.hydra/metrics.yaml", NULL);
+  if (data == NULL || strstr(data, "- loss\n") == NULL ||
+      strstr(data, "- acc") == NULL || strstr(data, "metrics.bin") == NULL) {
+    fail_with("metrics", "names not registered in .hydra/metrics.yaml");
+  }
+  free(data);
+
+  metrics = hydra_metrics_open("outputs/c_api_metrics", HYDRA_METRICS_CSV, 0,
+                               &error);
+  if (metrics == NULL) {
+    fail_with("metrics open csv", error ? error : "(unknown)");
+  }
+  assert_status("metrics log csv",
+                hydra_metrics_log(metrics, 2, "acc", 0.5), NULL);
+  assert_status("metrics close csv", hydra_metrics_close(metrics, &error),
+                error);
+  data = read_text_file("outputs/c_api_metrics/metrics.csv", NULL);
+  if (data == NULL || strcmp(data, "step,name,value\n2,acc,0.5\n") != 0) {
+    fail_with("metrics", "unexpected CSV output");
+  }
+  free(data);
+
+  // The run directory comes from the resolved config, not the raw string.
+  hydra_config_t* run_cfg = hydra_config_create();
+  assert_status("metrics config",
+                hydra_config_merge_string(
+                    run_cfg,
+                    "base: outputs/c_api_metrics_cfg\n"
+                    "hydra: {run: {dir: '${base}/run'}}\n",
+                    "metrics", &error),
+                error);
+  metrics = hydra_metrics_open_config(run_cfg, &error);
+  if (metrics == NULL) {
+    fail_with("metrics open config", error ? error : "(unknown)");
+  }
+  assert_status("metrics close config", hydra_metrics_close(metrics, &error),
+                error);
+  if (!directory_exists("outputs/c_api_metrics_cfg/run") ||
+      directory_exists("${base}")) {
+    fail_with("metrics", "hydra.run.dir used without resolution");
+  }
+  hydra_config_destroy(run_cfg);
+}
+
+static void check_schema(hydra_config_t* cfg) {
+  char* error = NULL;
+  if (hydra_schema_compile_string("trainer: {batch_size: {type: integer}}",
+                                  &error) != NULL ||
+      error == NULL || strstr(error, "unknown type 'integer'") == NULL) {
+    fail_with("schema", "unknown type accepted");
+  }
+  hydra_string_free(error);
+  error = NULL;
+
+  hydra_schema_t* schema = hydra_schema_compile_string(
+      "trainer:\n"
+      "  batch_size: {type: int, min: 1, max: 1024}\n"
+      "  tags: {type: sequence, items: {type: string, pattern: '[a-z]+'}}\n"
+      "plots: {type: sequence, items: {field: {type: string}}}\n",
+      &error);
+  if (schema == NULL) {
+    fail_with("schema compile", error ? error : "(unknown)");
+  }
+  assert_status("schema validate", hydra_schema_validate(schema, cfg, &error),
+                error);
+
+  hydra_schema_t* strict = hydra_schema_compile_string(
+      "trainer:\n"
+      "  batch_size: {type: int, min: 32}\n"
+      "  max_epochs: {type: string}\n"
+      "  optimizer: {type: string, enum: [adam, sgd]}\n",
+      &error);
+  if (strict == NULL) {
+    fail_with("schema compile", error ? error : "(unknown)");
+  }
+  if (hydra_schema_validate(strict, cfg, &error) != HYDRA_STATUS_ERROR ||
+      error == NULL ||
+      strstr(error, "trainer.batch_size: 16 is below the minimum 32") ==
+          NULL ||
+      strstr(error, "trainer.max_epochs: expected string, got int") == NULL ||
+      strstr(error, "trainer.optimizer: missing") == NULL) {
+    fail_with("schema", "violations not reported together");
+  }
+  hydra_string_free(error);
+  error = NULL;
+
+  // Values are checked after interpolation, even on a config nothing has
+  // read yet.
+  hydra_config_t* fresh = hydra_config_create();
+  hydra_schema_t* typed =
+      hydra_schema_compile_string("b: {type: string, pattern: '[0-9]+'}\n",
+                                  &error);
+  if (typed == NULL ||
+      hydra_config_merge_string(fresh, "a: 3\nb: '${a}'\n", "fresh", NULL) !=
+          HYDRA_STATUS_OK) {
+    fail_with("schema compile", error ? error : "(unknown)");
+  }
+  assert_status("schema validate unresolved",
+                hydra_schema_validate(typed, fresh, &error), error);
+  hydra_schema_destroy(typed);
+  hydra_config_destroy(fresh);
+
+  hydra_schema_destroy(strict);
+  hydra_schema_destroy(schema);
+}
+
+struct query_matches {
+  char paths[4][64];
+  int64_t values[4];
+  size_t count;
+};
+
+static int collect_match(const char* path, const hydra_value_t* value,
+                         void* user_data) {
+  struct query_matches* matches = (struct query_matches*)user_data;
+  snprintf(matches->paths[matches->count], sizeof(matches->paths[0]), "%s",
+           path);
+  matches->values[matches->count] =
+      value->type == HYDRA_VALUE_INT ? value->as.integer : -1;
+  return ++matches->count < 4;
+}
+
+static void check_query(hydra_config_t* cfg) {
+  char* error = NULL;
+  if (hydra_query_compile("params[1:", &error) != NULL || error == NULL ||
+      strstr(error, "at position") == NULL) {
+    fail_with("query", "malformed query accepted");
+  }
+  hydra_string_free(error);
+  error = NULL;
+
+  hydra_query_t* query = hydra_query_compile("params.*", &error);
+  if (query == NULL) {
+    fail_with("query compile", error ? error : "(unknown)");
+  }
+  struct query_matches matches = {0};
+  size_t count                 = 0;
+  assert_status("query run",
+                hydra_query_run(query, cfg, collect_match, &matches, &count,
+                                &error),
+                error);
+  if (count != 2 || strcmp(matches.paths[0], "params.alpha") != 0 ||
+      matches.values[0] != 10 || strcmp(matches.paths[1], "params.beta") != 0 ||
+      matches.values[1] != 20) {
+    fail_with("query", "unexpected matches");
+  }
+  hydra_query_destroy(query);
+
+  count = 0;
+  assert_status("select",
+                hydra_config_select(cfg, "plots[?field=='loss'].title", NULL,
+                                    NULL, &count, &error),
+                error);
+  if (count != 1) {
+    fail_with("select", "predicate mismatch");
+  }
+
+  // Predicates see interpolated values on a config nothing has read yet.
+  hydra_config_t* fresh = hydra_config_create();
+  if (hydra_config_merge_string(fresh, "a: x\nitems: [{name: '${a}'}]\n",
+                                "fresh", NULL) != HYDRA_STATUS_OK) {
+    fail_with("select", hydra_last_error());
+  }
+  count = 0;
+  assert_status("select unresolved",
+                hydra_config_select(fresh, "items[?name=='x']", NULL, NULL,
+                                    &count, &error),
+                error);
+  if (count != 1) {
+    fail_with("select", "interpolation not resolved");
+  }
+  hydra_config_destroy(fresh);
+
+  // A config that fails to resolve is not a malformed expression.
+  hydra_config_t* broken = hydra_config_create();
+  if (hydra_config_merge_string(broken, "a: '${missing}'\n", "broken",
+                                NULL) != HYDRA_STATUS_OK) {
+    fail_with("select", hydra_last_error());
+  }
+  if (hydra_config_select(broken, "a", NULL, NULL, NULL, NULL) !=
+      HYDRA_STATUS_ERROR) {
+    fail_with("select", "resolution failure reported as a parse error");
+  }
+  if (hydra_config_select(broken, "a[", NULL, NULL, NULL, NULL) !=
+      HYDRA_STATUS_PARSE_ERROR) {
+    fail_with("select", "malformed expression not a parse error");
+  }
+  hydra_config_destroy(broken);
+}
+
 int main(void) {
   hydra_config_t* cfg = hydra_config_create();
   if (cfg == NULL) {
@@ -224,6 +640,31 @@ int main(void) {
   hydra_string_free(layout_value);
   hydra_config_destroy(layouts);
 
+  // Borrowed views share storage with their parent
+  hydra_config_t* layouts_view = NULL;
+  assert_status("view",
+                hydra_config_view(cfg, "visualization.layouts", &layouts_view,
+                                  &error),
+                error);
+  const char* via_view   = hydra_config_get_string_or_default(
+      layouts_view, "primary", NULL);
+  const char* via_parent = hydra_config_get_string_or_default(
+      cfg, "visualization.layouts.primary", NULL);
+  if (via_view == NULL || via_view != via_parent) {
+    fprintf(stderr, "[FAIL] view does not borrow parent storage\n");
+    hydra_config_destroy(layouts_view);
+    hydra_config_destroy(cfg);
+    return 1;
+  }
+  if (hydra_config_apply_override(layouts_view, "primary=list", NULL) !=
+      HYDRA_STATUS_INVALID_ARGUMENT) {
+    fprintf(stderr, "[FAIL] view accepted an override\n");
+    hydra_config_destroy(layouts_view);
+    hydra_config_destroy(cfg);
+    return 1;
+  }
+  hydra_config_destroy(layouts_view);
+
   // Clone helpers
   char* cloned = NULL;
   assert_status("clone string",
@@ -267,6 +708,14 @@ int main(void) {
     fail_with("ensure directory", "expected directory missing");
   }
 
+  check_status_codes(cfg);
+  check_resolution_after_writes();
+  check_bulk_access(cfg);
+  check_allocators(cfg);
+  check_metrics(cfg);
+  check_schema(cfg);
+  check_query(cfg);
+
   hydra_config_destroy(cfg);
   printf("[OK] hydra c api tests passed\n");
   return 0;
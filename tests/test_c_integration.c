@@ -2,6 +2,10 @@
 #include "hydra/c_api_utils.h"
 #include "hydra/logging.h"
 
+#include "app_config.h"
+#include "app_config_embedded.h"
+
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -228,6 +232,213 @@ static void test_config_expect_helpers(void) {
   hydra_config_destroy(cfg);
 }
 
+static void test_codegen_generated_loader(void) {
+  const char* config_path = "../../tests/configs/integration/simple.yaml";
+  if (!file_exists(config_path)) {
+    return;
+  }
+
+  char* err           = NULL;
+  const char* argv[]  = {"test_program", "trainer.batch_size=64", NULL};
+  hydra_config_t* cfg = hydra_initialize(2, (char**)argv, config_path, &err);
+
+  ASSERT_TRUE(cfg != NULL);
+  if (err != NULL) {
+    hydra_string_free(err);
+    err = NULL;
+  }
+
+  app_config_t app;
+  hydra_status_t status = app_config_load(cfg, &app, &err);
+  ASSERT_TRUE(status == HYDRA_STATUS_OK);
+  ASSERT_EQ_INT(app.trainer.batch_size, 64);
+  ASSERT_EQ_INT(app.model.depth, 50);
+  ASSERT_EQ_STR(app.model.name, "resnet");
+  ASSERT_TRUE(app.trainer.learning_rate > 0.0009 &&
+              app.trainer.learning_rate < 0.0011);
+  ASSERT_EQ_INT(app.hydra.job_logging.root.handlers_count, 2);
+  ASSERT_EQ_STR(app.hydra.job_logging.root.handlers[1], "file");
+  app_config_release(&app);
+
+  status = hydra_config_apply_override(cfg, "model.depth=deep", &err);
+  ASSERT_TRUE(status == HYDRA_STATUS_OK);
+  status = app_config_load(cfg, &app, &err);
+  ASSERT_TRUE(status == HYDRA_STATUS_TYPE_MISMATCH);
+  ASSERT_TRUE(err != NULL);
+  hydra_string_free(err);
+
+  hydra_config_destroy(cfg);
+}
+
+static void test_hydra_initialize_embedded(void) {
+  char* err           = NULL;
+  const char* argv[]  = {"test_program", "model.depth=18", NULL};
+  hydra_config_t* cfg = hydra_initialize_embedded(
+      2, (char**)argv, app_config_embedded, app_config_embedded_size, &err);
+
+  ASSERT_TRUE(cfg != NULL);
+
+  // Build-time override, then the runtime one on top.
+  ASSERT_EQ_INT(hydra_config_expect_int(cfg, "trainer.batch_size"), 48);
+  ASSERT_EQ_INT(hydra_config_expect_int(cfg, "model.depth"), 18);
+
+  // The job name and interpolations follow the running program.
+  char* log_file = hydra_config_expect_string(
+      cfg, "hydra.job_logging.handlers.file.filename");
+  ASSERT_TRUE(strstr(log_file, "${") == NULL);
+  ASSERT_TRUE(strstr(log_file, "/test_program.log") != NULL);
+  hydra_string_free(log_file);
+  hydra_config_destroy(cfg);
+
+  cfg = hydra_initialize_embedded(1, (char**)argv, app_config_embedded,
+                                  app_config_embedded_size / 2, &err);
+  ASSERT_TRUE(cfg == NULL);
+  ASSERT_TRUE(err != NULL);
+  hydra_string_free(err);
+}
+
+static int count_root_keys(hydra_config_t* cfg) {
+  hydra_config_iter_t* iter = NULL;
+  int count                 = 0;
+  if (hydra_config_map_iter(cfg, "", &iter, NULL) != HYDRA_STATUS_OK) {
+    return -1;
+  }
+  while (hydra_config_iter_next(iter, NULL, NULL, NULL, NULL) == 1) {
+    count++;
+  }
+  hydra_config_iter_destroy(iter);
+  return count;
+}
+
+static void test_access_profile_loading(void) {
+  const char* config_path  = "../../tests/configs/integration/simple.yaml";
+  const char* profile_path = "test_access_profile";
+  if (!file_exists(config_path)) {
+    return;
+  }
+  FILE* profile = fopen(profile_path, "w");
+  ASSERT_TRUE(profile != NULL);
+  fputs("model.name\n", profile);
+  fclose(profile);
+
+  char* err          = NULL;
+  const char* argv[] = {"test_program",
+                        "+hydra.access_profile.load=test_access_profile", NULL};
+  hydra_config_t* cfg = hydra_initialize(2, (char**)argv, config_path, &err);
+  ASSERT_TRUE(cfg != NULL);
+
+  // Only `hydra` and the profiled subtree were composed...
+  ASSERT_EQ_INT(count_root_keys(cfg), 2);
+  char* name = hydra_config_expect_string(cfg, "model.name");
+  ASSERT_EQ_STR(name, "resnet");
+  hydra_string_free(name);
+
+  // ...and the first lookup outside the profile loads the rest.
+  ASSERT_EQ_INT(hydra_config_expect_int(cfg, "trainer.batch_size"), 32);
+  ASSERT_EQ_INT(count_root_keys(cfg), 5);
+  hydra_config_destroy(cfg);
+
+  // The async loader projects the same way and completes on a miss.
+  hydra_init_t* init =
+      hydra_initialize_async(2, (char**)argv, config_path, NULL, NULL, &err);
+  ASSERT_TRUE(init != NULL);
+  cfg = hydra_init_wait(init, &err);
+  ASSERT_TRUE(cfg != NULL);
+  ASSERT_EQ_INT(count_root_keys(cfg), 2);
+  ASSERT_EQ_INT(hydra_config_get_int_or_default(cfg, "trainer.batch_size", 0),
+                32);
+  hydra_config_destroy(cfg);
+
+  // .hydra/config.yaml always holds the full config.
+  cfg = hydra_initialize(2, (char**)argv, config_path, &err);
+  ASSERT_TRUE(cfg != NULL);
+  char* run_dir = NULL;
+  ASSERT_TRUE(hydra_write_outputs(cfg, NULL, 0, &run_dir, &err) ==
+              HYDRA_STATUS_OK);
+  char config_file[512];
+  snprintf(config_file, sizeof(config_file), "%s/.hydra/config.yaml", run_dir);
+  FILE* written = fopen(config_file, "r");
+  ASSERT_TRUE(written != NULL);
+  char line[256];
+  int has_trainer = 0;
+  while (fgets(line, sizeof(line), written) != NULL) {
+    has_trainer |= strncmp(line, "trainer:", 8) == 0;
+  }
+  fclose(written);
+  ASSERT_TRUE(has_trainer);
+  hydra_string_free(run_dir);
+  hydra_config_destroy(cfg);
+  remove(profile_path);
+}
+
+static int async_callback_calls        = 0;
+static hydra_status_t async_callback_status = HYDRA_STATUS_OK;
+
+static void record_async_completion(hydra_status_t status, void* user_data) {
+  (void)user_data;
+  async_callback_calls++;
+  async_callback_status = status;
+}
+
+static _Atomic(hydra_init_t*) waited_init = NULL;
+static hydra_status_t wait_in_callback_status = HYDRA_STATUS_OK;
+
+static void wait_in_callback(hydra_status_t status, void* user_data) {
+  (void)status;
+  (void)user_data;
+  hydra_init_t* init;
+  while ((init = atomic_load(&waited_init)) == NULL) {
+  }
+  hydra_config_t* cfg = hydra_init_wait(init, NULL);
+  wait_in_callback_status = cfg == NULL ? hydra_last_status() : HYDRA_STATUS_OK;
+  hydra_config_destroy(cfg);
+}
+
+static void test_hydra_initialize_async(void) {
+  const char* config_path = "../../tests/configs/integration/simple.yaml";
+  if (!file_exists(config_path)) {
+    return;
+  }
+
+  char* err           = NULL;
+  char override_arg[] = "trainer.batch_size=64";
+  const char* argv[]  = {"test_program", override_arg, NULL};
+  hydra_init_t* init  = hydra_initialize_async(
+      2, (char**)argv, config_path, record_async_completion, NULL, &err);
+  ASSERT_TRUE(init != NULL);
+  // Arguments were copied before the call returned.
+  override_arg[0] = '!';
+
+  while (!hydra_init_ready(init)) {
+    // Other startup work would go here.
+  }
+  hydra_config_t* cfg = hydra_init_wait(init, &err);
+  ASSERT_TRUE(cfg != NULL);
+  ASSERT_EQ_INT(async_callback_calls, 1);
+  ASSERT_TRUE(async_callback_status == HYDRA_STATUS_OK);
+  ASSERT_EQ_INT(hydra_config_expect_int(cfg, "trainer.batch_size"), 64);
+  hydra_config_destroy(cfg);
+
+  // Failures surface from hydra_init_wait.
+  init = hydra_initialize_async(1, (char**)argv, "missing/config.yaml", NULL,
+                                NULL, &err);
+  ASSERT_TRUE(init != NULL);
+  cfg = hydra_init_wait(init, &err);
+  ASSERT_TRUE(cfg == NULL);
+  ASSERT_TRUE(err != NULL);
+  hydra_string_free(err);
+
+  // Waiting from the callback is refused; the handle is waited on here.
+  init = hydra_initialize_async(1, (char**)argv, config_path, wait_in_callback,
+                                NULL, NULL);
+  ASSERT_TRUE(init != NULL);
+  atomic_store(&waited_init, init);
+  cfg = hydra_init_wait(init, NULL);
+  ASSERT_TRUE(cfg != NULL);
+  ASSERT_TRUE(wait_in_callback_status == HYDRA_STATUS_INVALID_ARGUMENT);
+  hydra_config_destroy(cfg);
+}
+
 int main(void) {
   test_case_t tests[] = {
       {"hydra_initialize_basic", test_hydra_initialize_basic},
@@ -235,6 +446,10 @@ int main(void) {
       {"hydra_write_outputs", test_hydra_write_outputs},
       {"logging_level_config", test_logging_level_config},
       {"config_expect_helpers", test_config_expect_helpers},
+      {"codegen_generated_loader", test_codegen_generated_loader},
+      {"hydra_initialize_embedded", test_hydra_initialize_embedded},
+      {"hydra_initialize_async", test_hydra_initialize_async},
+      {"access_profile_loading", test_access_profile_loading},
       {NULL, NULL}};
 
   int total = 0;
@@ -1,20 +1,47 @@
+#include "hydra/access_profile.hpp"
+#include "hydra/c_api.h"
+#include "hydra/compose.hpp"
+#include "hydra/config_bind.hpp"
+#include "hydra/config_blob.hpp"
 #include "hydra/config_node.hpp"
 #include "hydra/config_utils.hpp"
 #include "hydra/interpolation.hpp"
+#include "hydra/live_config.hpp"
+#include "hydra/logging.h"
 #include "hydra/logging.hpp"
 #include "hydra/overrides.hpp"
+#include "hydra/query.hpp"
+#include "hydra/schema.hpp"
+#include "hydra/time_utils.hpp"
+#include "hydra/visit.hpp"
 #include "hydra/yaml_emitter.hpp"
 #include "hydra/yaml_loader.hpp"
 
+#include "app_config.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
 #include <cstdint>
 #include <cstdlib>
+#include <cstring>
 #include <filesystem>
 #include <fstream>
+#include <future>
 #include <iostream>
+#include <iterator>
+#include <memory>
+#include <optional>
 #include <stdexcept>
 #include <string>
+#include <string_view>
+#include <thread>
 #include <vector>
 
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
 namespace fs = std::filesystem;
 
 namespace {
@@ -301,6 +328,89 @@ TEST_CASE(yaml_emission_round_trip) {
   ASSERT_EQ(numbers->as_sequence().size(), static_cast<size_t>(2));
 }
 
+namespace {
+
+enum class Optimizer { sgd, adam };
+HYDRA_BIND_ENUM(Optimizer, sgd, adam)
+
+struct LayerSpec {
+  std::string kind;
+  int32_t width;
+};
+HYDRA_BIND(LayerSpec, kind, width)
+
+struct NetSpec {
+  std::string name;
+  double lr;
+  bool shuffle;
+  Optimizer optimizer;
+  std::vector<LayerSpec> layers;
+  std::vector<std::string> tags;
+  std::optional<int64_t> seed;
+  std::optional<std::string> note;
+};
+HYDRA_BIND(NetSpec, name, lr, shuffle, optimizer, layers, tags, seed, note)
+
+} // namespace
+
+TEST_CASE(bind_struct_fields) {
+  hydra::ConfigNode root = hydra::load_yaml_string(R"(
+net:
+  name: tiny
+  lr: 1
+  shuffle: true
+  optimizer: adam
+  layers:
+    - {kind: conv, width: 32}
+    - {kind: dense, width: 10}
+  tags: [a, b]
+  seed: null
+  unused: 3
+)",
+                                                   "<bind>");
+  NetSpec net = hydra::utils::bind<NetSpec>(root, {"net"});
+  ASSERT_EQ(net.name, std::string("tiny"));
+  ASSERT_TRUE(net.lr == 1.0 && net.shuffle);
+  ASSERT_TRUE(net.optimizer == Optimizer::adam);
+  ASSERT_EQ(net.layers.size(), static_cast<size_t>(2));
+  ASSERT_EQ(net.layers[1].kind, std::string("dense"));
+  ASSERT_EQ(net.layers[1].width, 10);
+  ASSERT_EQ(net.tags[1], std::string("b"));
+  ASSERT_TRUE(!net.seed.has_value() && !net.note.has_value());
+
+  hydra::ConfigNode bad = hydra::load_yaml_string(R"(
+name: 3
+lr: fast
+optimizer: rmsprop
+layers:
+  - {kind: conv, width: 4294967296}
+  - {width: 1}
+tags: [x]
+)",
+                                                  "<bind>");
+  try {
+    hydra::utils::bind<NetSpec>(bad);
+    ASSERT_TRUE(false);
+  } catch (const hydra::utils::BindError& ex) {
+    const std::vector<std::string>& errors = ex.errors();
+    auto has = [&](const std::string& text) {
+      for (const std::string& error : errors) {
+        if (error == text) {
+          return true;
+        }
+      }
+      return false;
+    };
+    ASSERT_EQ(errors.size(), static_cast<size_t>(6));
+    ASSERT_TRUE(has("name: expected string, got int"));
+    ASSERT_TRUE(has("lr: expected numeric value, got string"));
+    ASSERT_TRUE(has("optimizer: 'rmsprop' is not one of sgd, adam"));
+    ASSERT_TRUE(has("layers.0.width: integer 4294967296 is out of range"));
+    ASSERT_TRUE(has("layers.1.kind: missing"));
+    ASSERT_TRUE(has("shuffle: missing"));
+  }
+}
+
 TEST_CASE(logging_level_debug) {
   fs::path config_path = "../../tests/configs/logging/level_debug.yaml";
   if (!fs::exists(config_path)) {
@@ -362,6 +472,589 @@ TEST_CASE(logging_file_only) {
   ASSERT_TRUE(filename->is_string());
 }
 
+namespace {
+
+std::atomic<int> async_records_seen{0};
+
+void count_async_record(log_Event* /*ev*/) {
+  async_records_seen.fetch_add(1, std::memory_order_relaxed);
+}
+
+std::vector<std::string> named_records;
+
+// Suppressed count carried by each record seen, -1 when it has none.
+std::vector<long long> rated_records;
+
+void collect_rated_record(log_Event* ev) {
+  long long suppressed = -1;
+  for (size_t i = 0; i < ev->field_count; ++i) {
+    if (std::string(ev->fields[i].key) == "suppressed") {
+      suppressed = ev->fields[i].value.i;
+    }
+  }
+  rated_records.push_back(suppressed);
+}
+
+void collect_named_record(log_Event* ev) {
+  named_records.push_back(ev->logger != nullptr ? ev->logger : "");
+}
+
+} // namespace
+
+TEST_CASE(logging_async_delivers_all_records) {
+  ASSERT_EQ(log_add_callback(count_async_record, nullptr, LOG_TRACE), 0);
+  async_records_seen = 0;
+  log_set_quiet(true);
+
+  // A tiny queue forces producers through the blocking overflow path.
+  ASSERT_EQ(log_start_async(16, LOG_OVERFLOW_BLOCK), 0);
+  std::vector<std::thread> producers;
+  for (int t = 0; t < 4; ++t) {
+    producers.emplace_back([t] {
+      for (int i = 0; i < 1000; ++i) {
+        log_info("producer %d record %d", t, i);
+      }
+    });
+  }
+  for (auto& producer : producers) {
+    producer.join();
+  }
+  log_flush();
+  ASSERT_EQ(async_records_seen.load(), 4000);
+  ASSERT_EQ(log_dropped_count(), 0ULL);
+  log_stop_async();
+
+  ASSERT_EQ(log_remove_callback(count_async_record, nullptr), 0);
+  log_set_quiet(false);
+}
+
+TEST_CASE(logging_async_restart_under_load) {
+  ASSERT_EQ(log_add_callback(count_async_record, nullptr, LOG_TRACE), 0);
+  async_records_seen = 0;
+  log_set_quiet(true);
+
+  // Restarting with another queue size replaces the ring while producers
+  // keep logging; every record still arrives, async or synchronously.
+  std::atomic<bool> done{false};
+  std::vector<std::thread> producers;
+  for (int t = 0; t < 4; ++t) {
+    producers.emplace_back([t] {
+      for (int i = 0; i < 2000; ++i) {
+        log_info("producer %d record %d", t, i);
+      }
+    });
+  }
+  std::thread restarter([&] {
+    for (size_t round = 0; !done.load(); ++round) {
+      log_start_async(round % 2 == 0 ? 16 : 64, LOG_OVERFLOW_BLOCK);
+      std::this_thread::yield();
+      log_stop_async();
+    }
+  });
+  for (auto& producer : producers) {
+    producer.join();
+  }
+  done = true;
+  restarter.join();
+  ASSERT_EQ(async_records_seen.load(), 8000);
+
+  ASSERT_EQ(log_remove_callback(count_async_record, nullptr), 0);
+  log_set_quiet(false);
+}
+
+TEST_CASE(logging_sink_churn_under_interval_flush) {
+  log_set_quiet(true);
+
+  // Sinks come and go while producers log and the interval flusher runs.
+  std::atomic<bool> done{false};
+  std::vector<std::thread> producers;
+  for (int t = 0; t < 3; ++t) {
+    producers.emplace_back([&done, t] {
+      for (int i = 0; !done.load(); ++i) {
+        log_info("producer %d record %d", t, i);
+      }
+    });
+  }
+  for (int round = 0; round < 200; ++round) {
+    FILE* sink = std::tmpfile();
+    ASSERT_TRUE(sink != nullptr);
+    ASSERT_EQ(log_add_json_fp(sink, LOG_TRACE, nullptr, 0), 0);
+    ASSERT_EQ(log_set_flush(sink, LOG_FLUSH_INTERVAL, 1), 0);
+    std::this_thread::yield();
+    ASSERT_EQ(log_remove_fp(sink), 0);
+    std::fclose(sink);
+  }
+  done = true;
+  for (auto& producer : producers) {
+    producer.join();
+  }
+  log_set_quiet(false);
+}
+
+TEST_CASE(logging_flush_on_level) {
+  FILE* sink = std::tmpfile();
+  ASSERT_TRUE(sink != nullptr);
+  auto written = [sink] {
+    struct stat info {};
+    fstat(fileno(sink), &info);
+    return static_cast<long long>(info.st_size);
+  };
+  log_set_quiet(true);
+  ASSERT_EQ(log_add_fp(sink, LOG_TRACE), 0);
+  ASSERT_EQ(log_set_flush(sink, LOG_FLUSH_LEVEL, LOG_WARN), 0);
+
+  log_info("buffered until a warning arrives");
+  ASSERT_EQ(written(), 0LL);
+  log_warn("flushes both records");
+  ASSERT_TRUE(written() > 0);
+  ASSERT_EQ(log_remove_fp(sink), 0);
+  std::fclose(sink);
+  log_set_quiet(false);
+}
+
+TEST_CASE(logging_skips_disabled_levels) {
+  int evaluated = 0;
+  auto argument = [&evaluated] { return ++evaluated; };
+  log_set_quiet(true);
+
+  // No sink is attached, so nothing is enabled.
+  log_info("value %d", argument());
+  log_fatal("value %d", argument());
+  ASSERT_EQ(evaluated, 0);
+
+  ASSERT_EQ(log_add_callback(count_async_record, nullptr, LOG_WARN), 0);
+  ASSERT_TRUE(!log_enabled(LOG_INFO));
+  ASSERT_TRUE(log_enabled(LOG_WARN));
+  log_info("value %d", argument());
+  log_warn("value %d", argument());
+  ASSERT_EQ(evaluated, 1);
+  ASSERT_EQ(log_remove_callback(count_async_record, nullptr), 0);
+  ASSERT_TRUE(!log_enabled(LOG_FATAL));
+
+  log_set_quiet(false);
+  ASSERT_TRUE(log_enabled(LOG_TRACE));
+}
+
+TEST_CASE(logging_binary_round_trip) {
+  fs::path path = fs::temp_directory_path() / "hydra_test_binary.blog";
+  log_set_quiet(true);
+  ASSERT_EQ(log_start_binary(path.string().c_str(), LOG_DEBUG), 0);
+
+  log_trace("below the binary level");
+  log_info("epoch %d loss=%.3f tag=%s", 3, 0.125, "warmup");
+  std::thread([] {
+    log_warn("[%*d] %zu bytes, 100%%", 4, 7, static_cast<size_t>(42));
+  }).join();
+  log_error("wide %ls", L"text");
+  log_stop_binary();
+  log_set_quiet(false);
+
+  FILE* out = std::tmpfile();
+  ASSERT_TRUE(out != nullptr);
+  ASSERT_EQ(log_decode_binary(path.string().c_str(), out), 3L);
+  std::rewind(out);
+  std::string text;
+  char chunk[256];
+  while (std::fgets(chunk, sizeof(chunk), out) != nullptr) {
+    text += chunk;
+  }
+  std::fclose(out);
+  fs::remove(path);
+
+  ASSERT_TRUE(text.find("INFO ") != std::string::npos);
+  ASSERT_TRUE(text.find("epoch 3 loss=0.125 tag=warmup\n") !=
+              std::string::npos);
+  ASSERT_TRUE(text.find("[   7] 42 bytes, 100%\n") != std::string::npos);
+  ASSERT_TRUE(text.find("wide text\n") != std::string::npos);
+  ASSERT_TRUE(text.find("below the binary level") == std::string::npos);
+  ASSERT_TRUE(text.find("epoch") < text.find("bytes"));
+}
+
+TEST_CASE(logging_binary_restart_under_load) {
+  fs::path dir = fs::temp_directory_path() / "hydra_test_binary_restart";
+  fs::remove_all(dir);
+  fs::create_directories(dir);
+  log_set_quiet(true);
+
+  // Every record in every file must find its site in that same file.
+  std::atomic<bool> done{false};
+  std::vector<std::thread> producers;
+  for (int t = 0; t < 3; ++t) {
+    producers.emplace_back([&done, t] {
+      for (int i = 0; !done.load(); ++i) {
+        log_info("producer %d record %d", t, i);
+      }
+    });
+  }
+  const int files = 20;
+  for (int i = 0; i < files; ++i) {
+    fs::path path = dir / ("part" + std::to_string(i) + ".blog");
+    ASSERT_EQ(log_start_binary(path.string().c_str(), LOG_INFO), 0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  done = true;
+  for (auto& producer : producers) {
+    producer.join();
+  }
+  log_stop_binary();
+  log_set_quiet(false);
+
+  for (int i = 0; i < files; ++i) {
+    fs::path path = dir / ("part" + std::to_string(i) + ".blog");
+    FILE* out     = std::tmpfile();
+    ASSERT_TRUE(out != nullptr);
+    long count = log_decode_binary(path.string().c_str(), out);
+    std::rewind(out);
+    long lines = 0;
+    char chunk[256];
+    while (std::fgets(chunk, sizeof(chunk), out) != nullptr) {
+      lines += std::strchr(chunk, '\n') != nullptr ? 1 : 0;
+    }
+    std::fclose(out);
+    ASSERT_EQ(lines, count);
+  }
+  fs::remove_all(dir);
+}
+
+TEST_CASE(logging_rotates_by_size) {
+  fs::path dir = fs::temp_directory_path() / "hydra_test_rotation";
+  fs::remove_all(dir);
+  fs::create_directories(dir);
+  fs::path path = dir / "job.log";
+  FILE* fp      = std::fopen(path.string().c_str(), "w");
+  ASSERT_TRUE(fp != nullptr);
+  log_set_quiet(true);
+  ASSERT_EQ(log_add_fp(fp, LOG_TRACE), 0);
+  ASSERT_EQ(log_set_rotation(fp, path.string().c_str(), 512, 2,
+                             LOG_ROTATE_NEVER, false),
+            0);
+
+  auto segment = [&](int index) {
+    return fs::path(path.string() + "." + std::to_string(index));
+  };
+  for (int round = 0; round < 3; ++round) {
+    for (int i = 0; i < 10; ++i) {
+      log_info("round %d record %d", round, i);
+    }
+    // The rotation thread swaps the file shortly after the limit is hit.
+    for (int wait = 0; wait < 200 && fs::file_size(path) >= 512; ++wait) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+  }
+  log_info("after rotation");
+
+  ASSERT_EQ(log_remove_fp(fp), 0);
+  log_info("not written anywhere");
+  log_set_quiet(false);
+  std::fclose(fp);
+
+  auto read = [](const fs::path& file) {
+    std::ifstream in(file);
+    return std::string(std::istreambuf_iterator<char>(in), {});
+  };
+  ASSERT_TRUE(fs::exists(segment(1)));
+  ASSERT_TRUE(fs::exists(segment(2)));
+  ASSERT_TRUE(!fs::exists(segment(3)));
+  std::string recent = read(segment(1)) + read(path);
+  ASSERT_TRUE(recent.find("round 2 record 9") != std::string::npos);
+  ASSERT_TRUE(read(path).find("after rotation") != std::string::npos);
+  ASSERT_TRUE(recent.find("not written") == std::string::npos);
+  fs::remove_all(dir);
+}
+
+TEST_CASE(logging_rotation_reconfigured_under_load) {
+  fs::path path = fs::temp_directory_path() / "hydra_test_rotation_swap.log";
+  FILE* sink    = std::fopen(path.string().c_str(), "w");
+  ASSERT_TRUE(sink != nullptr);
+  ASSERT_EQ(log_add_fp(sink, LOG_INFO), 0);
+  log_set_quiet(true);
+
+  // What re-running init_logging does while other threads keep logging.
+  std::atomic<bool> done{false};
+  std::vector<std::thread> producers;
+  for (int t = 0; t < 3; ++t) {
+    producers.emplace_back([&done, t] {
+      for (int i = 0; !done.load(); ++i) {
+        log_info("producer %d record %d", t, i);
+      }
+    });
+  }
+  for (int round = 0; round < 100; ++round) {
+    ASSERT_EQ(log_set_rotation(sink, path.string().c_str(),
+                               round % 2 == 0 ? 1LL << 30 : 0, 1,
+                               LOG_ROTATE_NEVER, false),
+              0);
+  }
+  done = true;
+  for (auto& producer : producers) {
+    producer.join();
+  }
+  log_set_quiet(false);
+  ASSERT_EQ(log_remove_fp(sink), 0);
+  std::fclose(sink);
+  fs::remove(path);
+}
+
+TEST_CASE(logging_named_logger_levels) {
+  hydra::ConfigNode config = hydra::load_yaml_string(R"(
+hydra:
+  job_logging:
+    root: {level: INFO, handlers: []}
+    loggers:
+      trainer: {level: DEBUG}
+      trainer.data: {level: ERROR}
+)");
+  hydra_logger_t* loader = hydra_logger_get("trainer.data.loader");
+  hydra::init_logging(config);
+  hydra_logger_t* model = hydra_logger_get("trainer.model");
+  hydra_logger_t* other = hydra_logger_get("other");
+  ASSERT_TRUE(loader == hydra_logger_get("trainer.data.loader"));
+  ASSERT_EQ(std::string(loader->name), std::string("trainer.data.loader"));
+
+  // Handles created before init_logging are updated in place.
+  ASSERT_EQ(loader->level, static_cast<int>(LOG_ERROR));
+  ASSERT_EQ(model->level, static_cast<int>(LOG_DEBUG));
+  ASSERT_EQ(other->level, static_cast<int>(LOG_INFO));
+
+  named_records.clear();
+  ASSERT_EQ(log_add_callback(collect_named_record, nullptr, LOG_TRACE), 0);
+  hydra_log_debug(model, "batch %d", 1);
+  hydra_log_warn(loader, "dropped");
+  hydra_log_error(loader, "failed");
+  hydra_log_debug(other, "hidden");
+  ASSERT_EQ(named_records.size(), static_cast<size_t>(2));
+  ASSERT_EQ(named_records[0], std::string("trainer.model"));
+  ASSERT_EQ(named_records[1], std::string("trainer.data.loader"));
+  ASSERT_EQ(log_remove_callback(collect_named_record, nullptr), 0);
+
+  hydra::init_logging(hydra::load_yaml_string(R"(
+hydra:
+  job_logging:
+    root: {level: WARN, handlers: []}
+)"));
+  ASSERT_EQ(model->level, static_cast<int>(LOG_WARN));
+  log_set_quiet(false);
+  log_set_level(LOG_TRACE);
+}
+
+TEST_CASE(logging_json_lines) {
+  FILE* sink = std::tmpfile();
+  ASSERT_TRUE(sink != nullptr);
+  const char* fields[] = {"job", "train", "run_dir", "out/\"quoted\""};
+  log_set_quiet(true);
+  ASSERT_EQ(log_add_json_fp(sink, LOG_INFO, fields, 2), 0);
+
+  log_debug("below the sink level");
+  log_info("tab\there \x01 \\ done");
+  log_Field kv[] = {log_field_str("phase", "line\nbreak"),
+                    log_field_int("epoch", 3),
+                    log_field_double("loss", 0.25),
+                    log_field_bool("best", true)};
+  log_kv(LOG_WARN, kv, 4, "epoch %d finished", 3);
+  // Fields survive the copy into the async queue.
+  ASSERT_EQ(log_start_async(16, LOG_OVERFLOW_BLOCK), 0);
+  log_kv(LOG_INFO, kv + 1, 1, "async");
+  log_stop_async();
+
+  ASSERT_EQ(log_remove_fp(sink), 0);
+  log_set_quiet(false);
+  std::rewind(sink);
+  std::vector<std::string> lines;
+  char line[1024];
+  while (std::fgets(line, sizeof(line), sink) != nullptr) {
+    lines.emplace_back(line);
+  }
+  std::fclose(sink);
+
+  auto contains = [&lines](size_t index, const char* text) {
+    return lines[index].find(text) != std::string::npos;
+  };
+  ASSERT_EQ(lines.size(), static_cast<size_t>(3));
+  ASSERT_TRUE(lines[0].rfind("{\"ts\":\"", 0) == 0);
+  ASSERT_TRUE(contains(0, "\"level\":\"INFO\""));
+  ASSERT_TRUE(contains(0, "\"msg\":\"tab\\there \\u0001 \\\\ done\","
+                          "\"job\":\"train\","
+                          "\"run_dir\":\"out/\\\"quoted\\\"\"}\n"));
+  ASSERT_TRUE(contains(1, "\"msg\":\"epoch 3 finished\""));
+  ASSERT_TRUE(contains(1, ",\"phase\":\"line\\nbreak\",\"epoch\":3,"
+                          "\"loss\":0.25,\"best\":true}"));
+  ASSERT_TRUE(contains(2, "\"msg\":\"async\""));
+  ASSERT_TRUE(contains(2, ",\"epoch\":3}"));
+}
+
+TEST_CASE(logging_rate_limited_macros) {
+  log_set_quiet(true);
+  ASSERT_EQ(log_add_callback(collect_rated_record, nullptr, LOG_TRACE), 0);
+
+  rated_records.clear();
+  for (int i = 0; i < 10; ++i) {
+    log_every_n(LOG_WARN, 4, "every fourth %d", i);
+  }
+  ASSERT_EQ(rated_records.size(), static_cast<size_t>(3)); // calls 0, 4, 8
+  ASSERT_EQ(rated_records[0], -1LL);
+  ASSERT_EQ(rated_records[1], 3LL);
+  ASSERT_EQ(rated_records[2], 3LL);
+
+  rated_records.clear();
+  for (int i = 0; i < 10; ++i) {
+    log_first_n(LOG_WARN, 2, "first two %d", i);
+  }
+  // The first two, then one summary at call 3 covering calls 2 and 3; the
+  // rest fall inside the summary interval.
+  ASSERT_EQ(rated_records.size(), static_cast<size_t>(3));
+  ASSERT_EQ(rated_records[2], 2LL);
+
+  rated_records.clear();
+  for (int i = 0; i < 1000; ++i) {
+    log_every_sec(LOG_WARN, 60.0, "once a minute");
+  }
+  ASSERT_EQ(rated_records.size(), static_cast<size_t>(1));
+
+  rated_records.clear();
+  for (int i = 0; i < 1000; ++i) {
+    log_sample(LOG_WARN, 0.0, "never");
+    log_sample(LOG_WARN, 1.0, "always");
+  }
+  ASSERT_EQ(rated_records.size(), static_cast<size_t>(1000));
+
+  // Disabled levels neither emit nor count.
+  rated_records.clear();
+  ASSERT_EQ(log_remove_callback(collect_rated_record, nullptr), 0);
+  ASSERT_EQ(log_add_callback(collect_rated_record, nullptr, LOG_ERROR), 0);
+  for (int i = 0; i < 10; ++i) {
+    log_every_n(LOG_INFO, 2, "filtered");
+  }
+  ASSERT_TRUE(rated_records.empty());
+  ASSERT_EQ(log_remove_callback(collect_rated_record, nullptr), 0);
+  log_set_quiet(false);
+}
+
+TEST_CASE(logging_flight_recorder) {
+  fs::path path = fs::temp_directory_path() / "hydra_test_recorder.flight";
+  fs::path dump = path.string() + ".dump";
+  fs::remove(dump);
+  auto read_text = [](FILE* in) {
+    std::string text;
+    char chunk[256];
+    std::rewind(in);
+    while (std::fgets(chunk, sizeof(chunk), in) != nullptr) {
+      text += chunk;
+    }
+    std::fclose(in);
+    return text;
+  };
+  log_set_quiet(true);
+  ASSERT_EQ(log_start_recorder(path.string().c_str(), 4, LOG_TRACE,
+                               "config=test"),
+            0);
+  ASSERT_TRUE(log_enabled(LOG_TRACE));
+
+  for (int i = 0; i < 6; ++i) {
+    log_trace("step %d", i);
+  }
+  std::thread([] { log_debug("from worker"); }).join();
+
+  FILE* out = std::tmpfile();
+  ASSERT_TRUE(out != nullptr);
+  ASSERT_EQ(log_dump_recorder(fileno(out)), 0);
+  std::string dumped = read_text(out);
+  ASSERT_TRUE(dumped.find("config=test") != std::string::npos);
+  ASSERT_TRUE(dumped.find("TRACE [") != std::string::npos);
+  ASSERT_TRUE(dumped.find("step 1\n") == std::string::npos);
+  ASSERT_TRUE(dumped.find("step 2\n") < dumped.find("step 5\n"));
+  ASSERT_TRUE(dumped.find("step 5\n") < dumped.find("from worker\n"));
+
+  // A crashing child leaves both the mapped file and the text dump.
+  pid_t child = fork();
+  if (child == 0) {
+    log_error("about to crash");
+    std::abort();
+  }
+  int status = 0;
+  ASSERT_EQ(waitpid(child, &status, 0), child);
+  ASSERT_TRUE(WIFSIGNALED(status) && WTERMSIG(status) == SIGABRT);
+  log_stop_recorder();
+  log_set_quiet(false);
+
+  std::ifstream dump_in(dump);
+  std::string crash((std::istreambuf_iterator<char>(dump_in)),
+                    std::istreambuf_iterator<char>());
+  ASSERT_TRUE(crash.find("signal 6, config=test") != std::string::npos);
+  ASSERT_TRUE(crash.find("about to crash\n") != std::string::npos);
+
+  out = std::tmpfile();
+  ASSERT_TRUE(out != nullptr);
+  ASSERT_EQ(log_decode_recorder(path.string().c_str(), out), 5L);
+  std::string decoded = read_text(out);
+  ASSERT_TRUE(decoded.find("signal 6") != std::string::npos);
+  ASSERT_TRUE(decoded.find("about to crash\n") != std::string::npos);
+  ASSERT_TRUE(decoded.find("step 2\n") == std::string::npos);
+  fs::remove(path);
+  fs::remove(dump);
+}
+
+TEST_CASE(logging_flight_recorder_restart) {
+  log_set_quiet(true);
+  ASSERT_EQ(log_start_recorder(nullptr, 8, LOG_TRACE, "first"), 0);
+  log_info("old record");
+  log_stop_recorder();
+
+  // The old region is unmapped, whatever the size; the new rings start empty.
+  ASSERT_EQ(log_start_recorder(nullptr, 16, LOG_TRACE, "between"), 0);
+  log_info("old record");
+  ASSERT_EQ(log_start_recorder(nullptr, 8, LOG_TRACE, "second"), 0);
+  bool on_altstack = false;
+  std::thread([&on_altstack] {
+    log_info("new record");
+    stack_t stack;
+    on_altstack = sigaltstack(nullptr, &stack) == 0 &&
+                  !(stack.ss_flags & SS_DISABLE);
+  }).join();
+  ASSERT_TRUE(on_altstack);
+
+  FILE* out = std::tmpfile();
+  ASSERT_TRUE(out != nullptr);
+  ASSERT_EQ(log_dump_recorder(fileno(out)), 0);
+  std::string dumped;
+  char chunk[256];
+  std::rewind(out);
+  while (std::fgets(chunk, sizeof(chunk), out) != nullptr) {
+    dumped += chunk;
+  }
+  std::fclose(out);
+  log_stop_recorder();
+  log_set_quiet(false);
+
+  ASSERT_TRUE(dumped.find("second") != std::string::npos);
+  ASSERT_TRUE(dumped.find("new record\n") != std::string::npos);
+  ASSERT_TRUE(dumped.find("first") == std::string::npos);
+  ASSERT_TRUE(dumped.find("between") == std::string::npos);
+  ASSERT_TRUE(dumped.find("old record") == std::string::npos);
+
+  // Regions are unmapped while other threads keep recording.
+  log_set_quiet(true);
+  std::atomic<bool> done{false};
+  std::vector<std::thread> producers;
+  for (int t = 0; t < 3; ++t) {
+    producers.emplace_back([&done, t] {
+      for (int i = 0; !done.load(); ++i) {
+        log_info("producer %d record %d", t, i);
+      }
+    });
+  }
+  for (int round = 0; round < 200; ++round) {
+    ASSERT_EQ(log_start_recorder(nullptr, round % 2 == 0 ? 4 : 32, LOG_TRACE,
+                                 "churn"),
+              0);
+  }
+  done = true;
+  for (auto& producer : producers) {
+    producer.join();
+  }
+  log_stop_recorder();
+  log_set_quiet(false);
+}
+
 TEST_CASE(integration_simple_config) {
   fs::path config_path = "../../tests/configs/integration/simple.yaml";
   if (!fs::exists(config_path)) {
@@ -485,6 +1178,482 @@ TEST_CASE(utils_initialize_with_overrides) {
   ASSERT_EQ(depth->as_int(), static_cast<int64_t>(101));
 }
 
+TEST_CASE(codegen_generated_types) {
+  fs::path config_path = "../../tests/configs/integration/simple.yaml";
+  if (!fs::exists(config_path)) {
+    return;
+  }
+
+  const char* argv[]       = {"test_program", "model.depth=101", nullptr};
+  hydra::ConfigNode config = hydra::utils::initialize(
+      2, const_cast<char**>(argv), config_path.string());
+
+  generated::AppConfig app = generated::load_app_config(config);
+  ASSERT_EQ(app.trainer.batch_size, static_cast<int64_t>(32));
+  ASSERT_TRUE(app.trainer.learning_rate > 0.0009 &&
+              app.trainer.learning_rate < 0.0011);
+  ASSERT_EQ(app.model.depth, static_cast<int64_t>(101));
+  ASSERT_EQ(app.model.name, std::string("resnet"));
+  ASSERT_EQ(app.experiment.labels.stage__a__b, std::string("baseline"));
+  ASSERT_EQ(app.hydra.job.name, std::string("test_program"));
+  ASSERT_EQ(app.hydra.job_logging.root.handlers.size(), static_cast<size_t>(2));
+  ASSERT_TRUE(app.hydra.job_logging.handlers.console.is_mapping());
+
+  hydra::assign_path(config, {"trainer", "batch_size"},
+                     hydra::make_string("large"), false);
+  bool threw = false;
+  try {
+    generated::load_app_config(config);
+  } catch (const hydra::utils::BindError& ex) {
+    threw = ex.errors().size() == 1 &&
+            ex.errors()[0].rfind("trainer.batch_size:", 0) == 0;
+  }
+  ASSERT_TRUE(threw);
+}
+
+TEST_CASE(config_blob_round_trip) {
+  hydra::ConfigNode config = hydra::load_yaml_string(
+      "name: ${model.name}-run\n"
+      "model: {name: resnet, depth: 50, lr: 0.5, frozen: false}\n"
+      "layers: [1, two, null, [3]]\n"
+      "hydra: {job: {name: null}}\n");
+  std::string blob = hydra::serialize_config(config);
+
+  hydra::ConfigNode loaded =
+      hydra::deserialize_config(blob.data(), blob.size());
+  ASSERT_EQ(hydra::to_yaml_string(loaded), hydra::to_yaml_string(config));
+
+  const char* argv[] = {"embedded_program", "model.depth=18", nullptr};
+  hydra::ConfigNode initialized = hydra::utils::initialize_embedded(
+      2, const_cast<char**>(argv), blob.data(), blob.size());
+  ASSERT_EQ(hydra::utils::expect_string(initialized, {"name"}),
+            std::string("resnet-run"));
+  ASSERT_EQ(hydra::utils::expect_int(initialized, {"model", "depth"}),
+            static_cast<int64_t>(18));
+  ASSERT_EQ(hydra::utils::expect_string(initialized, {"hydra", "job", "name"}),
+            std::string("embedded_program"));
+
+  bool threw = false;
+  try {
+    hydra::deserialize_config(blob.data(), blob.size() - 1);
+  } catch (const std::runtime_error&) {
+    threw = true;
+  }
+  ASSERT_TRUE(threw);
+}
+
+TEST_CASE(schema_validation) {
+  hydra::Schema schema = hydra::Schema::compile(hydra::load_yaml_string(
+      "model:\n"
+      "  name: {type: string, pattern: '[a-z0-9_]+'}\n"
+      "  depth: {type: int, min: 1, max: 200}\n"
+      "  dropout: {type: double, min: 0, max: 1, nullable: true}\n"
+      "  activation: {type: string, enum: [relu, gelu]}\n"
+      "  widths: {type: sequence, items: {type: int, min: 1}}\n"
+      "trainer:\n"
+      "  seed: {type: int, required: false}\n"));
+
+  hydra::ConfigNode config = hydra::load_yaml_string(
+      "model: {name: resnet_50, depth: 50, dropout: null, activation: relu,\n"
+      "        widths: [64, 128], extra: 1}\n"
+      "trainer: {}\n");
+  ASSERT_TRUE(schema.validate(config).empty());
+
+  config = hydra::load_yaml_string(
+      "model: {name: ResNet, depth: 500, dropout: 0.5, activation: tanh,\n"
+      "        widths: [64, 0, x]}\n");
+  std::vector<std::string> errors = schema.validate(config);
+  std::vector<std::string> expected = {
+      "model.activation: 'tanh' is not one of 'relu', 'gelu'",
+      "model.depth: 500 is above the maximum 200",
+      "model.name: 'ResNet' does not match '[a-z0-9_]+'",
+      "model.widths.1: 0 is below the minimum 1",
+      "model.widths.2: expected int, got string",
+      "trainer: missing"};
+  ASSERT_EQ(errors.size(), expected.size());
+  for (size_t i = 0; i < expected.size(); ++i) {
+    ASSERT_EQ(errors[i], expected[i]);
+  }
+
+  bool threw = false;
+  try {
+    hydra::Schema::compile(
+        hydra::load_yaml_string("depth: {type: int, pattern: x}"));
+  } catch (const std::runtime_error& ex) {
+    threw = std::string(ex.what()).find("pattern needs type string") !=
+            std::string::npos;
+  }
+  ASSERT_TRUE(threw);
+
+  // initialize() checks the schema named by hydra.schema.
+  fs::path schema_path = fs::temp_directory_path() / "hydra_test_schema.yaml";
+  std::ofstream(schema_path)
+      << "trainer: {batch_size: {type: int, max: 64}}\n";
+  fs::path config_path = "../../tests/configs/integration/simple.yaml";
+  if (fs::exists(config_path)) {
+    std::string schema_override = "+hydra.schema=" + schema_path.string();
+    const char* argv[] = {"test_program", schema_override.c_str(),
+                          "trainer.batch_size=128", nullptr};
+    threw = false;
+    try {
+      hydra::utils::initialize(3, const_cast<char**>(argv),
+                               config_path.string());
+    } catch (const hydra::SchemaError& ex) {
+      threw = ex.errors().size() == 1 &&
+              ex.errors()[0] == "trainer.batch_size: 128 is above the "
+                                "maximum 64";
+    }
+    ASSERT_TRUE(threw);
+  }
+  fs::remove(schema_path);
+}
+
+TEST_CASE(live_config_snapshots) {
+  hydra::LiveConfig live(hydra::load_yaml_string(
+      "trainer: {batch_size: 32, lr: 0.1}\n"
+      "model: {name: resnet, tag: '${model.name}-${trainer.batch_size}'}\n"));
+  ASSERT_EQ(hydra::utils::expect_string(*live.snapshot(), {"model", "tag"}),
+            std::string("resnet-32"));
+
+  std::vector<std::string> seen;
+  live.subscribe("trainer", [&](const hydra::LiveConfig::Snapshot& config) {
+    seen.push_back("trainer:" + std::to_string(hydra::utils::expect_int(
+                                    *config, {"trainer", "batch_size"})));
+  });
+  auto model = live.subscribe(
+      "model", [&](const hydra::LiveConfig::Snapshot&) {
+        seen.push_back("model");
+      });
+  live.subscribe("trainer.warmup", [&](const hydra::LiveConfig::Snapshot&) {
+    seen.push_back("warmup");
+  });
+
+  hydra::LiveConfig::Snapshot before = live.snapshot();
+  live.update({"trainer.batch_size=64", "+trainer.warmup=5"});
+  // The old snapshot is untouched; the interpolation follows the change.
+  ASSERT_EQ(hydra::utils::expect_int(*before, {"trainer", "batch_size"}),
+            static_cast<int64_t>(32));
+  ASSERT_EQ(hydra::utils::expect_string(*live.snapshot(), {"model", "tag"}),
+            std::string("resnet-64"));
+  ASSERT_EQ(live.version(), static_cast<uint64_t>(1));
+  ASSERT_EQ(seen.size(), static_cast<size_t>(3));
+  ASSERT_EQ(seen[0], std::string("model"));
+  ASSERT_EQ(seen[1], std::string("trainer:64"));
+  ASSERT_EQ(seen[2], std::string("warmup"));
+
+  // Same value again: no subtree changes, so nobody is notified.
+  seen.clear();
+  live.update({"trainer.batch_size=64"});
+  ASSERT_TRUE(seen.empty());
+
+  // A failing batch publishes nothing.
+  bool threw = false;
+  try {
+    live.update({"trainer.lr=0.2", "missing.key=1"});
+  } catch (const std::exception&) {
+    threw = true;
+  }
+  ASSERT_TRUE(threw);
+  ASSERT_EQ(live.version(), static_cast<uint64_t>(2));
+  ASSERT_TRUE(
+      hydra::utils::expect_double(*live.snapshot(), {"trainer", "lr"}) < 0.15);
+
+  live.unsubscribe(model);
+  live.update({"model.name=vit"});
+  ASSERT_EQ(seen.size(), static_cast<size_t>(0));
+
+  // Readers keep taking snapshots while a writer publishes.
+  std::atomic<bool> stop{false};
+  std::atomic<int64_t> reads{0};
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 4; ++i) {
+    readers.emplace_back([&] {
+      while (!stop.load()) {
+        hydra::LiveConfig::Snapshot config = live.snapshot();
+        int64_t batch =
+            hydra::utils::expect_int(*config, {"trainer", "batch_size"});
+        std::string tag =
+            hydra::utils::expect_string(*config, {"model", "tag"});
+        if (tag != "vit-" + std::to_string(batch)) {
+          reads.store(-1000000);
+          return;
+        }
+        reads.fetch_add(1);
+      }
+    });
+  }
+  for (int i = 1; i <= 200; ++i) {
+    live.update({"trainer.batch_size=" + std::to_string(i)});
+  }
+  stop.store(true);
+  for (std::thread& reader : readers) {
+    reader.join();
+  }
+  ASSERT_TRUE(reads.load() >= 0);
+}
+
+TEST_CASE(compose_many_parallel) {
+  fs::path config_path = "../../tests/configs/integration/with_env.yaml";
+  if (!fs::exists(config_path)) {
+    return;
+  }
+
+  // Neither the process environment nor the wall clock is consulted.
+  auto fixed = std::chrono::system_clock::time_point(
+      std::chrono::seconds(1700000000));
+  hydra::ComposeContext context;
+  context.environment    = {{"DB_HOST", "context-db"}, {"BATCH_SIZE", "7"}};
+  context.clock          = [fixed] { return fixed; };
+  context.default_config = config_path;
+
+  std::vector<hydra::OverrideSet> sets;
+  for (int i = 0; i < 500; ++i) {
+    sets.push_back({{}, {"model.depth=" + std::to_string(i)}});
+  }
+  sets.push_back({{}, {"missing.key=1"}});
+
+  std::vector<hydra::ComposeResult> results =
+      hydra::compose_many(context, sets, 8);
+  ASSERT_EQ(results.size(), sets.size());
+  std::string run_dir =
+      "./test_outputs/" + hydra::format_time("%Y-%m-%d_%H-%M-%S", fixed);
+  for (int i = 0; i < 500; ++i) {
+    const hydra::ConfigNode& config = results[i].config;
+    ASSERT_TRUE(results[i].ok());
+    ASSERT_EQ(hydra::utils::expect_int(config, {"model", "depth"}),
+              static_cast<int64_t>(i));
+    ASSERT_EQ(hydra::utils::expect_string(config, {"database", "host"}),
+              std::string("context-db"));
+    ASSERT_EQ(hydra::utils::expect_string(config, {"trainer", "batch_size"}),
+              std::string("7"));
+    ASSERT_EQ(hydra::utils::expect_string(config, {"hydra", "run", "dir"}),
+              run_dir);
+  }
+  ASSERT_TRUE(!results.back().ok());
+
+  // The file was parsed once; later compositions copy the cached tree.
+  ASSERT_TRUE(context.cache->find(fs::weakly_canonical(config_path)) !=
+              nullptr);
+}
+
+TEST_CASE(compose_async_overlaps_startup) {
+  fs::path config_path = "../../tests/configs/integration/simple.yaml";
+  if (!fs::exists(config_path)) {
+    return;
+  }
+
+  const char* argv[] = {"test_program", "trainer.batch_size=96", nullptr};
+  std::future<hydra::ConfigNode> pending = hydra::utils::initialize_async(
+      2, const_cast<char**>(argv), config_path.string());
+  hydra::ConfigNode config = pending.get();
+  ASSERT_EQ(hydra::utils::expect_int(config, {"trainer", "batch_size"}),
+            static_cast<int64_t>(96));
+  ASSERT_EQ(hydra::utils::expect_string(config, {"hydra", "job", "name"}),
+            std::string("test_program"));
+
+  hydra::ComposeContext context;
+  std::future<hydra::ConfigNode> failing =
+      hydra::compose_async(context, {{"missing/config.yaml"}, {}});
+  bool threw = false;
+  try {
+    failing.get();
+  } catch (const std::exception&) {
+    threw = true;
+  }
+  ASSERT_TRUE(threw);
+}
+
+TEST_CASE(access_profile_projection) {
+  fs::path dir = create_temp_directory("access_profile");
+  {
+    std::ofstream out(dir / "config.yaml");
+    out << "hydra: {job: {name: profiled}, run: {dir: " << dir.string()
+        << "}}\n"
+        << "model: {name: resnet, tag: '${data.root}/${model.name}'}\n"
+        << "data: {root: /data, shards: [1, 2, 3]}\n"
+        << "unused: {a: 1, b: {c: 2}}\n";
+  }
+  hydra::ComposeContext context;
+  hydra::OverrideSet set{{dir / "config.yaml"}, {}};
+  hydra::ConfigNode full = context.compose(set);
+
+  // Only lookups made while tracking is on are recorded.
+  hydra::clear_tracked_paths();
+  hydra::set_access_tracking(true);
+  hydra::utils::expect_string(full, {"model", "tag"});
+  hydra::utils::require_node(full, {"data", "shards"});
+  hydra::find_path(full, {"data", "shards", "1"});
+  hydra::set_access_tracking(false);
+  hydra::find_path(full, {"unused", "a"});
+
+  fs::path file = hydra::write_access_profile(dir);
+  ASSERT_TRUE(file == dir / ".hydra" / "access_profile");
+  ASSERT_EQ(read_file(file), std::string("data.shards\nmodel.tag\n"));
+
+  bool projected              = false;
+  context.use_access_profile = true;
+  context.profile            = std::make_shared<const hydra::AccessProfile>(
+      hydra::AccessProfile::load_file(file));
+  hydra::ConfigNode config = context.compose(set, &projected);
+  ASSERT_TRUE(projected);
+  // The targets of kept interpolations are kept too; `hydra` always is.
+  ASSERT_EQ(hydra::utils::expect_string(config, {"model", "tag"}),
+            std::string("/data/resnet"));
+  ASSERT_EQ(hydra::utils::require_node(config, {"data", "shards"})
+                .as_sequence()
+                .size(),
+            static_cast<size_t>(3));
+  ASSERT_EQ(hydra::utils::expect_string(config, {"hydra", "job", "name"}),
+            std::string("profiled"));
+  ASSERT_TRUE(!hydra::utils::has_node(config, {"unused"}));
+
+  // The value-returning entry points cannot complete a tree later, so they
+  // ignore hydra.access_profile.load.
+  std::string config_arg = (dir / "config.yaml").string();
+  std::string load_arg   = "+hydra.access_profile.load=" + file.string();
+  char program[]         = "profiled";
+  char config_flag[]     = "--config";
+  char* argv[] = {program, config_flag, config_arg.data(), load_arg.data()};
+  ASSERT_TRUE(hydra::utils::has_node(hydra::utils::initialize(4, argv),
+                                     {"unused"}));
+
+  // What a miss merges in leaves existing nodes where they are.
+  const hydra::ConfigNode* tag = hydra::find_path(config, {"model", "tag"});
+  hydra::fill_missing(config, full);
+  ASSERT_TRUE(hydra::find_path(config, {"model", "tag"}) == tag);
+  ASSERT_EQ(hydra::utils::expect_int(config, {"unused", "b", "c"}),
+            static_cast<int64_t>(2));
+  fs::remove_all(dir);
+}
+
+TEST_CASE(query_select) {
+  hydra::ConfigNode config = hydra::load_yaml_string(
+      "model:\n"
+      "  layers:\n"
+      "    - {name: a, units: 64, type: conv}\n"
+      "    - {name: b, units: 128, type: dense}\n"
+      "    - {name: c, units: 32, type: conv}\n"
+      "  lr: 0.1\n"
+      "optim: {lr: 0.01, 'a.b': 1}\n",
+      "query");
+
+  auto names = [&](std::string_view expression) {
+    std::string joined;
+    for (const hydra::ConfigNode* node : hydra::select(config, expression)) {
+      joined += (joined.empty() ? "" : ",") +
+                (node->is_string() ? node->as_string()
+                                   : hydra::to_yaml_string(*node));
+    }
+    return joined;
+  };
+  ASSERT_EQ(names("model.layers.*.name"), std::string("a,b,c"));
+  ASSERT_EQ(names("model.layers[1:].name"), std::string("b,c"));
+  ASSERT_EQ(names("model.layers[::-2].name"), std::string("c,a"));
+  ASSERT_EQ(names("model.layers[-1].name"), std::string("c"));
+  ASSERT_EQ(names("model.layers[?units>=64].name"), std::string("a,b"));
+  ASSERT_EQ(names("**[?type=='conv'].name"), std::string("a,c"));
+  ASSERT_EQ(names("model.layers[?missing].name"), std::string(""));
+  ASSERT_EQ(hydra::select(config, "**.lr").size(), static_cast<size_t>(2));
+  ASSERT_EQ(hydra::select(config, "optim['a.b']").size(),
+            static_cast<size_t>(1));
+  ASSERT_EQ(hydra::select(config, "optim.a\\.b").size(),
+            static_cast<size_t>(1));
+  ASSERT_TRUE(hydra::select(config, "").front() == &config);
+
+  // Paths come with the matches, and the visitor can stop the walk.
+  hydra::Query query = hydra::Query::compile("**.units");
+  std::vector<std::string> paths;
+  bool finished = query.for_each(
+      config, [&](const std::vector<std::string>& path,
+                  const hydra::ConfigNode&) {
+        paths.push_back(hydra::format_override_path(path));
+        return paths.size() < 2;
+      });
+  ASSERT_TRUE(!finished);
+  ASSERT_EQ(paths.size(), static_cast<size_t>(2));
+  ASSERT_EQ(paths[1], std::string("model.layers.1.units"));
+
+  bool threw = false;
+  try {
+    hydra::Query::compile("model.layers[?units ~ 3]");
+  } catch (const std::runtime_error& ex) {
+    threw = std::string(ex.what()).find("position") != std::string::npos;
+  }
+  ASSERT_TRUE(threw);
+}
+
+TEST_CASE(visit_and_walk) {
+  hydra::ConfigNode config = hydra::load_yaml_string(
+      "a: {b: 1, c: [x, 2.5]}\n"
+      "d: null\n"
+      "e: true\n",
+      "walk");
+
+  auto kind = [](const hydra::ConfigNode& node) {
+    return hydra::visit(node, hydra::overloaded{
+                                  [](const hydra::ConfigNode::map_t& map) {
+                                    return "map" + std::to_string(map.size());
+                                  },
+                                  [](bool) { return std::string("bool"); },
+                                  [](int64_t) { return std::string("int"); },
+                                  [](const auto&) { return std::string("?"); },
+                              });
+  };
+  ASSERT_EQ(kind(config), std::string("map3"));
+  ASSERT_EQ(kind(*hydra::find_path(config, {"a", "b"})), std::string("int"));
+  ASSERT_EQ(kind(*hydra::find_path(config, {"e"})), std::string("bool"));
+  ASSERT_EQ(kind(*hydra::find_path(config, {"d"})), std::string("?"));
+
+  // Pre-order on the way down, post-order on the way up.
+  std::string order;
+  hydra::walk(
+      config,
+      [&](hydra::WalkPath path, const hydra::ConfigNode&) {
+        order += "<" + hydra::format_override_path(hydra::path_components(path));
+      },
+      [&](hydra::WalkPath path, const hydra::ConfigNode&) {
+        order += ">" + std::to_string(path.size());
+      });
+  ASSERT_EQ(order, std::string("<<a<a.b>2<a.c<a.c.0>3<a.c.1>3>2>1<d>1<e>1>0"));
+
+  // Skipping a subtree and stopping the walk.
+  std::vector<std::string> seen;
+  bool finished = hydra::walk(
+      config, [&](hydra::WalkPath path, const hydra::ConfigNode&) {
+        std::string rendered =
+            hydra::format_override_path(hydra::path_components(path));
+        seen.push_back(rendered);
+        if (rendered == "a.c") {
+          return hydra::WalkAction::SkipChildren;
+        }
+        return rendered == "d" ? hydra::WalkAction::Stop
+                               : hydra::WalkAction::Continue;
+      });
+  ASSERT_TRUE(!finished);
+  ASSERT_EQ(seen.size(), static_cast<size_t>(5));
+  ASSERT_EQ(seen.back(), std::string("d"));
+
+  // Walking a mutable tree may rewrite values in place.
+  hydra::walk(config, [](hydra::WalkPath, hydra::ConfigNode& node) {
+    if (node.is_int()) {
+      node = hydra::make_int(node.as_int() * 10);
+    }
+  });
+  ASSERT_EQ(hydra::utils::expect_int(config, {"a", "b"}),
+            static_cast<int64_t>(10));
+
+  // The resolver runs on walk() and still reports cycles.
+  hydra::ConfigNode cyclic =
+      hydra::load_yaml_string("x: '${y}'\ny: 'v${x}'\n", "cycle");
+  bool threw = false;
+  try {
+    hydra::resolve_interpolations(cyclic);
+  } catch (const std::runtime_error& ex) {
+    threw = std::string(ex.what()).find("cycle") != std::string::npos;
+  }
+  ASSERT_TRUE(threw);
+}
+
 TEST_CASE(utils_write_hydra_outputs) {
   fs::path config_path = "../../tests/configs/integration/simple.yaml";
   if (!fs::exists(config_path)) {
@@ -516,6 +1685,79 @@ TEST_CASE(utils_write_hydra_outputs) {
   fs::remove_all(run_dir);
 }
 
+TEST_CASE(c_api_frozen_concurrent_reads) {
+  hydra_config_t* cfg = hydra_config_create();
+  ASSERT_TRUE(cfg != nullptr);
+  const char* yaml = "paths:\n"
+                     "  root: /data\n"
+                     "  cache: ${paths.root}/cache\n"
+                     "trainer:\n"
+                     "  batch_size: 32\n"
+                     "  lr: 0.5\n"
+                     "  tags: [a, b, c]\n";
+  ASSERT_TRUE(hydra_config_merge_string(cfg, yaml, "inline", nullptr) ==
+              HYDRA_STATUS_OK);
+  ASSERT_TRUE(hydra_config_freeze(cfg, nullptr) == HYDRA_STATUS_OK);
+  ASSERT_TRUE(hydra_config_is_frozen(cfg) == 1);
+
+  char* err = nullptr;
+  ASSERT_TRUE(hydra_config_apply_override(cfg, "trainer.batch_size=1", &err) !=
+              HYDRA_STATUS_OK);
+  ASSERT_TRUE(err != nullptr);
+  hydra_string_free(err);
+
+  std::atomic<int> failures{0};
+  std::vector<std::thread> workers;
+  for (int t = 0; t < 8; ++t) {
+    workers.emplace_back([cfg, &failures]() {
+      for (int i = 0; i < 500; ++i) {
+        int64_t batch = 0;
+        if (hydra_config_get_int(cfg, "trainer.batch_size", &batch, nullptr) !=
+                HYDRA_STATUS_OK ||
+            batch != 32) {
+          ++failures;
+        }
+        char* cache = nullptr;
+        if (hydra_config_get_string(cfg, "paths.cache", &cache, nullptr) !=
+                HYDRA_STATUS_OK ||
+            std::string(cache) != "/data/cache") {
+          ++failures;
+        }
+        hydra_string_free(cache);
+
+        hydra_config_iter_t* iter = nullptr;
+        if (hydra_config_sequence_iter(cfg, "trainer.tags", &iter, nullptr) !=
+            HYDRA_STATUS_OK) {
+          ++failures;
+          continue;
+        }
+        size_t seen = 0;
+        while (hydra_config_iter_next(iter, nullptr, nullptr, nullptr,
+                                      nullptr) == 1) {
+          ++seen;
+        }
+        hydra_config_iter_destroy(iter);
+        if (seen != 3) {
+          ++failures;
+        }
+
+        if (i % 50 == 0) {
+          char* yaml_out = hydra_config_to_yaml_string(cfg, nullptr);
+          if (yaml_out == nullptr) {
+            ++failures;
+          }
+          hydra_string_free(yaml_out);
+        }
+      }
+    });
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  hydra_config_destroy(cfg);
+  ASSERT_EQ(failures.load(), 0);
+}
+
 int main() {
   int failures = 0;
   for (const auto& test : registry()) {